@@ -0,0 +1,264 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "bench.h"
+#include "error_stack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/*****************************************************************************
+ *   L O C A L   D E F I N I T I O N S
+ *****************************************************************************/
+
+#define M_MAX_REPS              1000
+#define M_MAX_OPS               1000000000ULL
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+static uint32_t             m_d_nr_warmups_ud       = 2;
+static uint32_t             m_d_nr_reps_ud          = 15;
+static uint64_t             m_d_min_run_ns_ud       = 20 * 1000000ULL;
+static int                  m_d_argc_d              = 0;
+static const char**         m_d_arg_apc             = NULL;     //names to run, incl options
+static int                  m_d_header_done_d       = 0;
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static int m_r_run_once (
+          bench_r*                    p_bench_pr,
+    const uint64_t                    p_nr_ops_ud,
+    const char*                       p_bench_name_pc,
+          bench_t*                    p_bench_pz);
+
+static int m_r_cmp_double (
+    const void*                       p_a_p,
+    const void*                       p_b_p);
+
+static double m_r_percentile (
+    const double*                     p_sorted_ad,
+    const uint32_t                    p_nr_ud,
+    const uint32_t                    p_percent_ud);
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+extern int bench_r_init (
+    const int                         argc,
+    const char*                       arg_apc[])
+{
+    m_d_argc_d  = argc;
+    m_d_arg_apc = arg_apc;
+    for (int i = 1; i < argc; i ++) {
+        if (arg_apc[i][0] != '-')
+            continue;
+        if (  (i + 1 >= argc)
+           || (strlen (arg_apc[i]) != 2))
+            return ERROR (-1, "invalid option \"%s\", expecting -w <n>, -r <n> or -t <ms>", arg_apc[i]);
+
+        char*   l_end_pc = NULL;
+        unsigned long l_value_ud = strtoul (arg_apc[i + 1], &l_end_pc, 10);
+        if (  (l_end_pc == arg_apc[i + 1])
+           || (*l_end_pc != '\0'))
+            return ERROR (-1, "invalid value \"%s\" for %s", arg_apc[i + 1], arg_apc[i]);
+
+        switch (arg_apc[i][1]) {
+        case 'w':
+            m_d_nr_warmups_ud = (uint32_t)l_value_ud;
+            break;
+        case 'r':
+            if (  (l_value_ud < 1)
+               || (l_value_ud > M_MAX_REPS))
+                return ERROR (-1, "-r %lu not 1..%u", l_value_ud, M_MAX_REPS);
+            m_d_nr_reps_ud = (uint32_t)l_value_ud;
+            break;
+        case 't':
+            m_d_min_run_ns_ud = (uint64_t)l_value_ud * 1000000ULL;
+            break;
+        default:
+            return ERROR (-1, "unknown option %s", arg_apc[i]);
+        }
+        i ++;   //skip the value
+    }
+    return SUCCESS ();
+}/*bench_r_init()*/
+
+
+extern int bench_r_must_run (
+    const char*                       p_bench_name_pc)
+{
+    int l_nr_names_d = 0;
+    for (int i = 1; i < m_d_argc_d; i ++) {
+        if (m_d_arg_apc[i][0] == '-') {
+            i ++;   //skip option and value
+            continue;
+        }
+        l_nr_names_d ++;
+        if (strstr (p_bench_name_pc, m_d_arg_apc[i]) != NULL)
+            return 1;
+    }
+    return (l_nr_names_d == 0) ? 1 : 0;
+}/*bench_r_must_run()*/
+
+
+extern int bench_r_run (
+    const char*                       p_bench_name_pc,
+          bench_r*                    p_bench_pr)
+{
+    bench_t         l_bench_z;
+
+    /*
+     * calibrate: scale the nr of ops up until one run takes long enough
+     * to not measure the clock, this also warms the caches
+     */
+    uint64_t        l_nr_ops_ud = 1;
+    for (;;) {
+        if (m_r_run_once (p_bench_pr, l_nr_ops_ud, p_bench_name_pc, &l_bench_z) != 0)
+            return ERROR (-1, "bench %s failed", p_bench_name_pc);
+        if (  (l_bench_z.elapsed_ns_ud >= m_d_min_run_ns_ud)
+           || (l_nr_ops_ud >= M_MAX_OPS))
+            break;
+
+        //aim 20% over the min time, at most 100x and at least 2x more ops
+        uint64_t l_next_ud = (l_bench_z.elapsed_ns_ud == 0)
+            ? l_nr_ops_ud * 100
+            : (uint64_t)((double)l_nr_ops_ud * 1.2 * (double)m_d_min_run_ns_ud / (double)l_bench_z.elapsed_ns_ud);
+        if (l_next_ud > l_nr_ops_ud * 100)
+            l_next_ud = l_nr_ops_ud * 100;
+        if (l_next_ud < l_nr_ops_ud * 2)
+            l_next_ud = l_nr_ops_ud * 2;
+        l_nr_ops_ud = (l_next_ud > M_MAX_OPS) ? M_MAX_OPS : l_next_ud;
+    }
+
+    for (uint32_t i = 0; i < m_d_nr_warmups_ud; i ++) {
+        if (m_r_run_once (p_bench_pr, l_nr_ops_ud, p_bench_name_pc, &l_bench_z) != 0)
+            return ERROR (-1, "bench %s failed in warmup", p_bench_name_pc);
+    }
+
+    /*
+     * repetitions: ns/op of each run
+     */
+    double          l_ns_per_op_ad[M_MAX_REPS];
+    for (uint32_t i = 0; i < m_d_nr_reps_ud; i ++) {
+        if (m_r_run_once (p_bench_pr, l_nr_ops_ud, p_bench_name_pc, &l_bench_z) != 0)
+            return ERROR (-1, "bench %s failed in repetition %u", p_bench_name_pc, i + 1);
+        l_ns_per_op_ad[i] = (double)l_bench_z.elapsed_ns_ud / (double)l_nr_ops_ud;
+    }
+    qsort (l_ns_per_op_ad, m_d_nr_reps_ud, sizeof (double), m_r_cmp_double);
+
+    double          l_p50_d = m_r_percentile (l_ns_per_op_ad, m_d_nr_reps_ud, 50);
+    if (!m_d_header_done_d) {
+        printf ("%-40s %10s %10s %10s %10s %10s %10s\n",
+            "bench", "ops/run", "min ns/op", "p50 ns/op", "p90 ns/op", "p99 ns/op", "p50 MB/s");
+        m_d_header_done_d = 1;
+    }
+    printf ("%-40s %10llu %10.1f %10.1f %10.1f %10.1f",
+        p_bench_name_pc,
+        (unsigned long long)l_nr_ops_ud,
+        l_ns_per_op_ad[0],
+        l_p50_d,
+        m_r_percentile (l_ns_per_op_ad, m_d_nr_reps_ud, 90),
+        m_r_percentile (l_ns_per_op_ad, m_d_nr_reps_ud, 99));
+    if (  (l_bench_z.bytes_per_op_ud > 0)
+       && (l_p50_d > 0))
+        printf (" %10.1f\n", (double)l_bench_z.bytes_per_op_ud * 1000.0 / l_p50_d);
+    else
+        printf (" %10s\n", "-");
+    fflush (stdout);
+    return SUCCESS ();
+}/*bench_r_run()*/
+
+
+extern void bench_r_start (
+          bench_t*                    p_bench_pz)
+{
+    p_bench_pz->elapsed_ns_ud = 0;
+    p_bench_pz->running_d     = 1;
+    p_bench_pz->start_ns_ud   = bench_r_now_ns ();
+}/*bench_r_start()*/
+
+
+extern void bench_r_pause (
+          bench_t*                    p_bench_pz)
+{
+    if (!p_bench_pz->running_d)
+        return;
+    p_bench_pz->elapsed_ns_ud += bench_r_now_ns () - p_bench_pz->start_ns_ud;
+    p_bench_pz->running_d      = 0;
+}/*bench_r_pause()*/
+
+
+extern void bench_r_resume (
+          bench_t*                    p_bench_pz)
+{
+    if (p_bench_pz->running_d)
+        return;
+    p_bench_pz->running_d   = 1;
+    p_bench_pz->start_ns_ud = bench_r_now_ns ();
+}/*bench_r_resume()*/
+
+
+extern uint64_t bench_r_now_ns (void)
+{
+    struct timespec l_ts_z;
+    clock_gettime (CLOCK_MONOTONIC, &l_ts_z);
+    return (uint64_t)l_ts_z.tv_sec * 1000000000ULL + (uint64_t)l_ts_z.tv_nsec;
+}/*bench_r_now_ns()*/
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+static int m_r_run_once (
+          bench_r*                    p_bench_pr,
+    const uint64_t                    p_nr_ops_ud,
+    const char*                       p_bench_name_pc,
+          bench_t*                    p_bench_pz)
+{
+    memset (p_bench_pz, 0, sizeof (*p_bench_pz));
+    p_bench_pz->nr_ops_ud = p_nr_ops_ud;
+    bench_r_start (p_bench_pz);
+    if (p_bench_pr (p_bench_pz) != 0)
+        return ERROR (-1, "bench %s failed with %llu ops", p_bench_name_pc, (unsigned long long)p_nr_ops_ud);
+    bench_r_pause (p_bench_pz);
+    return SUCCESS ();
+}/*m_r_run_once()*/
+
+
+static int m_r_cmp_double (
+    const void*                       p_a_p,
+    const void*                       p_b_p)
+{
+    double l_a_d = *(const double*)p_a_p;
+    double l_b_d = *(const double*)p_b_p;
+    return (l_a_d < l_b_d) ? -1 : (l_a_d > l_b_d) ? 1 : 0;
+}/*m_r_cmp_double()*/
+
+
+//nearest rank in sorted values
+static double m_r_percentile (
+    const double*                     p_sorted_ad,
+    const uint32_t                    p_nr_ud,
+    const uint32_t                    p_percent_ud)
+{
+    uint32_t l_rank_ud = (p_percent_ud * p_nr_ud + 99) / 100;
+    if (l_rank_ud < 1)
+        l_rank_ud = 1;
+    return p_sorted_ad[l_rank_ud - 1];
+}/*m_r_percentile()*/
@@ -0,0 +1,110 @@
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "error_stack.h"
+#include <stdint.h>
+#include <string.h>
+
+
+/*****************************************************************************
+ * P U B L I C   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+//state of one run of a benchmark, passed to the BENCH() function
+typedef struct bench_s {
+    uint64_t                    nr_ops_ud;          //ops to do in this run, chosen by the runner
+    uint64_t                    bytes_per_op_ud;    //set by the bench to report bytes/s, 0=not reported
+    uint64_t                    elapsed_ns_ud;      //timed so far, excl paused time
+    uint64_t                    start_ns_ud;        //when timing was (re)started
+    int                         running_d;          //1 while timing
+} bench_t;
+
+typedef int (bench_r) (
+          bench_t*                    p_bench_pz);
+
+
+/*****************************************************************************
+ * P U B L I C   M A C R O   D E F I N I T I O N S
+ *****************************************************************************/
+
+/*
+ * A benchmark does p_bench_pz->nr_ops_ud ops and returns SUCCESS or ERROR.
+ * Timing starts before it is called and stops when it returns. Call
+ * bench_r_start() after setup and bench_r_pause() before cleanup to only
+ * time the ops:
+ *
+ *     BENCH(write_100) {
+ *         ...setup...
+ *         p_bench_pz->bytes_per_op_ud = 100;
+ *         bench_r_start (p_bench_pz);
+ *         for (uint64_t i = 0; i < p_bench_pz->nr_ops_ud; i ++)
+ *             ...one op...
+ *         bench_r_pause (p_bench_pz);
+ *         ...cleanup...
+ *         return SUCCESS ();
+ *     }
+ */
+#define BENCH(name) \
+    static int bench_r_##name (bench_t* p_bench_pz)
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+/*
+ * PURPOSE:
+ *     Read the runner options and the names of benchmarks to run.
+ *     Options:
+ *         -w <n>       Warmup runs, not reported, default 2
+ *         -r <n>       Repetitions reported, default 15
+ *         -t <ms>      Min time of a run, the nr of ops is scaled up
+ *                      until a run takes at least this long, default 20
+ *     Other args select benchmarks with that text in their name,
+ *     without args all are run.
+ *
+ * RETURN:
+ *     SUCCESS or ERROR when an option is not valid
+ */
+extern int bench_r_init (
+    const int                         argc,
+    const char*                       arg_apc[]);
+
+// 1 when selected by the args of bench_r_init()
+extern int bench_r_must_run (
+    const char*                       p_bench_name_pc);
+
+/*
+ * PURPOSE:
+ *     Calibrate the nr of ops per run, do the warmup runs and then the
+ *     repetitions, and print one line with the ns/op of the fastest run,
+ *     the 50th, 90th and 99th percentile of the runs, and bytes/s of the
+ *     median run when the bench set bytes_per_op_ud.
+ *
+ * RETURN:
+ *     SUCCESS or ERROR when the bench failed
+ */
+extern int bench_r_run (
+    const char*                       p_bench_name_pc,
+          bench_r*                    p_bench_pr);
+
+// restart timing from 0, e.g. after setup
+extern void bench_r_start (
+          bench_t*                    p_bench_pz);
+
+// stop timing, e.g. to refill between timed ops
+extern void bench_r_pause (
+          bench_t*                    p_bench_pz);
+
+// continue timing after bench_r_pause()
+extern void bench_r_resume (
+          bench_t*                    p_bench_pz);
+
+// monotonic clock in nanoseconds
+extern uint64_t bench_r_now_ns (void);
+
+#endif /*_BENCH_H_*/
@@ -0,0 +1,232 @@
+#include "hl_blocks.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+
+/*
+ * Baseline benchmarks of hl_blocks against memory as mock flash, for
+ * block sizes, message sizes and min_data_per_part values. Setup and
+ * cleanup are not timed.
+ */
+
+#define M_BENCH_NR_BLOCKS       64
+#define M_BENCH_MAX_MSG_SIZE    4096
+
+static uint32_t            m_d_bench_block_size_ud  = 0;
+static uint32_t            m_d_bench_nr_blocks_ud   = 0;
+static unsigned char*      m_d_bench_flash_auc      = NULL;
+static unsigned char       m_d_bench_msg_auc[M_BENCH_MAX_MSG_SIZE];
+
+static int m_r_bench_open (
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_min_part_size_ud,
+    const hl_blocks_full_mode_e       p_full_mode_e,
+          hl_blocks_t**               p_blocks_ppz);
+
+static int m_r_bench_close (
+          hl_blocks_t**               p_blocks_ppz);
+
+static int m_r_bench_block_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p);
+
+static int m_r_bench_block_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp);
+
+static int m_r_bench_write (
+          bench_t*                    p_bench_pz,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_msg_size_ud,
+    const uint32_t                    p_min_part_size_ud);
+
+static int m_r_bench_read (
+          bench_t*                    p_bench_pz,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_msg_size_ud,
+    const uint32_t                    p_min_part_size_ud);
+
+
+/*
+ * write: one message per op, overwriting the oldest blocks when full so
+ * the writes never stop, incl writing each full block to flash
+ */
+BENCH(write_b512_m16)       { return m_r_bench_write (p_bench_pz,  512,   16, 16); }
+BENCH(write_b512_m100)      { return m_r_bench_write (p_bench_pz,  512,  100, 16); }
+BENCH(write_b512_m1000)     { return m_r_bench_write (p_bench_pz,  512, 1000, 16); }
+BENCH(write_b4096_m16)      { return m_r_bench_write (p_bench_pz, 4096,   16, 16); }
+BENCH(write_b4096_m100)     { return m_r_bench_write (p_bench_pz, 4096,  100, 16); }
+BENCH(write_b4096_m1000)    { return m_r_bench_write (p_bench_pz, 4096, 1000, 16); }
+
+BENCH(write_b512_m100_p4)   { return m_r_bench_write (p_bench_pz,  512,  100,  4); }
+BENCH(write_b512_m100_p64)  { return m_r_bench_write (p_bench_pz,  512,  100, 64); }
+BENCH(write_b512_m100_p256) { return m_r_bench_write (p_bench_pz,  512,  100, 256); }
+
+/*
+ * read: one message per op, from blocks filled with half of the capacity
+ * at a time while the timer is paused
+ */
+BENCH(read_b512_m16)        { return m_r_bench_read (p_bench_pz,  512,   16, 16); }
+BENCH(read_b512_m100)       { return m_r_bench_read (p_bench_pz,  512,  100, 16); }
+BENCH(read_b512_m1000)      { return m_r_bench_read (p_bench_pz,  512, 1000, 16); }
+BENCH(read_b4096_m16)       { return m_r_bench_read (p_bench_pz, 4096,   16, 16); }
+BENCH(read_b4096_m100)      { return m_r_bench_read (p_bench_pz, 4096,  100, 16); }
+BENCH(read_b4096_m1000)     { return m_r_bench_read (p_bench_pz, 4096, 1000, 16); }
+
+BENCH(read_b512_m100_p4)    { return m_r_bench_read (p_bench_pz,  512,  100,  4); }
+BENCH(read_b512_m100_p64)   { return m_r_bench_read (p_bench_pz,  512,  100, 64); }
+BENCH(read_b512_m100_p256)  { return m_r_bench_read (p_bench_pz,  512,  100, 256); }
+
+/*
+ * sync: write a message and sync it to flash, one block write per op
+ */
+BENCH(sync_b512_m100) {
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (m_r_bench_open (512, 16, HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST, &l_blocks_pz) != 0)
+        return ERROR (-1, "bench setup failed");
+
+    p_bench_pz->bytes_per_op_ud = 100;
+    bench_r_start (p_bench_pz);
+    for (uint64_t i = 0; i < p_bench_pz->nr_ops_ud; i ++) {
+        hl_blocks_msg_seq_t     l_seq_ud;
+        if (hl_blocks_r_write (l_blocks_pz, m_d_bench_msg_auc, 100, &l_seq_ud) != 0)
+            return ERROR (-1, "write %llu failed", (unsigned long long)i);
+        if (hl_blocks_r_sync (l_blocks_pz) != 0)
+            return ERROR (-1, "sync %llu failed", (unsigned long long)i);
+    }
+    bench_r_pause (p_bench_pz);
+    return m_r_bench_close (&l_blocks_pz);
+}//BENCH()
+
+
+static int m_r_bench_write (
+          bench_t*                    p_bench_pz,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_msg_size_ud,
+    const uint32_t                    p_min_part_size_ud)
+{
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (m_r_bench_open (p_block_size_ud, p_min_part_size_ud, HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST, &l_blocks_pz) != 0)
+        return ERROR (-1, "bench setup failed");
+
+    p_bench_pz->bytes_per_op_ud = p_msg_size_ud;
+    bench_r_start (p_bench_pz);
+    for (uint64_t i = 0; i < p_bench_pz->nr_ops_ud; i ++) {
+        hl_blocks_msg_seq_t     l_seq_ud;
+        if (hl_blocks_r_write (l_blocks_pz, m_d_bench_msg_auc, p_msg_size_ud, &l_seq_ud) != 0)
+            return ERROR (-1, "write %llu failed", (unsigned long long)i);
+    }
+    bench_r_pause (p_bench_pz);
+    return m_r_bench_close (&l_blocks_pz);
+}/*m_r_bench_write()*/
+
+
+static int m_r_bench_read (
+          bench_t*                    p_bench_pz,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_msg_size_ud,
+    const uint32_t                    p_min_part_size_ud)
+{
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (m_r_bench_open (p_block_size_ud, p_min_part_size_ud, HL_BLOCKS_K_FULL_MODE_REJECT, &l_blocks_pz) != 0)
+        return ERROR (-1, "bench setup failed");
+
+    //half of the capacity, counting a part header per message and per block
+    uint64_t        l_batch_ud = ((uint64_t)M_BENCH_NR_BLOCKS / 2 * p_block_size_ud) / (p_msg_size_ud + 32);
+    if (l_batch_ud < 1)
+        l_batch_ud = 1;
+
+    static unsigned char l_buf_auc[M_BENCH_MAX_MSG_SIZE];
+    p_bench_pz->bytes_per_op_ud = p_msg_size_ud;
+    bench_r_start (p_bench_pz);
+    uint64_t        l_done_ud = 0;
+    while (l_done_ud < p_bench_pz->nr_ops_ud) {
+        uint64_t l_nr_ud = p_bench_pz->nr_ops_ud - l_done_ud;
+        if (l_nr_ud > l_batch_ud)
+            l_nr_ud = l_batch_ud;
+
+        bench_r_pause (p_bench_pz);
+        for (uint64_t i = 0; i < l_nr_ud; i ++) {
+            hl_blocks_msg_seq_t     l_seq_ud;
+            if (hl_blocks_r_write (l_blocks_pz, m_d_bench_msg_auc, p_msg_size_ud, &l_seq_ud) != 0)
+                return ERROR (-1, "write %llu failed", (unsigned long long)(l_done_ud + i));
+        }
+        if (hl_blocks_r_sync (l_blocks_pz) != 0)
+            return ERROR (-1, "sync failed");
+        bench_r_resume (p_bench_pz);
+
+        for (uint64_t i = 0; i < l_nr_ud; i ++) {
+            size_t                  l_size_ud;
+            hl_blocks_msg_seq_t     l_seq_ud;
+            if (hl_blocks_r_read (l_blocks_pz, l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud) != 0)
+                return ERROR (-1, "read %llu failed", (unsigned long long)(l_done_ud + i));
+        }
+        l_done_ud += l_nr_ud;
+    }
+    bench_r_pause (p_bench_pz);
+    return m_r_bench_close (&l_blocks_pz);
+}/*m_r_bench_read()*/
+
+
+static int m_r_bench_open (
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_min_part_size_ud,
+    const hl_blocks_full_mode_e       p_full_mode_e,
+          hl_blocks_t**               p_blocks_ppz)
+{
+    m_d_bench_block_size_ud = p_block_size_ud;
+    m_d_bench_nr_blocks_ud  = M_BENCH_NR_BLOCKS;
+    m_d_bench_flash_auc     = (unsigned char*)calloc (M_BENCH_NR_BLOCKS, p_block_size_ud);
+    if (m_d_bench_flash_auc == NULL)
+        return ERROR (-1, "failed to allocate %u x %u bytes", M_BENCH_NR_BLOCKS, p_block_size_ud);
+    for (uint32_t i = 0; i < sizeof (m_d_bench_msg_auc); i ++)
+        m_d_bench_msg_auc[i] = (unsigned char)('0' + i % 10);
+
+    if (hl_blocks_r_open (
+                p_block_size_ud,
+                M_BENCH_NR_BLOCKS,
+                M_BENCH_MAX_MSG_SIZE,
+                p_min_part_size_ud,
+                m_r_bench_block_write,
+                m_r_bench_block_addr,
+                p_blocks_ppz)
+                != 0)
+        return ERROR (-1, "failed to open blocks");
+    if (hl_blocks_r_set_full_mode (*p_blocks_ppz, p_full_mode_e) != 0)
+        return ERROR (-1, "failed to set full mode %d", p_full_mode_e);
+    return SUCCESS ();
+}/*m_r_bench_open()*/
+
+static int m_r_bench_close (
+          hl_blocks_t**               p_blocks_ppz)
+{
+    if (hl_blocks_r_close (p_blocks_ppz) != 0)
+        return ERROR (-1, "failed to close blocks");
+
+    free (m_d_bench_flash_auc);
+    m_d_bench_flash_auc = NULL;
+    return SUCCESS ();
+}/*m_r_bench_close()*/
+
+static int m_r_bench_block_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p)
+{
+    if (p_idx_ud >= m_d_bench_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_bench_nr_blocks_ud - 1);
+
+    memcpy (m_d_bench_flash_auc + (size_t)m_d_bench_block_size_ud * p_idx_ud, p_block_p, m_d_bench_block_size_ud);
+    return SUCCESS ();
+}/*m_r_bench_block_write()*/
+
+static int m_r_bench_block_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp)
+{
+    if (p_idx_ud >= m_d_bench_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_bench_nr_blocks_ud - 1);
+
+    *p_block_pp = m_d_bench_flash_auc + (size_t)m_d_bench_block_size_ud * p_idx_ud;
+    return SUCCESS ();
+}/*m_r_bench_block_addr()*/
@@ -0,0 +1,29 @@
+#!/bin/bash
+
+function debug() {
+    echo -e $(date "+%Y-%m-%d") DEBUG $* >&2
+}
+
+function error() {
+    echo -e $(date "+%Y-%m-%d") ERROR $* >&2
+    exit 1
+}
+
+# each tool is one file in tools/ with its own main(),
+# linked with the library files it needs
+mkdir -p build
+
+debug "Compiling hl_blocks_inspect ..."
+gcc -O2 -I. tools/hl_blocks_inspect.c hl_blocks_scan.c crc32.c error_stack.c log.c log_format.c -o build/hl_blocks_inspect -lpthread \
+    || error "Failed to compile hl_blocks_inspect"
+
+debug "Compiling hl_blocks_powercut_bench ..."
+gcc -O2 -I. tools/hl_blocks_powercut_bench.c hl_blocks.c hl_blocks_fault.c latency_hist.c crc32.c error_stack.c log.c log_format.c -o build/hl_blocks_powercut_bench -lpthread \
+    || error "Failed to compile hl_blocks_powercut_bench"
+
+debug "Compiling hl_blocks_trace_replay ..."
+gcc -O2 -I. tools/hl_blocks_trace_replay.c hl_blocks.c hl_blocks_fault.c hl_blocks_flashsim.c hl_blocks_trace.c latency_hist.c crc32.c error_stack.c log.c log_format.c -o build/hl_blocks_trace_replay -lpthread \
+    || error "Failed to compile hl_blocks_trace_replay"
+
+debug "PASSED"
+exit 0
@@ -0,0 +1,75 @@
+#!/bin/bash
+
+function debug() {
+    echo -e $(date "+%Y-%m-%d") DEBUG $* >&2
+}
+
+function error() {
+    echo -e $(date "+%Y-%m-%d") ERROR $* >&2
+    exit 1
+}
+
+# same as ctest.sh for BENCH() in bench_*.c, compiled with -O2,
+# args are passed to the bench program, see bench_r_init() in bench.h
+
+debug "Getting bench names ..."
+bench_names=$(mktemp)
+grep -hoe "^BENCH([A-Za-z0-9_]*)" bench_*.c | sed "s/BENCH(\(.*\))/\1/" > ${bench_names}
+
+debug "Got $(wc -l ${bench_names} | awk '{print $1}') bench names"
+
+bench_main="generated_main_bench_program.c"
+cat << EOF > ${bench_main}
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "error_stack.h"
+
+// include bench files:
+EOF
+
+ls -1 bench_*.c | sed "s/^/#include \"/;s/\$/\"/" >> ${bench_main}
+
+cat << EOF >> ${bench_main}
+
+// main bench function to run all benchmarks
+int main(int argc, const char* arg_apc[]) {
+    if (bench_r_init (argc, arg_apc) != 0) {
+        error_stack_r_print (stderr);
+        exit (1);
+    }
+    //calling all benchmarks:
+EOF
+
+# call all the benchmarks
+cat ${bench_names} | \
+awk '{print "\
+    if (bench_r_must_run (\"" $1 "\")) {\n\
+        if (bench_r_run (\"" $1 "\", bench_r_" $1 ") != 0)\n\
+        {\n\
+            printf (\"" $1 " FAILED.\\n\");\n\
+            error_stack_r_print (stderr);\n\
+            exit (1);\n\
+        }\n\
+    }\n\
+    "\
+}' >> ${bench_main}
+
+cat << EOF >> ${bench_main}
+    return SUCCESS();
+}/*main*/
+EOF
+
+rm -f ${bench_names}
+
+# library files, without the tests and the bench files included above
+lib_files=$(ls -1 *.c | grep -v "^test_\|^bench_\|^generated_main_")
+
+debug "Compiling..."
+mkdir -p build
+gcc -O2 -I. ${bench_main} ${lib_files} -o build/bench_main -lpthread || error "Failed to compile"
+
+debug "Running..."
+./build/bench_main $* || error "Benchmarks failed"
+debug "PASSED"
+exit 0
@@ -79,7 +79,7 @@ EOF
 rm -f ${test_names}
 
 debug "Compiling..."
-gcc *.c -o test_main || error "Failed to compile"
+gcc $(ls -1 *.c | grep -v "^bench\|^generated_main_bench_program.c$") -o test_main -lpthread || error "Failed to compile"
 
 debug "Running..."
 ./test_main $* || error "Tests failed"
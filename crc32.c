@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "crc32.h"
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+#define M_CRC32_POLY                0xEDB88320
+
+static uint32_t             m_d_table_aud[256];
+static int                  m_d_table_ready_d       = 0;
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static void m_r_make_table (void);
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+extern uint32_t crc32_r_update (
+    const uint32_t                    p_crc_ud,
+    const void*                       p_data_p,
+    const size_t                      p_size_ud)
+{
+    if (!m_d_table_ready_d)
+        m_r_make_table ();
+
+    const unsigned char* l_data_puc = (const unsigned char*)p_data_p;
+    uint32_t l_crc_ud = ~p_crc_ud;
+    for (size_t l_ofs_ud = 0; l_ofs_ud < p_size_ud; l_ofs_ud++)
+        l_crc_ud = m_d_table_aud[(l_crc_ud ^ l_data_puc[l_ofs_ud]) & 0xFF] ^ (l_crc_ud >> 8);
+    return ~l_crc_ud;
+}/*crc32_r_update()*/
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+//threads making the table at the same time write the same values
+static void m_r_make_table (void)
+{
+    for (uint32_t l_byte_ud = 0; l_byte_ud < 256; l_byte_ud++) {
+        uint32_t l_crc_ud = l_byte_ud;
+        for (int l_bit_d = 0; l_bit_d < 8; l_bit_d++)
+            l_crc_ud = (l_crc_ud & 1) ? (M_CRC32_POLY ^ (l_crc_ud >> 1)) : (l_crc_ud >> 1);
+        m_d_table_aud[l_byte_ud] = l_crc_ud;
+    }
+    m_d_table_ready_d = 1;
+}/*m_r_make_table()*/
@@ -0,0 +1,38 @@
+#ifndef _CRC32_H_
+#define _CRC32_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+/*
+ * PURPOSE:
+ *     Calculate the CRC-32 (IEEE 802.3, same as zlib crc32()) of data,
+ *     in one call or in pieces.
+ *
+ *     Usage:
+ *         uint32_t crc = crc32_r_update (0, data, size);
+ *         crc = crc32_r_update (crc, more_data, more_size);
+ *
+ * PARAMETERS:
+ *     p_crc_ud                 0 to start or the CRC of the data before
+ *     p_data_p                 Data to add
+ *     p_size_ud                Nr of bytes to add
+ *
+ * RETURN:
+ *     CRC of all data so far
+ */
+extern uint32_t crc32_r_update (
+    const uint32_t                    p_crc_ud,
+    const void*                       p_data_p,
+    const size_t                      p_size_ud);
+
+#endif /*_CRC32_H_*/
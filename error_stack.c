@@ -1,9 +1,13 @@
 #include "error_stack.h"
+#include "log_format.h"
+#include <pthread.h>
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
 
-#define M_STACK_ENTRY_FILE_SIZE       120   //128-4-4
-#define M_STACK_ENTRY_TEXT_SIZE       128
+#define M_STACK_ENTRY_MAX_ARGS        8     //args kept per entry, incl * width/precision
+#define M_STACK_ENTRY_STR_SIZE        96    //bytes for the copies of %s args
 
 
 // maximum stack entries allowed
@@ -15,16 +19,34 @@
  *   L O C A L   D A T A   T Y P E   D E F I N I T I O N S
  *****************************************************************************/
 
+typedef struct m_arg_s {
+    log_format_arg_e            type_e;
+    log_format_value_t          u;          //except str_pc
+    unsigned int                str_ofs_ud; //in str_ac
+} m_arg_t;
+
+// the text is only formatted when printed, so an entry keeps the format
+// and a copy of the arguments: creating an entry costs a few stores,
+// because many errors are expected and never printed, e.g. nothing to read
 typedef struct m_stack_entry_s {
-    // bytes 0..128
-    char                        file_ac[M_STACK_ENTRY_FILE_SIZE];
+    const char*                 file_pc;    //__FILE__, so always valid
     int                         line_d;
     int                         code_d;
-    // bytes 128..256
-    char                        text_ac[M_STACK_ENTRY_TEXT_SIZE];
+    const char*                 format_pc;  //string literal, so always valid
+    unsigned int                nr_args_ud;
+    int                         truncated_d;//1 when the format has more args than kept
+    unsigned int                str_used_ud;
+    m_arg_t                     arg_az[M_STACK_ENTRY_MAX_ARGS];
+    char                        str_ac[M_STACK_ENTRY_STR_SIZE];
 } m_stack_entry_t;
 
-// error stack must be initialised for each thread to use its own stack
+// position while printing an entry
+typedef struct m_print_s {
+    const m_stack_entry_t*      entry_pz;
+    unsigned int                arg_idx_ud;
+} m_print_t;
+
+// each thread has its own stack, made on first use and freed at thread exit
 struct error_stack_s {
     unsigned int                depth_ud; //nr of entries
     m_stack_entry_t             entry_az[M_STACK_MAX_DEPTH];
@@ -35,16 +57,33 @@ struct error_stack_s {
  *   L O C A L   D A T A    D E F I N I T I O N S
  *****************************************************************************/
 
-static error_stack_t*           m_d_error_stack_pz = NULL;
+static _Thread_local error_stack_t* m_d_error_stack_pz = NULL;
+
+// only to free the stack of each thread when it exits
+static pthread_key_t            m_d_free_key_z;
+static pthread_once_t           m_d_free_key_once_z = PTHREAD_ONCE_INIT;
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static error_stack_t* m_r_get_stack (void);
+
+static void m_r_make_free_key (void);
+
+static void m_r_free_stack (
+          void*                       p_stack_p);
+
+static int m_r_next_arg (
+          void*                       p_context_p,
+    const log_format_arg_e            p_type_e,
+          log_format_value_t*         p_value_pz);
 
 
 extern void error_stack_r_init (void)
 {
-    m_d_error_stack_pz = (error_stack_t*)malloc (sizeof (error_stack_t));
-    if (m_d_error_stack_pz == NULL) {
-        fprintf (stderr, "error_stack_r_init: out of memory\n");
-        exit (1);
-    }
+    m_r_get_stack ()->depth_ud = 0;
 }/*error_stack_r_init()*/
 
 
@@ -75,37 +114,62 @@ extern int error (
         return p_code_d;
     }
 
-    if (m_d_error_stack_pz == NULL) {
-        error_stack_r_init ();
-    }
+    error_stack_t*              l_stack_pz = m_r_get_stack ();
 
     // get next stack entry, not exceeding depth
-    if (m_d_error_stack_pz->depth_ud >= M_STACK_MAX_DEPTH) {
-        m_d_error_stack_pz->depth_ud = M_STACK_MAX_DEPTH - 1;
+    if (l_stack_pz->depth_ud >= M_STACK_MAX_DEPTH) {
+        l_stack_pz->depth_ud = M_STACK_MAX_DEPTH - 1;
     }
-    m_stack_entry_t*            l_entry_pz = &m_d_error_stack_pz->entry_az[m_d_error_stack_pz->depth_ud];
+    m_stack_entry_t*            l_entry_pz = &l_stack_pz->entry_az[l_stack_pz->depth_ud];
 
-    // write the file name, using the last part if too long
-    size_t                      l_file_len_ud = strlen (p_file_pc);
-    size_t                      l_file_ofs_ud = 0;
-    if (l_file_len_ud > M_STACK_ENTRY_FILE_SIZE - 1) {
-        l_file_ofs_ud = l_file_len_ud - M_STACK_ENTRY_FILE_SIZE;
-    }
-    strlcpy (
-        l_entry_pz->file_ac,
-        p_file_pc + l_file_ofs_ud,
-        sizeof (l_entry_pz->file_ac));
-
-    l_entry_pz->line_d = p_line_d;
-    l_entry_pz->code_d = p_code_d;
+    l_entry_pz->file_pc     = p_file_pc;
+    l_entry_pz->line_d      = p_line_d;
+    l_entry_pz->code_d      = p_code_d;
+    l_entry_pz->format_pc   = p_format_pc;
+    l_entry_pz->nr_args_ud  = 0;
+    l_entry_pz->truncated_d = 0;
+    l_entry_pz->str_used_ud = 0;
 
-    // write the formatted text, truncating if too long
+    // keep the arguments to format when printed
     va_list                     l_va_list_z;
     va_start (l_va_list_z, p_format_pc);
-    vsnprintf(l_entry_pz->text_ac, sizeof (l_entry_pz->text_ac), p_format_pc, l_va_list_z);
+    log_format_spec_t           l_spec_z;
+    const char*                 l_next_pc = p_format_pc;
+    while ((l_next_pc = log_format_r_next_spec (l_next_pc, &l_spec_z)) != NULL) {
+        if (l_spec_z.type_e == LOG_FORMAT_K_ARG_NONE)
+            continue;
+        if (l_entry_pz->nr_args_ud + l_spec_z.nr_stars_ud + 1 > M_STACK_ENTRY_MAX_ARGS) {
+            l_entry_pz->truncated_d = 1;
+            break;
+        }
+
+        for (unsigned int l_star_ud = 0; l_star_ud < l_spec_z.nr_stars_ud; l_star_ud++) {
+            m_arg_t* l_arg_pz = &l_entry_pz->arg_az[l_entry_pz->nr_args_ud++];
+            l_arg_pz->type_e = LOG_FORMAT_K_ARG_INT;
+            l_arg_pz->u.d    = va_arg (l_va_list_z, int);
+        }
+
+        m_arg_t* l_arg_pz = &l_entry_pz->arg_az[l_entry_pz->nr_args_ud++];
+        l_arg_pz->type_e = l_spec_z.type_e;
+        log_format_r_get_arg (&l_va_list_z, l_spec_z.type_e, &l_arg_pz->u);
+        if (l_spec_z.type_e == LOG_FORMAT_K_ARG_STR) {
+            // copy what fits, the caller's string may be gone when printed
+            unsigned int l_free_ud = M_STACK_ENTRY_STR_SIZE - l_entry_pz->str_used_ud;
+            if (l_free_ud <= 1) {
+                l_entry_pz->str_ac[M_STACK_ENTRY_STR_SIZE - 1] = '\0';
+                l_arg_pz->str_ofs_ud = M_STACK_ENTRY_STR_SIZE - 1;
+                continue;
+            }
+            size_t l_len_ud = strnlen (l_arg_pz->u.str_pc, l_free_ud - 1);
+            memcpy (l_entry_pz->str_ac + l_entry_pz->str_used_ud, l_arg_pz->u.str_pc, l_len_ud);
+            l_entry_pz->str_ac[l_entry_pz->str_used_ud + l_len_ud] = '\0';
+            l_arg_pz->str_ofs_ud = l_entry_pz->str_used_ud;
+            l_entry_pz->str_used_ud += (unsigned int)l_len_ud + 1;
+        }
+    }/*while more conversions*/
     va_end(l_va_list_z);
 
-    m_d_error_stack_pz->depth_ud++;
+    l_stack_pz->depth_ud++;
     return p_code_d;
 }/*error()*/
 
@@ -113,21 +177,128 @@ extern int error (
 extern void error_stack_r_print (
           FILE*                       p_file_fp)
 {
-    if (m_d_error_stack_pz == NULL) {
+    error_stack_r_print_snapshot (p_file_fp, m_d_error_stack_pz);
+}/*error_stack_r_print()*/
+
+
+extern error_stack_t* error_stack_r_snapshot (void)
+{
+    error_stack_t* l_copy_pz = (error_stack_t*)malloc (sizeof (error_stack_t));
+    if (l_copy_pz == NULL)
+        return NULL;
+    l_copy_pz->depth_ud = 0;
+    if (m_d_error_stack_pz != NULL) {
+        l_copy_pz->depth_ud = m_d_error_stack_pz->depth_ud;
+        memcpy (l_copy_pz->entry_az, m_d_error_stack_pz->entry_az, l_copy_pz->depth_ud * sizeof (m_stack_entry_t));
+    }
+    return l_copy_pz;
+}/*error_stack_r_snapshot()*/
+
+
+extern int error_stack_r_propagate (
+    const error_stack_t*              p_snapshot_pz)
+{
+    if (  (p_snapshot_pz == NULL)
+       || (p_snapshot_pz->depth_ud == 0))
+        return -1;
+
+    // add the entries after those of this thread, the deepest first,
+    // replacing the top entry when full like error()
+    error_stack_t*              l_stack_pz = m_r_get_stack ();
+    for (unsigned int l_idx_ud = 0; l_idx_ud < p_snapshot_pz->depth_ud; l_idx_ud++) {
+        if (l_stack_pz->depth_ud >= M_STACK_MAX_DEPTH) {
+            l_stack_pz->depth_ud = M_STACK_MAX_DEPTH - 1;
+        }
+        l_stack_pz->entry_az[l_stack_pz->depth_ud++] = p_snapshot_pz->entry_az[l_idx_ud];
+    }
+    return p_snapshot_pz->entry_az[p_snapshot_pz->depth_ud - 1].code_d;
+}/*error_stack_r_propagate()*/
+
+
+extern void error_stack_r_free (
+          error_stack_t*              p_snapshot_pz)
+{
+    free (p_snapshot_pz);
+}/*error_stack_r_free()*/
+
+
+extern void error_stack_r_print_snapshot (
+          FILE*                       p_file_fp,
+    const error_stack_t*              p_stack_pz)
+{
+    if (p_stack_pz == NULL) {
         fprintf (p_file_fp, "No error stack to print\n");
         return;
     }
 
     // print the stack entries from last to first
-    unsigned int                l_depth_ud = m_d_error_stack_pz->depth_ud;
+    unsigned int                l_depth_ud = p_stack_pz->depth_ud;
     while (l_depth_ud > 0) {
         l_depth_ud --;
 
-        const m_stack_entry_t*      l_entry_pz = &m_d_error_stack_pz->entry_az[l_depth_ud];
-        fprintf (p_file_fp, "  ERR[%d]: %s(%d): %s\n",
+        const m_stack_entry_t*      l_entry_pz = &p_stack_pz->entry_az[l_depth_ud];
+        fprintf (p_file_fp, "  ERR[%d]: %s(%d): ",
             l_depth_ud,
-            l_entry_pz->file_ac,
-            l_entry_pz->line_d,
-            l_entry_pz->text_ac);
+            l_entry_pz->file_pc,
+            l_entry_pz->line_d);
+        m_print_t                   l_print_z = {l_entry_pz, 0};
+        if (  (log_format_r_print (p_file_fp, l_entry_pz->format_pc, m_r_next_arg, &l_print_z) == 0)
+           && (l_entry_pz->truncated_d))
+            fprintf (p_file_fp, " (args truncated)");
+        fprintf (p_file_fp, "\n");
     }/*while step through entries*/
-}/*error_stack_r_print()*/
+}/*error_stack_r_print_snapshot()*/
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************/
+
+// stack of this thread, made on first use
+static error_stack_t* m_r_get_stack (void)
+{
+    if (m_d_error_stack_pz == NULL) {
+        m_d_error_stack_pz = (error_stack_t*)malloc (sizeof (error_stack_t));
+        if (m_d_error_stack_pz == NULL) {
+            fprintf (stderr, "error_stack: out of memory\n");
+            exit (1);
+        }
+        m_d_error_stack_pz->depth_ud = 0;
+
+        pthread_once (&m_d_free_key_once_z, m_r_make_free_key);
+        pthread_setspecific (m_d_free_key_z, m_d_error_stack_pz);
+    }
+    return m_d_error_stack_pz;
+}/*m_r_get_stack()*/
+
+
+static void m_r_make_free_key (void)
+{
+    pthread_key_create (&m_d_free_key_z, m_r_free_stack);
+}/*m_r_make_free_key()*/
+
+
+// called when a thread exits
+static void m_r_free_stack (
+          void*                       p_stack_p)
+{
+    free (p_stack_p);
+    m_d_error_stack_pz = NULL;
+}/*m_r_free_stack()*/
+
+
+// next kept argument of the entry being printed
+static int m_r_next_arg (
+          void*                       p_context_p,
+    const log_format_arg_e            p_type_e,
+          log_format_value_t*         p_value_pz)
+{
+    m_print_t* l_print_pz = (m_print_t*)p_context_p;
+    if (l_print_pz->arg_idx_ud >= l_print_pz->entry_pz->nr_args_ud)
+        return -1;
+    const m_arg_t* l_arg_pz = &l_print_pz->entry_pz->arg_az[l_print_pz->arg_idx_ud++];
+    *p_value_pz = l_arg_pz->u;
+    if (p_type_e == LOG_FORMAT_K_ARG_STR)
+        p_value_pz->str_pc = l_print_pz->entry_pz->str_ac + l_arg_pz->str_ofs_ud;
+    return 0;
+}/*m_r_next_arg()*/
@@ -32,9 +32,9 @@ typedef struct error_stack_s error_stack_t;
  * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
  *****************************************************************************/
 
-// allocates an error stack for this thread
-// call at start of main and each child thread
-// it sets static data to use for the rest of the thread
+// clears the error stack of this thread
+// each thread has its own stack, made on first use and freed when the
+// thread exits, so calling this is optional
 // it will exit the process if no more memory is available
 extern void error_stack_r_init (void);
 
@@ -53,4 +53,22 @@ extern int error (
 extern void error_stack_r_print (
           FILE*                       p_file_fp);
 
+// copy the error stack of this thread, e.g. in a worker thread that failed,
+// to pass to another thread
+// free with error_stack_r_free(), returns NULL when out of memory
+extern error_stack_t* error_stack_r_snapshot (void);
+
+// add the entries of a snapshot to the error stack of this thread,
+// e.g. after joining the worker thread, then add an ERROR() as usual
+// returns the code of the last entry in the snapshot, -1 when empty
+extern int error_stack_r_propagate (
+    const error_stack_t*              p_snapshot_pz);
+
+extern void error_stack_r_free (
+          error_stack_t*              p_snapshot_pz);
+
+extern void error_stack_r_print_snapshot (
+          FILE*                       p_file_fp,
+    const error_stack_t*              p_snapshot_pz);
+
 #endif /*_ERROR_STACK_H_*/
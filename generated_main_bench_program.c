@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "error_stack.h"
+
+// include bench files:
+#include "bench_hl_blocks.c"
+
+// main bench function to run all benchmarks
+int main(int argc, const char* arg_apc[]) {
+    if (bench_r_init (argc, arg_apc) != 0) {
+        error_stack_r_print (stderr);
+        exit (1);
+    }
+    //calling all benchmarks:
+    if (bench_r_must_run ("write_b512_m16")) {
+        if (bench_r_run ("write_b512_m16", bench_r_write_b512_m16) != 0)
+        {
+            printf ("write_b512_m16 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("write_b512_m100")) {
+        if (bench_r_run ("write_b512_m100", bench_r_write_b512_m100) != 0)
+        {
+            printf ("write_b512_m100 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("write_b512_m1000")) {
+        if (bench_r_run ("write_b512_m1000", bench_r_write_b512_m1000) != 0)
+        {
+            printf ("write_b512_m1000 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("write_b4096_m16")) {
+        if (bench_r_run ("write_b4096_m16", bench_r_write_b4096_m16) != 0)
+        {
+            printf ("write_b4096_m16 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("write_b4096_m100")) {
+        if (bench_r_run ("write_b4096_m100", bench_r_write_b4096_m100) != 0)
+        {
+            printf ("write_b4096_m100 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("write_b4096_m1000")) {
+        if (bench_r_run ("write_b4096_m1000", bench_r_write_b4096_m1000) != 0)
+        {
+            printf ("write_b4096_m1000 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("write_b512_m100_p4")) {
+        if (bench_r_run ("write_b512_m100_p4", bench_r_write_b512_m100_p4) != 0)
+        {
+            printf ("write_b512_m100_p4 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("write_b512_m100_p64")) {
+        if (bench_r_run ("write_b512_m100_p64", bench_r_write_b512_m100_p64) != 0)
+        {
+            printf ("write_b512_m100_p64 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("write_b512_m100_p256")) {
+        if (bench_r_run ("write_b512_m100_p256", bench_r_write_b512_m100_p256) != 0)
+        {
+            printf ("write_b512_m100_p256 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("read_b512_m16")) {
+        if (bench_r_run ("read_b512_m16", bench_r_read_b512_m16) != 0)
+        {
+            printf ("read_b512_m16 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("read_b512_m100")) {
+        if (bench_r_run ("read_b512_m100", bench_r_read_b512_m100) != 0)
+        {
+            printf ("read_b512_m100 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("read_b512_m1000")) {
+        if (bench_r_run ("read_b512_m1000", bench_r_read_b512_m1000) != 0)
+        {
+            printf ("read_b512_m1000 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("read_b4096_m16")) {
+        if (bench_r_run ("read_b4096_m16", bench_r_read_b4096_m16) != 0)
+        {
+            printf ("read_b4096_m16 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("read_b4096_m100")) {
+        if (bench_r_run ("read_b4096_m100", bench_r_read_b4096_m100) != 0)
+        {
+            printf ("read_b4096_m100 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("read_b4096_m1000")) {
+        if (bench_r_run ("read_b4096_m1000", bench_r_read_b4096_m1000) != 0)
+        {
+            printf ("read_b4096_m1000 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("read_b512_m100_p4")) {
+        if (bench_r_run ("read_b512_m100_p4", bench_r_read_b512_m100_p4) != 0)
+        {
+            printf ("read_b512_m100_p4 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("read_b512_m100_p64")) {
+        if (bench_r_run ("read_b512_m100_p64", bench_r_read_b512_m100_p64) != 0)
+        {
+            printf ("read_b512_m100_p64 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("read_b512_m100_p256")) {
+        if (bench_r_run ("read_b512_m100_p256", bench_r_read_b512_m100_p256) != 0)
+        {
+            printf ("read_b512_m100_p256 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    if (bench_r_must_run ("sync_b512_m100")) {
+        if (bench_r_run ("sync_b512_m100", bench_r_sync_b512_m100) != 0)
+        {
+            printf ("sync_b512_m100 FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        }
+    }
+    
+    return SUCCESS();
+}/*main*/
@@ -3,7 +3,15 @@
 #include "error_stack.h"
 
 // include test files:
+#include "test_error_stack.c"
+#include "test_hl_blocks_fault.c"
+#include "test_hl_blocks_flashsim.c"
+#include "test_hl_blocks_mmap.c"
+#include "test_hl_blocks_scan.c"
+#include "test_hl_blocks_trace.c"
+#include "test_hl_blocks_uring.c"
 #include "test_hl_qspi_mem.c"
+#include "test_log.c"
 
 static int m_r_must_run_test (
     const int argc,
@@ -25,6 +33,150 @@ static int m_r_must_run_test (
 // main test function to run all tests
 int main(int argc, const char* arg_apc[]) {
     //calling all tests:
+    if (m_r_must_run_test (argc, arg_apc, "test_r_error_stack_format_when_printed")) {
+        printf("\n\n===== TEST: test_r_error_stack_format_when_printed ======\n");
+        if (test_r_error_stack_format_when_printed() != 0)
+        {
+            printf ("test_r_error_stack_format_when_printed FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_error_stack_format_when_printed PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_error_stack_per_thread_and_propagate")) {
+        printf("\n\n===== TEST: test_r_error_stack_per_thread_and_propagate ======\n");
+        if (test_r_error_stack_per_thread_and_propagate() != 0)
+        {
+            printf ("test_r_error_stack_per_thread_and_propagate FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_error_stack_per_thread_and_propagate PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_fault_power_cut_on_each_write")) {
+        printf("\n\n===== TEST: test_r_fault_power_cut_on_each_write ======\n");
+        if (test_r_fault_power_cut_on_each_write() != 0)
+        {
+            printf ("test_r_fault_power_cut_on_each_write FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_fault_power_cut_on_each_write PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_fault_torn_write_reaches_flash_partly")) {
+        printf("\n\n===== TEST: test_r_fault_torn_write_reaches_flash_partly ======\n");
+        if (test_r_fault_torn_write_reaches_flash_partly() != 0)
+        {
+            printf ("test_r_fault_torn_write_reaches_flash_partly FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_fault_torn_write_reaches_flash_partly PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_flashsim_program_and_erase")) {
+        printf("\n\n===== TEST: test_r_flashsim_program_and_erase ======\n");
+        if (test_r_flashsim_program_and_erase() != 0)
+        {
+            printf ("test_r_flashsim_program_and_erase FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_flashsim_program_and_erase PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_flashsim_nor_ring")) {
+        printf("\n\n===== TEST: test_r_flashsim_nor_ring ======\n");
+        if (test_r_flashsim_nor_ring() != 0)
+        {
+            printf ("test_r_flashsim_nor_ring FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_flashsim_nor_ring PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_mmap_write_close_reopen_and_read")) {
+        printf("\n\n===== TEST: test_r_mmap_write_close_reopen_and_read ======\n");
+        if (test_r_mmap_write_close_reopen_and_read() != 0)
+        {
+            printf ("test_r_mmap_write_close_reopen_and_read FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_mmap_write_close_reopen_and_read PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_mmap_addr_is_file_data")) {
+        printf("\n\n===== TEST: test_r_mmap_addr_is_file_data ======\n");
+        if (test_r_mmap_addr_is_file_data() != 0)
+        {
+            printf ("test_r_mmap_addr_is_file_data FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_mmap_addr_is_file_data PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_scan_image_and_export")) {
+        printf("\n\n===== TEST: test_r_scan_image_and_export ======\n");
+        if (test_r_scan_image_and_export() != 0)
+        {
+            printf ("test_r_scan_image_and_export FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_scan_image_and_export PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_trace_record_and_replay")) {
+        printf("\n\n===== TEST: test_r_trace_record_and_replay ======\n");
+        if (test_r_trace_record_and_replay() != 0)
+        {
+            printf ("test_r_trace_record_and_replay FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_trace_record_and_replay PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_uring_write_close_reopen_and_read")) {
+        printf("\n\n===== TEST: test_r_uring_write_close_reopen_and_read ======\n");
+        if (test_r_uring_write_close_reopen_and_read() != 0)
+        {
+            printf ("test_r_uring_write_close_reopen_and_read FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_uring_write_close_reopen_and_read PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_uring_unaligned_blocks_in_file")) {
+        printf("\n\n===== TEST: test_r_uring_unaligned_blocks_in_file ======\n");
+        if (test_r_uring_unaligned_blocks_in_file() != 0)
+        {
+            printf ("test_r_uring_unaligned_blocks_in_file FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_uring_unaligned_blocks_in_file PASSED.\n");
+        }
+    }
+    
     if (m_r_must_run_test (argc, arg_apc, "test_r_write_first_small_and_read_from_heap")) {
         printf("\n\n===== TEST: test_r_write_first_small_and_read_from_heap ======\n");
         if (test_r_write_first_small_and_read_from_heap() != 0)
@@ -145,5 +297,293 @@ int main(int argc, const char* arg_apc[]) {
         }
     }
     
+    if (m_r_must_run_test (argc, arg_apc, "test_r_overwrite_oldest_when_full")) {
+        printf("\n\n===== TEST: test_r_overwrite_oldest_when_full ======\n");
+        if (test_r_overwrite_oldest_when_full() != 0)
+        {
+            printf ("test_r_overwrite_oldest_when_full FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_overwrite_oldest_when_full PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_overwrite_oldest_with_spanning_messages")) {
+        printf("\n\n===== TEST: test_r_overwrite_oldest_with_spanning_messages ======\n");
+        if (test_r_overwrite_oldest_with_spanning_messages() != 0)
+        {
+            printf ("test_r_overwrite_oldest_with_spanning_messages FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_overwrite_oldest_with_spanning_messages PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_prio_read_highest_first")) {
+        printf("\n\n===== TEST: test_r_prio_read_highest_first ======\n");
+        if (test_r_prio_read_highest_first() != 0)
+        {
+            printf ("test_r_prio_read_highest_first FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_prio_read_highest_first PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_prio_cold_start_and_rotation")) {
+        printf("\n\n===== TEST: test_r_prio_cold_start_and_rotation ======\n");
+        if (test_r_prio_cold_start_and_rotation() != 0)
+        {
+            printf ("test_r_prio_cold_start_and_rotation FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_prio_cold_start_and_rotation PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_drain_fd_with_framing_in_small_writes")) {
+        printf("\n\n===== TEST: test_r_drain_fd_with_framing_in_small_writes ======\n");
+        if (test_r_drain_fd_with_framing_in_small_writes() != 0)
+        {
+            printf ("test_r_drain_fd_with_framing_in_small_writes FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_drain_fd_with_framing_in_small_writes PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_checkpoint_resume_at_read_offset")) {
+        printf("\n\n===== TEST: test_r_checkpoint_resume_at_read_offset ======\n");
+        if (test_r_checkpoint_resume_at_read_offset() != 0)
+        {
+            printf ("test_r_checkpoint_resume_at_read_offset FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_checkpoint_resume_at_read_offset PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_checkpoint_roll_forward_after_power_cut")) {
+        printf("\n\n===== TEST: test_r_checkpoint_roll_forward_after_power_cut ======\n");
+        if (test_r_checkpoint_roll_forward_after_power_cut() != 0)
+        {
+            printf ("test_r_checkpoint_roll_forward_after_power_cut FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_checkpoint_roll_forward_after_power_cut PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_checkpoint_on_sync_or_every_blocks")) {
+        printf("\n\n===== TEST: test_r_checkpoint_on_sync_or_every_blocks ======\n");
+        if (test_r_checkpoint_on_sync_or_every_blocks() != 0)
+        {
+            printf ("test_r_checkpoint_on_sync_or_every_blocks FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_checkpoint_on_sync_or_every_blocks PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_stats_count_writes_syncs_and_reads")) {
+        printf("\n\n===== TEST: test_r_stats_count_writes_syncs_and_reads ======\n");
+        if (test_r_stats_count_writes_syncs_and_reads() != 0)
+        {
+            printf ("test_r_stats_count_writes_syncs_and_reads FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_stats_count_writes_syncs_and_reads PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_latency_histograms_and_reset")) {
+        printf("\n\n===== TEST: test_r_latency_histograms_and_reset ======\n");
+        if (test_r_latency_histograms_and_reset() != 0)
+        {
+            printf ("test_r_latency_histograms_and_reset FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_latency_histograms_and_reset PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_whole_messages_not_split")) {
+        printf("\n\n===== TEST: test_r_whole_messages_not_split ======\n");
+        if (test_r_whole_messages_not_split() != 0)
+        {
+            printf ("test_r_whole_messages_not_split FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_whole_messages_not_split PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_direct_writev_of_large_messages")) {
+        printf("\n\n===== TEST: test_r_direct_writev_of_large_messages ======\n");
+        if (test_r_direct_writev_of_large_messages() != 0)
+        {
+            printf ("test_r_direct_writev_of_large_messages FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_direct_writev_of_large_messages PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_aligned_message_data")) {
+        printf("\n\n===== TEST: test_r_aligned_message_data ======\n");
+        if (test_r_aligned_message_data() != 0)
+        {
+            printf ("test_r_aligned_message_data FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_aligned_message_data PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_linear_mapped_flash_without_addr_pr")) {
+        printf("\n\n===== TEST: test_r_linear_mapped_flash_without_addr_pr ======\n");
+        if (test_r_linear_mapped_flash_without_addr_pr() != 0)
+        {
+            printf ("test_r_linear_mapped_flash_without_addr_pr FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_linear_mapped_flash_without_addr_pr PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_tagged_messages_filtered_read")) {
+        printf("\n\n===== TEST: test_r_tagged_messages_filtered_read ======\n");
+        if (test_r_tagged_messages_filtered_read() != 0)
+        {
+            printf ("test_r_tagged_messages_filtered_read FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_tagged_messages_filtered_read PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_overwrite_oldest_keeps_reads_consistent")) {
+        printf("\n\n===== TEST: test_r_overwrite_oldest_keeps_reads_consistent ======\n");
+        if (test_r_overwrite_oldest_keeps_reads_consistent() != 0)
+        {
+            printf ("test_r_overwrite_oldest_keeps_reads_consistent FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_overwrite_oldest_keeps_reads_consistent PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_prio_full_keeps_space_to_sync_all_lanes")) {
+        printf("\n\n===== TEST: test_r_prio_full_keeps_space_to_sync_all_lanes ======\n");
+        if (test_r_prio_full_keeps_space_to_sync_all_lanes() != 0)
+        {
+            printf ("test_r_prio_full_keeps_space_to_sync_all_lanes FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_prio_full_keeps_space_to_sync_all_lanes PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_legacy_blocks_without_crc_are_read")) {
+        printf("\n\n===== TEST: test_r_legacy_blocks_without_crc_are_read ======\n");
+        if (test_r_legacy_blocks_without_crc_are_read() != 0)
+        {
+            printf ("test_r_legacy_blocks_without_crc_are_read FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_legacy_blocks_without_crc_are_read PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_open_checks_crc_of_newest_block_only")) {
+        printf("\n\n===== TEST: test_r_open_checks_crc_of_newest_block_only ======\n");
+        if (test_r_open_checks_crc_of_newest_block_only() != 0)
+        {
+            printf ("test_r_open_checks_crc_of_newest_block_only FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_open_checks_crc_of_newest_block_only PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_tag_readers_release_behind_cursors")) {
+        printf("\n\n===== TEST: test_r_tag_readers_release_behind_cursors ======\n");
+        if (test_r_tag_readers_release_behind_cursors() != 0)
+        {
+            printf ("test_r_tag_readers_release_behind_cursors FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_tag_readers_release_behind_cursors PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_log_module_levels")) {
+        printf("\n\n===== TEST: test_r_log_module_levels ======\n");
+        if (test_r_log_module_levels() != 0)
+        {
+            printf ("test_r_log_module_levels FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_log_module_levels PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_log_deferred")) {
+        printf("\n\n===== TEST: test_r_log_deferred ======\n");
+        if (test_r_log_deferred() != 0)
+        {
+            printf ("test_r_log_deferred FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_log_deferred PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_log_sink_file_rotation")) {
+        printf("\n\n===== TEST: test_r_log_sink_file_rotation ======\n");
+        if (test_r_log_sink_file_rotation() != 0)
+        {
+            printf ("test_r_log_sink_file_rotation FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_log_sink_file_rotation PASSED.\n");
+        }
+    }
+    
+    if (m_r_must_run_test (argc, arg_apc, "test_r_log_hex_rows")) {
+        printf("\n\n===== TEST: test_r_log_hex_rows ======\n");
+        if (test_r_log_hex_rows() != 0)
+        {
+            printf ("test_r_log_hex_rows FAILED.\n");
+            error_stack_r_print (stderr);
+            exit (1);
+        } else {
+            printf ("test_r_log_hex_rows PASSED.\n");
+        }
+    }
+    
     return SUCCESS();
 }/*main*/
@@ -2,59 +2,140 @@
  * I N C L U D E D   H E A D E R   F I L E S
  *****************************************************************************/
 
+#define LOG_MODULE  "hl_blocks"
+
+#include "crc32.h"
 #include "error_stack.h"
 #include "hl_blocks.h"
+#include "hl_blocks_format.h"
 #include "log.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <stddef.h>
 #include <string.h>
+#include <sys/uio.h>
 
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 
+//max nr of spans gathered in one hl_blocks_r_drain_fd() call
+#define M_DRAIN_MAX_IOV         64
+
+//1 to update the stats with relaxed atomics, to get them from another thread
+#ifndef HL_BLOCKS_STATS_ATOMIC
+#define HL_BLOCKS_STATS_ATOMIC  1
+#endif
+
+//only the thread using the instance updates the stats,
+//so a relaxed load and store is enough, without a locked add
+#if HL_BLOCKS_STATS_ATOMIC
+#define M_STAT_ADD(p_blocks_pz, field, n) \
+    __atomic_store_n (&(p_blocks_pz)->stats_z.field, (p_blocks_pz)->stats_z.field + (n), __ATOMIC_RELAXED)
+#define M_STAT_GET(p_blocks_pz, field) \
+    __atomic_load_n (&(p_blocks_pz)->stats_z.field, __ATOMIC_RELAXED)
+#else
+#define M_STAT_ADD(p_blocks_pz, field, n)   ((p_blocks_pz)->stats_z.field += (n))
+#define M_STAT_GET(p_blocks_pz, field)      ((p_blocks_pz)->stats_z.field)
+#endif
+
+//USDT probes of provider hl_blocks for bpftrace and perf, see README.md
+//each is a nop until attached, and nothing without <sys/sdt.h>
+//or with -DHL_BLOCKS_NO_PROBES
+#if defined(__has_include) && !defined(HL_BLOCKS_NO_PROBES)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define M_PROBES                1
+#endif
+#endif
+
+#ifdef M_PROBES
+#define M_PROBE1(name, a)               DTRACE_PROBE1 (hl_blocks, name, a)
+#define M_PROBE2(name, a, b)            DTRACE_PROBE2 (hl_blocks, name, a, b)
+#define M_PROBE3(name, a, b, c)         DTRACE_PROBE3 (hl_blocks, name, a, b, c)
+#define M_PROBE4(name, a, b, c, d)      DTRACE_PROBE4 (hl_blocks, name, a, b, c, d)
+#else
+#define M_PROBE1(name, a)               do {} while (0)
+#define M_PROBE2(name, a, b)            do {} while (0)
+#define M_PROBE3(name, a, b, c)         do {} while (0)
+#define M_PROBE4(name, a, b, c, d)      do {} while (0)
+#endif
+
 /*****************************************************************************
  *   L O C A L   D A T A   T Y P E   D E F I N I T I O N S
  *****************************************************************************/
 
-typedef uint32_t blk_seq_t;
+//each priority class has its own heap buffer and read position,
+//but all share the same flash blocks
+typedef struct m_lane_s {
+    uint32_t                    rd_idx_ud;      //next flash block of this prio to read from, wr_idx_ud when none
+    uint32_t                    rd_ofs_ud;      //read offset inside the current block = pos of next msg_head to read
+
+    //buffer in heap memory to write to and read from until necessary to sync
+    //it has the size of one block and when ready is written as is into a block
+    //of flash memory, i.e. the exact same layout.
+    //when read, shift remaining data up, cause no need to sync that ever
+    //read from this when wr_idx_ud == rd_idx_ud
+    unsigned char*              wr_blk_data_auc;
+    uint32_t                    wr_blk_used_ud; //data bytes after block header
+    uint64_t                    wr_tag_map_ud;  //tags written in the heap buffer, for the block tag map
+} m_lane_t;
+
+//lane read position while gathering messages to drain
+typedef struct m_drain_pos_s {
+    uint32_t                    rd_idx_ud;
+    uint32_t                    rd_ofs_ud;
+    uint32_t                    heap_ofs_ud;    //bytes consumed from the front of the heap buffer
+} m_drain_pos_t;
+
+//message gathered to drain
+typedef struct m_drain_msg_s {
+    uint32_t                    prio_ud;
+    uint32_t                    size_ud;        //bytes incl framing
+    m_drain_pos_t               end_pos_z;      //lane position after the message
+} m_drain_msg_t;
 
 struct hl_blocks_s {
     uint32_t                    max_msg_size_ud;
     uint32_t                    min_data_per_part_ud;
+    uint32_t                    whole_max_ud;   //messages up to this size are never split, 0=none
+    uint32_t                    align_ud;       //message parts padded to 4, 8 or 16, 0=packed
+    uint32_t                    tag_map_ud;     //1 to write the tag map at the end of each block
+    uint32_t                    data_size_ud;   //space for message parts between the block header and tag map
     uint32_t                    block_size_ud;
     uint32_t                    nr_blocks_ud;
     hl_blocks_write_r*          write_pr;
     hl_blocks_addr_r*           addr_pr;
+    const unsigned char*        linear_base_puc;//block 0 when all blocks are in one mapping, else NULL to use addr_pr
+    size_t                      linear_stride_ud;
+    hl_blocks_writev_r*         writev_pr;      //NULL when not used
+    hl_blocks_full_mode_e       full_mode_e;
+    uint32_t                    first_idx_ud;   //ring block 0 in flash, after the checkpoint blocks
+    uint32_t                    ckpt_generation_ud;//last checkpoint written, 0=none
+    uint32_t                    ckpt_every_ud;  //blocks between checkpoints, 0=only on explicit sync and close
+    uint32_t                    ckpt_blocks_ud; //blocks written since the last checkpoint
+    blk_seq_t                   ckpt_blk_seq_ud;//last block seq written before the last checkpoint
+    unsigned char*              ckpt_blk_data_auc;//block to write the checkpoint from, NULL when not used
+    unsigned char*              rel_blk_data_auc;//block to write a released block from
+    blk_seq_t*                  crc_seq_aud;    //seq of each block when its crc was checked, 0=not yet
+    blk_seq_t                   legacy_seq_ud;  //blocks without crc are only valid below this seq, see m_r_open_scan()
 
     blk_seq_t                   last_blk_seq_ud;//last block seq written, 0=none, 1=first,2,3...
     uint32_t                    wr_idx_ud;      //next flash block to write to
-    uint32_t                    rd_idx_ud;      //next flash block to read from
-    uint32_t                    rd_ofs_ud;      //read offset inside the current block = pos of next msg_head to read
+    uint32_t                    rd_idx_ud;      //oldest flash block not yet read (any prio)
 
-    //metrics
-    uint32_t                    wr_count_ud;    //incr each time write_pr() is called
+    //metrics, updated with M_STAT_ADD(), fill_ratio_d is not used
+    hl_blocks_stats_t           stats_z;
+    latency_hist_t*             lat_az;         //HL_BLOCKS_K_LATENCY_NR_OF histograms, NULL when not kept
+    latency_hist_t*             lat_reset_az;   //what each had at the last reset
+    hl_blocks_msg_seq_t         drop_first_seq_ud;//first msg seq lost in last drop, 0=none
+    hl_blocks_msg_seq_t         drop_last_seq_ud; //last msg seq lost in last drop, 0=none
 
-    //buffer in heap memory to write to and read from until necessary to sync
-    //it has the size of one block and when ready is written as is into a block
-    //of flash memory, i.e. the exact same layout.
-    //when read, shift remaining data up, cause no need to sync that ever
-    //read from this when wr_idx_ud == rd_idx_ud
-    unsigned char*              wr_blk_data_auc;
-    uint32_t                    wr_blk_used_ud; //data bytes after block header
     hl_blocks_msg_seq_t         last_msg_seq_ud;//last message seq written, 0=none, 1=first,2,3...
+    uint32_t                    nr_prios_ud;    //nr of lanes in use
+    uint32_t                    drain_prio_ud;  //lane of the message partly written by hl_blocks_r_drain_fd()
+    uint32_t                    drain_ofs_ud;   //bytes of that message already written, 0=none
+    m_lane_t                    lane_az[HL_BLOCKS_MAX_PRIOS];
 };
 
-typedef struct block_head_s {
-    blk_seq_t                   seq_ud;         //1,2,3, ... rollover to 1 when necessary
-    uint32_t                    used_size_ud;   //byte used in this block (after the block header)
-    uint32_t other_ud;
-    uint32_t crc_ud;
-} blk_head_t;
-
-typedef struct msg_head_s {
-    hl_blocks_msg_seq_t         seq_ud;         //1,2,3, ... rollover to 1 when necessary
-    uint32_t                    tot_size_ud;    //total bytes spanning all parts
-    uint32_t                    part_ud;        //0,1,2, ... within this message
-    uint32_t                    part_size_ud;   //bytes in this part (after the message header)
-} msg_head_t;
-
 /*****************************************************************************
  *   L O C A L   D A T A    D E F I N I T I O N S
  *****************************************************************************/
@@ -64,10 +145,161 @@ typedef struct msg_head_s {
  *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
  *****************************************************************************/
 
+static void m_r_free (
+          hl_blocks_t*                p_blocks_pz);
+
+static int m_r_open_scan (
+          hl_blocks_t*                p_blocks_pz);
+
+static int m_r_checkpoint_write (
+          hl_blocks_t*                p_blocks_pz);
+
+static int m_r_checkpoint_restore (
+          hl_blocks_t*                p_blocks_pz);
+
+static int m_r_flash_addr (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud,
+    const void**                      p_block_pp);
+
+static int m_r_abs_addr (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_abs_idx_ud,
+    const void**                      p_block_pp);
+
+static int m_r_flash_write (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud,
+    const void*                       p_block_p);
+
+static int m_r_flash_writev (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud,
+    const struct iovec*               p_iov_az,
+    const int                         p_nr_iov_d);
+
 static uint32_t m_r_block_seq (
     const hl_blocks_t*                p_blocks_pz,
     const uint32_t                    p_block_idx_ud);
 
+static uint32_t m_r_head_seq (
+    const hl_blocks_t*                p_blocks_pz,
+    const blk_head_t*                 p_blk_head_pz);
+
+static uint32_t m_r_block_head_seq (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud);
+
+static uint32_t m_r_block_valid_seq (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud);
+
+static uint32_t m_r_block_crc (
+    const hl_blocks_t*                p_blocks_pz,
+    const void*                       p_block_p);
+
+static uint64_t m_r_block_tag_map (
+    const hl_blocks_t*                p_blocks_pz,
+    const void*                       p_block_p);
+
+static uint32_t m_r_block_prio (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud);
+
+static void m_r_block_release (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud,
+    const blk_head_t*                 p_blk_head_pz);
+
+static uint32_t m_r_lane_next_idx (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const uint32_t                    p_block_idx_ud);
+
+static uint32_t m_r_lane_next_head_idx (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const uint32_t                    p_block_idx_ud);
+
+static void m_r_lane_next_block (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud);
+
+static void m_r_advance_tail (
+          hl_blocks_t*                p_blocks_pz);
+
+static uint32_t m_r_skip_continued_parts (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud);
+
+static int m_r_dropped_msg_part (
+    const hl_blocks_t*                p_blocks_pz,
+    const msg_head_t*                 p_msg_head_pz);
+
+static int m_r_drop_oldest_block (
+          hl_blocks_t*                p_blocks_pz);
+
+static int m_r_sync_lane (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const int                         p_full_d);
+
+static int m_r_sync_block (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const int                         p_full_d,
+          blk_head_t*                 p_blk_head_pz,
+    const struct iovec*               p_data_az,
+    const uint32_t                    p_nr_data_ud,
+    const uint32_t                    p_used_ud);
+
+static const msg_head_t* m_r_drain_part (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+          m_drain_pos_t*              p_pos_pz);
+
+static void m_r_drain_seek (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const m_drain_pos_t*              p_pos_pz);
+
+static int m_r_read_lane (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+          void*                       p_buff_data_p,
+    const size_t                      p_buff_size_ud,
+          size_t*                     p_read_size_pud,
+          hl_blocks_msg_seq_t*        p_read_seq_pud);
+
+static int m_r_read_lane_tags (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+          hl_blocks_cursor_lane_t*    p_lane_cursor_pz,
+    const uint64_t                    p_tag_mask_ud,
+          void*                       p_buff_data_p,
+    const size_t                      p_buff_size_ud,
+          size_t*                     p_read_size_pud,
+          hl_blocks_msg_seq_t*        p_read_seq_pud,
+          uint32_t*                   p_tag_pud);
+
+static uint32_t m_r_release_lane (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const hl_blocks_msg_seq_t         p_seq_ud);
+
+static size_t m_r_min_part_data (
+    const hl_blocks_t*                p_blocks_pz,
+    const size_t                      p_size_ud,
+    const size_t                      p_remain_ud);
+
+static uint64_t m_r_latency_start (
+    const hl_blocks_t*                p_blocks_pz);
+
+static void m_r_latency_add (
+          hl_blocks_t*                p_blocks_pz,
+    const hl_blocks_latency_e         p_latency_e,
+    const uint64_t                    p_start_ns_ud);
+
 
 /*****************************************************************************
  *****************************************************************************
@@ -75,6 +307,14 @@ static uint32_t m_r_block_seq (
  *****************************************************************************
  *****************************************************************************/
 
+extern void hl_blocks_r_options_init (
+          hl_blocks_options_t*        p_options_pz)
+{
+    memset (p_options_pz, 0, sizeof (hl_blocks_options_t));
+    p_options_pz->nr_prios_ud = 1;
+}/*hl_blocks_r_options_init()*/
+
+
 extern int hl_blocks_r_open (
     const uint32_t                    p_block_size_ud,
     const uint32_t                    p_nr_blocks_ud,
@@ -84,129 +324,169 @@ extern int hl_blocks_r_open (
           hl_blocks_addr_r*           p_addr_pr,
           hl_blocks_t**               p_blocks_ppz)
 {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    return hl_blocks_r_open_options (
+        p_block_size_ud,
+        p_nr_blocks_ud,
+        p_max_msg_size_ud,
+        p_min_data_per_part_ud,
+        p_write_pr,
+        p_addr_pr,
+        &l_options_z,
+        p_blocks_ppz);
+}/*hl_blocks_r_open()*/
+
+
+extern int hl_blocks_r_open_options (
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const uint32_t                    p_max_msg_size_ud,
+    const uint32_t                    p_min_data_per_part_ud,
+          hl_blocks_write_r*          p_write_pr,
+          hl_blocks_addr_r*           p_addr_pr,
+    const hl_blocks_options_t*        p_options_pz,
+          hl_blocks_t**               p_blocks_ppz)
+{
+    if (  (p_options_pz == NULL)
+       || (p_options_pz->nr_prios_ud < 1)
+       || (p_options_pz->nr_prios_ud > HL_BLOCKS_MAX_PRIOS))
+        return ERROR (-1, "invalid options for hl_blocks_r_open_options(%p) nr_prios not 1..%u",
+            p_options_pz,
+            HL_BLOCKS_MAX_PRIOS);
+
+    if (  (p_options_pz->whole_max_ud > 0)
+       && (  (sizeof (blk_head_t) + sizeof (msg_head_t) + p_options_pz->whole_max_ud > p_block_size_ud)
+          || (  (p_options_pz->tag_map_ud)
+             && (sizeof (blk_head_t) + sizeof (msg_head_t) + HL_BLOCKS_TAG_MAP_SIZE + p_options_pz->whole_max_ud > p_block_size_ud))))
+        return ERROR (-1, "whole_max %u does not fit in a block of %u bytes with headers",
+            p_options_pz->whole_max_ud,
+            p_block_size_ud);
+
+    if (  (  (p_options_pz->align_ud != 0)
+          && (p_options_pz->align_ud != 4)
+          && (p_options_pz->align_ud != 8)
+          && (p_options_pz->align_ud != 16))
+       || (  (p_options_pz->align_ud > 0)
+          && (p_block_size_ud % p_options_pz->align_ud != 0)))
+        return ERROR (-1, "align %u not 0, 4, 8 or 16 or not a divisor of block size %u",
+            p_options_pz->align_ud,
+            p_block_size_ud);
+
+    if (  (  (p_addr_pr == NULL)
+          && (p_options_pz->linear_base_p == NULL))
+       || (  (p_options_pz->linear_stride_ud > 0)
+          && (p_options_pz->linear_stride_ud < p_block_size_ud)))
+        return ERROR (-1, "need addr_pr or linear_base with a stride of at least block size %u, not %u",
+            p_block_size_ud,
+            p_options_pz->linear_stride_ud);
+
+    //the tag map takes the last bytes of each block, padded to keep the space aligned
+    uint32_t l_data_size_ud = p_block_size_ud - sizeof (blk_head_t);
+    if (p_options_pz->tag_map_ud)
+        l_data_size_ud -= HL_BLOCKS_ALIGN_UP (HL_BLOCKS_TAG_MAP_SIZE, p_options_pz->align_ud);
+    if (  (p_block_size_ud < sizeof (blk_head_t) + HL_BLOCKS_TAG_MAP_SIZE + 2 * sizeof (msg_head_t))
+       || (p_max_msg_size_ud / (l_data_size_ud - sizeof (msg_head_t)) + 2 > HL_BLOCKS_MAX_PARTS))
+        return ERROR (-1, "block size %u too small for messages of %u bytes in max %u parts",
+            p_block_size_ud,
+            p_max_msg_size_ud,
+            HL_BLOCKS_MAX_PARTS);
+
+    uint32_t l_first_idx_ud = (p_options_pz->checkpoint_ud) ? HL_BLOCKS_CHECKPOINT_BLOCKS : 0;
+    if (  (l_first_idx_ud > 0)
+       && (  (p_block_size_ud < sizeof (checkpoint_t))
+          || (p_nr_blocks_ud < l_first_idx_ud + 2)))
+        return ERROR (-1, "checkpoint requires block size >= %zu and more than %u blocks, not %u x %u",
+            sizeof (checkpoint_t),
+            l_first_idx_ud + 1,
+            p_nr_blocks_ud,
+            p_block_size_ud);
+
+    uint64_t l_start_ns_ud = (p_options_pz->latency_ud) ? latency_hist_r_now_ns () : 0;
+
     //start with empty and clear buffer settings
     hl_blocks_t* l_blocks_pz = (hl_blocks_t*)malloc (sizeof (hl_blocks_t));
     l_blocks_pz->block_size_ud          = p_block_size_ud;
-    l_blocks_pz->nr_blocks_ud           = p_nr_blocks_ud;
+    l_blocks_pz->nr_blocks_ud           = p_nr_blocks_ud - l_first_idx_ud;
     l_blocks_pz->max_msg_size_ud        = p_max_msg_size_ud;
     l_blocks_pz->min_data_per_part_ud   = p_min_data_per_part_ud;
+    l_blocks_pz->whole_max_ud           = p_options_pz->whole_max_ud;
+    l_blocks_pz->align_ud               = p_options_pz->align_ud;
+    l_blocks_pz->tag_map_ud             = p_options_pz->tag_map_ud;
+    l_blocks_pz->data_size_ud           = l_data_size_ud;
     l_blocks_pz->write_pr               = p_write_pr;
     l_blocks_pz->addr_pr                = p_addr_pr;
+    l_blocks_pz->linear_base_puc        = (const unsigned char*)p_options_pz->linear_base_p;
+    l_blocks_pz->linear_stride_ud       = (p_options_pz->linear_stride_ud > 0) ? p_options_pz->linear_stride_ud : p_block_size_ud;
+    l_blocks_pz->writev_pr              = NULL;
+    l_blocks_pz->full_mode_e            = HL_BLOCKS_K_FULL_MODE_REJECT;
+    l_blocks_pz->first_idx_ud           = l_first_idx_ud;
+    l_blocks_pz->ckpt_generation_ud     = 0;
+    l_blocks_pz->ckpt_every_ud          = p_options_pz->checkpoint_every_ud;
+    l_blocks_pz->ckpt_blocks_ud         = 0;
+    l_blocks_pz->ckpt_blk_seq_ud        = 0;
+    l_blocks_pz->ckpt_blk_data_auc      = NULL;
+    if (l_first_idx_ud > 0)
+        l_blocks_pz->ckpt_blk_data_auc = (unsigned char*)calloc (1, p_block_size_ud);
+    l_blocks_pz->rel_blk_data_auc       = (unsigned char*)malloc (p_block_size_ud);
+    l_blocks_pz->crc_seq_aud            = (blk_seq_t*)calloc (l_blocks_pz->nr_blocks_ud, sizeof (blk_seq_t));
+    l_blocks_pz->legacy_seq_ud          = 0;
 
     l_blocks_pz->last_blk_seq_ud        = 0;
     l_blocks_pz->wr_idx_ud              = 0;
     l_blocks_pz->rd_idx_ud              = 0;
-    l_blocks_pz->rd_ofs_ud              = 0;
-    l_blocks_pz->wr_count_ud            = 0;
-
-    l_blocks_pz->wr_blk_data_auc = (unsigned char*)malloc (l_blocks_pz->block_size_ud);
-    memset (l_blocks_pz->wr_blk_data_auc, 0, l_blocks_pz->block_size_ud);
-    l_blocks_pz->wr_blk_used_ud  = 0;
-    l_blocks_pz->last_msg_seq_ud = 0;
-
-    //see if any data already exists in the blocks
-    uint32_t                     l_min_idx_ud = 0;
-    blk_seq_t                    l_min_seq_ud = 0;
-    uint32_t                     l_max_idx_ud = 0;
-    blk_seq_t                    l_max_seq_ud = 0;
-    for (uint32_t l_idx_ud = 0; l_idx_ud < p_nr_blocks_ud; l_idx_ud++) {
-        uint32_t l_seq_ud = m_r_block_seq (l_blocks_pz, l_idx_ud);
-        if (l_seq_ud == 0)
-            continue;
-
-        if ((l_min_seq_ud == 0) || (l_seq_ud < l_min_seq_ud)) {
-            l_min_idx_ud = l_idx_ud;
-            l_min_seq_ud = l_seq_ud;
-        }
-        if ((l_max_seq_ud == 0) || (l_seq_ud > l_max_seq_ud)) {
-            l_max_idx_ud = l_idx_ud;
-            l_max_seq_ud = l_seq_ud;
+    memset (&l_blocks_pz->stats_z, 0, sizeof (hl_blocks_stats_t));
+    l_blocks_pz->lat_az                 = NULL;
+    l_blocks_pz->lat_reset_az           = NULL;
+    if (p_options_pz->latency_ud) {
+        l_blocks_pz->lat_az       = (latency_hist_t*)calloc (HL_BLOCKS_K_LATENCY_NR_OF, sizeof (latency_hist_t));
+        l_blocks_pz->lat_reset_az = (latency_hist_t*)calloc (HL_BLOCKS_K_LATENCY_NR_OF, sizeof (latency_hist_t));
+    }
+    l_blocks_pz->drop_first_seq_ud      = 0;
+    l_blocks_pz->drop_last_seq_ud       = 0;
+    l_blocks_pz->last_msg_seq_ud        = 0;
+
+    l_blocks_pz->nr_prios_ud            = p_options_pz->nr_prios_ud;
+    l_blocks_pz->drain_prio_ud          = 0;
+    l_blocks_pz->drain_ofs_ud           = 0;
+    for (uint32_t l_prio_ud = 0; l_prio_ud < HL_BLOCKS_MAX_PRIOS; l_prio_ud++) {
+        m_lane_t* l_lane_pz = &l_blocks_pz->lane_az[l_prio_ud];
+        l_lane_pz->rd_idx_ud        = 0;
+        l_lane_pz->rd_ofs_ud        = 0;
+        l_lane_pz->wr_blk_data_auc  = NULL;
+        l_lane_pz->wr_blk_used_ud   = 0;
+        l_lane_pz->wr_tag_map_ud    = 0;
+        if (l_prio_ud < l_blocks_pz->nr_prios_ud) {
+            l_lane_pz->wr_blk_data_auc = (unsigned char*)malloc (l_blocks_pz->block_size_ud);
+            memset (l_lane_pz->wr_blk_data_auc, 0, l_blocks_pz->block_size_ud);
         }
-    }/*for each block*/
-
-    //must have both or neither of min/max
-    if ((l_min_seq_ud > 0) ^ (l_max_seq_ud > 0))
-        return ERROR (HL_BLOCKS_K_ERROR_CORRUPTED,
-                "min(seq=%u, idx=%u), max(seq=%u, idx=%u) (requires either or both non-zero seq)",
-                l_min_seq_ud,
-                l_min_idx_ud,
-                l_max_seq_ud,
-                l_max_idx_ud);
-
-    //if seq min==max, then idx min must also be max, i.e. the same block
-    if ((l_min_seq_ud == l_max_seq_ud) ^ (l_min_idx_ud == l_max_idx_ud))
-        return ERROR (HL_BLOCKS_K_ERROR_CORRUPTED,
-                "min(seq=%u, idx=%u), max(seq=%u, idx=%u) (require none or both the same)",
-                l_min_seq_ud,
-                l_min_idx_ud,
-                l_max_seq_ud,
-                l_max_idx_ud);
-
-    if (l_min_seq_ud > 0) {
-        //found data to read
-        l_blocks_pz->rd_idx_ud = l_min_idx_ud;
-        l_blocks_pz->wr_idx_ud = (l_max_idx_ud + 1) % l_blocks_pz->nr_blocks_ud;
-        l_blocks_pz->last_blk_seq_ud = l_max_seq_ud;
-
-        //need to skip over partial messages at the head of the rd block
-        //i.e. parts of messages already read from earlier blocks
-        if (l_blocks_pz->rd_idx_ud < l_blocks_pz->wr_idx_ud)
-        {
-            const void*                 l_block_p;
-            (*p_addr_pr) (l_blocks_pz->rd_idx_ud, &l_block_p);
-            const blk_head_t* l_blk_head_pz = (const blk_head_t*)l_block_p;
-            const unsigned char* l_block_data_puc = (const unsigned char*)l_block_p + sizeof (blk_head_t);
-            uint32_t l_rd_ofs_ud = 0;
-            while (l_rd_ofs_ud < l_blk_head_pz->used_size_ud)
-            {
-                const msg_head_t* l_msg_head_pz = (const msg_head_t*)(l_block_data_puc + l_rd_ofs_ud);
-
-                l_rd_ofs_ud += sizeof (msg_head_t) + l_msg_head_pz->part_size_ud;
-                if (l_msg_head_pz->part_ud > 0)
-                {
-                    //must skip this part - it is part of message started in previous block
-                    //that was completely read before shutdown
-                    l_blocks_pz->rd_ofs_ud = l_rd_ofs_ud;
-                } else {
-                    //not skipping this part, stop the loop
-                    break;
-                }
-            }/*while reading message parts in this block*/
-        }//if open with block to read
+    }/*for each lane*/
 
-        //read messages in last written block to see what is last msg_seq used
-        {
-            const void*                 l_block_p;
-            (*p_addr_pr) (l_max_idx_ud, &l_block_p);
-            const blk_head_t* l_blk_head_pz = (const blk_head_t*)l_block_p;
-            // DEBUG ("blk[%u].head(seq=%u,used_sz=%u).ofs=%u",
-            //     p_blocks_pz->rd_idx_ud,
-            //     l_flash_blk_head_pz->seq_ud,
-            //     l_flash_blk_head_pz->used_size_ud,
-            //     p_blocks_pz->rd_ofs_ud);
-            const unsigned char* l_block_data_puc = (const unsigned char*)l_block_p + sizeof (blk_head_t);
-            uint32_t l_rd_ofs_ud = 0;
-            while (l_rd_ofs_ud < l_blk_head_pz->used_size_ud)
-            {
-                const msg_head_t* l_msg_head_pz = (const msg_head_t*)(l_block_data_puc + l_rd_ofs_ud);
-                l_rd_ofs_ud += sizeof (msg_head_t) + l_msg_head_pz->part_size_ud;
-                l_blocks_pz->last_msg_seq_ud = l_msg_head_pz->seq_ud;
-            }/*while reading message parts in this block*/
-        }/*scope*/
-    }/*if found data to read*/
+    //resume from the checkpoint, else see if any data already exists in the blocks
+    int l_result_d = -1;
+    if (l_blocks_pz->first_idx_ud > 0)
+        l_result_d = m_r_checkpoint_restore (l_blocks_pz);
+    if (l_result_d != 0)
+        l_result_d = m_r_open_scan (l_blocks_pz);
+    if (l_result_d != 0) {
+        m_r_free (l_blocks_pz);
+        return ERROR (l_result_d, "Failed to resume from existing blocks");
+    }
 
+    m_r_latency_add (l_blocks_pz, HL_BLOCKS_K_LATENCY_OPEN, l_start_ns_ud);
     *p_blocks_ppz = l_blocks_pz;
-    DEBUG ("Opened with %u blocks x %u bytes: last blk_seq=%u, msg_seq=%u, wr_idx=%u, rd_idx=%u, rd_ofs=%u",
+    DEBUG ("Opened with %u blocks x %u bytes: last blk_seq=%u, msg_seq=%u, wr_idx=%u, rd_idx=%u, rd_ofs=%u, prios=%u",
         l_blocks_pz->nr_blocks_ud,
         l_blocks_pz->block_size_ud,
         l_blocks_pz->last_blk_seq_ud,
         l_blocks_pz->last_msg_seq_ud,
         l_blocks_pz->wr_idx_ud,
         l_blocks_pz->rd_idx_ud,
-        l_blocks_pz->rd_ofs_ud);
+        l_blocks_pz->lane_az[0].rd_ofs_ud,
+        l_blocks_pz->nr_prios_ud);
 
     return SUCCESS ();
-}/*hl_blocks_r_open()*/
+}/*hl_blocks_r_open_options()*/
 
 
 extern int hl_blocks_r_close (
@@ -214,12 +494,15 @@ extern int hl_blocks_r_close (
 {
     hl_blocks_t* l_blocks_pz = *p_blocks_ppz;
     int l_result_d;
+    //also writes the checkpoint with the read positions for the next open
     l_result_d = hl_blocks_r_sync (l_blocks_pz);
-    if (l_result_d != 0)
-        return ERROR (l_result_d, "Failed to sync before closing");
 
-    free (l_blocks_pz);
+    //local memory is released even when the flash failed, e.g. on power cut,
+    //because the blocks cannot be used any more
+    m_r_free (l_blocks_pz);
     *p_blocks_ppz = NULL;
+    if (l_result_d != 0)
+        return ERROR (l_result_d, "Failed to sync before closing");
     return SUCCESS ();
 }/*hl_blocks_r_close()*/
 
@@ -229,44 +512,101 @@ extern int hl_blocks_r_write (
     const void*                       p_data_p,
     const size_t                      p_size_ud,
           hl_blocks_msg_seq_t*        p_write_seq_pud)
+{
+    return hl_blocks_r_write_prio (p_blocks_pz, 0, p_data_p, p_size_ud, p_write_seq_pud);
+}/*hl_blocks_r_write()*/
+
+
+extern int hl_blocks_r_write_prio (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const void*                       p_data_p,
+    const size_t                      p_size_ud,
+          hl_blocks_msg_seq_t*        p_write_seq_pud)
+{
+    return hl_blocks_r_write_tag (p_blocks_pz, p_prio_ud, 0, p_data_p, p_size_ud, p_write_seq_pud);
+}/*hl_blocks_r_write_prio()*/
+
+
+extern int hl_blocks_r_write_tag (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const uint32_t                    p_tag_ud,
+    const void*                       p_data_p,
+    const size_t                      p_size_ud,
+          hl_blocks_msg_seq_t*        p_write_seq_pud)
 {
     if ((p_data_p == NULL) || (p_size_ud == 0))
         return ERROR (-1, "invalid parameters for hl_blocks_r_write(%p,%zu)", p_data_p, p_size_ud);
+    if (p_prio_ud >= p_blocks_pz->nr_prios_ud)
+        return ERROR (-1, "invalid prio %u not 0..%u", p_prio_ud, p_blocks_pz->nr_prios_ud - 1);
+    if (p_tag_ud >= HL_BLOCKS_MAX_TAGS)
+        return ERROR (-1, "invalid tag %u not 0..%u", p_tag_ud, HL_BLOCKS_MAX_TAGS - 1);
+
+    m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+    uint64_t l_start_ns_ud = m_r_latency_start (p_blocks_pz);
+    M_PROBE2 (write_begin, p_prio_ud, p_size_ud);
 
     //ensure write will fit in remaining buffer space to avoid partial write
     //also ensure there is always one block left for any heap writes to be synced
-    //if system shutsdown.
+    //if system shutsdown, for this prio and each other prio with data in its heap.
     {
         size_t                      l_remain_ud = p_size_ud;
-        uint32_t                    l_wr_blk_used_ud = p_blocks_pz->wr_blk_used_ud;
+        uint32_t                    l_wr_blk_used_ud = l_lane_pz->wr_blk_used_ud;
         uint32_t                    l_sync_count_ud = 0;
+        uint32_t                    l_reserved_ud = 0;
+        for (uint32_t l_other_ud = 0; l_other_ud < p_blocks_pz->nr_prios_ud; l_other_ud++) {
+            if (  (l_other_ud != p_prio_ud)
+               && (p_blocks_pz->lane_az[l_other_ud].wr_blk_used_ud > 0))
+                l_reserved_ud ++;
+        }
+        //blocks that can be written before wr_idx_ud reaches rd_idx_ud
+        uint32_t l_free_ud = (p_blocks_pz->rd_idx_ud + p_blocks_pz->nr_blocks_ud - p_blocks_pz->wr_idx_ud - 1) % p_blocks_pz->nr_blocks_ud;
         while (l_remain_ud > 0)
         {
             //determine space left in current write buffer
-            size_t l_buffer_space_ud = p_blocks_pz->block_size_ud
-                - sizeof (blk_head_t)
-                - l_wr_blk_used_ud;
+            size_t l_buffer_space_ud = p_blocks_pz->data_size_ud - l_wr_blk_used_ud;
 
             //determine min space required to write some/all into this block
-            if (sizeof (msg_head_t) + MIN (p_blocks_pz->min_data_per_part_ud, l_remain_ud)
+            if (sizeof (msg_head_t) + m_r_min_part_data (p_blocks_pz, p_size_ud, l_remain_ud)
                     > l_buffer_space_ud)
             {
                 //must write into next block
                 l_sync_count_ud ++;
-                if ((p_blocks_pz->wr_idx_ud + 1 + l_sync_count_ud) % p_blocks_pz->nr_blocks_ud == p_blocks_pz->rd_idx_ud)
+                if (p_blocks_pz->full_mode_e == HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST)
                 {
-                    ERROR_LOG ("Do not write partial!");
-                    return ERROR (HL_BLOCKS_K_ERROR_NO_SPACE_LEFT_IN_BUFFER,
-                        "Not enough space left for this message");
+                    //sync drops old blocks as needed, but must never drop
+                    //the block holding the first part of this message,
+                    //also not when the other prios sync their heap blocks
+                    if (l_sync_count_ud + l_reserved_ud >= p_blocks_pz->nr_blocks_ud) {
+                        M_STAT_ADD (p_blocks_pz, rejects_full_ud, 1);
+                        return ERROR (HL_BLOCKS_K_ERROR_NO_SPACE_LEFT_IN_BUFFER,
+                            "Message size %zu needs %u blocks with %u kept for other prios, of %u",
+                            p_size_ud,
+                            l_sync_count_ud,
+                            l_reserved_ud,
+                            p_blocks_pz->nr_blocks_ud);
+                    }
                 }
-                l_buffer_space_ud = p_blocks_pz->block_size_ud - sizeof (blk_head_t);
+                l_buffer_space_ud = p_blocks_pz->data_size_ud;
             }/*if cannot fit more into this block*/
             uint32_t l_part_size_ud = (uint32_t)MIN(l_remain_ud, l_buffer_space_ud - sizeof (msg_head_t));
-            l_wr_blk_used_ud += (sizeof (msg_head_t) + l_part_size_ud);
+            l_wr_blk_used_ud += HL_BLOCKS_PART_STEP (p_blocks_pz->align_ud, l_part_size_ud);
             l_remain_ud -= l_part_size_ud;
         }/*while more to write*/
 
-        DEBUG ("sync=%u wr=%u rd=%u", l_sync_count_ud, p_blocks_pz->wr_idx_ud, p_blocks_pz->rd_idx_ud);
+        //the blocks synced now, then one for the heap block of this prio
+        //and of each other prio with data
+        if (  (p_blocks_pz->full_mode_e != HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST)
+           && (l_sync_count_ud + 1 + l_reserved_ud > l_free_ud))
+        {
+            //expected when the reader is behind, so not logged
+            M_STAT_ADD (p_blocks_pz, rejects_full_ud, 1);
+            return ERROR (HL_BLOCKS_K_ERROR_NO_SPACE_LEFT_IN_BUFFER,
+                "Not enough space left for this message");
+        }
+
+        DEBUG ("sync=%u reserved=%u wr=%u rd=%u", l_sync_count_ud, l_reserved_ud, p_blocks_pz->wr_idx_ud, p_blocks_pz->rd_idx_ud);
     }//local scope
 
     //write now
@@ -276,45 +616,101 @@ extern int hl_blocks_r_write (
     while (l_remain_ud > 0)
     {
         //determine space left in current write buffer
-        size_t l_buffer_space_ud = p_blocks_pz->block_size_ud
-            - sizeof (blk_head_t)
-            - p_blocks_pz->wr_blk_used_ud;
+        size_t l_buffer_space_ud = p_blocks_pz->data_size_ud - l_lane_pz->wr_blk_used_ud;
 
         //determine min space required to write some/all into this block
-        if (sizeof (msg_head_t) + MIN (p_blocks_pz->min_data_per_part_ud, l_remain_ud)
+        if (sizeof (msg_head_t) + m_r_min_part_data (p_blocks_pz, p_size_ud, l_remain_ud)
                 > l_buffer_space_ud)
         {
-            int l_result_d = hl_blocks_r_sync (p_blocks_pz);
+            //space left only because the message must not be split
+            if (sizeof (msg_head_t) + MIN (p_blocks_pz->min_data_per_part_ud, l_remain_ud)
+                    <= l_buffer_space_ud) {
+                M_STAT_ADD (p_blocks_pz, msgs_moved_whole_ud, 1);
+                M_STAT_ADD (p_blocks_pz, whole_pad_bytes_ud, l_buffer_space_ud);
+            }
+            int l_result_d = m_r_sync_lane (p_blocks_pz, p_prio_ud, 1);
             if (l_result_d != 0)
             {
                 ERROR_LOG ("SYNC failed");
                 return ERROR(l_result_d, "Failed to sync before writing more data");
             }
-            l_buffer_space_ud = p_blocks_pz->block_size_ud - sizeof (blk_head_t);
+            l_buffer_space_ud = p_blocks_pz->data_size_ud;
         }/*if cannot fit more into this block*/
 
+        //a part filling a whole block, that is not the last part, is written
+        //straight from the data, the same as through the heap block
+        //except with a tag map, which is not after the used data
+        if (  (p_blocks_pz->writev_pr != NULL)
+           && (!p_blocks_pz->tag_map_ud)
+           && (l_lane_pz->wr_blk_used_ud == 0)
+           && (l_remain_ud > l_buffer_space_ud - sizeof (msg_head_t)))
+        {
+            blk_head_t                  l_blk_head_z;
+            msg_head_t                  l_msg_head_z;
+            struct iovec                l_data_az[2];
+            l_msg_head_z.seq_ud       = p_blocks_pz->last_msg_seq_ud + 1;
+            l_msg_head_z.tot_size_ud  = p_size_ud;
+            l_msg_head_z.part_ud      = (uint16_t)l_part_index_ud;
+            l_msg_head_z.tag_ud       = (uint16_t)p_tag_ud;
+            l_msg_head_z.part_size_ud = (uint32_t)(l_buffer_space_ud - sizeof (msg_head_t));
+            l_data_az[0].iov_base = &l_msg_head_z;
+            l_data_az[0].iov_len  = sizeof (msg_head_t);
+            l_data_az[1].iov_base = (void*)l_next_puc;
+            l_data_az[1].iov_len  = l_msg_head_z.part_size_ud;
+            M_PROBE4 (part_append,
+                p_blocks_pz->wr_idx_ud,
+                l_msg_head_z.seq_ud,
+                l_msg_head_z.part_ud,
+                l_msg_head_z.part_size_ud);
+            int l_result_d = m_r_sync_block (p_blocks_pz, p_prio_ud, 1, &l_blk_head_z, l_data_az, 2, (uint32_t)l_buffer_space_ud);
+            if (l_result_d != 0)
+                return ERROR (l_result_d, "Failed to write part %u directly", l_part_index_ud);
+
+            l_next_puc  += l_msg_head_z.part_size_ud;
+            l_remain_ud -= l_msg_head_z.part_size_ud;
+            l_part_index_ud ++;
+            continue;
+        }/*if whole block from the data*/
+
         //write message header
-        msg_head_t* l_msg_head_pz = (msg_head_t*)(p_blocks_pz->wr_blk_data_auc + sizeof (blk_head_t) + p_blocks_pz->wr_blk_used_ud);
+        msg_head_t* l_msg_head_pz = (msg_head_t*)(l_lane_pz->wr_blk_data_auc + sizeof (blk_head_t) + l_lane_pz->wr_blk_used_ud);
         l_msg_head_pz->seq_ud = p_blocks_pz->last_msg_seq_ud + 1;
         l_msg_head_pz->tot_size_ud = p_size_ud;
-        l_msg_head_pz->part_ud = l_part_index_ud;
+        l_msg_head_pz->part_ud = (uint16_t)l_part_index_ud;
+        l_msg_head_pz->tag_ud = (uint16_t)p_tag_ud;
+        l_lane_pz->wr_tag_map_ud |= HL_BLOCKS_TAG_BIT (p_tag_ud);
         l_msg_head_pz->part_size_ud = (uint32_t)MIN(l_remain_ud, l_buffer_space_ud - sizeof (msg_head_t));
 
         //copy message data after head
         memcpy (
-            p_blocks_pz->wr_blk_data_auc + sizeof (blk_head_t) + p_blocks_pz->wr_blk_used_ud + sizeof (msg_head_t),
+            l_lane_pz->wr_blk_data_auc + sizeof (blk_head_t) + l_lane_pz->wr_blk_used_ud + sizeof (msg_head_t),
             l_next_puc,
             l_msg_head_pz->part_size_ud);
 
-        p_blocks_pz->wr_blk_used_ud += (sizeof (msg_head_t) + l_msg_head_pz->part_size_ud);
-        DEBUG ("wrote->blk[%5u](seq=%10u now=%3u) msg(seq=%5u size=%5u part[%2u]=%5u)",
+        //block space is a multiple of the alignment, so the padding always fits
+        uint32_t l_step_ud = HL_BLOCKS_PART_STEP (p_blocks_pz->align_ud, l_msg_head_pz->part_size_ud);
+        if (l_step_ud > sizeof (msg_head_t) + l_msg_head_pz->part_size_ud) {
+            memset (
+                (unsigned char*)l_msg_head_pz + sizeof (msg_head_t) + l_msg_head_pz->part_size_ud,
+                0,
+                l_step_ud - sizeof (msg_head_t) - l_msg_head_pz->part_size_ud);
+            M_STAT_ADD (p_blocks_pz, align_pad_bytes_ud, l_step_ud - sizeof (msg_head_t) - l_msg_head_pz->part_size_ud);
+        }
+        l_lane_pz->wr_blk_used_ud += l_step_ud;
+        M_PROBE4 (part_append,
+            p_blocks_pz->wr_idx_ud,
+            l_msg_head_pz->seq_ud,
+            l_msg_head_pz->part_ud,
+            l_msg_head_pz->part_size_ud);
+        DEBUG ("wrote->blk[%5u](seq=%10u now=%3u) msg(seq=%5u size=%5u part[%2u]=%5u) prio=%u",
             p_blocks_pz->wr_idx_ud,
             p_blocks_pz->last_blk_seq_ud + 1,
-            p_blocks_pz->wr_blk_used_ud,
+            l_lane_pz->wr_blk_used_ud,
             l_msg_head_pz->seq_ud,
             l_msg_head_pz->tot_size_ud,
             l_msg_head_pz->part_ud,
-            l_msg_head_pz->part_size_ud);
+            l_msg_head_pz->part_size_ud,
+            p_prio_ud);
 
         l_next_puc  += l_msg_head_pz->part_size_ud;
         l_remain_ud -= l_msg_head_pz->part_size_ud;
@@ -322,53 +718,44 @@ extern int hl_blocks_r_write (
     }/*while more to write*/
 
     p_blocks_pz->last_msg_seq_ud ++;
+    M_STAT_ADD (p_blocks_pz, msgs_written_ud, 1);
+    M_STAT_ADD (p_blocks_pz, bytes_written_ud, p_size_ud);
+    M_STAT_ADD (p_blocks_pz, parts_written_ud, l_part_index_ud);
+    if (l_part_index_ud > 1)
+        M_STAT_ADD (p_blocks_pz, msgs_split_ud, 1);
+    m_r_latency_add (p_blocks_pz, HL_BLOCKS_K_LATENCY_WRITE, l_start_ns_ud);
+    M_PROBE4 (write_end, p_prio_ud, p_size_ud, p_blocks_pz->last_msg_seq_ud, l_part_index_ud);
     if (p_write_seq_pud != NULL)
         *p_write_seq_pud = p_blocks_pz->last_msg_seq_ud;
 
     return SUCCESS ();
-}/*hl_blocks_r_write()*/
+}/*hl_blocks_r_write_tag()*/
 
 
 extern int hl_blocks_r_sync (
           hl_blocks_t*                p_blocks_pz)
 {
-    if (p_blocks_pz->wr_blk_used_ud > 0)
-    {
-        //check there is enough space not to overwrite unread messages
-        //this is when write index will increment to fall on same block as read index
-        if ((p_blocks_pz->wr_idx_ud + 1) % p_blocks_pz->nr_blocks_ud == p_blocks_pz->rd_idx_ud)
-            return ERROR (HL_BLOCKS_K_ERROR_NO_SPACE_LEFT_IN_BUFFER,
-                "No space left in buffer wr_idx=%u rd_idx=%u",
-                p_blocks_pz->wr_idx_ud,
-                p_blocks_pz->rd_idx_ud);
-
-        //update the block header
-        //sync the buffer to flash memory and start a new clean buffer
-        blk_head_t* l_blk_head_pz = (blk_head_t*)(p_blocks_pz->wr_blk_data_auc);
-        l_blk_head_pz->seq_ud = p_blocks_pz->last_blk_seq_ud + 1;
-        l_blk_head_pz->used_size_ud = p_blocks_pz->wr_blk_used_ud;
-        if ((*p_blocks_pz->write_pr) (
-                p_blocks_pz->wr_idx_ud,
-                p_blocks_pz->wr_blk_data_auc)
-                != 0)
-            return ERROR (-1,
-                "Failed to sync write to flash blk[%u]",
-                p_blocks_pz->wr_idx_ud);
-
-        DEBUG ("synced blk[%5u](seq=%10u tot=%3u) -> FLASH",
-            p_blocks_pz->wr_idx_ud,
-            l_blk_head_pz->seq_ud,
-            l_blk_head_pz->used_size_ud);
-
-        p_blocks_pz->last_blk_seq_ud ++;
-        p_blocks_pz->wr_count_ud ++;
-        p_blocks_pz->wr_idx_ud = (p_blocks_pz->wr_idx_ud + 1) % p_blocks_pz->nr_blocks_ud;
-        p_blocks_pz->wr_blk_used_ud = 0;
-        memset (p_blocks_pz->wr_blk_data_auc, 0, p_blocks_pz->block_size_ud);
-    }/*if buffer used*/
+    uint64_t l_start_ns_ud = m_r_latency_start (p_blocks_pz);
+
+    //highest prio first, so it is first to read after cold start
+    for (uint32_t l_prio_ud = p_blocks_pz->nr_prios_ud; l_prio_ud > 0; ) {
+        l_prio_ud --;
+        int l_result_d = m_r_sync_lane (p_blocks_pz, l_prio_ud, 0);
+        if (l_result_d != 0)
+            return ERROR (l_result_d, "Failed to sync prio %u", l_prio_ud);
+    }/*for each lane*/
+
+    //save the write and read positions for the next open
+    if (p_blocks_pz->first_idx_ud > 0) {
+        int l_result_d = m_r_checkpoint_write (p_blocks_pz);
+        if (l_result_d != 0)
+            return ERROR (l_result_d, "Failed to write checkpoint");
+    }
+    m_r_latency_add (p_blocks_pz, HL_BLOCKS_K_LATENCY_SYNC, l_start_ns_ud);
     return SUCCESS ();
 }/*hl_blocks_r_sync()*/
 
+
 extern int hl_blocks_r_read (
           hl_blocks_t*                p_blocks_pz,
           void*                       p_buff_data_p,
@@ -387,53 +774,1552 @@ extern int hl_blocks_r_read (
             p_read_size_pud,
             p_read_seq_pud);
 
-    //read message parts in loop until break when got the whole message
-    uint32_t l_msg_seq_ud       = 0;
-    uint32_t l_tot_size_ud      = 0;
-    uint32_t l_buff_ofs_ud      = 0;     //this is also size of all parts already copied into the buffer
-    uint32_t l_buff_rem_ud      = p_buff_size_ud;
-    uint32_t l_parts_copied_ud  = 0;        //incr after got a part
-
-    while (1) {
-        //determine if read from flash or heap space
-        uint32_t                    l_read_from_flash_ud    = (p_blocks_pz->rd_idx_ud != p_blocks_pz->wr_idx_ud);
-        const blk_head_t*           l_flash_blk_head_pz     = NULL;
-        const msg_head_t*           l_msg_head_pz           = NULL;
+    //a message partly drained is read again as a whole
+    p_blocks_pz->drain_ofs_ud = 0;
+    uint64_t l_start_ns_ud = m_r_latency_start (p_blocks_pz);
 
-        //get msg_head in either flash or heap
-        if (l_read_from_flash_ud)
-        {
-            //read from flash block[rd_idx_ud] at data ofs rd_ofs_ud after the block head
-            //note: reading from flash does not shift other messages forward
-            //      because flash is not changed after being written once)
-            //get address of flash block to read
-            const void*                 l_block_p;
-            (*p_blocks_pz->addr_pr) (p_blocks_pz->rd_idx_ud, &l_block_p);
-            l_flash_blk_head_pz = (const blk_head_t*)l_block_p;
-            const unsigned char* l_blk_data_puc = (const unsigned char*)l_block_p + sizeof (blk_head_t);
-            //get message header and copy the data
-            l_msg_head_pz = (const msg_head_t*)(l_blk_data_puc + p_blocks_pz->rd_ofs_ud);
-        } /*if read from flash*/
-        else
+    //drain the highest prio with anything to read first
+    for (uint32_t l_prio_ud = p_blocks_pz->nr_prios_ud; l_prio_ud > 0; ) {
+        l_prio_ud --;
+        const m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[l_prio_ud];
+        if (  (l_lane_pz->rd_idx_ud != p_blocks_pz->wr_idx_ud)
+           || (l_lane_pz->wr_blk_used_ud > 0))
         {
-            //nothing more in flash to read, see if anything in heap space to read
-            if (p_blocks_pz->wr_blk_used_ud == 0)
-                return ERROR (HL_BLOCKS_K_ERROR_READ_ALL, "Nothing more to read.");
-            l_msg_head_pz = (const msg_head_t*)(p_blocks_pz->wr_blk_data_auc + sizeof (blk_head_t));
-        }/*if read from heap*/
+            int l_result_d = m_r_read_lane (
+                p_blocks_pz,
+                l_prio_ud,
+                p_buff_data_p,
+                p_buff_size_ud,
+                p_read_size_pud,
+                p_read_seq_pud);
+            //only empty blocks or parts of dropped messages were left in this prio
+            if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+                continue;
+            if (l_result_d == 0)
+                m_r_latency_add (p_blocks_pz, HL_BLOCKS_K_LATENCY_READ, l_start_ns_ud);
+            return l_result_d;
+        }
+    }/*for each lane*/
 
-        if (  (  (l_parts_copied_ud == 0)
-              && (l_msg_head_pz->part_ud > 0))
-           || (  (l_parts_copied_ud > 0)
-              && (  (l_msg_seq_ud != l_msg_head_pz->seq_ud)
-                 || (l_tot_size_ud != l_msg_head_pz->tot_size_ud)
-                 || (l_parts_copied_ud != l_msg_head_pz->part_ud)
+    return ERROR (HL_BLOCKS_K_ERROR_READ_ALL, "Nothing more to read.");
+}/*hl_blocks_r_read()*/
+
+
+extern void hl_blocks_r_cursor_init (
+          hl_blocks_cursor_t*         p_cursor_pz)
+{
+    memset (p_cursor_pz, 0, sizeof (hl_blocks_cursor_t));
+}/*hl_blocks_r_cursor_init()*/
+
+
+extern int hl_blocks_r_read_tags (
+          hl_blocks_t*                p_blocks_pz,
+          hl_blocks_cursor_t*         p_cursor_pz,
+    const uint64_t                    p_tag_mask_ud,
+          void*                       p_buff_data_p,
+    const size_t                      p_buff_size_ud,
+          size_t*                     p_read_size_pud,
+          hl_blocks_msg_seq_t*        p_read_seq_pud,
+          uint32_t*                   p_tag_pud)
+{
+    if (  (p_blocks_pz == NULL)
+       || (p_cursor_pz == NULL)
+       || (p_buff_data_p == NULL)
+       || (p_buff_size_ud == 0)
+       || (p_read_size_pud == NULL))
+        return ERROR (-1, "invalid params for hl_blocks_r_read_tags(%p,%p,0x%llx,%p,%zu,%p)",
+            p_blocks_pz,
+            p_cursor_pz,
+            (unsigned long long)p_tag_mask_ud,
+            p_buff_data_p,
+            p_buff_size_ud,
+            p_read_size_pud);
+
+    uint64_t l_start_ns_ud = m_r_latency_start (p_blocks_pz);
+
+    //highest prio first, like hl_blocks_r_read()
+    for (uint32_t l_prio_ud = p_blocks_pz->nr_prios_ud; l_prio_ud > 0; ) {
+        l_prio_ud --;
+        int l_result_d = m_r_read_lane_tags (
+            p_blocks_pz,
+            l_prio_ud,
+            &p_cursor_pz->lane_az[l_prio_ud],
+            p_tag_mask_ud,
+            p_buff_data_p,
+            p_buff_size_ud,
+            p_read_size_pud,
+            p_read_seq_pud,
+            p_tag_pud);
+        if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+            continue;
+        if (l_result_d == 0)
+            m_r_latency_add (p_blocks_pz, HL_BLOCKS_K_LATENCY_READ, l_start_ns_ud);
+        return l_result_d;
+    }/*for each lane*/
+
+    return ERROR (HL_BLOCKS_K_ERROR_READ_ALL, "Nothing more with the tags to read.");
+}/*hl_blocks_r_read_tags()*/
+
+
+extern int hl_blocks_r_release (
+          hl_blocks_t*                p_blocks_pz,
+          hl_blocks_cursor_t* const   p_cursor_apz[],
+    const uint32_t                    p_nr_cursors_ud,
+          uint32_t*                   p_nr_released_pud)
+{
+    if (  (p_blocks_pz == NULL)
+       || (  (p_cursor_apz == NULL)
+          && (p_nr_cursors_ud > 0)))
+        return ERROR (-1, "invalid params for hl_blocks_r_release(%p,%p,%u)",
+            p_blocks_pz,
+            p_cursor_apz,
+            p_nr_cursors_ud);
+
+    uint32_t l_nr_released_ud = 0;
+    for (uint32_t l_prio_ud = 0; (l_prio_ud < p_blocks_pz->nr_prios_ud) && (p_nr_cursors_ud > 0); l_prio_ud++) {
+        //slowest cursor, nothing is passed when one did not copy anything yet
+        hl_blocks_msg_seq_t l_min_seq_ud = p_cursor_apz[0]->lane_az[l_prio_ud].last_seq_ud;
+        for (uint32_t l_nr_ud = 1; (l_nr_ud < p_nr_cursors_ud) && (l_min_seq_ud != 0); l_nr_ud++) {
+            hl_blocks_msg_seq_t l_seq_ud = p_cursor_apz[l_nr_ud]->lane_az[l_prio_ud].last_seq_ud;
+            if (  (l_seq_ud == 0)
+               || ((int32_t)(l_seq_ud - l_min_seq_ud) < 0))
+                l_min_seq_ud = l_seq_ud;
+        }/*for each cursor*/
+        if (l_min_seq_ud != 0)
+            l_nr_released_ud += m_r_release_lane (p_blocks_pz, l_prio_ud, l_min_seq_ud);
+    }/*for each lane*/
+    m_r_advance_tail (p_blocks_pz);
+
+    M_STAT_ADD (p_blocks_pz, blocks_released_ud, l_nr_released_ud);
+    DEBUG ("released %u blocks behind %u cursors", l_nr_released_ud, p_nr_cursors_ud);
+    if (p_nr_released_pud != NULL)
+        *p_nr_released_pud = l_nr_released_ud;
+    return SUCCESS ();
+}/*hl_blocks_r_release()*/
+
+
+extern int hl_blocks_r_drain_fd (
+          hl_blocks_t*                p_blocks_pz,
+    const int                         p_fd_d,
+    const size_t                      p_max_bytes_ud,
+    const hl_blocks_framing_e         p_framing_e,
+          size_t*                     p_drained_pud,
+          uint32_t*                   p_nr_msgs_pud)
+{
+    if (  (p_blocks_pz == NULL)
+       || (p_fd_d < 0)
+       || (p_max_bytes_ud == 0)
+       || (p_framing_e < 0)
+       || (p_framing_e >= HL_BLOCKS_K_FRAMING_NR_OF))
+        return ERROR (-1, "invalid params for hl_blocks_r_drain_fd(%p,%d,%zu,%d)",
+            p_blocks_pz,
+            p_fd_d,
+            p_max_bytes_ud,
+            p_framing_e);
+    if (p_drained_pud != NULL)
+        *p_drained_pud = 0;
+    if (p_nr_msgs_pud != NULL)
+        *p_nr_msgs_pud = 0;
+
+    struct iovec                l_iov_az[M_DRAIN_MAX_IOV];
+    uint32_t                    l_frame_aud[M_DRAIN_MAX_IOV];
+    m_drain_msg_t               l_msg_az[M_DRAIN_MAX_IOV];
+    uint32_t                    l_nr_iov_ud     = 0;
+    uint32_t                    l_nr_msgs_ud    = 0;
+    size_t                      l_gathered_ud   = 0;    //bytes of whole messages gathered
+    uint32_t                    l_frame_size_ud = (p_framing_e == HL_BLOCKS_K_FRAMING_LEN32) ? sizeof (uint32_t) : 0;
+    int                         l_full_d        = 0;
+
+    //lanes in read order, starting with the one of a partly drained message
+    //the gathered bytes include what was already drained of that message
+    for (uint32_t l_nr_ud = 0; (l_nr_ud <= p_blocks_pz->nr_prios_ud) && (!l_full_d); l_nr_ud++)
+    {
+        uint32_t l_prio_ud;
+        if (l_nr_ud == 0) {
+            if (p_blocks_pz->drain_ofs_ud == 0)
+                continue;
+            l_prio_ud = p_blocks_pz->drain_prio_ud;
+        } else {
+            l_prio_ud = p_blocks_pz->nr_prios_ud - l_nr_ud;
+            if (  (p_blocks_pz->drain_ofs_ud > 0)
+               && (l_prio_ud == p_blocks_pz->drain_prio_ud))
+                continue;
+        }
+
+        m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[l_prio_ud];
+        m_drain_pos_t l_pos_z = {
+            .rd_idx_ud      = l_lane_pz->rd_idx_ud,
+            .rd_ofs_ud      = l_lane_pz->rd_ofs_ud,
+            .heap_ofs_ud    = 0,
+        };
+        while (1)
+        {
+            //lower prios only after all of this one
+            if (  (l_gathered_ud >= p_max_bytes_ud + p_blocks_pz->drain_ofs_ud)
+               || (l_nr_msgs_ud >= M_DRAIN_MAX_IOV)) {
+                l_full_d = 1;
+                break;
+            }
+
+            m_drain_pos_t l_msg_pos_z = l_pos_z;
+            uint32_t l_msg_iov_ud = l_nr_iov_ud;
+            const msg_head_t* l_msg_head_pz = m_r_drain_part (p_blocks_pz, l_prio_ud, &l_msg_pos_z);
+            if (l_msg_head_pz == NULL)
+                break;      //lane empty
+
+            if (l_msg_head_pz->part_ud != 0)
+            {
+                if (l_nr_msgs_ud > 0) {
+                    l_full_d = 1;   //drain what is before it first
+                    break;
+                }
+
+                //same as hl_blocks_r_read(): skip the rest of a dropped message
+                if (m_r_dropped_msg_part (p_blocks_pz, l_msg_head_pz)) {
+                    M_STAT_ADD (p_blocks_pz, drop_blks_ud, m_r_skip_continued_parts (p_blocks_pz, l_prio_ud));
+                    m_r_advance_tail (p_blocks_pz);
+                    l_pos_z.rd_idx_ud   = l_lane_pz->rd_idx_ud;
+                    l_pos_z.rd_ofs_ud   = l_lane_pz->rd_ofs_ud;
+                    l_pos_z.heap_ofs_ud = 0;
+                    continue;
+                }
+
+                //same as hl_blocks_r_read(): continue in the next block
+                M_STAT_ADD (p_blocks_pz, corruptions_ud, 1);
+                M_PROBE4 (corruption,
+                    l_lane_pz->rd_idx_ud,
+                    l_msg_head_pz->seq_ud,
+                    l_msg_head_pz->part_ud,
+                    l_msg_head_pz->part_size_ud);
+                ERROR_LOG ("Data corruption, drain at msg head(%u,%u,%u,%u)",
+                    l_msg_head_pz->seq_ud,
+                    l_msg_head_pz->tot_size_ud,
+                    l_msg_head_pz->part_ud,
+                    l_msg_head_pz->part_size_ud);
+                if (l_lane_pz->rd_idx_ud != p_blocks_pz->wr_idx_ud)
+                {
+                    const void*                 l_block_p;
+                    m_r_flash_addr (p_blocks_pz, l_lane_pz->rd_idx_ud, &l_block_p);
+                    m_r_block_release (p_blocks_pz, l_lane_pz->rd_idx_ud, (const blk_head_t*)l_block_p);
+                    m_r_lane_next_block (p_blocks_pz, l_prio_ud);
+                    m_r_advance_tail (p_blocks_pz);
+                }
+                p_blocks_pz->drain_ofs_ud = 0;
+                return ERROR (HL_BLOCKS_K_ERROR_CORRUPTED, "data corrupted - see error log");
+            }/*if not at start of message*/
+
+            if (l_frame_size_ud > 0) {
+                l_frame_aud[l_nr_msgs_ud] = htonl (l_msg_head_pz->tot_size_ud);
+                l_iov_az[l_nr_iov_ud].iov_base = &l_frame_aud[l_nr_msgs_ud];
+                l_iov_az[l_nr_iov_ud].iov_len  = l_frame_size_ud;
+                l_nr_iov_ud ++;
+            }
+
+            //all parts of the message, which may continue in later blocks
+            hl_blocks_msg_seq_t l_msg_seq_ud = l_msg_head_pz->seq_ud;
+            uint32_t l_tot_size_ud = l_msg_head_pz->tot_size_ud;
+            uint32_t l_got_size_ud = 0;
+            uint32_t l_part_ud = 0;
+            while (1)
+            {
+                if (  (l_nr_iov_ud >= M_DRAIN_MAX_IOV)
+                   || (l_msg_head_pz->seq_ud != l_msg_seq_ud)
+                   || (l_msg_head_pz->part_ud != l_part_ud)
+                   || (l_got_size_ud + l_msg_head_pz->part_size_ud > l_tot_size_ud))
+                    break;
+                l_iov_az[l_nr_iov_ud].iov_base = (void*)((const unsigned char*)l_msg_head_pz + sizeof (msg_head_t));
+                l_iov_az[l_nr_iov_ud].iov_len  = l_msg_head_pz->part_size_ud;
+                l_nr_iov_ud ++;
+                l_got_size_ud += l_msg_head_pz->part_size_ud;
+                l_part_ud ++;
+                if (l_got_size_ud >= l_tot_size_ud)
+                    break;
+                l_msg_head_pz = m_r_drain_part (p_blocks_pz, l_prio_ud, &l_msg_pos_z);
+                if (l_msg_head_pz == NULL)
+                    break;
+            }/*while more parts*/
+
+            if (l_got_size_ud < l_tot_size_ud)
+            {
+                //out of iovecs or a bad part, which is found by the next call
+                l_nr_iov_ud = l_msg_iov_ud;
+                l_full_d = 1;
+                break;
+            }
+
+            l_msg_az[l_nr_msgs_ud].prio_ud   = l_prio_ud;
+            l_msg_az[l_nr_msgs_ud].size_ud   = l_frame_size_ud + l_tot_size_ud;
+            l_msg_az[l_nr_msgs_ud].end_pos_z = l_msg_pos_z;
+            l_nr_msgs_ud ++;
+            l_gathered_ud += l_frame_size_ud + l_tot_size_ud;
+            l_pos_z = l_msg_pos_z;
+        }/*while gathering messages of this lane*/
+
+        if (  (l_nr_ud == 0)
+           && (l_nr_msgs_ud == 0))
+            p_blocks_pz->drain_ofs_ud = 0;  //partly drained message no longer there
+    }/*for each lane*/
+
+    if (l_nr_msgs_ud == 0)
+        return ERROR (HL_BLOCKS_K_ERROR_READ_ALL, "Nothing more to read.");
+
+    //skip what was drained before and stop at the max
+    uint32_t l_first_iov_ud = 0;
+    size_t l_skip_ud = p_blocks_pz->drain_ofs_ud;
+    while (l_skip_ud >= l_iov_az[l_first_iov_ud].iov_len) {
+        l_skip_ud -= l_iov_az[l_first_iov_ud].iov_len;
+        l_first_iov_ud ++;
+    }
+    l_iov_az[l_first_iov_ud].iov_base = (unsigned char*)l_iov_az[l_first_iov_ud].iov_base + l_skip_ud;
+    l_iov_az[l_first_iov_ud].iov_len -= l_skip_ud;
+    size_t l_rem_ud = p_max_bytes_ud;
+    uint32_t l_end_iov_ud = l_first_iov_ud;
+    while ((l_end_iov_ud < l_nr_iov_ud) && (l_rem_ud > 0)) {
+        if (l_iov_az[l_end_iov_ud].iov_len > l_rem_ud)
+            l_iov_az[l_end_iov_ud].iov_len = l_rem_ud;
+        l_rem_ud -= l_iov_az[l_end_iov_ud].iov_len;
+        l_end_iov_ud ++;
+    }
+
+    ssize_t l_written_d;
+    do {
+        l_written_d = writev (p_fd_d, &l_iov_az[l_first_iov_ud], (int)(l_end_iov_ud - l_first_iov_ud));
+    } while ((l_written_d < 0) && (errno == EINTR));
+    if (l_written_d < 0)
+    {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+            return SUCCESS ();
+        return ERROR (-1, "failed to write %u messages to fd %d: %s", l_nr_msgs_ud, p_fd_d, strerror (errno));
+    }
+
+    //consume the messages written completely
+    size_t l_done_ud = p_blocks_pz->drain_ofs_ud + (size_t)l_written_d;
+    m_drain_pos_t* l_lane_pos_apz[HL_BLOCKS_MAX_PRIOS] = {NULL};
+    uint32_t l_nr_done_ud = 0;
+    while (  (l_nr_done_ud < l_nr_msgs_ud)
+          && (l_done_ud >= l_msg_az[l_nr_done_ud].size_ud))
+    {
+        l_done_ud -= l_msg_az[l_nr_done_ud].size_ud;
+        M_STAT_ADD (p_blocks_pz, bytes_read_ud, l_msg_az[l_nr_done_ud].size_ud - l_frame_size_ud);
+        l_lane_pos_apz[l_msg_az[l_nr_done_ud].prio_ud] = &l_msg_az[l_nr_done_ud].end_pos_z;
+        l_nr_done_ud ++;
+    }
+    for (uint32_t l_prio_ud = 0; l_prio_ud < p_blocks_pz->nr_prios_ud; l_prio_ud++) {
+        if (l_lane_pos_apz[l_prio_ud] != NULL)
+            m_r_drain_seek (p_blocks_pz, l_prio_ud, l_lane_pos_apz[l_prio_ud]);
+    }
+    M_STAT_ADD (p_blocks_pz, msgs_read_ud, l_nr_done_ud);
+    p_blocks_pz->drain_ofs_ud = (uint32_t)l_done_ud;
+    if (l_done_ud > 0)
+        p_blocks_pz->drain_prio_ud = l_msg_az[l_nr_done_ud].prio_ud;
+
+    DEBUG ("drain-->fd %d %zd bytes, %u msgs, partly %u bytes",
+        p_fd_d,
+        l_written_d,
+        l_nr_done_ud,
+        p_blocks_pz->drain_ofs_ud);
+    if (p_drained_pud != NULL)
+        *p_drained_pud = (size_t)l_written_d;
+    if (p_nr_msgs_pud != NULL)
+        *p_nr_msgs_pud = l_nr_done_ud;
+    return SUCCESS ();
+}/*hl_blocks_r_drain_fd()*/
+
+
+extern int hl_blocks_r_set_full_mode (
+          hl_blocks_t*                p_blocks_pz,
+    const hl_blocks_full_mode_e       p_full_mode_e)
+{
+    if (  (p_blocks_pz == NULL)
+       || (p_full_mode_e < 0)
+       || (p_full_mode_e >= HL_BLOCKS_K_FULL_MODE_NR_OF))
+        return ERROR (-1, "invalid params for hl_blocks_r_set_full_mode(%p,%d)",
+            p_blocks_pz,
+            p_full_mode_e);
+
+    if (  (p_full_mode_e == HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST)
+       && (p_blocks_pz->nr_blocks_ud < 2))
+        return ERROR (-1, "overwrite mode requires at least 2 blocks, not %u",
+            p_blocks_pz->nr_blocks_ud);
+
+    p_blocks_pz->full_mode_e = p_full_mode_e;
+    return SUCCESS ();
+}/*hl_blocks_r_set_full_mode()*/
+
+
+extern int hl_blocks_r_set_writev (
+          hl_blocks_t*                p_blocks_pz,
+          hl_blocks_writev_r*         p_writev_pr)
+{
+    if (p_blocks_pz == NULL)
+        return ERROR (-1, "invalid params for hl_blocks_r_set_writev(NULL)");
+    p_blocks_pz->writev_pr = p_writev_pr;
+    return SUCCESS ();
+}/*hl_blocks_r_set_writev()*/
+
+
+extern int hl_blocks_r_get_dropped (
+    const hl_blocks_t*                p_blocks_pz,
+          uint32_t*                   p_nr_msgs_pud,
+          uint32_t*                   p_nr_blocks_pud,
+          hl_blocks_msg_seq_t*        p_first_seq_pud,
+          hl_blocks_msg_seq_t*        p_last_seq_pud)
+{
+    if (p_blocks_pz == NULL)
+        return ERROR (-1, "invalid params for hl_blocks_r_get_dropped(NULL)");
+
+    if (p_nr_msgs_pud != NULL)
+        *p_nr_msgs_pud = (uint32_t)p_blocks_pz->stats_z.drop_msgs_ud;
+    if (p_nr_blocks_pud != NULL)
+        *p_nr_blocks_pud = (uint32_t)p_blocks_pz->stats_z.drop_blks_ud;
+    if (p_first_seq_pud != NULL)
+        *p_first_seq_pud = p_blocks_pz->drop_first_seq_ud;
+    if (p_last_seq_pud != NULL)
+        *p_last_seq_pud = p_blocks_pz->drop_last_seq_ud;
+    return SUCCESS ();
+}/*hl_blocks_r_get_dropped()*/
+
+
+extern int hl_blocks_r_get_stats (
+    const hl_blocks_t*                p_blocks_pz,
+          hl_blocks_stats_t*          p_stats_pz)
+{
+    if (  (p_blocks_pz == NULL)
+       || (p_stats_pz == NULL))
+        return ERROR (-1, "invalid params for hl_blocks_r_get_stats(%p,%p)", p_blocks_pz, p_stats_pz);
+
+    p_stats_pz->msgs_written_ud     = M_STAT_GET (p_blocks_pz, msgs_written_ud);
+    p_stats_pz->bytes_written_ud    = M_STAT_GET (p_blocks_pz, bytes_written_ud);
+    p_stats_pz->msgs_split_ud       = M_STAT_GET (p_blocks_pz, msgs_split_ud);
+    p_stats_pz->msgs_moved_whole_ud = M_STAT_GET (p_blocks_pz, msgs_moved_whole_ud);
+    p_stats_pz->whole_pad_bytes_ud  = M_STAT_GET (p_blocks_pz, whole_pad_bytes_ud);
+    p_stats_pz->parts_written_ud    = M_STAT_GET (p_blocks_pz, parts_written_ud);
+    p_stats_pz->msgs_read_ud        = M_STAT_GET (p_blocks_pz, msgs_read_ud);
+    p_stats_pz->bytes_read_ud       = M_STAT_GET (p_blocks_pz, bytes_read_ud);
+    p_stats_pz->msgs_skipped_ud     = M_STAT_GET (p_blocks_pz, msgs_skipped_ud);
+    p_stats_pz->blocks_skipped_ud   = M_STAT_GET (p_blocks_pz, blocks_skipped_ud);
+    p_stats_pz->blocks_released_ud  = M_STAT_GET (p_blocks_pz, blocks_released_ud);
+    p_stats_pz->reads_heap_ud       = M_STAT_GET (p_blocks_pz, reads_heap_ud);
+    p_stats_pz->reads_flash_ud      = M_STAT_GET (p_blocks_pz, reads_flash_ud);
+    p_stats_pz->syncs_full_ud       = M_STAT_GET (p_blocks_pz, syncs_full_ud);
+    p_stats_pz->syncs_explicit_ud   = M_STAT_GET (p_blocks_pz, syncs_explicit_ud);
+    p_stats_pz->blocks_written_ud   = M_STAT_GET (p_blocks_pz, blocks_written_ud);
+    p_stats_pz->blocks_direct_ud    = M_STAT_GET (p_blocks_pz, blocks_direct_ud);
+    p_stats_pz->block_used_ud       = M_STAT_GET (p_blocks_pz, block_used_ud);
+    p_stats_pz->pad_bytes_ud        = M_STAT_GET (p_blocks_pz, pad_bytes_ud);
+    p_stats_pz->align_pad_bytes_ud  = M_STAT_GET (p_blocks_pz, align_pad_bytes_ud);
+    p_stats_pz->rejects_full_ud     = M_STAT_GET (p_blocks_pz, rejects_full_ud);
+    p_stats_pz->corruptions_ud      = M_STAT_GET (p_blocks_pz, corruptions_ud);
+    p_stats_pz->drop_msgs_ud        = M_STAT_GET (p_blocks_pz, drop_msgs_ud);
+    p_stats_pz->drop_blks_ud        = M_STAT_GET (p_blocks_pz, drop_blks_ud);
+
+    //block_size_ud and the header do not change after open
+    p_stats_pz->fill_ratio_d = 0.0;
+    if (p_stats_pz->blocks_written_ud > 0)
+        p_stats_pz->fill_ratio_d = (double)p_stats_pz->block_used_ud
+            / ((double)p_stats_pz->blocks_written_ud * p_blocks_pz->data_size_ud);
+    return SUCCESS ();
+}/*hl_blocks_r_get_stats()*/
+
+
+extern int hl_blocks_r_get_latency (
+          hl_blocks_t*                p_blocks_pz,
+    const hl_blocks_latency_e         p_latency_e,
+    const int                         p_reset_d,
+          latency_hist_t*             p_hist_pz)
+{
+    if (  (p_blocks_pz == NULL)
+       || (p_latency_e < 0)
+       || (p_latency_e >= HL_BLOCKS_K_LATENCY_NR_OF)
+       || (p_hist_pz == NULL))
+        return ERROR (-1, "invalid params for hl_blocks_r_get_latency(%p,%d,%p)",
+            p_blocks_pz,
+            p_latency_e,
+            p_hist_pz);
+    if (p_blocks_pz->lat_az == NULL)
+        return ERROR (-1, "latency not kept, open with latency_ud = 1");
+
+    latency_hist_t              l_now_z;
+    latency_hist_r_snapshot (&p_blocks_pz->lat_az[p_latency_e], &l_now_z);
+    *p_hist_pz = l_now_z;
+    latency_hist_r_sub (p_hist_pz, &p_blocks_pz->lat_reset_az[p_latency_e]);
+    if (p_reset_d)
+        p_blocks_pz->lat_reset_az[p_latency_e] = l_now_z;
+    return SUCCESS ();
+}/*hl_blocks_r_get_latency()*/
+
+
+extern uint32_t hl_blocks_r___get_write_count (
+    const hl_blocks_t*                p_blocks_pz)
+{
+    if (p_blocks_pz == NULL)
+        return 0;
+    return (uint32_t)M_STAT_GET (p_blocks_pz, blocks_written_ud);
+}
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+static void m_r_free (
+          hl_blocks_t*                p_blocks_pz)
+{
+    for (uint32_t l_prio_ud = 0; l_prio_ud < p_blocks_pz->nr_prios_ud; l_prio_ud++)
+        free (p_blocks_pz->lane_az[l_prio_ud].wr_blk_data_auc);
+    free (p_blocks_pz->ckpt_blk_data_auc);
+    free (p_blocks_pz->rel_blk_data_auc);
+    free (p_blocks_pz->crc_seq_aud);
+    free (p_blocks_pz->lat_az);
+    free (p_blocks_pz->lat_reset_az);
+    free (p_blocks_pz);
+}/*m_r_free()*/
+
+
+//write the positions into the checkpoint block not written last time,
+//so the other one is still valid if this write is interrupted
+static int m_r_checkpoint_write (
+          hl_blocks_t*                p_blocks_pz)
+{
+    checkpoint_t                l_ckpt_z;
+    memset (&l_ckpt_z, 0, sizeof (l_ckpt_z));
+    l_ckpt_z.magic_ud           = HL_BLOCKS_CHECKPOINT_MAGIC;
+    l_ckpt_z.generation_ud      = p_blocks_pz->ckpt_generation_ud + 1;
+    l_ckpt_z.block_size_ud      = p_blocks_pz->block_size_ud;
+    l_ckpt_z.nr_blocks_ud       = p_blocks_pz->nr_blocks_ud;
+    l_ckpt_z.nr_prios_ud        = p_blocks_pz->nr_prios_ud;
+    l_ckpt_z.last_blk_seq_ud    = p_blocks_pz->last_blk_seq_ud;
+    l_ckpt_z.wr_idx_ud          = p_blocks_pz->wr_idx_ud;
+    l_ckpt_z.rd_idx_ud          = p_blocks_pz->rd_idx_ud;
+    l_ckpt_z.last_msg_seq_ud    = p_blocks_pz->last_msg_seq_ud;
+    for (uint32_t l_prio_ud = 0; l_prio_ud < p_blocks_pz->nr_prios_ud; l_prio_ud++) {
+        l_ckpt_z.lane_rd_idx_aud[l_prio_ud] = p_blocks_pz->lane_az[l_prio_ud].rd_idx_ud;
+        l_ckpt_z.lane_rd_ofs_aud[l_prio_ud] = p_blocks_pz->lane_az[l_prio_ud].rd_ofs_ud;
+    }
+    l_ckpt_z.crc_ud = crc32_r_update (0, &l_ckpt_z, offsetof (checkpoint_t, crc_ud));
+
+    memcpy (p_blocks_pz->ckpt_blk_data_auc, &l_ckpt_z, sizeof (l_ckpt_z));
+    uint32_t l_idx_ud = l_ckpt_z.generation_ud % HL_BLOCKS_CHECKPOINT_BLOCKS;
+    if ((*p_blocks_pz->write_pr) (l_idx_ud, p_blocks_pz->ckpt_blk_data_auc) != 0)
+        return ERROR (-1, "Failed to write checkpoint to flash blk[%u]", l_idx_ud);
+    p_blocks_pz->ckpt_generation_ud = l_ckpt_z.generation_ud;
+    p_blocks_pz->ckpt_blocks_ud     = 0;
+    p_blocks_pz->ckpt_blk_seq_ud    = l_ckpt_z.last_blk_seq_ud;
+    return SUCCESS ();
+}/*m_r_checkpoint_write()*/
+
+
+//resume from the newest valid checkpoint, then roll forward over
+//blocks written after it and blocks read after it
+//return error to resume with m_r_open_scan() instead
+static int m_r_checkpoint_restore (
+          hl_blocks_t*                p_blocks_pz)
+{
+    checkpoint_t                l_ckpt_z;
+    memset (&l_ckpt_z, 0, sizeof (l_ckpt_z));
+    for (uint32_t l_idx_ud = 0; l_idx_ud < HL_BLOCKS_CHECKPOINT_BLOCKS; l_idx_ud++) {
+        const void*                 l_block_p;
+        if (m_r_abs_addr (p_blocks_pz, l_idx_ud, &l_block_p) != 0)
+            continue;
+        checkpoint_t            l_read_z;
+        memcpy (&l_read_z, l_block_p, sizeof (l_read_z));
+        if (  (l_read_z.magic_ud != HL_BLOCKS_CHECKPOINT_MAGIC)
+           || (l_read_z.crc_ud != crc32_r_update (0, &l_read_z, offsetof (checkpoint_t, crc_ud))))
+            continue;
+        if (l_read_z.generation_ud > l_ckpt_z.generation_ud)
+            l_ckpt_z = l_read_z;
+    }/*for each checkpoint block*/
+
+    if (l_ckpt_z.generation_ud == 0)
+        return ERROR (-1, "No valid checkpoint");
+    p_blocks_pz->ckpt_generation_ud = l_ckpt_z.generation_ud;
+    p_blocks_pz->ckpt_blk_seq_ud    = l_ckpt_z.last_blk_seq_ud;
+    if (  (l_ckpt_z.block_size_ud != p_blocks_pz->block_size_ud)
+       || (l_ckpt_z.nr_blocks_ud != p_blocks_pz->nr_blocks_ud)
+       || (l_ckpt_z.nr_prios_ud != p_blocks_pz->nr_prios_ud)
+       || (l_ckpt_z.wr_idx_ud >= p_blocks_pz->nr_blocks_ud)
+       || (l_ckpt_z.rd_idx_ud >= p_blocks_pz->nr_blocks_ud))
+        return ERROR (-1, "Checkpoint %u is for %u blocks x %u bytes with %u prios",
+            l_ckpt_z.generation_ud,
+            l_ckpt_z.nr_blocks_ud,
+            l_ckpt_z.block_size_ud,
+            l_ckpt_z.nr_prios_ud);
+
+    //the block before the head is the last written, unless already read
+    uint32_t l_last_idx_ud = (l_ckpt_z.wr_idx_ud + p_blocks_pz->nr_blocks_ud - 1) % p_blocks_pz->nr_blocks_ud;
+    uint32_t l_last_seq_ud = m_r_block_valid_seq (p_blocks_pz, l_last_idx_ud);
+    if (  (l_ckpt_z.last_blk_seq_ud > 0)
+       && (l_last_seq_ud != 0)
+       && (l_last_seq_ud != l_ckpt_z.last_blk_seq_ud))
+        return ERROR (-1, "Checkpoint %u last blk[%u] seq=%u != %u in flash",
+            l_ckpt_z.generation_ud,
+            l_last_idx_ud,
+            l_ckpt_z.last_blk_seq_ud,
+            l_last_seq_ud);
+
+    //with blocks between checkpoints the ring may have wrapped over the
+    //read positions since, only the first block written after it may
+    //be where a lane was reading from heap
+    for (uint32_t l_prio_ud = 0; l_prio_ud <= p_blocks_pz->nr_prios_ud; l_prio_ud++) {
+        uint32_t l_rd_idx_ud = (l_prio_ud < p_blocks_pz->nr_prios_ud)
+            ? l_ckpt_z.lane_rd_idx_aud[l_prio_ud] % p_blocks_pz->nr_blocks_ud
+            : l_ckpt_z.rd_idx_ud;
+        uint32_t l_rd_seq_ud = m_r_block_valid_seq (p_blocks_pz, l_rd_idx_ud);
+        if (  (l_rd_seq_ud > l_ckpt_z.last_blk_seq_ud)
+           && (  (l_rd_idx_ud != l_ckpt_z.wr_idx_ud)
+              || (l_rd_seq_ud != l_ckpt_z.last_blk_seq_ud + 1)))
+            return ERROR (-1, "Checkpoint %u read position blk[%u] was written again since",
+                l_ckpt_z.generation_ud,
+                l_rd_idx_ud);
+    }/*for each lane and the tail*/
+
+    p_blocks_pz->last_blk_seq_ud = l_ckpt_z.last_blk_seq_ud;
+    p_blocks_pz->wr_idx_ud       = l_ckpt_z.wr_idx_ud;
+    p_blocks_pz->rd_idx_ud       = l_ckpt_z.rd_idx_ud;
+    p_blocks_pz->last_msg_seq_ud = l_ckpt_z.last_msg_seq_ud;
+    uint32_t l_old_wr_idx_ud     = l_ckpt_z.wr_idx_ud;
+
+    //roll forward over blocks written after the checkpoint,
+    //only the crc of the last one is checked, which may not be completely written
+    for (uint32_t l_count_ud = 0; l_count_ud < p_blocks_pz->nr_blocks_ud; l_count_ud++) {
+        if (m_r_block_head_seq (p_blocks_pz, p_blocks_pz->wr_idx_ud) != p_blocks_pz->last_blk_seq_ud + 1)
+            break;
+        uint32_t l_next_idx_ud = (p_blocks_pz->wr_idx_ud + 1) % p_blocks_pz->nr_blocks_ud;
+        if (  (  (l_count_ud + 1 == p_blocks_pz->nr_blocks_ud)
+              || (m_r_block_head_seq (p_blocks_pz, l_next_idx_ud) != p_blocks_pz->last_blk_seq_ud + 2))
+           && (m_r_block_valid_seq (p_blocks_pz, p_blocks_pz->wr_idx_ud) == 0))
+            break;
+
+        const void*                 l_block_p;
+        m_r_flash_addr (p_blocks_pz, p_blocks_pz->wr_idx_ud, &l_block_p);
+        const blk_head_t* l_blk_head_pz = (const blk_head_t*)l_block_p;
+        const unsigned char* l_block_data_puc = (const unsigned char*)l_block_p + sizeof (blk_head_t);
+        uint32_t l_rd_ofs_ud = 0;
+        while (l_rd_ofs_ud < l_blk_head_pz->used_size_ud)
+        {
+            const msg_head_t* l_msg_head_pz = (const msg_head_t*)(l_block_data_puc + l_rd_ofs_ud);
+            l_rd_ofs_ud += HL_BLOCKS_PART_STEP (l_blk_head_pz->align_ud, l_msg_head_pz->part_size_ud);
+            if (l_msg_head_pz->seq_ud > p_blocks_pz->last_msg_seq_ud)
+                p_blocks_pz->last_msg_seq_ud = l_msg_head_pz->seq_ud;
+        }/*while reading message parts in this block*/
+
+        p_blocks_pz->last_blk_seq_ud ++;
+        p_blocks_pz->wr_idx_ud = (p_blocks_pz->wr_idx_ud + 1) % p_blocks_pz->nr_blocks_ud;
+    }/*for each block written after the checkpoint*/
+
+    //lanes continue where they were, or at their next block when
+    //the block was read after the checkpoint
+    for (uint32_t l_prio_ud = 0; l_prio_ud < p_blocks_pz->nr_prios_ud; l_prio_ud++) {
+        m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[l_prio_ud];
+        l_lane_pz->rd_idx_ud = l_ckpt_z.lane_rd_idx_aud[l_prio_ud] % p_blocks_pz->nr_blocks_ud;
+        l_lane_pz->rd_ofs_ud = l_ckpt_z.lane_rd_ofs_aud[l_prio_ud];
+        if (l_lane_pz->rd_idx_ud == p_blocks_pz->wr_idx_ud)
+            continue;
+        if (  (m_r_block_valid_seq (p_blocks_pz, l_lane_pz->rd_idx_ud) == 0)
+           || (m_r_block_prio (p_blocks_pz, l_lane_pz->rd_idx_ud) != l_prio_ud))
+        {
+            //its block was read, or it was reading from heap and another prio was written
+            m_r_lane_next_block (p_blocks_pz, l_prio_ud);
+            m_r_skip_continued_parts (p_blocks_pz, l_prio_ud);
+        }
+        else if (l_lane_pz->rd_idx_ud == l_old_wr_idx_ud)
+        {
+            //it was reading from heap, which is now in this block
+            l_lane_pz->rd_ofs_ud = 0;
+        }
+    }/*for each lane*/
+    m_r_advance_tail (p_blocks_pz);
+
+    DEBUG ("Restored checkpoint %u and rolled forward %u blocks",
+        l_ckpt_z.generation_ud,
+        p_blocks_pz->last_blk_seq_ud - l_ckpt_z.last_blk_seq_ud);
+    return SUCCESS ();
+}/*m_r_checkpoint_restore()*/
+
+
+//blocks of the ring are after the checkpoint blocks in flash
+static int m_r_flash_addr (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud,
+    const void**                      p_block_pp)
+{
+    return m_r_abs_addr (p_blocks_pz, p_blocks_pz->first_idx_ud + p_block_idx_ud, p_block_pp);
+}/*m_r_flash_addr()*/
+
+
+//address of a block incl the checkpoint blocks
+//inlined arithmetic for a linear mapping, which cannot fail, so no SUCCESS() call
+static int m_r_abs_addr (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_abs_idx_ud,
+    const void**                      p_block_pp)
+{
+    if (p_blocks_pz->linear_base_puc != NULL) {
+        *p_block_pp = p_blocks_pz->linear_base_puc + (size_t)p_abs_idx_ud * p_blocks_pz->linear_stride_ud;
+        return 0;
+    }
+    return (*p_blocks_pz->addr_pr) (p_abs_idx_ud, p_block_pp);
+}/*m_r_abs_addr()*/
+
+
+static int m_r_flash_write (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud,
+    const void*                       p_block_p)
+{
+    return (*p_blocks_pz->write_pr) (p_blocks_pz->first_idx_ud + p_block_idx_ud, p_block_p);
+}/*m_r_flash_write()*/
+
+
+static int m_r_flash_writev (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud,
+    const struct iovec*               p_iov_az,
+    const int                         p_nr_iov_d)
+{
+    return (*p_blocks_pz->writev_pr) (p_blocks_pz->first_idx_ud + p_block_idx_ud, p_iov_az, p_nr_iov_d);
+}/*m_r_flash_writev()*/
+
+
+//resume from the blocks in flash by reading the header of all blocks,
+//and the message headers in the oldest and newest block of each prio
+//the crc is only checked for the newest blocks, which may not be
+//completely written, and blocks with a seq out of sequence,
+//the others when they are read, see m_r_block_valid_seq()
+static int m_r_open_scan (
+          hl_blocks_t*                p_blocks_pz)
+{
+    //see if any data already exists in the blocks
+    uint32_t                     l_min_idx_ud = 0;
+    blk_seq_t                    l_min_seq_ud = 0;
+    uint32_t                     l_max_idx_ud = 0;
+    blk_seq_t                    l_max_seq_ud = 0;
+    uint32_t                     l_lane_min_idx_aud[HL_BLOCKS_MAX_PRIOS];
+    blk_seq_t                    l_lane_min_seq_aud[HL_BLOCKS_MAX_PRIOS];
+    uint32_t                     l_lane_max_idx_aud[HL_BLOCKS_MAX_PRIOS];
+    blk_seq_t                    l_lane_max_seq_aud[HL_BLOCKS_MAX_PRIOS];
+    memset (l_lane_min_seq_aud, 0, sizeof (l_lane_min_seq_aud));
+    memset (l_lane_max_seq_aud, 0, sizeof (l_lane_max_seq_aud));
+    M_PROBE1 (open_scan_begin, p_blocks_pz->nr_blocks_ud);
+
+    //blocks without crc were written before it, so older than all with crc
+    //images with a checkpoint were never written without crc
+    p_blocks_pz->legacy_seq_ud = 0;
+    if (p_blocks_pz->first_idx_ud == 0) {
+        p_blocks_pz->legacy_seq_ud = HL_BLOCKS_ERASED_WORD;
+        for (uint32_t l_idx_ud = 0; l_idx_ud < p_blocks_pz->nr_blocks_ud; l_idx_ud++) {
+            const void*                 l_block_p;
+            m_r_flash_addr (p_blocks_pz, l_idx_ud, &l_block_p);
+            const blk_head_t* l_blk_head_pz = (const blk_head_t*)l_block_p;
+            if (  (l_blk_head_pz->flags_ud & HL_BLOCKS_BLK_FLAG_CRC)
+               && (l_blk_head_pz->seq_ud != 0)
+               && (l_blk_head_pz->seq_ud < p_blocks_pz->legacy_seq_ud))
+                p_blocks_pz->legacy_seq_ud = l_blk_head_pz->seq_ud;
+        }/*for each block*/
+    }
+
+    //newest block with a valid crc, a block with a higher seq was not
+    //completely written, e.g. power cut while writing it
+    blk_seq_t l_above_seq_ud = 0;
+    do {
+        l_max_seq_ud = 0;
+        for (uint32_t l_idx_ud = 0; l_idx_ud < p_blocks_pz->nr_blocks_ud; l_idx_ud++) {
+            uint32_t l_seq_ud = m_r_block_head_seq (p_blocks_pz, l_idx_ud);
+            if (  (l_seq_ud > l_max_seq_ud)
+               && (  (l_above_seq_ud == 0)
+                  || (l_seq_ud < l_above_seq_ud))) {
+                l_max_idx_ud = l_idx_ud;
+                l_max_seq_ud = l_seq_ud;
+            }
+        }/*for each block*/
+        l_above_seq_ud = l_max_seq_ud;
+    } while (  (l_max_seq_ud > 0)
+            && (m_r_block_valid_seq (p_blocks_pz, l_max_idx_ud) == 0));
+
+    //blocks before the newest have the seqs before it,
+    //others are not trusted without their crc
+    uint32_t l_newest_idx_ud = l_max_idx_ud;
+    blk_seq_t l_newest_seq_ud = l_max_seq_ud;
+    l_max_seq_ud = 0;
+    for (uint32_t l_idx_ud = 0; l_idx_ud < p_blocks_pz->nr_blocks_ud; l_idx_ud++) {
+        uint32_t l_seq_ud = m_r_block_head_seq (p_blocks_pz, l_idx_ud);
+        uint32_t l_before_ud = (l_newest_idx_ud + p_blocks_pz->nr_blocks_ud - l_idx_ud) % p_blocks_pz->nr_blocks_ud;
+        if (  (l_seq_ud != 0)
+           && (l_seq_ud != l_newest_seq_ud - l_before_ud))
+            l_seq_ud = m_r_block_valid_seq (p_blocks_pz, l_idx_ud);
+        if (l_seq_ud == 0) {
+            //written but not valid, e.g. power cut while writing it
+            uint32_t l_head_seq_ud = m_r_block_seq (p_blocks_pz, l_idx_ud);
+            if (  (l_head_seq_ud != 0)
+               && (l_head_seq_ud != HL_BLOCKS_ERASED_WORD)) {
+                M_STAT_ADD (p_blocks_pz, corruptions_ud, 1);
+                M_PROBE4 (corruption, l_idx_ud, 0, 0, 0);
+            }
+            continue;
+        }
+
+        if ((l_min_seq_ud == 0) || (l_seq_ud < l_min_seq_ud)) {
+            l_min_idx_ud = l_idx_ud;
+            l_min_seq_ud = l_seq_ud;
+        }
+        if ((l_max_seq_ud == 0) || (l_seq_ud > l_max_seq_ud)) {
+            l_max_idx_ud = l_idx_ud;
+            l_max_seq_ud = l_seq_ud;
+        }
+
+        //oldest and newest block of each prio
+        uint32_t l_prio_ud = m_r_block_prio (p_blocks_pz, l_idx_ud);
+        if ((l_lane_min_seq_aud[l_prio_ud] == 0) || (l_seq_ud < l_lane_min_seq_aud[l_prio_ud])) {
+            l_lane_min_idx_aud[l_prio_ud] = l_idx_ud;
+            l_lane_min_seq_aud[l_prio_ud] = l_seq_ud;
+        }
+        if ((l_lane_max_seq_aud[l_prio_ud] == 0) || (l_seq_ud > l_lane_max_seq_aud[l_prio_ud])) {
+            l_lane_max_idx_aud[l_prio_ud] = l_idx_ud;
+            l_lane_max_seq_aud[l_prio_ud] = l_seq_ud;
+        }
+    }/*for each block*/
+
+    //must have both or neither of min/max
+    if ((l_min_seq_ud > 0) ^ (l_max_seq_ud > 0))
+        return ERROR (HL_BLOCKS_K_ERROR_CORRUPTED,
+                "min(seq=%u, idx=%u), max(seq=%u, idx=%u) (requires either or both non-zero seq)",
+                l_min_seq_ud,
+                l_min_idx_ud,
+                l_max_seq_ud,
+                l_max_idx_ud);
+
+    //if seq min==max, then idx min must also be max, i.e. the same block
+    if ((l_min_seq_ud == l_max_seq_ud) ^ (l_min_idx_ud == l_max_idx_ud))
+        return ERROR (HL_BLOCKS_K_ERROR_CORRUPTED,
+                "min(seq=%u, idx=%u), max(seq=%u, idx=%u) (require none or both the same)",
+                l_min_seq_ud,
+                l_min_idx_ud,
+                l_max_seq_ud,
+                l_max_idx_ud);
+
+    if (l_min_seq_ud > 0) {
+        //found data to read
+        p_blocks_pz->rd_idx_ud = l_min_idx_ud;
+        p_blocks_pz->wr_idx_ud = (l_max_idx_ud + 1) % p_blocks_pz->nr_blocks_ud;
+        p_blocks_pz->last_blk_seq_ud = l_max_seq_ud;
+
+        for (uint32_t l_prio_ud = 0; l_prio_ud < p_blocks_pz->nr_prios_ud; l_prio_ud++) {
+            m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[l_prio_ud];
+            if (l_lane_min_seq_aud[l_prio_ud] == 0) {
+                //nothing of this prio in flash
+                l_lane_pz->rd_idx_ud = p_blocks_pz->wr_idx_ud;
+                continue;
+            }
+
+            //need to skip over partial messages at the head of the rd block
+            //i.e. parts of messages already read from earlier blocks
+            l_lane_pz->rd_idx_ud = l_lane_min_idx_aud[l_prio_ud];
+            if (m_r_block_valid_seq (p_blocks_pz, l_lane_pz->rd_idx_ud) == 0) {
+                M_STAT_ADD (p_blocks_pz, corruptions_ud, 1);
+                m_r_lane_next_block (p_blocks_pz, l_prio_ud);
+            }
+            m_r_skip_continued_parts (p_blocks_pz, l_prio_ud);
+
+            //read messages in last written block to see what is last msg_seq used
+            if (m_r_block_valid_seq (p_blocks_pz, l_lane_max_idx_aud[l_prio_ud]) == 0) {
+                M_STAT_ADD (p_blocks_pz, corruptions_ud, 1);
+                continue;
+            }
+            const void*                 l_block_p;
+            m_r_flash_addr (p_blocks_pz, l_lane_max_idx_aud[l_prio_ud], &l_block_p);
+            const blk_head_t* l_blk_head_pz = (const blk_head_t*)l_block_p;
+            const unsigned char* l_block_data_puc = (const unsigned char*)l_block_p + sizeof (blk_head_t);
+            uint32_t l_rd_ofs_ud = 0;
+            while (l_rd_ofs_ud < l_blk_head_pz->used_size_ud)
+            {
+                const msg_head_t* l_msg_head_pz = (const msg_head_t*)(l_block_data_puc + l_rd_ofs_ud);
+                l_rd_ofs_ud += HL_BLOCKS_PART_STEP (l_blk_head_pz->align_ud, l_msg_head_pz->part_size_ud);
+                if (l_msg_head_pz->seq_ud > p_blocks_pz->last_msg_seq_ud)
+                    p_blocks_pz->last_msg_seq_ud = l_msg_head_pz->seq_ud;
+            }/*while reading message parts in this block*/
+        }/*for each lane*/
+        m_r_advance_tail (p_blocks_pz);
+    }/*if found data to read*/
+    M_PROBE3 (open_scan_end, p_blocks_pz->rd_idx_ud, p_blocks_pz->wr_idx_ud, p_blocks_pz->last_blk_seq_ud);
+    return SUCCESS ();
+}/*m_r_open_scan()*/
+
+
+static uint32_t m_r_block_seq (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud)
+{
+    if (p_block_idx_ud >= p_blocks_pz->nr_blocks_ud)
+        return 0;
+
+    //get address of block to read directly from flash
+    const void*                 l_block_p;
+    m_r_flash_addr (p_blocks_pz, p_block_idx_ud, &l_block_p);
+    blk_head_t* l_block_head_pz = (blk_head_t*)l_block_p;
+    return l_block_head_pz->seq_ud;
+}/*m_r_block_seq()*/
+
+
+//seq in a block header when it is valid, else 0 as if it is empty,
+//without the crc of the data, see m_r_block_valid_seq()
+//blocks written before the crc have neither the flag nor a crc, and are
+//only older than the first block with crc, not the newest block when the
+//power was cut after writing its first bytes
+static uint32_t m_r_head_seq (
+    const hl_blocks_t*                p_blocks_pz,
+    const blk_head_t*                 p_blk_head_pz)
+{
+    if (  (p_blk_head_pz->seq_ud == 0)
+       || (p_blk_head_pz->used_size_ud > p_blocks_pz->block_size_ud - sizeof (blk_head_t)
+                                       - ((p_blk_head_pz->flags_ud & HL_BLOCKS_BLK_FLAG_TAG_MAP) ? HL_BLOCKS_TAG_MAP_SIZE : 0))
+       || (  !(p_blk_head_pz->flags_ud & HL_BLOCKS_BLK_FLAG_CRC)
+          && (  (p_blk_head_pz->crc_ud != 0)
+             || (p_blk_head_pz->used_size_ud == 0)
+             || (p_blk_head_pz->seq_ud >= p_blocks_pz->legacy_seq_ud))))
+        return 0;
+    return p_blk_head_pz->seq_ud;
+}/*m_r_head_seq()*/
+
+
+//seq of a flash block when its header is valid, see m_r_head_seq()
+static uint32_t m_r_block_head_seq (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud)
+{
+    if (p_block_idx_ud >= p_blocks_pz->nr_blocks_ud)
+        return 0;
+
+    const void*                 l_block_p;
+    m_r_flash_addr (p_blocks_pz, p_block_idx_ud, &l_block_p);
+    return m_r_head_seq (p_blocks_pz, (const blk_head_t*)l_block_p);
+}/*m_r_block_head_seq()*/
+
+
+//seq of a flash block when its crc is valid, else 0 as if it is empty,
+//e.g. when the power was cut while writing it
+//the crc is only calculated the first time for each block seq
+static uint32_t m_r_block_valid_seq (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud)
+{
+    if (p_block_idx_ud >= p_blocks_pz->nr_blocks_ud)
+        return 0;
+
+    const void*                 l_block_p;
+    m_r_flash_addr (p_blocks_pz, p_block_idx_ud, &l_block_p);
+    const blk_head_t* l_block_head_pz = (const blk_head_t*)l_block_p;
+    uint32_t l_seq_ud = m_r_head_seq (p_blocks_pz, l_block_head_pz);
+    if (  (l_seq_ud == 0)
+       || (p_blocks_pz->crc_seq_aud[p_block_idx_ud] == l_seq_ud))
+        return l_seq_ud;
+    if (  (l_block_head_pz->flags_ud & HL_BLOCKS_BLK_FLAG_CRC)
+       && (l_block_head_pz->crc_ud != m_r_block_crc (p_blocks_pz, l_block_p)))
+        return 0;
+    p_blocks_pz->crc_seq_aud[p_block_idx_ud] = l_seq_ud;
+    return l_seq_ud;
+}/*m_r_block_valid_seq()*/
+
+
+//crc32 of the block header before crc_ud, the used data after the header
+//and the tag map at the end of the block if any
+static uint32_t m_r_block_crc (
+    const hl_blocks_t*                p_blocks_pz,
+    const void*                       p_block_p)
+{
+    const blk_head_t* l_block_head_pz = (const blk_head_t*)p_block_p;
+    uint32_t l_crc_ud = crc32_r_update (0, p_block_p, offsetof (blk_head_t, crc_ud));
+    l_crc_ud = crc32_r_update (
+        l_crc_ud,
+        (const unsigned char*)p_block_p + sizeof (blk_head_t),
+        l_block_head_pz->used_size_ud);
+    if (l_block_head_pz->flags_ud & HL_BLOCKS_BLK_FLAG_TAG_MAP)
+        l_crc_ud = crc32_r_update (
+            l_crc_ud,
+            (const unsigned char*)p_block_p + p_blocks_pz->block_size_ud - HL_BLOCKS_TAG_MAP_SIZE,
+            HL_BLOCKS_TAG_MAP_SIZE);
+    return l_crc_ud;
+}/*m_r_block_crc()*/
+
+
+//tags of the messages in a block, all when it has no tag map
+static uint64_t m_r_block_tag_map (
+    const hl_blocks_t*                p_blocks_pz,
+    const void*                       p_block_p)
+{
+    if (!(((const blk_head_t*)p_block_p)->flags_ud & HL_BLOCKS_BLK_FLAG_TAG_MAP))
+        return HL_BLOCKS_ALL_TAGS;
+    uint64_t l_map_ud;
+    memcpy (&l_map_ud, (const unsigned char*)p_block_p + p_blocks_pz->block_size_ud - HL_BLOCKS_TAG_MAP_SIZE, sizeof (l_map_ud));
+    return l_map_ud;
+}/*m_r_block_tag_map()*/
+
+
+//prio of a flash block, limited to the lanes in use
+//so blocks written with more prios are read as the highest prio
+static uint32_t m_r_block_prio (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud)
+{
+    const void*                 l_block_p;
+    m_r_flash_addr (p_blocks_pz, p_block_idx_ud, &l_block_p);
+    const blk_head_t* l_block_head_pz = (const blk_head_t*)l_block_p;
+    return MIN (l_block_head_pz->prio_ud, p_blocks_pz->nr_prios_ud - 1);
+}/*m_r_block_prio()*/
+
+
+//mark a completely read (or dropped) block with seq=0
+//not to read it again after cold start
+//the block is changed in a copy, because the address from addr_pr() may be
+//flash that can only be changed with write_pr(), and only 1 bits to 0 on
+//NOR flash, which is all that changes here, so no erase is needed
+static void m_r_block_release (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_block_idx_ud,
+    const blk_head_t*                 p_blk_head_pz)
+{
+    M_PROBE3 (block_consume, p_block_idx_ud, p_blk_head_pz->seq_ud, p_blk_head_pz->used_size_ud);
+
+    //open rolls forward from the checkpoint only while the block seqs follow,
+    //so a block written after the checkpoint is not released before the
+    //checkpoint has the blocks up to it
+    if (  (p_blocks_pz->first_idx_ud > 0)
+       && (p_blk_head_pz->seq_ud > p_blocks_pz->ckpt_blk_seq_ud)
+       && (m_r_checkpoint_write (p_blocks_pz) != 0))
+        ERROR_LOG ("Failed to write checkpoint before releasing blk[%u]", p_block_idx_ud);
+
+    memcpy (p_blocks_pz->rel_blk_data_auc, p_blk_head_pz, p_blocks_pz->block_size_ud);
+    ((blk_head_t*)p_blocks_pz->rel_blk_data_auc)->seq_ud = 0;
+    m_r_flash_write (p_blocks_pz, p_block_idx_ud, p_blocks_pz->rel_blk_data_auc);
+}/*m_r_block_release()*/
+
+
+//next flash block of a prio after the specified one,
+//skipping blocks of other prios and invalid blocks, or wr_idx_ud when there is none
+static uint32_t m_r_lane_next_idx (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const uint32_t                    p_block_idx_ud)
+{
+    uint32_t l_idx_ud = p_block_idx_ud;
+    do {
+        l_idx_ud = (l_idx_ud + 1) % p_blocks_pz->nr_blocks_ud;
+    } while (  (l_idx_ud != p_blocks_pz->wr_idx_ud)
+            && (  (m_r_block_seq (p_blocks_pz, l_idx_ud) == 0)
+               || (m_r_block_prio (p_blocks_pz, l_idx_ud) != p_prio_ud)
+               || (m_r_block_valid_seq (p_blocks_pz, l_idx_ud) == 0)));
+    return l_idx_ud;
+}/*m_r_lane_next_idx()*/
+
+
+//like m_r_lane_next_idx() from the block headers only, without the crc,
+//to pass over blocks without reading them
+static uint32_t m_r_lane_next_head_idx (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const uint32_t                    p_block_idx_ud)
+{
+    uint32_t l_idx_ud = p_block_idx_ud;
+    do {
+        l_idx_ud = (l_idx_ud + 1) % p_blocks_pz->nr_blocks_ud;
+    } while (  (l_idx_ud != p_blocks_pz->wr_idx_ud)
+            && (  (m_r_block_head_seq (p_blocks_pz, l_idx_ud) == 0)
+               || (m_r_block_prio (p_blocks_pz, l_idx_ud) != p_prio_ud)));
+    return l_idx_ud;
+}/*m_r_lane_next_head_idx()*/
+
+
+//move the lane read position to its next flash block after the current one
+static void m_r_lane_next_block (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud)
+{
+    m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+    l_lane_pz->rd_idx_ud = m_r_lane_next_idx (p_blocks_pz, p_prio_ud, l_lane_pz->rd_idx_ud);
+    l_lane_pz->rd_ofs_ud = 0;
+}/*m_r_lane_next_block()*/
+
+
+//move rd_idx_ud over blocks already read by any lane, or invalid,
+//to make their space available for writing
+static void m_r_advance_tail (
+          hl_blocks_t*                p_blocks_pz)
+{
+    while (  (p_blocks_pz->rd_idx_ud != p_blocks_pz->wr_idx_ud)
+          && (m_r_block_valid_seq (p_blocks_pz, p_blocks_pz->rd_idx_ud) == 0))
+        p_blocks_pz->rd_idx_ud = (p_blocks_pz->rd_idx_ud + 1) % p_blocks_pz->nr_blocks_ud;
+}/*m_r_advance_tail()*/
+
+
+//skip over parts at the head of the lane rd block that continue messages
+//started in an earlier block, which was already read or dropped,
+//i.e. set rd_ofs_ud to the first message part 0 in the block.
+//blocks with nothing but such parts are released and skipped too.
+//when the rd block is the heap buffer, those parts are removed from it.
+//return the nr of flash blocks released
+static uint32_t m_r_skip_continued_parts (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud)
+{
+    m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+    uint32_t l_nr_released_ud = 0;
+    while (l_lane_pz->rd_idx_ud != p_blocks_pz->wr_idx_ud)
+    {
+        const void*                 l_block_p;
+        m_r_flash_addr (p_blocks_pz, l_lane_pz->rd_idx_ud, &l_block_p);
+        const blk_head_t* l_blk_head_pz = (const blk_head_t*)l_block_p;
+        const unsigned char* l_block_data_puc = (const unsigned char*)l_block_p + sizeof (blk_head_t);
+        uint32_t l_rd_ofs_ud = l_lane_pz->rd_ofs_ud;
+        while (l_rd_ofs_ud < l_blk_head_pz->used_size_ud)
+        {
+            const msg_head_t* l_msg_head_pz = (const msg_head_t*)(l_block_data_puc + l_rd_ofs_ud);
+            if (l_msg_head_pz->part_ud == 0)
+                break;
+            l_rd_ofs_ud += HL_BLOCKS_PART_STEP (l_blk_head_pz->align_ud, l_msg_head_pz->part_size_ud);
+        }/*while parts of older messages*/
+
+        if (l_rd_ofs_ud < l_blk_head_pz->used_size_ud)
+        {
+            l_lane_pz->rd_ofs_ud = l_rd_ofs_ud;
+            return l_nr_released_ud;
+        }
+
+        //nothing left to read in this block
+        m_r_block_release (p_blocks_pz, l_lane_pz->rd_idx_ud, l_blk_head_pz);
+        m_r_lane_next_block (p_blocks_pz, p_prio_ud);
+        l_nr_released_ud ++;
+    }/*while reading from flash*/
+
+    unsigned char* l_data_puc = l_lane_pz->wr_blk_data_auc + sizeof (blk_head_t);
+    uint32_t l_skip_ud = 0;
+    while (l_skip_ud < l_lane_pz->wr_blk_used_ud)
+    {
+        const msg_head_t* l_msg_head_pz = (const msg_head_t*)(l_data_puc + l_skip_ud);
+        if (l_msg_head_pz->part_ud == 0)
+            break;
+        l_skip_ud += HL_BLOCKS_PART_STEP (p_blocks_pz->align_ud, l_msg_head_pz->part_size_ud);
+    }/*while parts of older messages*/
+
+    if (l_skip_ud > 0)
+    {
+        memmove (
+            l_data_puc,
+            l_data_puc + l_skip_ud,
+            l_lane_pz->wr_blk_used_ud - l_skip_ud);
+        l_lane_pz->wr_blk_used_ud -= l_skip_ud;
+    }
+    return l_nr_released_ud;
+}/*m_r_skip_continued_parts()*/
+
+
+//1 when a part after the first is of a message dropped while it was
+//written, so its later parts were written after the drop skipped its parts
+static int m_r_dropped_msg_part (
+    const hl_blocks_t*                p_blocks_pz,
+    const msg_head_t*                 p_msg_head_pz)
+{
+    return (  (p_msg_head_pz->part_ud > 0)
+           && (p_blocks_pz->drop_last_seq_ud != 0)
+           && ((int32_t)(p_msg_head_pz->seq_ud - p_blocks_pz->drop_last_seq_ud) <= 0));
+}/*m_r_dropped_msg_part()*/
+
+
+//drop the oldest unread flash block to make space for the next sync
+//the reader of its prio continues at the first whole message after it
+static int m_r_drop_oldest_block (
+          hl_blocks_t*                p_blocks_pz)
+{
+    if (p_blocks_pz->rd_idx_ud == p_blocks_pz->wr_idx_ud)
+        return ERROR (-1, "No flash block to drop rd_idx=wr_idx=%u", p_blocks_pz->rd_idx_ud);
+
+    //the oldest unread block is always the current block of its lane
+    uint32_t l_prio_ud = m_r_block_prio (p_blocks_pz, p_blocks_pz->rd_idx_ud);
+    m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[l_prio_ud];
+    if (l_lane_pz->rd_idx_ud != p_blocks_pz->rd_idx_ud) {
+        M_STAT_ADD (p_blocks_pz, corruptions_ud, 1);
+        M_PROBE4 (corruption, p_blocks_pz->rd_idx_ud, 0, 0, 0);
+        return ERROR (HL_BLOCKS_K_ERROR_CORRUPTED, "Oldest blk[%u] prio %u is not read next, lane at blk[%u]",
+            p_blocks_pz->rd_idx_ud,
+            l_prio_ud,
+            l_lane_pz->rd_idx_ud);
+    }
+
+    const void*                 l_block_p;
+    m_r_flash_addr (p_blocks_pz, p_blocks_pz->rd_idx_ud, &l_block_p);
+    const blk_head_t* l_blk_head_pz = (const blk_head_t*)l_block_p;
+    const unsigned char* l_block_data_puc = (const unsigned char*)l_block_p + sizeof (blk_head_t);
+
+    //count the unread messages starting in this block
+    uint32_t            l_nr_msgs_ud    = 0;
+    hl_blocks_msg_seq_t l_first_seq_ud  = 0;
+    hl_blocks_msg_seq_t l_last_seq_ud   = 0;
+    uint32_t            l_rd_ofs_ud     = l_lane_pz->rd_ofs_ud;
+    while (l_rd_ofs_ud < l_blk_head_pz->used_size_ud)
+    {
+        const msg_head_t* l_msg_head_pz = (const msg_head_t*)(l_block_data_puc + l_rd_ofs_ud);
+        if (l_msg_head_pz->part_ud == 0)
+        {
+            if (l_nr_msgs_ud == 0)
+                l_first_seq_ud = l_msg_head_pz->seq_ud;
+            l_last_seq_ud = l_msg_head_pz->seq_ud;
+            l_nr_msgs_ud ++;
+        }
+        l_rd_ofs_ud += HL_BLOCKS_PART_STEP (l_blk_head_pz->align_ud, l_msg_head_pz->part_size_ud);
+    }/*while reading message parts in this block*/
+
+    if (l_nr_msgs_ud > 0)
+    {
+        p_blocks_pz->drop_first_seq_ud = l_first_seq_ud;
+        p_blocks_pz->drop_last_seq_ud  = l_last_seq_ud;
+    }
+
+    DEBUG ("dropped blk[%5u](seq=%10u) %u msgs(seq=%u..%u) prio=%u",
+        p_blocks_pz->rd_idx_ud,
+        l_blk_head_pz->seq_ud,
+        l_nr_msgs_ud,
+        l_first_seq_ud,
+        l_last_seq_ud,
+        l_prio_ud);
+
+    if (  (p_blocks_pz->drain_ofs_ud > 0)
+       && (p_blocks_pz->drain_prio_ud == l_prio_ud))
+    {
+        ERROR_LOG ("Dropped msg seq=%u after draining %u bytes of it", l_first_seq_ud, p_blocks_pz->drain_ofs_ud);
+        p_blocks_pz->drain_ofs_ud = 0;
+    }
+
+    m_r_block_release (p_blocks_pz, p_blocks_pz->rd_idx_ud, l_blk_head_pz);
+    M_STAT_ADD (p_blocks_pz, drop_msgs_ud, l_nr_msgs_ud);
+    M_STAT_ADD (p_blocks_pz, drop_blks_ud, 1);
+
+    //continue reading after the parts of the dropped messages
+    m_r_lane_next_block (p_blocks_pz, l_prio_ud);
+    M_STAT_ADD (p_blocks_pz, drop_blks_ud, m_r_skip_continued_parts (p_blocks_pz, l_prio_ud));
+    m_r_advance_tail (p_blocks_pz);
+    return SUCCESS ();
+}/*m_r_drop_oldest_block()*/
+
+
+//write the heap buffer of one prio into the next flash block
+static int m_r_sync_lane (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const int                         p_full_d)
+{
+    m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+    if (l_lane_pz->wr_blk_used_ud == 0)
+        return SUCCESS ();
+    return m_r_sync_block (
+        p_blocks_pz,
+        p_prio_ud,
+        p_full_d,
+        (blk_head_t*)(l_lane_pz->wr_blk_data_auc),
+        NULL,
+        0,
+        l_lane_pz->wr_blk_used_ud);
+}/*m_r_sync_lane()*/
+
+
+//write the next flash block, either the heap buffer of the prio from its
+//header when p_data_az is NULL, or with writev_pr() from a separate header
+//and the pieces of data after it
+static int m_r_sync_block (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const int                         p_full_d,
+          blk_head_t*                 p_blk_head_pz,
+    const struct iovec*               p_data_az,
+    const uint32_t                    p_nr_data_ud,
+    const uint32_t                    p_used_ud)
+{
+    uint32_t l_used_ud = p_used_ud;
+
+    //check there is enough space not to overwrite unread messages
+    //this is when write index will increment to fall on same block as read index
+    if ((p_blocks_pz->wr_idx_ud + 1) % p_blocks_pz->nr_blocks_ud == p_blocks_pz->rd_idx_ud)
+    {
+        if (p_blocks_pz->full_mode_e != HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST) {
+            M_STAT_ADD (p_blocks_pz, rejects_full_ud, 1);
+            return ERROR (HL_BLOCKS_K_ERROR_NO_SPACE_LEFT_IN_BUFFER,
+                "No space left in buffer wr_idx=%u rd_idx=%u",
+                p_blocks_pz->wr_idx_ud,
+                p_blocks_pz->rd_idx_ud);
+        }
+
+        int l_result_d = m_r_drop_oldest_block (p_blocks_pz);
+        if (l_result_d != 0)
+            return ERROR (l_result_d, "Failed to drop oldest block to make space");
+
+        //the drop removed the parts in the heap buffer of the messages it
+        //dropped, when the lane read from the block being written
+        if (p_data_az == NULL) {
+            m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+            l_used_ud = l_lane_pz->wr_blk_used_ud;
+            if (l_used_ud == 0) {
+                DEBUG ("nothing left to sync in prio %u after drop", p_prio_ud);
+                l_lane_pz->wr_tag_map_ud = 0;
+                memset (l_lane_pz->wr_blk_data_auc, 0, p_blocks_pz->block_size_ud);
+                return SUCCESS ();
+            }
+        }
+    }/*if no space left*/
+
+    //update the block header
+    p_blk_head_pz->seq_ud = p_blocks_pz->last_blk_seq_ud + 1;
+    p_blk_head_pz->used_size_ud = l_used_ud;
+    p_blk_head_pz->prio_ud = (uint8_t)p_prio_ud;
+    p_blk_head_pz->flags_ud = HL_BLOCKS_BLK_FLAG_CRC;
+    p_blk_head_pz->align_ud = (uint16_t)p_blocks_pz->align_ud;
+    if (p_data_az == NULL) {
+        if (p_blocks_pz->tag_map_ud) {
+            p_blk_head_pz->flags_ud |= HL_BLOCKS_BLK_FLAG_TAG_MAP;
+            memcpy (
+                (unsigned char*)p_blk_head_pz + p_blocks_pz->block_size_ud - HL_BLOCKS_TAG_MAP_SIZE,
+                &p_blocks_pz->lane_az[p_prio_ud].wr_tag_map_ud,
+                HL_BLOCKS_TAG_MAP_SIZE);
+        }
+        p_blk_head_pz->crc_ud = m_r_block_crc (p_blocks_pz, p_blk_head_pz);
+    } else {
+        //same as m_r_block_crc() over the pieces
+        uint32_t l_crc_ud = crc32_r_update (0, p_blk_head_pz, offsetof (blk_head_t, crc_ud));
+        for (uint32_t l_nr_ud = 0; l_nr_ud < p_nr_data_ud; l_nr_ud++)
+            l_crc_ud = crc32_r_update (l_crc_ud, p_data_az[l_nr_ud].iov_base, p_data_az[l_nr_ud].iov_len);
+        p_blk_head_pz->crc_ud = l_crc_ud;
+    }
+    M_PROBE4 (sync_begin, p_blocks_pz->wr_idx_ud, p_blk_head_pz->seq_ud, l_used_ud, p_full_d);
+
+    //sync the buffer to flash memory
+    uint64_t l_start_ns_ud = m_r_latency_start (p_blocks_pz);
+    int l_result_d;
+    if (p_data_az == NULL) {
+        l_result_d = m_r_flash_write (p_blocks_pz, p_blocks_pz->wr_idx_ud, p_blk_head_pz);
+    } else {
+        struct iovec                l_iov_az[4];
+        l_iov_az[0].iov_base = p_blk_head_pz;
+        l_iov_az[0].iov_len  = sizeof (blk_head_t);
+        memcpy (&l_iov_az[1], p_data_az, p_nr_data_ud * sizeof (struct iovec));
+        l_result_d = m_r_flash_writev (p_blocks_pz, p_blocks_pz->wr_idx_ud, l_iov_az, (int)p_nr_data_ud + 1);
+    }
+    if (l_result_d != 0)
+        return ERROR (-1,
+            "Failed to sync write to flash blk[%u]",
+            p_blocks_pz->wr_idx_ud);
+    m_r_latency_add (p_blocks_pz, HL_BLOCKS_K_LATENCY_WRITE_PR, l_start_ns_ud);
+    p_blocks_pz->crc_seq_aud[p_blocks_pz->wr_idx_ud] = p_blk_head_pz->seq_ud;
+    M_PROBE4 (sync_end, p_blocks_pz->wr_idx_ud, p_blk_head_pz->seq_ud, l_used_ud, p_full_d);
+
+    DEBUG ("synced blk[%5u](seq=%10u tot=%3u) -> FLASH prio=%u%s",
+        p_blocks_pz->wr_idx_ud,
+        p_blk_head_pz->seq_ud,
+        l_used_ud,
+        p_prio_ud,
+        (p_data_az == NULL) ? "" : " direct");
+
+    //lanes reading from heap must skip over the new block of another prio
+    //this lane now reads the new block if it was reading from heap
+    uint32_t l_new_wr_idx_ud = (p_blocks_pz->wr_idx_ud + 1) % p_blocks_pz->nr_blocks_ud;
+    for (uint32_t l_other_ud = 0; l_other_ud < p_blocks_pz->nr_prios_ud; l_other_ud++) {
+        if (  (l_other_ud != p_prio_ud)
+           && (p_blocks_pz->lane_az[l_other_ud].rd_idx_ud == p_blocks_pz->wr_idx_ud))
+            p_blocks_pz->lane_az[l_other_ud].rd_idx_ud = l_new_wr_idx_ud;
+    }/*for each other lane*/
+
+    p_blocks_pz->last_blk_seq_ud ++;
+    M_STAT_ADD (p_blocks_pz, blocks_written_ud, 1);
+    M_STAT_ADD (p_blocks_pz, block_used_ud, l_used_ud);
+    if (p_data_az != NULL)
+        M_STAT_ADD (p_blocks_pz, blocks_direct_ud, 1);
+    if (p_full_d) {
+        M_STAT_ADD (p_blocks_pz, syncs_full_ud, 1);
+        M_STAT_ADD (p_blocks_pz, pad_bytes_ud, p_blocks_pz->data_size_ud - l_used_ud);
+    } else {
+        M_STAT_ADD (p_blocks_pz, syncs_explicit_ud, 1);
+    }
+    p_blocks_pz->wr_idx_ud = l_new_wr_idx_ud;
+
+    //start a new clean buffer
+    if (p_data_az == NULL) {
+        m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+        l_lane_pz->wr_blk_used_ud = 0;
+        l_lane_pz->wr_tag_map_ud = 0;
+        memset (l_lane_pz->wr_blk_data_auc, 0, p_blocks_pz->block_size_ud);
+    }
+
+    //open rolls forward over the blocks written since the last checkpoint
+    p_blocks_pz->ckpt_blocks_ud ++;
+    if (  (p_blocks_pz->first_idx_ud > 0)
+       && (p_blocks_pz->ckpt_every_ud > 0)
+       && (p_blocks_pz->ckpt_blocks_ud >= p_blocks_pz->ckpt_every_ud))
+    {
+        l_result_d = m_r_checkpoint_write (p_blocks_pz);
+        if (l_result_d != 0)
+            return ERROR (l_result_d, "Failed to write checkpoint after blk[%u]", l_new_wr_idx_ud);
+    }
+    return SUCCESS ();
+}/*m_r_sync_block()*/
+
+
+//get the message part at a lane read position and move the position after it,
+//like m_r_read_lane() but without changing the lane
+//return NULL when nothing more to read in the lane
+static const msg_head_t* m_r_drain_part (
+    const hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+          m_drain_pos_t*              p_pos_pz)
+{
+    const m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+    if (p_pos_pz->rd_idx_ud != p_blocks_pz->wr_idx_ud)
+    {
+        const void*                 l_block_p;
+        m_r_flash_addr (p_blocks_pz, p_pos_pz->rd_idx_ud, &l_block_p);
+        const blk_head_t* l_blk_head_pz = (const blk_head_t*)l_block_p;
+        const msg_head_t* l_msg_head_pz = (const msg_head_t*)((const unsigned char*)l_block_p + sizeof (blk_head_t) + p_pos_pz->rd_ofs_ud);
+        uint32_t l_step_ud = HL_BLOCKS_PART_STEP (l_blk_head_pz->align_ud, l_msg_head_pz->part_size_ud);
+        if (p_pos_pz->rd_ofs_ud + l_step_ud >= l_blk_head_pz->used_size_ud) {
+            p_pos_pz->rd_idx_ud = m_r_lane_next_idx (p_blocks_pz, p_prio_ud, p_pos_pz->rd_idx_ud);
+            p_pos_pz->rd_ofs_ud = 0;
+        } else {
+            p_pos_pz->rd_ofs_ud += l_step_ud;
+        }
+        return l_msg_head_pz;
+    }/*if in flash*/
+
+    if (p_pos_pz->heap_ofs_ud >= l_lane_pz->wr_blk_used_ud)
+        return NULL;
+    const msg_head_t* l_msg_head_pz = (const msg_head_t*)(l_lane_pz->wr_blk_data_auc + sizeof (blk_head_t) + p_pos_pz->heap_ofs_ud);
+    p_pos_pz->heap_ofs_ud += HL_BLOCKS_PART_STEP (p_blocks_pz->align_ud, l_msg_head_pz->part_size_ud);
+    return l_msg_head_pz;
+}/*m_r_drain_part()*/
+
+
+//move the lane read position to where m_r_drain_part() got to,
+//releasing the flash blocks passed and removing the parts read from heap
+static void m_r_drain_seek (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const m_drain_pos_t*              p_pos_pz)
+{
+    m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+    while (l_lane_pz->rd_idx_ud != p_pos_pz->rd_idx_ud)
+    {
+        const void*                 l_block_p;
+        m_r_flash_addr (p_blocks_pz, l_lane_pz->rd_idx_ud, &l_block_p);
+        m_r_block_release (p_blocks_pz, l_lane_pz->rd_idx_ud, (const blk_head_t*)l_block_p);
+        m_r_lane_next_block (p_blocks_pz, p_prio_ud);
+    }
+    l_lane_pz->rd_ofs_ud = p_pos_pz->rd_ofs_ud;
+
+    if (p_pos_pz->heap_ofs_ud > 0)
+    {
+        memmove (
+            l_lane_pz->wr_blk_data_auc + sizeof (blk_head_t),
+            l_lane_pz->wr_blk_data_auc + sizeof (blk_head_t) + p_pos_pz->heap_ofs_ud,
+            l_lane_pz->wr_blk_used_ud - p_pos_pz->heap_ofs_ud);
+        l_lane_pz->wr_blk_used_ud -= p_pos_pz->heap_ofs_ud;
+    }
+    m_r_advance_tail (p_blocks_pz);
+}/*m_r_drain_seek()*/
+
+
+//read the next message of one prio
+static int m_r_read_lane (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+          void*                       p_buff_data_p,
+    const size_t                      p_buff_size_ud,
+          size_t*                     p_read_size_pud,
+          hl_blocks_msg_seq_t*        p_read_seq_pud)
+{
+    m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+
+    //read message parts in loop until break when got the whole message
+    uint32_t l_msg_seq_ud       = 0;
+    uint32_t l_tot_size_ud      = 0;
+    uint32_t l_buff_ofs_ud      = 0;     //this is also size of all parts already copied into the buffer
+    uint32_t l_buff_rem_ud      = p_buff_size_ud;
+    uint32_t l_parts_copied_ud  = 0;        //incr after got a part
+    uint32_t l_first_from_flash_ud = 0;     //first part read from flash, else heap
+
+    while (1) {
+        //determine if read from flash or heap space
+        uint32_t                    l_read_from_flash_ud    = (l_lane_pz->rd_idx_ud != p_blocks_pz->wr_idx_ud);
+        const blk_head_t*           l_flash_blk_head_pz     = NULL;
+        const msg_head_t*           l_msg_head_pz           = NULL;
+
+        //get msg_head in either flash or heap
+        if (l_read_from_flash_ud)
+        {
+            //read from flash block[rd_idx_ud] at data ofs rd_ofs_ud after the block head
+            //note: reading from flash does not shift other messages forward
+            //      because flash is not changed after being written once)
+            //get address of flash block to read
+            const void*                 l_block_p;
+            m_r_flash_addr (p_blocks_pz, l_lane_pz->rd_idx_ud, &l_block_p);
+            l_flash_blk_head_pz = (const blk_head_t*)l_block_p;
+
+            //when starting a block, get the headers of the next one in cache,
+            //only for a linear mapping where that is just arithmetic
+            if (  (l_lane_pz->rd_ofs_ud == 0)
+               && (p_blocks_pz->linear_base_puc != NULL))
+            {
+                const void*                 l_next_block_p;
+                m_r_flash_addr (p_blocks_pz, (l_lane_pz->rd_idx_ud + 1) % p_blocks_pz->nr_blocks_ud, &l_next_block_p);
+                __builtin_prefetch (l_next_block_p, 0, 3);
+            }
+
+            //a block without data is empty, e.g. from before a drop
+            //removed all parts in the heap buffer
+            if (l_flash_blk_head_pz->used_size_ud == 0)
+            {
+                DEBUG ("skip empty blk[%5u](seq=%10u)", l_lane_pz->rd_idx_ud, l_flash_blk_head_pz->seq_ud);
+                m_r_block_release (p_blocks_pz, l_lane_pz->rd_idx_ud, l_flash_blk_head_pz);
+                m_r_lane_next_block (p_blocks_pz, p_prio_ud);
+                m_r_advance_tail (p_blocks_pz);
+                continue;
+            }
+            const unsigned char* l_blk_data_puc = (const unsigned char*)l_block_p + sizeof (blk_head_t);
+            //get message header and copy the data
+            l_msg_head_pz = (const msg_head_t*)(l_blk_data_puc + l_lane_pz->rd_ofs_ud);
+        } /*if read from flash*/
+        else
+        {
+            //nothing more in flash to read, see if anything in heap space to read
+            if (l_lane_pz->wr_blk_used_ud == 0)
+                return ERROR (HL_BLOCKS_K_ERROR_READ_ALL, "Nothing more to read.");
+            l_msg_head_pz = (const msg_head_t*)(l_lane_pz->wr_blk_data_auc + sizeof (blk_head_t));
+        }/*if read from heap*/
+
+        //parts of a message that was dropped while it was written come
+        //after the drop, skip them like the drop did for older parts
+        if (  (l_parts_copied_ud == 0)
+           && (m_r_dropped_msg_part (p_blocks_pz, l_msg_head_pz)))
+        {
+            DEBUG ("skip parts of dropped msg(seq=%u) from part %u",
+                l_msg_head_pz->seq_ud,
+                l_msg_head_pz->part_ud);
+            M_STAT_ADD (p_blocks_pz, drop_blks_ud, m_r_skip_continued_parts (p_blocks_pz, p_prio_ud));
+            m_r_advance_tail (p_blocks_pz);
+            continue;
+        }
+
+        if (  (  (l_parts_copied_ud == 0)
+              && (l_msg_head_pz->part_ud > 0))
+           || (  (l_parts_copied_ud > 0)
+              && (  (l_msg_seq_ud != l_msg_head_pz->seq_ud)
+                 || (l_tot_size_ud != l_msg_head_pz->tot_size_ud)
+                 || (l_parts_copied_ud != l_msg_head_pz->part_ud)
                  || (l_buff_ofs_ud + l_msg_head_pz->part_size_ud > l_tot_size_ud)
                  )
               )
            )
         {
             //todo: should be able to deal with this is first read block starts with last part of other message
+            M_STAT_ADD (p_blocks_pz, corruptions_ud, 1);
+            M_PROBE4 (corruption,
+                l_read_from_flash_ud ? l_lane_pz->rd_idx_ud : p_blocks_pz->wr_idx_ud,
+                l_msg_head_pz->seq_ud,
+                l_msg_head_pz->part_ud,
+                l_msg_head_pz->part_size_ud);
             ERROR_LOG ("Data corruption, msg(seq=%u,tot=%u,parts=%u,size=%u) next head(%u,%u,%u,%u)",
                 l_msg_seq_ud,
                 l_tot_size_ud,
@@ -446,8 +2332,10 @@ extern int hl_blocks_r_read (
 
             if (l_read_from_flash_ud)
             {
-                p_blocks_pz->rd_idx_ud ++; //next read start in next block: todo: check for end of buffer
-                p_blocks_pz->rd_ofs_ud = 0;
+                //next read start in next block
+                m_r_block_release (p_blocks_pz, l_lane_pz->rd_idx_ud, l_flash_blk_head_pz);
+                m_r_lane_next_block (p_blocks_pz, p_prio_ud);
+                m_r_advance_tail (p_blocks_pz);
             }
             return ERROR (-1, "data corrupted - see error log");
         }//if corrupted
@@ -457,6 +2345,7 @@ extern int hl_blocks_r_read (
             //store message overall properties from the first header
             l_msg_seq_ud     = l_msg_head_pz->seq_ud;
             l_tot_size_ud    = l_msg_head_pz->tot_size_ud;
+            l_first_from_flash_ud = l_read_from_flash_ud;
             *p_read_size_pud = l_tot_size_ud;
             if (p_read_seq_pud != NULL)
                 *p_read_seq_pud  = l_msg_head_pz->seq_ud;
@@ -484,86 +2373,290 @@ extern int hl_blocks_r_read (
 
         if (l_read_from_flash_ud)
         {
-            DEBUG ("read<--blk[%5u](seq=%10u rem=%3u) msg(seq=%5u size=%5u part[%2u]=%5u)",
-                p_blocks_pz->rd_idx_ud,
+            DEBUG ("read<--blk[%5u](seq=%10u rem=%3u) msg(seq=%5u size=%5u part[%2u]=%5u) prio=%u",
+                l_lane_pz->rd_idx_ud,
                 l_flash_blk_head_pz->seq_ud,
-                l_flash_blk_head_pz->used_size_ud - p_blocks_pz->rd_ofs_ud - sizeof (msg_head_t) - l_msg_head_pz->part_size_ud,
+                l_flash_blk_head_pz->used_size_ud - l_lane_pz->rd_ofs_ud - sizeof (msg_head_t) - l_msg_head_pz->part_size_ud,
                 l_msg_head_pz->seq_ud,
                 l_msg_head_pz->tot_size_ud,
                 l_msg_head_pz->part_ud,
-                l_msg_head_pz->part_size_ud);
+                l_msg_head_pz->part_size_ud,
+                p_prio_ud);
 
             //update the flash read offset and block to skip over this message
-            if (p_blocks_pz->rd_ofs_ud + sizeof (msg_head_t) + l_msg_head_pz->part_size_ud
-                    >= l_flash_blk_head_pz->used_size_ud)
+            uint32_t l_step_ud = HL_BLOCKS_PART_STEP (l_flash_blk_head_pz->align_ud, l_msg_head_pz->part_size_ud);
+            if (l_lane_pz->rd_ofs_ud + l_step_ud >= l_flash_blk_head_pz->used_size_ud)
             {
-                //update seq=0 of the read block not to read it again after cold start
-                ((blk_head_t*)l_flash_blk_head_pz)->seq_ud = 0;
-                (*p_blocks_pz->write_pr) (p_blocks_pz->rd_idx_ud, l_flash_blk_head_pz);
-
-                p_blocks_pz->rd_ofs_ud = 0;
-                p_blocks_pz->rd_idx_ud = (p_blocks_pz->rd_idx_ud + 1) % p_blocks_pz->nr_blocks_ud;
+                m_r_block_release (p_blocks_pz, l_lane_pz->rd_idx_ud, l_flash_blk_head_pz);
+                m_r_lane_next_block (p_blocks_pz, p_prio_ud);
+                m_r_advance_tail (p_blocks_pz);
             } else {
-                p_blocks_pz->rd_ofs_ud += sizeof (msg_head_t) + l_msg_head_pz->part_size_ud;
+                l_lane_pz->rd_ofs_ud += l_step_ud;
             }
         }/*if read from flash*/
         else
         {
+            //before the head is moved
+            M_PROBE4 (heap_read,
+                p_prio_ud,
+                l_msg_head_pz->seq_ud,
+                l_msg_head_pz->part_ud,
+                l_msg_head_pz->part_size_ud);
+
             //shifting remaining messages in heap to front of buffer
-            uint32_t l_head_and_data_size_ud = sizeof (msg_head_t) + l_msg_head_pz->part_size_ud;
-            if (p_blocks_pz->wr_blk_used_ud > sizeof (msg_head_t) + l_msg_head_pz->part_size_ud)
+            uint32_t l_head_and_data_size_ud = HL_BLOCKS_PART_STEP (p_blocks_pz->align_ud, l_msg_head_pz->part_size_ud);
+            if (l_lane_pz->wr_blk_used_ud > l_head_and_data_size_ud)
             {
                 memmove (
-                    p_blocks_pz->wr_blk_data_auc + sizeof (blk_head_t),
-                    p_blocks_pz->wr_blk_data_auc + sizeof (blk_head_t) + l_head_and_data_size_ud,
-                    p_blocks_pz->wr_blk_used_ud - l_head_and_data_size_ud);
+                    l_lane_pz->wr_blk_data_auc + sizeof (blk_head_t),
+                    l_lane_pz->wr_blk_data_auc + sizeof (blk_head_t) + l_head_and_data_size_ud,
+                    l_lane_pz->wr_blk_used_ud - l_head_and_data_size_ud);
             }/*if something to move*/
-            p_blocks_pz->wr_blk_used_ud -= l_head_and_data_size_ud;
+            l_lane_pz->wr_blk_used_ud -= l_head_and_data_size_ud;
 
-            DEBUG ("read<--heap      (seq=%10u used=%3u) msg(seq=%5u size=%5u part[%2u]=%5u)",
-                //p_blocks_pz->rd_idx_ud,
+            DEBUG ("read<--heap      (seq=%10u used=%3u) msg(seq=%5u size=%5u part[%2u]=%5u) prio=%u",
+                //l_lane_pz->rd_idx_ud,
                 p_blocks_pz->last_blk_seq_ud,
-                p_blocks_pz->wr_blk_used_ud,
+                l_lane_pz->wr_blk_used_ud,
                 l_msg_head_pz->seq_ud,
                 l_msg_head_pz->tot_size_ud,
                 l_msg_head_pz->part_ud,
-                l_msg_head_pz->part_size_ud);
+                l_msg_head_pz->part_size_ud,
+                p_prio_ud);
         }/*if read from heap*/
 
         if (l_buff_ofs_ud >= l_tot_size_ud)
-            return SUCCESS();   //got the whole message
+        {
+            //got the whole message
+            M_STAT_ADD (p_blocks_pz, msgs_read_ud, 1);
+            M_STAT_ADD (p_blocks_pz, bytes_read_ud, l_tot_size_ud);
+            if (l_first_from_flash_ud)
+                M_STAT_ADD (p_blocks_pz, reads_flash_ud, 1);
+            else
+                M_STAT_ADD (p_blocks_pz, reads_heap_ud, 1);
+            return SUCCESS();
+        }
 
     }//while reading message parts
     return ERROR (-1, "Not expected to get here!");
-}/*hl_blocks_r_read()*/
+}/*m_r_read_lane()*/
 
 
-extern uint32_t hl_blocks_r___get_write_count (
-    const hl_blocks_t*                p_blocks_pz)
+//copy the next message of one prio after the cursor with a tag in the mask,
+//without changing the read position of the lane or releasing blocks
+static int m_r_read_lane_tags (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+          hl_blocks_cursor_lane_t*    p_lane_cursor_pz,
+    const uint64_t                    p_tag_mask_ud,
+          void*                       p_buff_data_p,
+    const size_t                      p_buff_size_ud,
+          size_t*                     p_read_size_pud,
+          hl_blocks_msg_seq_t*        p_read_seq_pud,
+          uint32_t*                   p_tag_pud)
 {
-    if (p_blocks_pz == NULL)
-        return 0;
-    return p_blocks_pz->wr_count_ud;
-}
+    const m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+
+    //start at the read position of the lane, or after the last message
+    //copied when its block is still there: blocks read by the lane were
+    //released, so then their seq is 0 or of a newer block
+    m_drain_pos_t l_pos_z = {
+        .rd_idx_ud      = l_lane_pz->rd_idx_ud,
+        .rd_ofs_ud      = l_lane_pz->rd_ofs_ud,
+        .heap_ofs_ud    = 0,
+    };
+    if (  (p_lane_cursor_pz->blk_seq_ud != 0)
+       && (l_lane_pz->rd_idx_ud != p_blocks_pz->wr_idx_ud)
+       && (p_lane_cursor_pz->blk_idx_ud < p_blocks_pz->nr_blocks_ud)
+       && (p_lane_cursor_pz->blk_idx_ud != p_blocks_pz->wr_idx_ud)
+       && (m_r_block_seq (p_blocks_pz, p_lane_cursor_pz->blk_idx_ud) == p_lane_cursor_pz->blk_seq_ud))
+    {
+        if (  (p_lane_cursor_pz->blk_idx_ud != l_lane_pz->rd_idx_ud)
+           || (p_lane_cursor_pz->blk_ofs_ud > l_lane_pz->rd_ofs_ud))
+        {
+            l_pos_z.rd_idx_ud = p_lane_cursor_pz->blk_idx_ud;
+            l_pos_z.rd_ofs_ud = p_lane_cursor_pz->blk_ofs_ud;
+        }
+    }
 
-/*****************************************************************************
- *****************************************************************************
- *   L O C A L   F U N C T I O N   D E F I N I T I O N S
- *****************************************************************************
- *****************************************************************************/
+    const msg_head_t* l_msg_head_pz = NULL;
+    while (1)
+    {
+        //pass over a flash block without any of the tags from its tag map,
+        //only the crc of a block to read from is checked
+        if (l_pos_z.rd_idx_ud != p_blocks_pz->wr_idx_ud)
+        {
+            const void*                 l_block_p;
+            m_r_flash_addr (p_blocks_pz, l_pos_z.rd_idx_ud, &l_block_p);
+            int l_pass_d = (  (((const blk_head_t*)l_block_p)->used_size_ud == 0)
+                           || ((m_r_block_tag_map (p_blocks_pz, l_block_p) & p_tag_mask_ud) == 0));
+            if (l_pass_d && (((const blk_head_t*)l_block_p)->used_size_ud > 0))
+                M_STAT_ADD (p_blocks_pz, blocks_skipped_ud, 1);
+            if (  l_pass_d
+               || (m_r_block_valid_seq (p_blocks_pz, l_pos_z.rd_idx_ud) == 0))
+            {
+                l_pos_z.rd_idx_ud = m_r_lane_next_head_idx (p_blocks_pz, p_prio_ud, l_pos_z.rd_idx_ud);
+                l_pos_z.rd_ofs_ud = 0;
+                continue;
+            }
+        }
 
-static uint32_t m_r_block_seq (
+        l_msg_head_pz = m_r_drain_part (p_blocks_pz, p_prio_ud, &l_pos_z);
+        if (l_msg_head_pz == NULL)
+            return ERROR (HL_BLOCKS_K_ERROR_READ_ALL, "Nothing more to read.");
+
+        //later parts of messages passed over
+        if (l_msg_head_pz->part_ud > 0)
+            continue;
+
+        //messages copied before, or with another tag
+        if (  (p_lane_cursor_pz->last_seq_ud != 0)
+           && ((int32_t)(l_msg_head_pz->seq_ud - p_lane_cursor_pz->last_seq_ud) <= 0))
+            continue;
+        if ((p_tag_mask_ud & HL_BLOCKS_TAG_BIT (l_msg_head_pz->tag_ud)) == 0)
+        {
+            M_STAT_ADD (p_blocks_pz, msgs_skipped_ud, 1);
+            continue;
+        }
+        break;
+    }/*while looking for a message*/
+
+    hl_blocks_msg_seq_t l_msg_seq_ud  = l_msg_head_pz->seq_ud;
+    uint32_t            l_tot_size_ud = l_msg_head_pz->tot_size_ud;
+    uint32_t            l_tag_ud      = l_msg_head_pz->tag_ud;
+    if (l_tot_size_ud > p_buff_size_ud)
+        return ERROR (-1,
+            "Message size %u will not fit in buffer size %zu",
+            l_tot_size_ud,
+            p_buff_size_ud);
+
+    //all parts of the message, which may continue in later blocks
+    uint32_t l_got_size_ud = 0;
+    uint32_t l_part_ud = 0;
+    while (1)
+    {
+        if (  (l_msg_head_pz == NULL)
+           || (l_msg_head_pz->seq_ud != l_msg_seq_ud)
+           || (l_msg_head_pz->part_ud != l_part_ud)
+           || (l_got_size_ud + l_msg_head_pz->part_size_ud > l_tot_size_ud))
+        {
+            //the next call continues after this message
+            M_STAT_ADD (p_blocks_pz, corruptions_ud, 1);
+            ERROR_LOG ("Data corruption, msg(seq=%u,tot=%u,parts=%u,size=%u) read with tags",
+                l_msg_seq_ud,
+                l_tot_size_ud,
+                l_part_ud,
+                l_got_size_ud);
+            p_lane_cursor_pz->last_seq_ud = l_msg_seq_ud;
+            return ERROR (HL_BLOCKS_K_ERROR_CORRUPTED, "data corrupted - see error log");
+        }
+        memcpy (
+            (unsigned char*)p_buff_data_p + l_got_size_ud,
+            (const unsigned char*)l_msg_head_pz + sizeof (msg_head_t),
+            l_msg_head_pz->part_size_ud);
+        l_got_size_ud += l_msg_head_pz->part_size_ud;
+        l_part_ud ++;
+        if (l_got_size_ud >= l_tot_size_ud)
+            break;
+        l_msg_head_pz = m_r_drain_part (p_blocks_pz, p_prio_ud, &l_pos_z);
+    }/*while more parts*/
+
+    //continue in this flash block next time, not in the heap buffer
+    //which moves when read or synced
+    p_lane_cursor_pz->last_seq_ud = l_msg_seq_ud;
+    p_lane_cursor_pz->blk_seq_ud  = 0;
+    if (l_pos_z.rd_idx_ud != p_blocks_pz->wr_idx_ud)
+    {
+        p_lane_cursor_pz->blk_idx_ud = l_pos_z.rd_idx_ud;
+        p_lane_cursor_pz->blk_ofs_ud = l_pos_z.rd_ofs_ud;
+        p_lane_cursor_pz->blk_seq_ud = m_r_block_seq (p_blocks_pz, l_pos_z.rd_idx_ud);
+    }
+
+    DEBUG ("read msg(seq=%u size=%u tag=%u) prio=%u mask=0x%llx",
+        l_msg_seq_ud,
+        l_tot_size_ud,
+        l_tag_ud,
+        p_prio_ud,
+        (unsigned long long)p_tag_mask_ud);
+    *p_read_size_pud = l_tot_size_ud;
+    if (p_read_seq_pud != NULL)
+        *p_read_seq_pud = l_msg_seq_ud;
+    if (p_tag_pud != NULL)
+        *p_tag_pud = l_tag_ud;
+    return SUCCESS ();
+}/*m_r_read_lane_tags()*/
+
+
+//release the flash blocks at the read position of a lane with only
+//message parts up to a seq, then the parts left of those messages
+//return the nr of flash blocks released
+static uint32_t m_r_release_lane (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const hl_blocks_msg_seq_t         p_seq_ud)
+{
+    m_lane_t* l_lane_pz = &p_blocks_pz->lane_az[p_prio_ud];
+    uint32_t l_nr_released_ud = 0;
+    while (l_lane_pz->rd_idx_ud != p_blocks_pz->wr_idx_ud)
+    {
+        //seqs only increase in a lane, so the last part has the highest
+        const void*                 l_block_p;
+        m_r_flash_addr (p_blocks_pz, l_lane_pz->rd_idx_ud, &l_block_p);
+        const blk_head_t* l_blk_head_pz = (const blk_head_t*)l_block_p;
+        const unsigned char* l_block_data_puc = (const unsigned char*)l_block_p + sizeof (blk_head_t);
+        hl_blocks_msg_seq_t l_last_seq_ud = 0;
+        uint32_t l_rd_ofs_ud = l_lane_pz->rd_ofs_ud;
+        while (l_rd_ofs_ud < l_blk_head_pz->used_size_ud)
+        {
+            const msg_head_t* l_msg_head_pz = (const msg_head_t*)(l_block_data_puc + l_rd_ofs_ud);
+            l_last_seq_ud = l_msg_head_pz->seq_ud;
+            l_rd_ofs_ud += HL_BLOCKS_PART_STEP (l_blk_head_pz->align_ud, l_msg_head_pz->part_size_ud);
+        }/*while reading message parts in this block*/
+        if (  (l_last_seq_ud != 0)
+           && ((int32_t)(l_last_seq_ud - p_seq_ud) > 0))
+            break;
+
+        m_r_block_release (p_blocks_pz, l_lane_pz->rd_idx_ud, l_blk_head_pz);
+        m_r_lane_next_block (p_blocks_pz, p_prio_ud);
+        l_nr_released_ud ++;
+    }/*while blocks in flash*/
+
+    //the next block may start with the rest of a message released
+    if (l_nr_released_ud > 0)
+        l_nr_released_ud += m_r_skip_continued_parts (p_blocks_pz, p_prio_ud);
+    return l_nr_released_ud;
+}/*m_r_release_lane()*/
+
+
+//min data of a message to write as the next part into a block,
+//else the part goes into the next block
+static size_t m_r_min_part_data (
     const hl_blocks_t*                p_blocks_pz,
-    const uint32_t                    p_block_idx_ud)
+    const size_t                      p_size_ud,
+    const size_t                      p_remain_ud)
 {
-    if (p_block_idx_ud >= p_blocks_pz->nr_blocks_ud)
-        return 0;
+    if (p_size_ud <= p_blocks_pz->whole_max_ud)
+        return p_remain_ud;     //only in one part
+    return MIN (p_blocks_pz->min_data_per_part_ud, p_remain_ud);
+}/*m_r_min_part_data()*/
 
-    //get address of block to read directly from flash
-    const void*                 l_block_p;
-    (*p_blocks_pz->addr_pr) (p_block_idx_ud, &l_block_p);
-    blk_head_t* l_block_head_pz = (blk_head_t*)l_block_p;
-    return l_block_head_pz->seq_ud;
-}/*m_r_block_seq()*/
 
+//start time of a call to add to a latency histogram, 0 when not kept
+static uint64_t m_r_latency_start (
+    const hl_blocks_t*                p_blocks_pz)
+{
+    if (p_blocks_pz->lat_az == NULL)
+        return 0;
+    return latency_hist_r_now_ns ();
+}/*m_r_latency_start()*/
 
+
+static void m_r_latency_add (
+          hl_blocks_t*                p_blocks_pz,
+    const hl_blocks_latency_e         p_latency_e,
+    const uint64_t                    p_start_ns_ud)
+{
+    if (p_blocks_pz->lat_az == NULL)
+        return;
+    latency_hist_r_add (&p_blocks_pz->lat_az[p_latency_e], latency_hist_r_now_ns () - p_start_ns_ud);
+}/*m_r_latency_add()*/
@@ -5,7 +5,10 @@
  * I N C L U D E D   H E A D E R   F I L E S
  *****************************************************************************/
 
+#include "latency_hist.h"
+#include <stdint.h>
 #include <stdlib.h>
+#include <sys/uio.h>
 
 
 /*****************************************************************************
@@ -14,8 +17,30 @@
 
 typedef uint32_t hl_blocks_msg_seq_t;
 
+//max nr of priority classes, see hl_blocks_options_t.nr_prios_ud
+#define HL_BLOCKS_MAX_PRIOS     8
+
+//message tags 0..HL_BLOCKS_MAX_TAGS-1, see hl_blocks_r_write_tag()
+//and a mask of them for hl_blocks_r_read_tags()
+#define HL_BLOCKS_MAX_TAGS      64
+#define HL_BLOCKS_TAG_BIT(tag)  (1ULL << ((tag) & (HL_BLOCKS_MAX_TAGS - 1)))
+#define HL_BLOCKS_ALL_TAGS      (~0ULL)
+
 typedef struct hl_blocks_s hl_blocks_t;
 
+//position of one reader of hl_blocks_r_read_tags() in one prio
+typedef struct hl_blocks_cursor_lane_s {
+    hl_blocks_msg_seq_t         last_seq_ud;    //last message copied, 0=none
+    uint32_t                    blk_idx_ud;     //flash block to continue in
+    uint32_t                    blk_seq_ud;     //seq of that block, 0=continue at the read position
+    uint32_t                    blk_ofs_ud;     //data offset in that block
+} hl_blocks_cursor_lane_t;
+
+//position of one reader of hl_blocks_r_read_tags(), from hl_blocks_r_cursor_init()
+typedef struct hl_blocks_cursor_s {
+    hl_blocks_cursor_lane_t     lane_az[HL_BLOCKS_MAX_PRIOS];
+} hl_blocks_cursor_t;
+
 //writing is a control operation
 typedef int (hl_blocks_write_r) (
     const uint32_t                    p_idx_ud,     //0..N-1
@@ -28,6 +53,14 @@ typedef int (hl_blocks_addr_r) (
     const uint32_t                    p_idx_ud,     //0..N-1
     const void**                      p_block_pp);
 
+//optional vectored write, see hl_blocks_r_set_writev()
+//the pieces are the block header then the used data after it,
+//the rest of the block is not used and need not be written
+typedef int (hl_blocks_writev_r) (
+    const uint32_t                    p_idx_ud,     //0..N-1
+    const struct iovec*               p_iov_az,
+    const int                         p_nr_iov_d);
+
 typedef enum hl_blocks_error_enum_s {
     HL_BLOCKS_K_ERROR_CORRUPTED = -1,
     HL_BLOCKS_K_ERROR_READ_ALL = -2,
@@ -39,6 +72,83 @@ typedef enum hl_blocks_error_enum_s {
     HL_BLOCKS_K_ERROR_NR_OF
 } hl_blocks_error_e;
 
+//what write/sync does when all blocks are full of unread messages
+typedef enum hl_blocks_full_mode_enum_s {
+    HL_BLOCKS_K_FULL_MODE_REJECT = 0,           //fail with NO_SPACE_LEFT_IN_BUFFER (default)
+    HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST,     //drop the oldest unread block to make space
+    /*
+     * terminator
+     */
+    HL_BLOCKS_K_FULL_MODE_NR_OF
+} hl_blocks_full_mode_e;
+
+//how hl_blocks_r_drain_fd() separates messages in the output
+typedef enum hl_blocks_framing_enum_s {
+    HL_BLOCKS_K_FRAMING_NONE = 0,               //message data only, back to back
+    HL_BLOCKS_K_FRAMING_LEN32,                  //each message after its 4 byte size in network byte order
+    /*
+     * terminator
+     */
+    HL_BLOCKS_K_FRAMING_NR_OF
+} hl_blocks_framing_e;
+
+
+//optional settings for hl_blocks_r_open_options()
+//always initialise with hl_blocks_r_options_init() before changing fields
+typedef struct hl_blocks_options_s {
+    uint32_t                    nr_prios_ud;    //1..HL_BLOCKS_MAX_PRIOS priority classes, default 1 (FIFO)
+    uint32_t                    checkpoint_ud;  //1 to keep a checkpoint in the first 2 blocks for a fast open, default 0
+    uint32_t                    checkpoint_every_ud;//also write the checkpoint after this many blocks, default 0 = only in hl_blocks_r_sync() and close
+    uint32_t                    latency_ud;     //1 to keep latency histograms, see hl_blocks_r_get_latency(), default 0
+    uint32_t                    whole_max_ud;   //messages up to this size are never split over blocks, default 0
+    uint32_t                    align_ud;       //4, 8 or 16 to align message data in the blocks, default 0 (packed)
+    const void*                 linear_base_p;  //block 0 when all blocks are one linear mapping, default NULL to use addr_pr
+    uint32_t                    linear_stride_ud;//bytes from one block to the next with linear_base_p, default 0 = block size
+    uint32_t                    tag_map_ud;     //1 to keep a map of the message tags in each block, default 0
+} hl_blocks_options_t;
+
+//latency histograms kept with hl_blocks_options_t.latency_ud
+typedef enum hl_blocks_latency_enum_s {
+    HL_BLOCKS_K_LATENCY_WRITE = 0,              //hl_blocks_r_write() incl syncs when full
+    HL_BLOCKS_K_LATENCY_SYNC,                   //hl_blocks_r_sync()
+    HL_BLOCKS_K_LATENCY_WRITE_PR,               //each write_pr() of a message block, by write or sync
+    HL_BLOCKS_K_LATENCY_READ,                   //hl_blocks_r_read() that returned a message
+    HL_BLOCKS_K_LATENCY_OPEN,                   //hl_blocks_r_open() incl the scan
+    /*
+     * terminator
+     */
+    HL_BLOCKS_K_LATENCY_NR_OF
+} hl_blocks_latency_e;
+
+//counters since open, see hl_blocks_r_get_stats()
+typedef struct hl_blocks_stats_s {
+    uint64_t                    msgs_written_ud;
+    uint64_t                    bytes_written_ud;   //message data, without headers
+    uint64_t                    msgs_split_ud;      //messages written in more than one part
+    uint64_t                    msgs_moved_whole_ud;//messages up to whole_max_ud written in the next block instead of split
+    uint64_t                    whole_pad_bytes_ud; //bytes left empty by those, also in pad_bytes_ud
+    uint64_t                    parts_written_ud;   //message parts, one or more per message
+    uint64_t                    msgs_read_ud;       //by hl_blocks_r_read() and hl_blocks_r_drain_fd()
+    uint64_t                    bytes_read_ud;
+    uint64_t                    msgs_skipped_ud;    //messages passed over by hl_blocks_r_read_tags() for their tag, not consumed
+    uint64_t                    blocks_skipped_ud;  //blocks passed over by hl_blocks_r_read_tags() from their tag map, not consumed
+    uint64_t                    blocks_released_ud; //blocks freed by hl_blocks_r_release() behind the cursors
+    uint64_t                    reads_heap_ud;      //hl_blocks_r_read() of a message still in the heap buffer
+    uint64_t                    reads_flash_ud;     //hl_blocks_r_read() of a message starting in a flash block
+    uint64_t                    syncs_full_ud;      //blocks written because the next part did not fit
+    uint64_t                    syncs_explicit_ud;  //blocks written by hl_blocks_r_sync() or close
+    uint64_t                    blocks_written_ud;  //calls of write_pr() for message blocks, incl writev_pr()
+    uint64_t                    blocks_direct_ud;   //written with writev_pr() from the message data
+    uint64_t                    block_used_ud;      //data bytes in the blocks written, incl message headers
+    uint64_t                    pad_bytes_ud;       //bytes left empty in blocks synced when full
+    uint64_t                    align_pad_bytes_ud; //bytes added after message parts for align_ud
+    uint64_t                    rejects_full_ud;    //writes and syncs failed with NO_SPACE_LEFT_IN_BUFFER
+    uint64_t                    corruptions_ud;     //bad message parts read, bad blocks found by open
+    uint64_t                    drop_msgs_ud;       //see hl_blocks_r_get_dropped()
+    uint64_t                    drop_blks_ud;
+    double                      fill_ratio_d;       //avg block_used_ud / data space of the blocks written, 0..1
+} hl_blocks_stats_t;
+
 
 /*****************************************************************************
  * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
@@ -77,6 +187,70 @@ extern int hl_blocks_r_open (
           hl_blocks_addr_r*           p_addr_pr,
           hl_blocks_t**               p_blocks_ppz);
 
+/*
+ * PURPOSE:
+ *     Set default options, which is the same as hl_blocks_r_open().
+ */
+extern void hl_blocks_r_options_init (
+          hl_blocks_options_t*        p_options_pz);
+
+/*
+ * PURPOSE:
+ *     Same as hl_blocks_r_open() with more options.
+ *
+ *     With nr_prios_ud > 1, each priority class has its own heap block
+ *     and messages are written with hl_blocks_r_write_prio(). All classes
+ *     share the same flash blocks, each block holding messages of one
+ *     class only. hl_blocks_r_read() returns the oldest message of the
+ *     highest class that has anything to read. The space of a block is
+ *     only reused once all older blocks were also read.
+ *     Must open with the same nr of prios used before the cold start.
+ *
+ *     With whole_max_ud > 0, a message up to that size is written whole
+ *     in the next block when it does not fit in the current one, instead
+ *     of split when min_data_per_part fits. Its data is then in one piece
+ *     in flash, at the cost of the space left, see hl_blocks_r_get_stats().
+ *     Bigger messages are split as before. It must fit in a block after
+ *     the block and message headers.
+ *
+ *     With align_ud 4, 8 or 16, each message part is padded to a multiple
+ *     of it, so the data of each message starts aligned in the heap block
+ *     and in the flash block, and can be used as a struct without a copy
+ *     when the block addresses are aligned too. The block size must be a
+ *     multiple of it. Each block header has the alignment it was written
+ *     with, so blocks written with another align_ud are still read.
+ *
+ *     With linear_base_p, e.g. memory mapped QSPI flash, the address of
+ *     block N is linear_base_p + N * linear_stride_ud, computed inline
+ *     instead of calling p_addr_pr for each message part read and each
+ *     block scanned by open, and p_addr_pr may be NULL. Block N is the
+ *     same as passed to p_write_pr, incl the checkpoint blocks. Reading
+ *     then also prefetches the header of the next block when it starts
+ *     a block.
+ *
+ *     With tag_map_ud = 1, the last 8 bytes of each block are a map of
+ *     the tags of the messages in it, so hl_blocks_r_read_tags() passes
+ *     over blocks without a wanted tag without reading their messages. Large
+ *     messages are then always copied through the heap block, also with
+ *     hl_blocks_r_set_writev().
+ *
+ * PARAMETERS:
+ *     See hl_blocks_r_open()
+ *     p_options_pz            Options, from hl_blocks_r_options_init()
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_r_open_options (
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const uint32_t                    p_max_msg_size_ud,
+    const uint32_t                    p_min_data_per_part_ud,
+          hl_blocks_write_r*          p_write_pr,
+          hl_blocks_addr_r*           p_addr_pr,
+    const hl_blocks_options_t*        p_options_pz,
+          hl_blocks_t**               p_blocks_ppz);
+
 extern int hl_blocks_r_close (
           hl_blocks_t**               p_blocks_ppz);
 
@@ -86,6 +260,39 @@ extern int hl_blocks_r_write (
     const size_t                      p_size_ud,
           hl_blocks_msg_seq_t*        p_write_seq_pud);
 
+/*
+ * PURPOSE:
+ *     Write a message with a priority class 0..nr_prios-1,
+ *     where a higher value is read first.
+ *     hl_blocks_r_write() writes with prio 0.
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_r_write_prio (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const void*                       p_data_p,
+    const size_t                      p_size_ud,
+          hl_blocks_msg_seq_t*        p_write_seq_pud);
+
+/*
+ * PURPOSE:
+ *     Write a message with a priority class and a tag 0..HL_BLOCKS_MAX_TAGS-1,
+ *     e.g. the message type, kept in the message header for
+ *     hl_blocks_r_read_tags(). hl_blocks_r_write_prio() writes with tag 0.
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_r_write_tag (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_prio_ud,
+    const uint32_t                    p_tag_ud,
+    const void*                       p_data_p,
+    const size_t                      p_size_ud,
+          hl_blocks_msg_seq_t*        p_write_seq_pud);
+
 extern int hl_blocks_r_sync (
           hl_blocks_t*                p_blocks_pz);
 
@@ -96,9 +303,213 @@ extern int hl_blocks_r_read (
           size_t*                     p_read_size_pud,
           hl_blocks_msg_seq_t*        p_read_seq_pud);
 
+// start a cursor of hl_blocks_r_read_tags() at the oldest unread message
+extern void hl_blocks_r_cursor_init (
+          hl_blocks_cursor_t*         p_cursor_pz);
+
+/*
+ * PURPOSE:
+ *     Copy the next message after a cursor with one of the tags in a mask,
+ *     highest prio first like hl_blocks_r_read(), and move the cursor
+ *     after it. Nothing is consumed: messages with other tags, and the
+ *     ones copied, stay for hl_blocks_r_read() and for other cursors, so
+ *     several readers can each get their messages with their own cursor
+ *     and mask. Messages with other tags are passed over from their
+ *     message headers without copying their data, and blocks with a tag
+ *     map without any of the tags without reading their message headers,
+ *     see hl_blocks_options_t.tag_map_ud.
+ *     Messages consumed by hl_blocks_r_read() or dropped are no longer
+ *     found. The space is only freed by hl_blocks_r_read(), by
+ *     hl_blocks_r_release() behind all cursors, or by dropping with
+ *     HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST.
+ *
+ * PARAMETERS:
+ *     p_cursor_pz              from hl_blocks_r_cursor_init(), one per reader
+ *     p_tag_mask_ud            HL_BLOCKS_TAG_BIT() of each tag to read
+ *     p_tag_pud                NULL or set to the tag of the message copied
+ *     See hl_blocks_r_read() for the others
+ *
+ * RETURN:
+ *     SUCCESS, HL_BLOCKS_K_ERROR_READ_ALL when no message with the tags
+ *     is left after the cursor, or ERROR
+ */
+extern int hl_blocks_r_read_tags (
+          hl_blocks_t*                p_blocks_pz,
+          hl_blocks_cursor_t*         p_cursor_pz,
+    const uint64_t                    p_tag_mask_ud,
+          void*                       p_buff_data_p,
+    const size_t                      p_buff_size_ud,
+          size_t*                     p_read_size_pud,
+          hl_blocks_msg_seq_t*        p_read_seq_pud,
+          uint32_t*                   p_tag_pud);
+
+/*
+ * PURPOSE:
+ *     Free the flash blocks behind the slowest of the cursors of
+ *     hl_blocks_r_read_tags(), so the writer gets space when only those
+ *     readers run. A block is freed as if read by hl_blocks_r_read()
+ *     when each message in it is at or before every cursor in its prio.
+ *     Call it after reading, with all cursors still in use: messages
+ *     before the slowest cursor are no longer found by new cursors or
+ *     hl_blocks_r_read().
+ *
+ * PARAMETERS:
+ *     p_blocks_pz              Blocks to free
+ *     p_cursor_apz             The cursors of all readers
+ *     p_nr_cursors_ud          Nr of cursors, nothing is freed when 0
+ *     p_nr_released_pud        NULL or set to the nr of blocks freed
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_r_release (
+          hl_blocks_t*                p_blocks_pz,
+          hl_blocks_cursor_t* const   p_cursor_apz[],
+    const uint32_t                    p_nr_cursors_ud,
+          uint32_t*                   p_nr_released_pud);
+
+/*
+ * PURPOSE:
+ *     Write unread messages to a file or socket in one writev() call,
+ *     straight from the blocks returned by addr_pr() without copying
+ *     them into a buffer, in the same order as hl_blocks_r_read().
+ *
+ *     Only what the fd accepted is consumed. When it accepted part of a
+ *     message, the next call continues with the rest of that message,
+ *     so the output stream stays whole. Do not mix with
+ *     hl_blocks_r_read(), which returns whole messages only.
+ *
+ *     addr_pr() addresses must remain valid while reading other blocks,
+ *     as with memory mapped flash or hl_blocks_mmap.
+ *     A non-blocking fd that is not ready drains 0 bytes successfully.
+ *
+ * PARAMETERS:
+ *     p_blocks_pz              Blocks to read from
+ *     p_fd_d                   File or socket to write to
+ *     p_max_bytes_ud           Max bytes to write in this call
+ *     p_framing_e              Message framing in the output
+ *     p_drained_pud            NULL or set to nr of bytes written
+ *     p_nr_msgs_pud            NULL or set to nr of messages completed
+ *
+ * RETURN:
+ *     SUCCESS, HL_BLOCKS_K_ERROR_READ_ALL when nothing to drain, or ERROR
+ */
+extern int hl_blocks_r_drain_fd (
+          hl_blocks_t*                p_blocks_pz,
+    const int                         p_fd_d,
+    const size_t                      p_max_bytes_ud,
+    const hl_blocks_framing_e         p_framing_e,
+          size_t*                     p_drained_pud,
+          uint32_t*                   p_nr_msgs_pud);
+
+/*
+ * PURPOSE:
+ *     Select what happens when the buffer is full of unread messages.
+ *
+ *     In HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST sync never fails for lack
+ *     of space: it drops the oldest unread block (and the parts of messages
+ *     started in it that continue in the next block) so that writing keeps
+ *     a constant latency under backlog. The reader simply continues with
+ *     the oldest message still available. Use hl_blocks_r_get_dropped()
+ *     to see what was lost.
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_r_set_full_mode (
+          hl_blocks_t*                p_blocks_pz,
+    const hl_blocks_full_mode_e       p_full_mode_e);
+
+/*
+ * PURPOSE:
+ *     Set a vectored block write for large messages, NULL to stop using it.
+ *
+ *     The parts of a message that fill a whole block, except the last part
+ *     that stays in the heap block like any other, are then written
+ *     straight from the caller's data with the block and message headers
+ *     before it, instead of being copied into the heap block first. The
+ *     blocks are the same as with write_pr(), only written sooner, and
+ *     always after the heap block with the messages before it.
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_r_set_writev (
+          hl_blocks_t*                p_blocks_pz,
+          hl_blocks_writev_r*         p_writev_pr);
+
+/*
+ * PURPOSE:
+ *     Get the nr of messages and blocks dropped since open in
+ *     HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST and the range of message
+ *     sequence numbers lost in the last drop (0 when nothing was dropped).
+ *     Any output pointer may be NULL.
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_r_get_dropped (
+    const hl_blocks_t*                p_blocks_pz,
+          uint32_t*                   p_nr_msgs_pud,
+          uint32_t*                   p_nr_blocks_pud,
+          hl_blocks_msg_seq_t*        p_first_seq_pud,
+          hl_blocks_msg_seq_t*        p_last_seq_pud);
+
+/*
+ * PURPOSE:
+ *     Get the counters since open, e.g. to export as metrics.
+ *
+ *     The counters are kept in the instance and updated with relaxed
+ *     atomic stores, so another thread can get them while this one writes
+ *     or reads, without a lock. Each counter is exact, but they are not a
+ *     consistent snapshot of one moment. Build with
+ *     -DHL_BLOCKS_STATS_ATOMIC=0 for plain counters, when only the thread
+ *     using the instance gets them, e.g. on a target without 64 bit atomics.
+ *
+ *     pad_bytes_ud is the space lost to min_data_per_part_ud and whole_max_ud:
+ *     what was left in a block when the next part did not fit, of which
+ *     whole_pad_bytes_ud for messages not split. Blocks written by an
+ *     explicit sync are not full, which lowers fill_ratio_d but is not
+ *     counted as padding.
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_r_get_stats (
+    const hl_blocks_t*                p_blocks_pz,
+          hl_blocks_stats_t*          p_stats_pz);
+
+/*
+ * PURPOSE:
+ *     Get a latency histogram, kept when opened with latency_ud = 1.
+ *     Only successful calls are counted. The time of write_pr() is also
+ *     counted on its own, to tell a slow device from time spent in
+ *     hl_blocks. Get percentiles with latency_hist_r_percentile().
+ *
+ *     With reset, the next call returns only what was counted after this
+ *     one. It can be called from another thread than the one writing,
+ *     like hl_blocks_r_get_stats(), but only from one thread when reset
+ *     is used, because the reset point is kept in the instance.
+ *
+ * PARAMETERS:
+ *     p_blocks_pz              Opened with latency_ud = 1
+ *     p_latency_e              Which histogram
+ *     p_reset_d                1 to count from zero again after this call
+ *     p_hist_pz                Output: Copy of the histogram
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_r_get_latency (
+          hl_blocks_t*                p_blocks_pz,
+    const hl_blocks_latency_e         p_latency_e,
+    const int                         p_reset_d,
+          latency_hist_t*             p_hist_pz);
+
 /*
  * ===================[ ONLY FOR UNIT TESTING ]===================
  */
+// same as blocks_written_ud of hl_blocks_r_get_stats()
 extern uint32_t hl_blocks_r___get_write_count (
     const hl_blocks_t*                p_blocks_pz);
 
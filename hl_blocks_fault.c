@@ -0,0 +1,146 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#define LOG_MODULE  "hl_blocks_fault"
+
+#include "error_stack.h"
+#include "hl_blocks_fault.h"
+#include "log.h"
+#include <string.h>
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+static uint32_t             m_d_block_size_ud       = 0;
+static uint32_t             m_d_nr_blocks_ud        = 0;
+static unsigned char*       m_d_flash_auc           = NULL;     //what survives a power cut
+static unsigned char*       m_d_view_auc            = NULL;     //what hl_blocks reads
+static uint32_t             m_d_write_count_ud      = 0;
+
+//the power cut: at write m_d_cut_write_nr_ud (counted from open), 0=none
+static uint32_t             m_d_cut_write_nr_ud     = 0;
+static uint32_t             m_d_cut_torn_bytes_ud   = 0;
+static int                  m_d_cut_d               = 0;
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+extern int hl_blocks_fault_r_open (
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud)
+{
+    if (  (p_block_size_ud == 0)
+       || (p_nr_blocks_ud == 0))
+        return ERROR (-1, "invalid params for hl_blocks_fault_r_open(%u,%u)",
+            p_block_size_ud,
+            p_nr_blocks_ud);
+    if (m_d_flash_auc != NULL)
+        return ERROR (-1, "hl_blocks_fault already open, only one allowed");
+
+    size_t l_size_ud = (size_t)p_block_size_ud * p_nr_blocks_ud;
+    m_d_flash_auc = (unsigned char*)calloc (1, l_size_ud);
+    m_d_view_auc  = (unsigned char*)calloc (1, l_size_ud);
+    if (  (m_d_flash_auc == NULL)
+       || (m_d_view_auc == NULL)) {
+        hl_blocks_fault_r_close ();
+        return ERROR (-1, "failed to allocate 2 x %zu bytes", l_size_ud);
+    }
+
+    m_d_block_size_ud       = p_block_size_ud;
+    m_d_nr_blocks_ud        = p_nr_blocks_ud;
+    m_d_write_count_ud      = 0;
+    m_d_cut_write_nr_ud     = 0;
+    m_d_cut_torn_bytes_ud   = 0;
+    m_d_cut_d               = 0;
+    return SUCCESS ();
+}/*hl_blocks_fault_r_open()*/
+
+
+extern int hl_blocks_fault_r_close (void)
+{
+    free (m_d_flash_auc);
+    free (m_d_view_auc);
+    m_d_flash_auc = NULL;
+    m_d_view_auc  = NULL;
+    return SUCCESS ();
+}/*hl_blocks_fault_r_close()*/
+
+
+extern void hl_blocks_fault_r_cut_at (
+    const uint32_t                    p_write_nr_ud,
+    const uint32_t                    p_torn_bytes_ud)
+{
+    m_d_cut_write_nr_ud   = (p_write_nr_ud > 0) ? m_d_write_count_ud + p_write_nr_ud : 0;
+    m_d_cut_torn_bytes_ud = MIN (p_torn_bytes_ud, m_d_block_size_ud);
+}/*hl_blocks_fault_r_cut_at()*/
+
+
+extern int hl_blocks_fault_r_is_cut (void)
+{
+    return m_d_cut_d;
+}/*hl_blocks_fault_r_is_cut()*/
+
+
+extern void hl_blocks_fault_r_power_on (void)
+{
+    memcpy (m_d_view_auc, m_d_flash_auc, (size_t)m_d_block_size_ud * m_d_nr_blocks_ud);
+    m_d_cut_d           = 0;
+    m_d_cut_write_nr_ud = 0;
+}/*hl_blocks_fault_r_power_on()*/
+
+
+extern uint32_t hl_blocks_fault_r_get_write_count (void)
+{
+    return m_d_write_count_ud;
+}/*hl_blocks_fault_r_get_write_count()*/
+
+
+extern int hl_blocks_fault_r_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    m_d_write_count_ud ++;
+    if (m_d_cut_d)
+        return ERROR (-1, "power cut, cannot write blk[%u]", p_idx_ud);
+
+    size_t l_ofs_ud = (size_t)m_d_block_size_ud * p_idx_ud;
+    if (m_d_write_count_ud == m_d_cut_write_nr_ud) {
+        //only the start of the block reached the flash
+        memcpy (m_d_flash_auc + l_ofs_ud, p_block_p, m_d_cut_torn_bytes_ud);
+        m_d_cut_d = 1;
+        DEBUG ("power cut on write %u blk[%u] after %u bytes",
+            m_d_write_count_ud,
+            p_idx_ud,
+            m_d_cut_torn_bytes_ud);
+        return ERROR (-1, "power cut while writing blk[%u]", p_idx_ud);
+    }
+
+    //the block may be the view, when writing a block read from it
+    memmove (m_d_view_auc + l_ofs_ud, p_block_p, m_d_block_size_ud);
+    memcpy (m_d_flash_auc + l_ofs_ud, m_d_view_auc + l_ofs_ud, m_d_block_size_ud);
+    return SUCCESS ();
+}/*hl_blocks_fault_r_write()*/
+
+
+extern int hl_blocks_fault_r_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    *p_block_pp = m_d_view_auc + ((size_t)m_d_block_size_ud * p_idx_ud);
+    return SUCCESS ();
+}/*hl_blocks_fault_r_addr()*/
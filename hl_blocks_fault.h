@@ -0,0 +1,87 @@
+#ifndef _HL_BLOCKS_FAULT_H_
+#define _HL_BLOCKS_FAULT_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+/*
+ * PURPOSE:
+ *     Block backend for hl_blocks in memory that simulates a power cut
+ *     at any write, to test and measure recovery with hl_blocks_r_open().
+ *
+ *     It keeps the flash contents, which survive the power cut, and a
+ *     copy returned by hl_blocks_fault_r_addr(), like memory mapped
+ *     flash that is read directly. hl_blocks_fault_r_cut_at() selects the
+ *     write where the power is cut: only the first p_torn_bytes_ud bytes
+ *     of that block reach the flash and that and all later writes fail,
+ *     until hl_blocks_fault_r_power_on() restores the copy from flash.
+ *
+ *     Only one instance can be open at a time, because the hl_blocks
+ *     backend functions has no context.
+ *
+ *     Usage:
+ *         hl_blocks_fault_r_open (512, 64);
+ *         hl_blocks_r_open (512, 64, ..., hl_blocks_fault_r_write, hl_blocks_fault_r_addr, &blocks);
+ *         hl_blocks_fault_r_cut_at (10, 100);
+ *         ... write until it fails ...
+ *         hl_blocks_r_close (&blocks);
+ *         hl_blocks_fault_r_power_on ();
+ *         hl_blocks_r_open (512, 64, ..., &blocks);
+ *
+ * PARAMETERS:
+ *     p_block_size_ud          Size of each block
+ *     p_nr_blocks_ud           Number of blocks, all empty
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_fault_r_open (
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud);
+
+// release the memory
+extern int hl_blocks_fault_r_close (void);
+
+/*
+ * PURPOSE:
+ *     Cut the power on a write.
+ *
+ * PARAMETERS:
+ *     p_write_nr_ud            1 for the next write, 2 for the one after, ...
+ *                              or 0 not to cut
+ *     p_torn_bytes_ud          Nr of bytes of that block written before the
+ *                              power is cut, 0..block size
+ */
+extern void hl_blocks_fault_r_cut_at (
+    const uint32_t                    p_write_nr_ud,
+    const uint32_t                    p_torn_bytes_ud);
+
+// 1 after the power was cut, until hl_blocks_fault_r_power_on()
+extern int hl_blocks_fault_r_is_cut (void);
+
+// read all blocks from flash again and accept writes
+extern void hl_blocks_fault_r_power_on (void);
+
+// nr of writes since open, incl failed writes
+extern uint32_t hl_blocks_fault_r_get_write_count (void);
+
+// hl_blocks_write_r for hl_blocks_r_open()
+extern int hl_blocks_fault_r_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p);
+
+// hl_blocks_addr_r for hl_blocks_r_open()
+extern int hl_blocks_fault_r_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp);
+
+#endif /*_HL_BLOCKS_FAULT_H_*/
@@ -0,0 +1,291 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#define LOG_MODULE  "hl_blocks_flashsim"
+
+#include "error_stack.h"
+#include "hl_blocks_flashsim.h"
+#include "log.h"
+#include <string.h>
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+
+#define M_ERASED_BYTE           0xFF
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+static hl_blocks_flashsim_config_t m_d_config_z;
+static uint32_t             m_d_block_size_ud       = 0;
+static uint32_t             m_d_nr_blocks_ud        = 0;
+static uint32_t             m_d_nr_units_ud         = 0;
+static unsigned char*       m_d_flash_auc           = NULL;     //nr_units x erase size
+static unsigned char*       m_d_unit_auc            = NULL;     //content of a unit while it is erased
+static uint32_t*            m_d_erases_aud          = NULL;     //per unit
+static uint32_t*            m_d_programs_aud        = NULL;     //per page, since its unit was erased
+static hl_blocks_flashsim_stats_t m_d_stats_z;
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static int m_r_must_erase (
+    const uint32_t                    p_ofs_ud,
+    const uint32_t                    p_end_ud,
+    const unsigned char*              p_data_puc);
+
+static void m_r_erase_and_program (
+    const uint32_t                    p_unit_ud,
+    const uint32_t                    p_ofs_ud,
+    const uint32_t                    p_end_ud,
+    const unsigned char*              p_data_puc);
+
+static int m_r_is_erased (
+    const unsigned char*              p_data_puc,
+    const uint32_t                    p_size_ud);
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+extern void hl_blocks_flashsim_r_config_init (
+    const hl_blocks_flashsim_type_e   p_type_e,
+          hl_blocks_flashsim_config_t* p_config_pz)
+{
+    if (p_type_e == HL_BLOCKS_FLASHSIM_K_TYPE_NAND) {
+        p_config_pz->page_size_ud       = 2048;
+        p_config_pz->erase_size_ud      = 64 * 2048;
+        p_config_pz->max_programs_ud    = 4;
+        p_config_pz->page_program_ns_ud = 200000;
+        p_config_pz->erase_ns_ud        = 700000;
+    } else {
+        p_config_pz->page_size_ud       = 256;
+        p_config_pz->erase_size_ud      = 4096;
+        p_config_pz->max_programs_ud    = 0;
+        p_config_pz->page_program_ns_ud = 700000;
+        p_config_pz->erase_ns_ud        = 45000000;
+    }
+}/*hl_blocks_flashsim_r_config_init()*/
+
+
+extern int hl_blocks_flashsim_r_open (
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const hl_blocks_flashsim_config_t* p_config_pz)
+{
+    if (  (p_block_size_ud == 0)
+       || (p_nr_blocks_ud == 0)
+       || (p_config_pz == NULL)
+       || (p_config_pz->page_size_ud == 0)
+       || (p_config_pz->erase_size_ud == 0)
+       || (p_config_pz->erase_size_ud % p_config_pz->page_size_ud != 0))
+        return ERROR (-1, "invalid params for hl_blocks_flashsim_r_open(%u,%u,%p)",
+            p_block_size_ud,
+            p_nr_blocks_ud,
+            p_config_pz);
+    if (  ((p_block_size_ud % p_config_pz->page_size_ud != 0) && (p_config_pz->page_size_ud % p_block_size_ud != 0))
+       || ((p_block_size_ud % p_config_pz->erase_size_ud != 0) && (p_config_pz->erase_size_ud % p_block_size_ud != 0)))
+        return ERROR (-1, "block size %u must be a multiple or a fraction of page size %u and erase size %u",
+            p_block_size_ud,
+            p_config_pz->page_size_ud,
+            p_config_pz->erase_size_ud);
+    if (m_d_flash_auc != NULL)
+        return ERROR (-1, "hl_blocks_flashsim already open, only one allowed");
+
+    uint64_t l_size_ud = (uint64_t)p_block_size_ud * p_nr_blocks_ud;
+    m_d_config_z        = *p_config_pz;
+    m_d_block_size_ud   = p_block_size_ud;
+    m_d_nr_blocks_ud    = p_nr_blocks_ud;
+    m_d_nr_units_ud     = (uint32_t)((l_size_ud + p_config_pz->erase_size_ud - 1) / p_config_pz->erase_size_ud);
+    l_size_ud           = (uint64_t)m_d_nr_units_ud * p_config_pz->erase_size_ud;
+    m_d_flash_auc       = (unsigned char*)malloc (l_size_ud);
+    m_d_unit_auc        = (unsigned char*)malloc (p_config_pz->erase_size_ud);
+    m_d_erases_aud      = (uint32_t*)calloc (m_d_nr_units_ud, sizeof (uint32_t));
+    m_d_programs_aud    = (uint32_t*)calloc (l_size_ud / p_config_pz->page_size_ud, sizeof (uint32_t));
+    if (  (m_d_flash_auc == NULL)
+       || (m_d_unit_auc == NULL)
+       || (m_d_erases_aud == NULL)
+       || (m_d_programs_aud == NULL)) {
+        hl_blocks_flashsim_r_close ();
+        return ERROR (-1, "failed to allocate %llu bytes of flash", (unsigned long long)l_size_ud);
+    }
+    memset (m_d_flash_auc, M_ERASED_BYTE, l_size_ud);
+    memset (&m_d_stats_z, 0, sizeof (m_d_stats_z));
+    return SUCCESS ();
+}/*hl_blocks_flashsim_r_open()*/
+
+
+extern int hl_blocks_flashsim_r_close (void)
+{
+    free (m_d_flash_auc);
+    free (m_d_unit_auc);
+    free (m_d_erases_aud);
+    free (m_d_programs_aud);
+    m_d_flash_auc    = NULL;
+    m_d_unit_auc     = NULL;
+    m_d_erases_aud   = NULL;
+    m_d_programs_aud = NULL;
+    return SUCCESS ();
+}/*hl_blocks_flashsim_r_close()*/
+
+
+extern void hl_blocks_flashsim_r_get_stats (
+          hl_blocks_flashsim_stats_t* p_stats_pz)
+{
+    *p_stats_pz = m_d_stats_z;
+}/*hl_blocks_flashsim_r_get_stats()*/
+
+
+extern const uint32_t* hl_blocks_flashsim_r_get_erase_counts (
+          uint32_t*                   p_nr_units_pud)
+{
+    *p_nr_units_pud = m_d_nr_units_ud;
+    return m_d_erases_aud;
+}/*hl_blocks_flashsim_r_get_erase_counts()*/
+
+
+extern int hl_blocks_flashsim_r_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    const uint32_t          l_page_size_ud  = m_d_config_z.page_size_ud;
+    const uint32_t          l_erase_size_ud = m_d_config_z.erase_size_ud;
+    const uint32_t          l_ofs_ud        = p_idx_ud * m_d_block_size_ud;
+    const uint32_t          l_end_ud        = l_ofs_ud + m_d_block_size_ud;
+    const unsigned char*    l_data_puc      = (const unsigned char*)p_block_p;
+    m_d_stats_z.writes_ud ++;
+    m_d_stats_z.bytes_written_ud += m_d_block_size_ud;
+
+    //erase the units where the block cannot be programmed as is
+    for (uint32_t l_unit_ofs_ud = l_ofs_ud - l_ofs_ud % l_erase_size_ud; l_unit_ofs_ud < l_end_ud; l_unit_ofs_ud += l_erase_size_ud) {
+        uint32_t l_lo_ud = MAX (l_ofs_ud, l_unit_ofs_ud);
+        uint32_t l_hi_ud = MIN (l_end_ud, l_unit_ofs_ud + l_erase_size_ud);
+        if (m_r_must_erase (l_lo_ud, l_hi_ud, l_data_puc + (l_lo_ud - l_ofs_ud)))
+            m_r_erase_and_program (l_unit_ofs_ud / l_erase_size_ud, l_lo_ud, l_hi_ud, l_data_puc + (l_lo_ud - l_ofs_ud));
+    }
+
+    //program the pages that changed, only 1 bits to 0 after the erase check
+    for (uint32_t l_page_ofs_ud = l_ofs_ud - l_ofs_ud % l_page_size_ud; l_page_ofs_ud < l_end_ud; l_page_ofs_ud += l_page_size_ud) {
+        uint32_t l_lo_ud = MAX (l_ofs_ud, l_page_ofs_ud);
+        uint32_t l_hi_ud = MIN (l_end_ud, l_page_ofs_ud + l_page_size_ud);
+        if (memcmp (m_d_flash_auc + l_lo_ud, l_data_puc + (l_lo_ud - l_ofs_ud), l_hi_ud - l_lo_ud) == 0)
+            continue;
+        memcpy (m_d_flash_auc + l_lo_ud, l_data_puc + (l_lo_ud - l_ofs_ud), l_hi_ud - l_lo_ud);
+        m_d_programs_aud[l_page_ofs_ud / l_page_size_ud] ++;
+        m_d_stats_z.pages_programmed_ud ++;
+        m_d_stats_z.time_ns_ud += m_d_config_z.page_program_ns_ud;
+    }
+    return SUCCESS ();
+}/*hl_blocks_flashsim_r_write()*/
+
+
+extern int hl_blocks_flashsim_r_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    *p_block_pp = m_d_flash_auc + (size_t)p_idx_ud * m_d_block_size_ud;
+    return SUCCESS ();
+}/*hl_blocks_flashsim_r_addr()*/
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+//1 when flash ofs..end in one unit cannot be programmed with the data:
+//a bit must change from 0 to 1, or a changed page was programmed too often
+static int m_r_must_erase (
+    const uint32_t                    p_ofs_ud,
+    const uint32_t                    p_end_ud,
+    const unsigned char*              p_data_puc)
+{
+    for (uint32_t l_ofs_ud = p_ofs_ud; l_ofs_ud < p_end_ud; l_ofs_ud++) {
+        unsigned char l_new_uc = p_data_puc[l_ofs_ud - p_ofs_ud];
+        if ((m_d_flash_auc[l_ofs_ud] & l_new_uc) != l_new_uc)
+            return 1;
+    }
+    if (m_d_config_z.max_programs_ud == 0)
+        return 0;
+
+    const uint32_t l_page_size_ud = m_d_config_z.page_size_ud;
+    for (uint32_t l_page_ofs_ud = p_ofs_ud - p_ofs_ud % l_page_size_ud; l_page_ofs_ud < p_end_ud; l_page_ofs_ud += l_page_size_ud) {
+        uint32_t l_lo_ud = MAX (p_ofs_ud, l_page_ofs_ud);
+        uint32_t l_hi_ud = MIN (p_end_ud, l_page_ofs_ud + l_page_size_ud);
+        if (  (m_d_programs_aud[l_page_ofs_ud / l_page_size_ud] >= m_d_config_z.max_programs_ud)
+           && (memcmp (m_d_flash_auc + l_lo_ud, p_data_puc + (l_lo_ud - p_ofs_ud), l_hi_ud - l_lo_ud) != 0))
+            return 1;
+    }
+    return 0;
+}/*m_r_must_erase()*/
+
+
+//erase a unit and program it with the data at ofs..end and the rest
+//of the unit as it was, a page at a time
+static void m_r_erase_and_program (
+    const uint32_t                    p_unit_ud,
+    const uint32_t                    p_ofs_ud,
+    const uint32_t                    p_end_ud,
+    const unsigned char*              p_data_puc)
+{
+    const uint32_t l_erase_size_ud = m_d_config_z.erase_size_ud;
+    const uint32_t l_page_size_ud  = m_d_config_z.page_size_ud;
+    const uint32_t l_unit_ofs_ud   = p_unit_ud * l_erase_size_ud;
+    unsigned char* l_unit_puc      = m_d_flash_auc + l_unit_ofs_ud;
+
+    memcpy (m_d_unit_auc, l_unit_puc, l_erase_size_ud);
+    memcpy (m_d_unit_auc + (p_ofs_ud - l_unit_ofs_ud), p_data_puc, p_end_ud - p_ofs_ud);
+    memset (l_unit_puc, M_ERASED_BYTE, l_erase_size_ud);
+    m_d_erases_aud[p_unit_ud] ++;
+    if (m_d_erases_aud[p_unit_ud] > m_d_stats_z.max_erases_ud)
+        m_d_stats_z.max_erases_ud = m_d_erases_aud[p_unit_ud];
+    m_d_stats_z.erases_ud ++;
+    m_d_stats_z.time_ns_ud += m_d_config_z.erase_ns_ud;
+    TRACE ("Erased unit %u, %u times", p_unit_ud, m_d_erases_aud[p_unit_ud]);
+
+    for (uint32_t l_page_ofs_ud = 0; l_page_ofs_ud < l_erase_size_ud; l_page_ofs_ud += l_page_size_ud) {
+        uint32_t l_page_ud = (l_unit_ofs_ud + l_page_ofs_ud) / l_page_size_ud;
+        m_d_programs_aud[l_page_ud] = 0;
+        if (m_r_is_erased (m_d_unit_auc + l_page_ofs_ud, l_page_size_ud))
+            continue;
+
+        memcpy (l_unit_puc + l_page_ofs_ud, m_d_unit_auc + l_page_ofs_ud, l_page_size_ud);
+        m_d_programs_aud[l_page_ud] = 1;
+        m_d_stats_z.pages_programmed_ud ++;
+        m_d_stats_z.time_ns_ud += m_d_config_z.page_program_ns_ud;
+
+        //data of other blocks in this page, before and after ofs..end
+        uint32_t l_lo_ud = l_unit_ofs_ud + l_page_ofs_ud;
+        uint32_t l_hi_ud = l_lo_ud + l_page_size_ud;
+        if (  ((l_lo_ud < p_ofs_ud) && !m_r_is_erased (m_d_unit_auc + l_page_ofs_ud, MIN (l_hi_ud, p_ofs_ud) - l_lo_ud))
+           || ((l_hi_ud > p_end_ud) && !m_r_is_erased (m_d_unit_auc + (MAX (l_lo_ud, p_end_ud) - l_unit_ofs_ud), l_hi_ud - MAX (l_lo_ud, p_end_ud))))
+            m_d_stats_z.pages_reprogrammed_ud ++;
+    }
+}/*m_r_erase_and_program()*/
+
+
+static int m_r_is_erased (
+    const unsigned char*              p_data_puc,
+    const uint32_t                    p_size_ud)
+{
+    for (uint32_t i = 0; i < p_size_ud; i++) {
+        if (p_data_puc[i] != M_ERASED_BYTE)
+            return 0;
+    }
+    return 1;
+}/*m_r_is_erased()*/
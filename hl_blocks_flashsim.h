@@ -0,0 +1,110 @@
+#ifndef _HL_BLOCKS_FLASHSIM_H_
+#define _HL_BLOCKS_FLASHSIM_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/*****************************************************************************
+ * P U B L I C   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+typedef enum hl_blocks_flashsim_type_enum_s {
+    HL_BLOCKS_FLASHSIM_K_TYPE_NOR = 0,          //e.g. SPI NOR: 256 byte pages, 4 KB sectors
+    HL_BLOCKS_FLASHSIM_K_TYPE_NAND,             //e.g. SLC NAND: 2 KB pages, 128 KB blocks
+    /*
+     * terminator
+     */
+    HL_BLOCKS_FLASHSIM_K_TYPE_NR_OF
+} hl_blocks_flashsim_type_e;
+
+//geometry and latency model
+//always initialise with hl_blocks_flashsim_r_config_init() before changing fields
+typedef struct hl_blocks_flashsim_config_s {
+    uint32_t                    page_size_ud;       //program unit
+    uint32_t                    erase_size_ud;      //erase unit, sector or NAND block, multiple of the page size
+    uint32_t                    max_programs_ud;    //programs per page between erases, NAND NOP, 0=unlimited
+    uint32_t                    page_program_ns_ud; //time to program a page
+    uint32_t                    erase_ns_ud;        //time to erase a unit
+} hl_blocks_flashsim_config_t;
+
+typedef struct hl_blocks_flashsim_stats_s {
+    uint64_t                    writes_ud;          //calls of hl_blocks_flashsim_r_write()
+    uint64_t                    bytes_written_ud;   //bytes passed to hl_blocks_flashsim_r_write()
+    uint64_t                    pages_programmed_ud;//incl pages programmed again after an erase
+    uint64_t                    pages_reprogrammed_ud;//of other blocks in a unit, to keep them after an erase
+    uint64_t                    erases_ud;
+    uint32_t                    max_erases_ud;      //erases of the most erased unit
+    uint64_t                    time_ns_ud;         //simulated time programming and erasing
+} hl_blocks_flashsim_stats_t;
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+// set the geometry and typical latencies of a flash type
+extern void hl_blocks_flashsim_r_config_init (
+    const hl_blocks_flashsim_type_e   p_type_e,
+          hl_blocks_flashsim_config_t* p_config_pz);
+
+/*
+ * PURPOSE:
+ *     Block backend for hl_blocks in memory that simulates NOR or NAND
+ *     flash, to measure write amplification, erases and flash time for
+ *     the settings of hl_blocks.
+ *     The flash starts erased, with all bytes 0xFF. Programming can only
+ *     change bits from 1 to 0, a page at a time, and NAND pages only
+ *     max_programs_ud times between erases. hl_blocks_flashsim_r_write()
+ *     programs the pages of the block that changed, and first erases the
+ *     units where that is not possible. Other blocks in an erased unit
+ *     are programmed again, as a flash driver must do when blocks are
+ *     smaller than the erase unit. hl_blocks_flashsim_r_addr() returns the
+ *     flash memory, like memory mapped flash that is read directly.
+ *     Only one instance can be open at a time, because the hl_blocks
+ *     backend functions has no context.
+ *     Usage:
+ *         hl_blocks_flashsim_config_t config;
+ *         hl_blocks_flashsim_r_config_init (HL_BLOCKS_FLASHSIM_K_TYPE_NOR, &config);
+ *         hl_blocks_flashsim_r_open (512, 64, &config);
+ *         hl_blocks_r_open (512, 64, ..., hl_blocks_flashsim_r_write, hl_blocks_flashsim_r_addr, &blocks);
+ *         ...
+ *         hl_blocks_flashsim_r_get_stats (&stats);
+ * PARAMETERS:
+ *     p_block_size_ud          Size of each block, a multiple or a fraction
+ *                              of the page size and of the erase size
+ *     p_nr_blocks_ud           Number of blocks
+ *     p_config_pz              Geometry and latency model
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_flashsim_r_open (
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const hl_blocks_flashsim_config_t* p_config_pz);
+
+// release the memory
+extern int hl_blocks_flashsim_r_close (void);
+
+extern void hl_blocks_flashsim_r_get_stats (
+          hl_blocks_flashsim_stats_t* p_stats_pz);
+
+// erases of each erase unit since open, and the nr of units
+extern const uint32_t* hl_blocks_flashsim_r_get_erase_counts (
+          uint32_t*                   p_nr_units_pud);
+
+// hl_blocks_write_r for hl_blocks_r_open()
+extern int hl_blocks_flashsim_r_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p);
+
+// hl_blocks_addr_r for hl_blocks_r_open()
+extern int hl_blocks_flashsim_r_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp);
+
+#endif /*_HL_BLOCKS_FLASHSIM_H_*/
@@ -0,0 +1,101 @@
+#ifndef _HL_BLOCKS_FORMAT_H_
+#define _HL_BLOCKS_FORMAT_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "hl_blocks.h"
+
+
+/*****************************************************************************
+ * P U B L I C   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+/*
+ * Layout of the blocks written by hl_blocks, for tools that read images
+ * without hl_blocks_r_open(). Each block is:
+ *     blk_head_t
+ *     msg_head_t + part_size_ud bytes of data (+ padding)
+ *     msg_head_t + part_size_ud bytes of data (+ padding)
+ *     ... up to used_size_ud bytes after the block header
+ * When align_ud is 4, 8 or 16, each part is padded to a multiple of it,
+ * so all headers and data start at that alignment in the block. Use
+ * HL_BLOCKS_PART_STEP() to get from one message header to the next.
+ * With HL_BLOCKS_BLK_FLAG_TAG_MAP in flags_ud, the last
+ * HL_BLOCKS_TAG_MAP_SIZE bytes of the block are a uint64_t with bit N
+ * set when a part of a message with tag N is in the block. The crc then
+ * also covers it, after the used bytes.
+ * A message that does not fit continues with part 1,2,... in the next
+ * block of the same priority. A block with seq_ud == 0 is empty or
+ * was released after it was read. A block with HL_BLOCKS_BLK_FLAG_CRC
+ * and a wrong crc_ud is treated as empty, e.g. when it was not
+ * completely written. Blocks written before the crc have neither the
+ * flag nor a crc, with crc_ud 0, and are read without checking it.
+ * Erased flash has all bits 1, so a block that was never written after
+ * an erase has seq_ud and used_size_ud HL_BLOCKS_ERASED_WORD and is empty.
+ */
+
+typedef uint32_t blk_seq_t;
+
+#define HL_BLOCKS_ERASED_WORD           0xFFFFFFFF
+
+typedef struct block_head_s {
+    blk_seq_t                   seq_ud;         //1,2,3, ... rollover to 1 when necessary
+    uint32_t                    used_size_ud;   //byte used in this block (after the block header)
+    uint8_t                     prio_ud;        //priority class of all messages in this block
+    uint8_t                     flags_ud;       //HL_BLOCKS_BLK_FLAG_...
+    uint16_t                    align_ud;       //alignment of the message parts, 0 when packed
+    uint32_t                    crc_ud;         //crc32 of the header before crc_ud and the used bytes after the header
+} blk_head_t;
+
+typedef struct msg_head_s {
+    hl_blocks_msg_seq_t         seq_ud;         //1,2,3, ... rollover to 1 when necessary
+    uint32_t                    tot_size_ud;    //total bytes spanning all parts
+    uint16_t                    part_ud;        //0,1,2, ... within this message
+    uint16_t                    tag_ud;         //0..HL_BLOCKS_MAX_TAGS-1 given by the writer, 0 when none
+    uint32_t                    part_size_ud;   //bytes in this part (after the message header)
+} msg_head_t;
+
+//blk_head_t.flags_ud
+#define HL_BLOCKS_BLK_FLAG_TAG_MAP      0x01    //tag map at the end of the block
+#define HL_BLOCKS_BLK_FLAG_CRC          0x02    //crc_ud is set, else 0 in blocks written before it
+
+#define HL_BLOCKS_TAG_MAP_SIZE          8
+#define HL_BLOCKS_MAX_PARTS             0xFFFF  //parts of one message, limited by part_ud
+
+//size of a part incl padding to the alignment in the block header
+#define HL_BLOCKS_ALIGN_UP(p_size_ud, p_align_ud)      \
+    (((p_align_ud) > 1) ? (((p_size_ud) + (p_align_ud) - 1) & ~((uint32_t)(p_align_ud) - 1)) : (p_size_ud))
+
+//bytes from a message header to the next one in a block
+#define HL_BLOCKS_PART_STEP(p_align_ud, p_part_size_ud) \
+    ((uint32_t)sizeof (msg_head_t) + HL_BLOCKS_ALIGN_UP (p_part_size_ud, p_align_ud))
+
+/*
+ * With hl_blocks_options_t.checkpoint_ud the first HL_BLOCKS_CHECKPOINT_BLOCKS
+ * blocks are not part of the ring and hold the checkpoint, written to each
+ * in turn. Open uses the valid one with the highest generation.
+ * zero_ud is always 0, so tools that do not know the checkpoint see
+ * an empty block.
+ */
+#define HL_BLOCKS_CHECKPOINT_BLOCKS     2
+#define HL_BLOCKS_CHECKPOINT_MAGIC      0x484C4350      //"HLCP"
+
+typedef struct checkpoint_s {
+    uint32_t                    zero_ud;        //where blk_head_t.seq_ud is
+    uint32_t                    magic_ud;       //HL_BLOCKS_CHECKPOINT_MAGIC
+    uint32_t                    generation_ud;  //1,2,3, ... incr on each write
+    uint32_t                    block_size_ud;
+    uint32_t                    nr_blocks_ud;   //ring blocks after the checkpoint blocks
+    uint32_t                    nr_prios_ud;
+    blk_seq_t                   last_blk_seq_ud;
+    uint32_t                    wr_idx_ud;      //head: next ring block to write
+    uint32_t                    rd_idx_ud;      //tail: oldest ring block not yet read
+    hl_blocks_msg_seq_t         last_msg_seq_ud;
+    uint32_t                    lane_rd_idx_aud[HL_BLOCKS_MAX_PRIOS];
+    uint32_t                    lane_rd_ofs_aud[HL_BLOCKS_MAX_PRIOS];
+    uint32_t                    crc_ud;         //crc32 of all fields before
+} checkpoint_t;
+
+#endif /*_HL_BLOCKS_FORMAT_H_*/
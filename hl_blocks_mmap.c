@@ -0,0 +1,323 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#ifdef __linux__
+#define _GNU_SOURCE     //sync_file_range()
+#endif
+
+#define LOG_MODULE  "hl_blocks_mmap"
+
+#include "error_stack.h"
+#include "hl_blocks_mmap.h"
+#include "log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+
+// nr of bytes to ask the kernel to read ahead when reading
+// a block outside of the previous read ahead window
+#define M_READ_AHEAD_SIZE           (256 * 1024)
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+static int                  m_d_fd_d                = -1;
+static unsigned char*       m_d_map_auc             = NULL;
+static size_t               m_d_map_size_ud         = 0;
+static size_t               m_d_page_size_ud        = 0;
+static uint32_t             m_d_block_size_ud       = 0;
+static uint32_t             m_d_nr_blocks_ud        = 0;
+static uint32_t             m_d_batch_blocks_ud     = 0;
+
+//consecutive blocks written, not yet handed to the kernel for write-back
+static uint32_t             m_d_pend_idx_ud         = 0;
+static uint32_t             m_d_pend_count_ud       = 0;
+
+//range of blocks written since the last flush, not yet known to be on disk
+static uint32_t             m_d_dirty_min_ud        = 0;
+static uint32_t             m_d_dirty_max_ud        = 0;
+static uint32_t             m_d_dirty_ud            = 0;
+
+//blocks [start..end) last advised to read ahead
+static uint32_t             m_d_ahead_start_ud      = 0;
+static uint32_t             m_d_ahead_end_ud        = 0;
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static int m_r_write_back (
+    const uint32_t                    p_idx_ud,
+    const uint32_t                    p_count_ud,
+    const int                         p_wait_d);
+
+static int m_r_written (
+    const uint32_t                    p_idx_ud);
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+extern int hl_blocks_mmap_r_open (
+    const char*                       p_path_pc,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const uint32_t                    p_batch_blocks_ud)
+{
+    if (  (p_path_pc == NULL)
+       || (p_block_size_ud == 0)
+       || (p_nr_blocks_ud == 0))
+        return ERROR (-1, "invalid params for hl_blocks_mmap_r_open(%s,%u,%u)",
+            (p_path_pc == NULL ? "NULL" : p_path_pc),
+            p_block_size_ud,
+            p_nr_blocks_ud);
+    if (m_d_map_auc != NULL)
+        return ERROR (-1, "hl_blocks_mmap already open, only one file allowed");
+
+    int l_fd_d = open (p_path_pc, O_RDWR | O_CREAT, 0644);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to open %s: %s", p_path_pc, strerror (errno));
+
+    //preallocate so writing to the mapping never fails for lack of disk space
+    size_t l_size_ud = (size_t)p_block_size_ud * p_nr_blocks_ud;
+    struct stat l_stat_z;
+    if (fstat (l_fd_d, &l_stat_z) != 0) {
+        close (l_fd_d);
+        return ERROR (-1, "failed to stat %s: %s", p_path_pc, strerror (errno));
+    }
+    if ((size_t)l_stat_z.st_size < l_size_ud) {
+        int l_result_d = posix_fallocate (l_fd_d, 0, (off_t)l_size_ud);
+        if (  (l_result_d != 0)
+           && (ftruncate (l_fd_d, (off_t)l_size_ud) != 0)) {
+            close (l_fd_d);
+            return ERROR (-1, "failed to allocate %zu bytes in %s: %s",
+                l_size_ud,
+                p_path_pc,
+                strerror (l_result_d));
+        }
+    }/*if too small*/
+
+    void* l_map_p = mmap (NULL, l_size_ud, PROT_READ | PROT_WRITE, MAP_SHARED, l_fd_d, 0);
+    if (l_map_p == MAP_FAILED) {
+        close (l_fd_d);
+        return ERROR (-1, "failed to map %zu bytes of %s: %s",
+            l_size_ud,
+            p_path_pc,
+            strerror (errno));
+    }
+
+    //blocks are read in order, so the kernel can read ahead aggressively
+    //and drop pages behind the reader
+    (void)madvise (l_map_p, l_size_ud, MADV_SEQUENTIAL);
+
+    m_d_fd_d            = l_fd_d;
+    m_d_map_auc         = (unsigned char*)l_map_p;
+    m_d_map_size_ud     = l_size_ud;
+    m_d_page_size_ud    = (size_t)sysconf (_SC_PAGESIZE);
+    m_d_block_size_ud   = p_block_size_ud;
+    m_d_nr_blocks_ud    = p_nr_blocks_ud;
+    m_d_batch_blocks_ud = p_batch_blocks_ud;
+    m_d_pend_count_ud   = 0;
+    m_d_dirty_ud        = 0;
+    m_d_ahead_start_ud  = 0;
+    m_d_ahead_end_ud    = 0;
+
+    DEBUG ("Mapped %s with %u blocks x %u bytes, batch=%u",
+        p_path_pc,
+        p_nr_blocks_ud,
+        p_block_size_ud,
+        p_batch_blocks_ud);
+    return SUCCESS ();
+}/*hl_blocks_mmap_r_open()*/
+
+
+extern int hl_blocks_mmap_r_close (void)
+{
+    if (m_d_map_auc == NULL)
+        return SUCCESS ();
+
+    int l_result_d = hl_blocks_mmap_r_flush ();
+    munmap (m_d_map_auc, m_d_map_size_ud);
+    close (m_d_fd_d);
+    m_d_map_auc         = NULL;
+    m_d_fd_d            = -1;
+    m_d_nr_blocks_ud    = 0;
+    if (l_result_d != 0)
+        return ERROR (l_result_d, "failed to flush before close");
+    return SUCCESS ();
+}/*hl_blocks_mmap_r_close()*/
+
+
+extern int hl_blocks_mmap_r_flush (void)
+{
+    if (m_d_map_auc == NULL)
+        return ERROR (-1, "hl_blocks_mmap not open");
+
+    m_d_pend_count_ud = 0;
+    if (m_d_dirty_ud == 0)
+        return SUCCESS ();
+
+    if (m_r_write_back (m_d_dirty_min_ud, m_d_dirty_max_ud - m_d_dirty_min_ud + 1, 1) != 0)
+        return ERROR (-1, "failed to flush blk[%u..%u]", m_d_dirty_min_ud, m_d_dirty_max_ud);
+
+    m_d_dirty_ud = 0;
+    return SUCCESS ();
+}/*hl_blocks_mmap_r_flush()*/
+
+
+extern int hl_blocks_mmap_r_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    //the block may already be in place when hl_blocks changed it through
+    //the address from hl_blocks_mmap_r_addr()
+    unsigned char* l_blk_puc = m_d_map_auc + (size_t)m_d_block_size_ud * p_idx_ud;
+    if (l_blk_puc != (const unsigned char*)p_block_p)
+        memcpy (l_blk_puc, p_block_p, m_d_block_size_ud);
+    return m_r_written (p_idx_ud);
+}/*hl_blocks_mmap_r_write()*/
+
+
+extern int hl_blocks_mmap_r_writev (
+    const uint32_t                    p_idx_ud,
+    const struct iovec*               p_iov_az,
+    const int                         p_nr_iov_d)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    //the rest of the block is left as is
+    unsigned char* l_blk_puc = m_d_map_auc + (size_t)m_d_block_size_ud * p_idx_ud;
+    size_t l_ofs_ud = 0;
+    for (int l_nr_d = 0; l_nr_d < p_nr_iov_d; l_nr_d++) {
+        if (l_ofs_ud + p_iov_az[l_nr_d].iov_len > m_d_block_size_ud)
+            return ERROR (-1, "writev of more than block size %u into blk[%u]", m_d_block_size_ud, p_idx_ud);
+        memcpy (l_blk_puc + l_ofs_ud, p_iov_az[l_nr_d].iov_base, p_iov_az[l_nr_d].iov_len);
+        l_ofs_ud += p_iov_az[l_nr_d].iov_len;
+    }
+    return m_r_written (p_idx_ud);
+}/*hl_blocks_mmap_r_writev()*/
+
+
+extern int hl_blocks_mmap_r_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    *p_block_pp = m_d_map_auc + (size_t)m_d_block_size_ud * p_idx_ud;
+
+    //hl_blocks asks for the same block for every message part,
+    //so only advise the kernel when moving out of the last window
+    if (  (p_idx_ud < m_d_ahead_start_ud)
+       || (p_idx_ud >= m_d_ahead_end_ud)) {
+        uint32_t l_nr_ud = (uint32_t)(M_READ_AHEAD_SIZE / m_d_block_size_ud);
+        if (l_nr_ud == 0)
+            l_nr_ud = 1;
+        l_nr_ud = MIN (l_nr_ud, m_d_nr_blocks_ud - p_idx_ud);
+
+        size_t l_ofs_ud = (size_t)m_d_block_size_ud * p_idx_ud;
+        size_t l_start_ud = l_ofs_ud - (l_ofs_ud % m_d_page_size_ud);
+        size_t l_end_ud = l_ofs_ud + (size_t)m_d_block_size_ud * l_nr_ud;
+        (void)madvise (m_d_map_auc + l_start_ud, l_end_ud - l_start_ud, MADV_WILLNEED);
+
+        m_d_ahead_start_ud = p_idx_ud;
+        m_d_ahead_end_ud   = p_idx_ud + l_nr_ud;
+    }/*if outside read ahead window*/
+    return SUCCESS ();
+}/*hl_blocks_mmap_r_addr()*/
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+//write back a range of blocks to disk,
+//either only starting it (p_wait_d=0) or waiting until done
+static int m_r_write_back (
+    const uint32_t                    p_idx_ud,
+    const uint32_t                    p_count_ud,
+    const int                         p_wait_d)
+{
+    size_t l_ofs_ud = (size_t)m_d_block_size_ud * p_idx_ud;
+    size_t l_start_ud = l_ofs_ud - (l_ofs_ud % m_d_page_size_ud);
+    size_t l_end_ud = l_ofs_ud + (size_t)m_d_block_size_ud * p_count_ud;
+
+#ifdef __linux__
+    if (!p_wait_d) {
+        //start write-back without waiting and without syncing metadata
+        if (sync_file_range (m_d_fd_d, (off_t)l_start_ud, (off_t)(l_end_ud - l_start_ud), SYNC_FILE_RANGE_WRITE) != 0)
+            return ERROR (-1, "sync_file_range(%zu,%zu) failed: %s",
+                l_start_ud,
+                l_end_ud - l_start_ud,
+                strerror (errno));
+        return SUCCESS ();
+    }
+#endif
+
+    if (msync (m_d_map_auc + l_start_ud, l_end_ud - l_start_ud, p_wait_d ? MS_SYNC : MS_ASYNC) != 0)
+        return ERROR (-1, "msync(%zu,%zu) failed: %s",
+            l_start_ud,
+            l_end_ud - l_start_ud,
+            strerror (errno));
+    return SUCCESS ();
+}/*m_r_write_back()*/
+
+
+//note a written block as dirty and start write-back of full batches
+static int m_r_written (
+    const uint32_t                    p_idx_ud)
+{
+    if (m_d_dirty_ud == 0) {
+        m_d_dirty_min_ud = p_idx_ud;
+        m_d_dirty_max_ud = p_idx_ud;
+        m_d_dirty_ud     = 1;
+    } else {
+        m_d_dirty_min_ud = MIN (m_d_dirty_min_ud, p_idx_ud);
+        if (p_idx_ud > m_d_dirty_max_ud)
+            m_d_dirty_max_ud = p_idx_ud;
+    }
+
+    if (m_d_batch_blocks_ud == 0)
+        return SUCCESS ();
+
+    //collect consecutive blocks, then start write-back of the whole run
+    if (  (m_d_pend_count_ud > 0)
+       && (p_idx_ud != m_d_pend_idx_ud + m_d_pend_count_ud)) {
+        if (  (p_idx_ud >= m_d_pend_idx_ud)
+           && (p_idx_ud < m_d_pend_idx_ud + m_d_pend_count_ud))
+            return SUCCESS ();  //already pending, e.g. block marked as read
+
+        if (m_r_write_back (m_d_pend_idx_ud, m_d_pend_count_ud, 0) != 0)
+            return ERROR (-1, "failed to write back blk[%u]+%u", m_d_pend_idx_ud, m_d_pend_count_ud);
+        m_d_pend_count_ud = 0;
+    }
+    if (m_d_pend_count_ud == 0)
+        m_d_pend_idx_ud = p_idx_ud;
+    m_d_pend_count_ud ++;
+
+    if (m_d_pend_count_ud >= m_d_batch_blocks_ud) {
+        if (m_r_write_back (m_d_pend_idx_ud, m_d_pend_count_ud, 0) != 0)
+            return ERROR (-1, "failed to write back blk[%u]+%u", m_d_pend_idx_ud, m_d_pend_count_ud);
+        m_d_pend_count_ud = 0;
+    }
+    return SUCCESS ();
+}/*m_r_written()*/
@@ -0,0 +1,79 @@
+#ifndef _HL_BLOCKS_MMAP_H_
+#define _HL_BLOCKS_MMAP_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+/*
+ * PURPOSE:
+ *     Block backend for hl_blocks on a memory mapped file, to use
+ *     hl_blocks as a persistent on-disk queue on Linux/POSIX.
+ *
+ *     The file is created and preallocated to hold all blocks and
+ *     mapped into memory. hl_blocks_mmap_r_addr() returns addresses
+ *     inside the mapping, so reads do not copy, and
+ *     hl_blocks_mmap_r_write() copies the block in place.
+ *     Written blocks are handed to the kernel for write-back in batches
+ *     of consecutive blocks, and hl_blocks_mmap_r_flush() waits until
+ *     all written blocks are on disk.
+ *
+ *     Only one file can be open at a time, because the hl_blocks
+ *     backend functions has no context.
+ *
+ *     Usage:
+ *         hl_blocks_mmap_r_open ("/var/queue.blk", 4096, 1024, 16);
+ *         hl_blocks_r_open (4096, 1024, ..., hl_blocks_mmap_r_write, hl_blocks_mmap_r_addr, &blocks);
+ *         ...
+ *         hl_blocks_r_close (&blocks);
+ *         hl_blocks_mmap_r_close ();
+ *
+ * PARAMETERS:
+ *     p_path_pc                File to create or open
+ *     p_block_size_ud          Size of each block
+ *     p_nr_blocks_ud           Number of blocks
+ *     p_batch_blocks_ud        Start write-back after this nr of consecutive
+ *                              written blocks, 0 to only write back on
+ *                              hl_blocks_mmap_r_flush() or close
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_mmap_r_open (
+    const char*                       p_path_pc,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const uint32_t                    p_batch_blocks_ud);
+
+// flush all written blocks to disk then unmap and close the file
+extern int hl_blocks_mmap_r_close (void);
+
+// wait until all blocks written so far are on disk
+extern int hl_blocks_mmap_r_flush (void);
+
+// hl_blocks_write_r for hl_blocks_r_open()
+extern int hl_blocks_mmap_r_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p);
+
+// hl_blocks_writev_r for hl_blocks_r_set_writev(), copies the pieces into the mapping
+extern int hl_blocks_mmap_r_writev (
+    const uint32_t                    p_idx_ud,
+    const struct iovec*               p_iov_az,
+    const int                         p_nr_iov_d);
+
+// hl_blocks_addr_r for hl_blocks_r_open()
+extern int hl_blocks_mmap_r_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp);
+
+#endif /*_HL_BLOCKS_MMAP_H_*/
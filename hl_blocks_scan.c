@@ -0,0 +1,451 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#define LOG_MODULE  "hl_blocks_scan"
+
+#include "crc32.h"
+#include "error_stack.h"
+#include "hl_blocks_format.h"
+#include "hl_blocks_scan.h"
+#include "log.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+//range of blocks scanned by one thread
+typedef struct m_worker_s {
+    pthread_t                   thread_z;
+    int                         started_d;
+    const unsigned char*        image_puc;
+    uint32_t                    block_size_ud;
+    uint32_t                    first_idx_ud;
+    uint32_t                    nr_blocks_ud;
+    hl_blocks_scan_block_t*     blocks_az;      //NULL when caller not interested
+    hl_blocks_scan_t            scan_z;         //summary of this range
+} m_worker_t;
+
+//block to export in seq order
+typedef struct m_export_blk_s {
+    uint32_t                    seq_ud;
+    uint32_t                    idx_ud;
+} m_export_blk_t;
+
+//message being joined from parts in several blocks
+typedef struct m_join_s {
+    unsigned char*              data_auc;
+    uint32_t                    alloc_size_ud;
+    hl_blocks_msg_seq_t         seq_ud;
+    uint32_t                    tot_size_ud;
+    uint32_t                    got_size_ud;
+    uint32_t                    next_part_ud;   //0 when no message in progress
+} m_join_t;
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static void m_r_scan_init (
+          hl_blocks_scan_t*           p_scan_pz,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud);
+
+static void* m_r_scan_range (
+          void*                       p_worker_p);
+
+static void m_r_scan_add (
+          hl_blocks_scan_t*           p_scan_pz,
+    const uint32_t                    p_idx_ud,
+    const hl_blocks_scan_block_t*     p_info_pz);
+
+static void m_r_scan_merge (
+          hl_blocks_scan_t*           p_scan_pz,
+    const hl_blocks_scan_t*           p_part_pz);
+
+static int m_r_export_blk_cmp (
+    const void*                       p_a_p,
+    const void*                       p_b_p);
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+extern void hl_blocks_scan_r_block (
+    const void*                       p_block_p,
+    const uint32_t                    p_block_size_ud,
+          hl_blocks_scan_block_t*     p_info_pz)
+{
+    memset (p_info_pz, 0, sizeof (hl_blocks_scan_block_t));
+    if (p_block_size_ud < sizeof (blk_head_t)) {
+        p_info_pz->errors_ud = HL_BLOCKS_SCAN_K_BAD_USED_SIZE;
+        return;
+    }
+
+    blk_head_t                  l_blk_head_z;
+    memcpy (&l_blk_head_z, p_block_p, sizeof (blk_head_t));
+    p_info_pz->seq_ud       = l_blk_head_z.seq_ud;
+    p_info_pz->used_size_ud = l_blk_head_z.used_size_ud;
+    p_info_pz->prio_ud      = l_blk_head_z.prio_ud;
+    if (  (l_blk_head_z.seq_ud == HL_BLOCKS_ERASED_WORD)
+       && (l_blk_head_z.used_size_ud == HL_BLOCKS_ERASED_WORD)) {
+        memset (p_info_pz, 0, sizeof (hl_blocks_scan_block_t));
+        return;     //erased, same as empty
+    }
+    if (l_blk_head_z.seq_ud == 0)
+        return;     //empty
+    if (l_blk_head_z.prio_ud >= HL_BLOCKS_MAX_PRIOS)
+        p_info_pz->errors_ud |= HL_BLOCKS_SCAN_K_BAD_PRIO;
+    if (  (l_blk_head_z.align_ud != 0)
+       && (l_blk_head_z.align_ud != 4)
+       && (l_blk_head_z.align_ud != 8)
+       && (l_blk_head_z.align_ud != 16)) {
+        p_info_pz->errors_ud |= HL_BLOCKS_SCAN_K_BAD_ALIGN;
+        return;
+    }
+    //the tag map, if any, is in the last bytes of the block
+    uint32_t l_map_size_ud = (l_blk_head_z.flags_ud & HL_BLOCKS_BLK_FLAG_TAG_MAP) ? HL_BLOCKS_TAG_MAP_SIZE : 0;
+    if (l_blk_head_z.used_size_ud > p_block_size_ud - sizeof (blk_head_t) - l_map_size_ud) {
+        p_info_pz->errors_ud |= HL_BLOCKS_SCAN_K_BAD_USED_SIZE;
+        return;
+    }
+    //blocks written before the crc have crc_ud 0 without the flag
+    uint32_t l_crc_ud = 0;
+    if (l_blk_head_z.flags_ud & HL_BLOCKS_BLK_FLAG_CRC) {
+        l_crc_ud = crc32_r_update (0, p_block_p, offsetof (blk_head_t, crc_ud));
+        l_crc_ud = crc32_r_update (l_crc_ud, (const unsigned char*)p_block_p + sizeof (blk_head_t), l_blk_head_z.used_size_ud);
+        l_crc_ud = crc32_r_update (l_crc_ud, (const unsigned char*)p_block_p + p_block_size_ud - l_map_size_ud, l_map_size_ud);
+    }
+    if (l_crc_ud != l_blk_head_z.crc_ud)
+        p_info_pz->errors_ud |= HL_BLOCKS_SCAN_K_BAD_CRC;
+
+    //walk the message parts
+    const unsigned char* l_data_puc = (const unsigned char*)p_block_p + sizeof (blk_head_t);
+    uint32_t l_ofs_ud = 0;
+    while (l_ofs_ud < l_blk_head_z.used_size_ud) {
+        if (l_blk_head_z.used_size_ud - l_ofs_ud < sizeof (msg_head_t)) {
+            p_info_pz->errors_ud |= HL_BLOCKS_SCAN_K_BAD_MSG_HEAD;
+            break;
+        }
+        msg_head_t              l_msg_head_z;
+        memcpy (&l_msg_head_z, l_data_puc + l_ofs_ud, sizeof (msg_head_t));
+        l_ofs_ud += sizeof (msg_head_t);
+        if (HL_BLOCKS_ALIGN_UP (l_msg_head_z.part_size_ud, l_blk_head_z.align_ud) > l_blk_head_z.used_size_ud - l_ofs_ud) {
+            p_info_pz->errors_ud |= HL_BLOCKS_SCAN_K_BAD_MSG_HEAD;
+            break;
+        }
+
+        if (l_msg_head_z.part_ud == 0) {
+            if (l_msg_head_z.part_size_ud > l_msg_head_z.tot_size_ud)
+                p_info_pz->errors_ud |= HL_BLOCKS_SCAN_K_BAD_MSG_SIZE;
+            p_info_pz->nr_msgs_ud ++;
+            p_info_pz->incomplete_ud = (l_msg_head_z.part_size_ud < l_msg_head_z.tot_size_ud);
+        } else {
+            //only the first part in a block can continue a message
+            if (p_info_pz->nr_parts_ud > 0)
+                p_info_pz->errors_ud |= HL_BLOCKS_SCAN_K_BAD_MSG_SEQ;
+            p_info_pz->continued_ud  = 1;
+            p_info_pz->incomplete_ud = 0;
+        }
+
+        if (p_info_pz->nr_parts_ud == 0)
+            p_info_pz->first_msg_seq_ud = l_msg_head_z.seq_ud;
+        else if (l_msg_head_z.seq_ud != p_info_pz->last_msg_seq_ud + 1)
+            p_info_pz->errors_ud |= HL_BLOCKS_SCAN_K_BAD_MSG_SEQ;
+        p_info_pz->last_msg_seq_ud = l_msg_head_z.seq_ud;
+        p_info_pz->nr_parts_ud ++;
+        l_ofs_ud += HL_BLOCKS_ALIGN_UP (l_msg_head_z.part_size_ud, l_blk_head_z.align_ud);
+    }/*while more parts*/
+    return;
+}/*hl_blocks_scan_r_block()*/
+
+
+extern int hl_blocks_scan_r_image (
+    const void*                       p_image_p,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const uint32_t                    p_nr_threads_ud,
+          hl_blocks_scan_block_t*     p_blocks_az,
+          hl_blocks_scan_t*           p_scan_pz)
+{
+    if (  (p_image_p == NULL)
+       || (p_block_size_ud <= sizeof (blk_head_t))
+       || (p_nr_blocks_ud == 0)
+       || (p_scan_pz == NULL))
+        return ERROR (-1, "invalid params for hl_blocks_scan_r_image(%p,%u,%u)",
+            p_image_p,
+            p_block_size_ud,
+            p_nr_blocks_ud);
+
+    uint32_t l_nr_workers_ud = (p_nr_threads_ud > 1) ? p_nr_threads_ud : 1;
+    if (l_nr_workers_ud > p_nr_blocks_ud)
+        l_nr_workers_ud = p_nr_blocks_ud;
+    m_worker_t* l_worker_az = (m_worker_t*)calloc (l_nr_workers_ud, sizeof (m_worker_t));
+    if (l_worker_az == NULL)
+        return ERROR (-1, "out of memory for %u workers", l_nr_workers_ud);
+
+    //each thread scans a range of consecutive blocks
+    uint32_t l_per_worker_ud = p_nr_blocks_ud / l_nr_workers_ud;
+    uint32_t l_first_idx_ud = 0;
+    for (uint32_t l_nr_ud = 0; l_nr_ud < l_nr_workers_ud; l_nr_ud++) {
+        m_worker_t* l_worker_pz = &l_worker_az[l_nr_ud];
+        l_worker_pz->image_puc      = (const unsigned char*)p_image_p;
+        l_worker_pz->block_size_ud  = p_block_size_ud;
+        l_worker_pz->first_idx_ud   = l_first_idx_ud;
+        l_worker_pz->nr_blocks_ud   = (l_nr_ud == l_nr_workers_ud - 1)
+                                    ? (p_nr_blocks_ud - l_first_idx_ud)
+                                    : l_per_worker_ud;
+        l_worker_pz->blocks_az      = p_blocks_az;
+        l_first_idx_ud += l_worker_pz->nr_blocks_ud;
+
+        //the last range is done in this thread, and any that could not start
+        if (l_nr_ud < l_nr_workers_ud - 1)
+            l_worker_pz->started_d = (pthread_create (&l_worker_pz->thread_z, NULL, m_r_scan_range, l_worker_pz) == 0);
+    }
+
+    m_r_scan_init (p_scan_pz, p_block_size_ud, p_nr_blocks_ud);
+    for (uint32_t l_nr_ud = 0; l_nr_ud < l_nr_workers_ud; l_nr_ud++) {
+        m_worker_t* l_worker_pz = &l_worker_az[l_nr_ud];
+        if (l_worker_pz->started_d)
+            pthread_join (l_worker_pz->thread_z, NULL);
+        else
+            m_r_scan_range (l_worker_pz);
+        m_r_scan_merge (p_scan_pz, &l_worker_pz->scan_z);
+    }
+    free (l_worker_az);
+    return SUCCESS ();
+}/*hl_blocks_scan_r_image()*/
+
+
+extern int hl_blocks_scan_r_export (
+    const void*                       p_image_p,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const hl_blocks_scan_block_t*     p_blocks_az,
+          hl_blocks_scan_msg_r*       p_msg_pr,
+          void*                       p_ctx_p,
+          uint64_t*                   p_nr_msgs_pud)
+{
+    if (  (p_image_p == NULL)
+       || (p_blocks_az == NULL)
+       || (p_msg_pr == NULL)
+       || (p_block_size_ud <= sizeof (blk_head_t)))
+        return ERROR (-1, "invalid params for hl_blocks_scan_r_export()");
+    if (p_nr_msgs_pud != NULL)
+        *p_nr_msgs_pud = 0;
+
+    //valid blocks from oldest to newest
+    m_export_blk_t* l_blk_az = (m_export_blk_t*)malloc ((size_t)p_nr_blocks_ud * sizeof (m_export_blk_t));
+    if (l_blk_az == NULL)
+        return ERROR (-1, "out of memory for %u blocks", p_nr_blocks_ud);
+    uint32_t l_nr_blks_ud = 0;
+    for (uint32_t l_idx_ud = 0; l_idx_ud < p_nr_blocks_ud; l_idx_ud++) {
+        if (  (p_blocks_az[l_idx_ud].seq_ud != 0)
+           && (p_blocks_az[l_idx_ud].errors_ud == 0)) {
+            l_blk_az[l_nr_blks_ud].seq_ud = p_blocks_az[l_idx_ud].seq_ud;
+            l_blk_az[l_nr_blks_ud].idx_ud = l_idx_ud;
+            l_nr_blks_ud ++;
+        }
+    }
+    qsort (l_blk_az, l_nr_blks_ud, sizeof (m_export_blk_t), m_r_export_blk_cmp);
+
+    m_join_t                    l_join_az[HL_BLOCKS_MAX_PRIOS];
+    memset (l_join_az, 0, sizeof (l_join_az));
+    int l_result_d = 0;
+    uint64_t l_nr_msgs_ud = 0;
+    for (uint32_t l_nr_ud = 0; (l_nr_ud < l_nr_blks_ud) && (l_result_d == 0); l_nr_ud++) {
+        const unsigned char* l_block_puc = (const unsigned char*)p_image_p
+                                         + (size_t)l_blk_az[l_nr_ud].idx_ud * p_block_size_ud;
+        const hl_blocks_scan_block_t* l_info_pz = &p_blocks_az[l_blk_az[l_nr_ud].idx_ud];
+        m_join_t* l_join_pz = &l_join_az[l_info_pz->prio_ud];
+        const unsigned char* l_data_puc = l_block_puc + sizeof (blk_head_t);
+        blk_head_t              l_blk_head_z;
+        memcpy (&l_blk_head_z, l_block_puc, sizeof (blk_head_t));
+        uint32_t l_ofs_ud = 0;
+        while ((l_ofs_ud < l_info_pz->used_size_ud) && (l_result_d == 0)) {
+            msg_head_t          l_msg_head_z;
+            memcpy (&l_msg_head_z, l_data_puc + l_ofs_ud, sizeof (msg_head_t));
+            const unsigned char* l_part_puc = l_data_puc + l_ofs_ud + sizeof (msg_head_t);
+            l_ofs_ud += HL_BLOCKS_PART_STEP (l_blk_head_z.align_ud, l_msg_head_z.part_size_ud);
+
+            if (l_msg_head_z.part_ud == 0) {
+                if (l_join_pz->next_part_ud != 0)
+                    DEBUG ("Skip msg seq=%u missing part %u", l_join_pz->seq_ud, l_join_pz->next_part_ud);
+                l_join_pz->next_part_ud = 0;
+
+                //complete in this block: no copy
+                if (l_msg_head_z.part_size_ud == l_msg_head_z.tot_size_ud) {
+                    l_result_d = (*p_msg_pr) (p_ctx_p, l_msg_head_z.seq_ud, l_info_pz->prio_ud, l_part_puc, l_msg_head_z.part_size_ud);
+                    l_nr_msgs_ud ++;
+                    continue;
+                }
+                if (l_msg_head_z.tot_size_ud > l_join_pz->alloc_size_ud) {
+                    unsigned char* l_new_auc = (unsigned char*)realloc (l_join_pz->data_auc, l_msg_head_z.tot_size_ud);
+                    if (l_new_auc == NULL) {
+                        l_result_d = ERROR (-1, "out of memory for msg seq=%u of %u bytes", l_msg_head_z.seq_ud, l_msg_head_z.tot_size_ud);
+                        break;
+                    }
+                    l_join_pz->data_auc      = l_new_auc;
+                    l_join_pz->alloc_size_ud = l_msg_head_z.tot_size_ud;
+                }
+                l_join_pz->seq_ud       = l_msg_head_z.seq_ud;
+                l_join_pz->tot_size_ud  = l_msg_head_z.tot_size_ud;
+                l_join_pz->got_size_ud  = 0;
+            } else if (  (l_join_pz->next_part_ud != l_msg_head_z.part_ud)
+                      || (l_join_pz->seq_ud != l_msg_head_z.seq_ud)
+                      || (l_join_pz->got_size_ud + l_msg_head_z.part_size_ud > l_join_pz->tot_size_ud)) {
+                //start of message not in the image, e.g. oldest block
+                l_join_pz->next_part_ud = 0;
+                continue;
+            }
+
+            memcpy (l_join_pz->data_auc + l_join_pz->got_size_ud, l_part_puc, l_msg_head_z.part_size_ud);
+            l_join_pz->got_size_ud += l_msg_head_z.part_size_ud;
+            l_join_pz->next_part_ud = l_msg_head_z.part_ud + 1;
+            if (l_join_pz->got_size_ud == l_join_pz->tot_size_ud) {
+                l_result_d = (*p_msg_pr) (p_ctx_p, l_join_pz->seq_ud, l_info_pz->prio_ud, l_join_pz->data_auc, l_join_pz->tot_size_ud);
+                l_nr_msgs_ud ++;
+                l_join_pz->next_part_ud = 0;
+            }
+        }/*for each part*/
+    }/*for each block*/
+
+    for (uint32_t l_prio_ud = 0; l_prio_ud < HL_BLOCKS_MAX_PRIOS; l_prio_ud++)
+        free (l_join_az[l_prio_ud].data_auc);
+    free (l_blk_az);
+    if (p_nr_msgs_pud != NULL)
+        *p_nr_msgs_pud = l_nr_msgs_ud;
+    if (l_result_d != 0)
+        return l_result_d;
+    return SUCCESS ();
+}/*hl_blocks_scan_r_export()*/
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+static void m_r_scan_init (
+          hl_blocks_scan_t*           p_scan_pz,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud)
+{
+    memset (p_scan_pz, 0, sizeof (hl_blocks_scan_t));
+    p_scan_pz->nr_blocks_ud  = p_nr_blocks_ud;
+    p_scan_pz->data_bytes_ud = (uint64_t)p_nr_blocks_ud * (p_block_size_ud - sizeof (blk_head_t));
+    p_scan_pz->head_idx_ud   = p_nr_blocks_ud;
+    p_scan_pz->tail_idx_ud   = p_nr_blocks_ud;
+}/*m_r_scan_init()*/
+
+
+//thread function: scan a range of blocks into the worker summary
+static void* m_r_scan_range (
+          void*                       p_worker_p)
+{
+    m_worker_t* l_worker_pz = (m_worker_t*)p_worker_p;
+    m_r_scan_init (&l_worker_pz->scan_z, l_worker_pz->block_size_ud, 0);
+
+    hl_blocks_scan_block_t      l_info_z;
+    for (uint32_t l_idx_ud = l_worker_pz->first_idx_ud;
+         l_idx_ud < l_worker_pz->first_idx_ud + l_worker_pz->nr_blocks_ud;
+         l_idx_ud++) {
+        hl_blocks_scan_block_t* l_info_pz = (l_worker_pz->blocks_az != NULL)
+                                          ? &l_worker_pz->blocks_az[l_idx_ud]
+                                          : &l_info_z;
+        hl_blocks_scan_r_block (
+            l_worker_pz->image_puc + (size_t)l_idx_ud * l_worker_pz->block_size_ud,
+            l_worker_pz->block_size_ud,
+            l_info_pz);
+        m_r_scan_add (&l_worker_pz->scan_z, l_idx_ud, l_info_pz);
+    }
+    return NULL;
+}/*m_r_scan_range()*/
+
+
+static void m_r_scan_add (
+          hl_blocks_scan_t*           p_scan_pz,
+    const uint32_t                    p_idx_ud,
+    const hl_blocks_scan_block_t*     p_info_pz)
+{
+    if (p_info_pz->seq_ud == 0) {
+        p_scan_pz->nr_empty_ud ++;
+        return;
+    }
+    p_scan_pz->nr_used_ud ++;
+    if ((p_scan_pz->head_seq_ud == 0) || (p_info_pz->seq_ud > p_scan_pz->head_seq_ud)) {
+        p_scan_pz->head_idx_ud = p_idx_ud;
+        p_scan_pz->head_seq_ud = p_info_pz->seq_ud;
+    }
+    if ((p_scan_pz->tail_seq_ud == 0) || (p_info_pz->seq_ud < p_scan_pz->tail_seq_ud)) {
+        p_scan_pz->tail_idx_ud = p_idx_ud;
+        p_scan_pz->tail_seq_ud = p_info_pz->seq_ud;
+    }
+    if (p_info_pz->errors_ud != 0) {
+        p_scan_pz->nr_corrupt_ud ++;
+        return;
+    }
+
+    p_scan_pz->used_bytes_ud += p_info_pz->used_size_ud;
+    p_scan_pz->nr_msgs_ud    += p_info_pz->nr_msgs_ud;
+    p_scan_pz->prio_blocks_aud[p_info_pz->prio_ud] ++;
+    if (p_info_pz->nr_parts_ud > 0) {
+        if ((p_scan_pz->first_msg_seq_ud == 0) || (p_info_pz->first_msg_seq_ud < p_scan_pz->first_msg_seq_ud))
+            p_scan_pz->first_msg_seq_ud = p_info_pz->first_msg_seq_ud;
+        if (p_info_pz->last_msg_seq_ud > p_scan_pz->last_msg_seq_ud)
+            p_scan_pz->last_msg_seq_ud = p_info_pz->last_msg_seq_ud;
+    }
+}/*m_r_scan_add()*/
+
+
+static void m_r_scan_merge (
+          hl_blocks_scan_t*           p_scan_pz,
+    const hl_blocks_scan_t*           p_part_pz)
+{
+    p_scan_pz->nr_used_ud    += p_part_pz->nr_used_ud;
+    p_scan_pz->nr_empty_ud   += p_part_pz->nr_empty_ud;
+    p_scan_pz->nr_corrupt_ud += p_part_pz->nr_corrupt_ud;
+    p_scan_pz->used_bytes_ud += p_part_pz->used_bytes_ud;
+    p_scan_pz->nr_msgs_ud    += p_part_pz->nr_msgs_ud;
+    for (uint32_t l_prio_ud = 0; l_prio_ud < HL_BLOCKS_MAX_PRIOS; l_prio_ud++)
+        p_scan_pz->prio_blocks_aud[l_prio_ud] += p_part_pz->prio_blocks_aud[l_prio_ud];
+
+    if (  (p_part_pz->head_seq_ud != 0)
+       && ((p_scan_pz->head_seq_ud == 0) || (p_part_pz->head_seq_ud > p_scan_pz->head_seq_ud))) {
+        p_scan_pz->head_idx_ud = p_part_pz->head_idx_ud;
+        p_scan_pz->head_seq_ud = p_part_pz->head_seq_ud;
+    }
+    if (  (p_part_pz->tail_seq_ud != 0)
+       && ((p_scan_pz->tail_seq_ud == 0) || (p_part_pz->tail_seq_ud < p_scan_pz->tail_seq_ud))) {
+        p_scan_pz->tail_idx_ud = p_part_pz->tail_idx_ud;
+        p_scan_pz->tail_seq_ud = p_part_pz->tail_seq_ud;
+    }
+    if (  (p_part_pz->first_msg_seq_ud != 0)
+       && ((p_scan_pz->first_msg_seq_ud == 0) || (p_part_pz->first_msg_seq_ud < p_scan_pz->first_msg_seq_ud)))
+        p_scan_pz->first_msg_seq_ud = p_part_pz->first_msg_seq_ud;
+    if (p_part_pz->last_msg_seq_ud > p_scan_pz->last_msg_seq_ud)
+        p_scan_pz->last_msg_seq_ud = p_part_pz->last_msg_seq_ud;
+}/*m_r_scan_merge()*/
+
+
+static int m_r_export_blk_cmp (
+    const void*                       p_a_p,
+    const void*                       p_b_p)
+{
+    const m_export_blk_t* l_a_pz = (const m_export_blk_t*)p_a_p;
+    const m_export_blk_t* l_b_pz = (const m_export_blk_t*)p_b_p;
+    if (l_a_pz->seq_ud < l_b_pz->seq_ud)
+        return -1;
+    if (l_a_pz->seq_ud > l_b_pz->seq_ud)
+        return 1;
+    return 0;
+}/*m_r_export_blk_cmp()*/
@@ -0,0 +1,140 @@
+#ifndef _HL_BLOCKS_SCAN_H_
+#define _HL_BLOCKS_SCAN_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "hl_blocks.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/*****************************************************************************
+ * P U B L I C   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+//problems found in a block, hl_blocks_scan_block_t.errors_ud
+#define HL_BLOCKS_SCAN_K_BAD_USED_SIZE      0x01    //used size larger than the block
+#define HL_BLOCKS_SCAN_K_BAD_PRIO           0x02    //prio not 0..HL_BLOCKS_MAX_PRIOS-1
+#define HL_BLOCKS_SCAN_K_BAD_MSG_HEAD       0x04    //message header or data outside used size
+#define HL_BLOCKS_SCAN_K_BAD_MSG_SEQ        0x08    //message seq not consecutive in the block
+#define HL_BLOCKS_SCAN_K_BAD_MSG_SIZE       0x10    //part larger than the message
+#define HL_BLOCKS_SCAN_K_BAD_CRC            0x20    //crc does not match, e.g. not completely written
+#define HL_BLOCKS_SCAN_K_BAD_ALIGN          0x40    //align not 0, 4, 8 or 16
+
+//what was found in one block of an image
+typedef struct hl_blocks_scan_block_s {
+    uint32_t                    seq_ud;         //block seq, 0 when empty
+    uint32_t                    used_size_ud;   //bytes used after the block header
+    uint32_t                    prio_ud;
+    uint32_t                    errors_ud;      //HL_BLOCKS_SCAN_K_BAD_... flags, 0 when valid
+    uint32_t                    nr_parts_ud;    //message parts in this block
+    uint32_t                    nr_msgs_ud;     //messages starting in this block
+    hl_blocks_msg_seq_t         first_msg_seq_ud;
+    hl_blocks_msg_seq_t         last_msg_seq_ud;
+    uint32_t                    continued_ud;   //1 when the first part continues a message from an earlier block
+    uint32_t                    incomplete_ud;  //1 when the last message continues in a later block
+} hl_blocks_scan_block_t;
+
+//summary of an image
+typedef struct hl_blocks_scan_s {
+    uint32_t                    nr_blocks_ud;
+    uint32_t                    nr_used_ud;     //blocks with data, incl corrupt
+    uint32_t                    nr_empty_ud;
+    uint32_t                    nr_corrupt_ud;
+    uint64_t                    used_bytes_ud;  //message bytes incl headers in used blocks
+    uint64_t                    data_bytes_ud;  //space for messages in all blocks
+    uint64_t                    nr_msgs_ud;     //messages starting in valid blocks
+    uint32_t                    head_idx_ud;    //newest block, nr_blocks_ud when none
+    uint32_t                    head_seq_ud;
+    uint32_t                    tail_idx_ud;    //oldest block, nr_blocks_ud when none
+    uint32_t                    tail_seq_ud;
+    hl_blocks_msg_seq_t         first_msg_seq_ud;//lowest message seq in valid blocks
+    hl_blocks_msg_seq_t         last_msg_seq_ud; //highest message seq in valid blocks
+    uint32_t                    prio_blocks_aud[HL_BLOCKS_MAX_PRIOS];
+} hl_blocks_scan_t;
+
+//called for each complete message by hl_blocks_scan_r_export()
+//return 0 to continue or != 0 to stop the export with that result
+typedef int (hl_blocks_scan_msg_r) (
+          void*                       p_ctx_p,
+    const hl_blocks_msg_seq_t         p_seq_ud,
+    const uint32_t                    p_prio_ud,
+    const void*                       p_data_p,
+    const uint32_t                    p_size_ud);
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+/*
+ * PURPOSE:
+ *     Validate the block and message headers of one block without
+ *     hl_blocks_r_open(), e.g. in a flash dump.
+ *
+ * PARAMETERS:
+ *     p_block_p                Block data
+ *     p_block_size_ud          Size of the block
+ *     p_info_pz                Set to what was found
+ */
+extern void hl_blocks_scan_r_block (
+    const void*                       p_block_p,
+    const uint32_t                    p_block_size_ud,
+          hl_blocks_scan_block_t*     p_info_pz);
+
+/*
+ * PURPOSE:
+ *     Scan all blocks of an image in memory, e.g. a memory mapped dump,
+ *     splitting the blocks over threads, and summarise the result:
+ *     oldest and newest blocks, fill and corruption.
+ *
+ * PARAMETERS:
+ *     p_image_p                All blocks consecutive in memory
+ *     p_block_size_ud          Size of each block
+ *     p_nr_blocks_ud           Number of blocks
+ *     p_nr_threads_ud          Threads to scan with, 0 or 1 to not start threads
+ *     p_blocks_az              NULL or array of p_nr_blocks_ud to get each block result
+ *     p_scan_pz                Set to the summary
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_scan_r_image (
+    const void*                       p_image_p,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const uint32_t                    p_nr_threads_ud,
+          hl_blocks_scan_block_t*     p_blocks_az,
+          hl_blocks_scan_t*           p_scan_pz);
+
+/*
+ * PURPOSE:
+ *     Call p_msg_pr for each complete message in the image, from the
+ *     oldest to the newest block, joining the parts of messages that
+ *     span blocks. Corrupt blocks and messages with missing parts are
+ *     skipped. Messages in one block are passed without copying.
+ *
+ * PARAMETERS:
+ *     p_image_p                All blocks consecutive in memory
+ *     p_block_size_ud          Size of each block
+ *     p_nr_blocks_ud           Number of blocks
+ *     p_blocks_az              Block results from hl_blocks_scan_r_image()
+ *     p_msg_pr                 Called for each message
+ *     p_ctx_p                  Passed to p_msg_pr
+ *     p_nr_msgs_pud            NULL or set to nr of messages exported
+ *
+ * RETURN:
+ *     SUCCESS or ERROR, or the result of p_msg_pr when it stopped
+ */
+extern int hl_blocks_scan_r_export (
+    const void*                       p_image_p,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const hl_blocks_scan_block_t*     p_blocks_az,
+          hl_blocks_scan_msg_r*       p_msg_pr,
+          void*                       p_ctx_p,
+          uint64_t*                   p_nr_msgs_pud);
+
+#endif /*_HL_BLOCKS_SCAN_H_*/
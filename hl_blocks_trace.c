@@ -0,0 +1,595 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#define LOG_MODULE  "hl_blocks_trace"
+
+#include "error_stack.h"
+#include "hl_blocks_trace.h"
+#include "log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/*****************************************************************************
+ *   L O C A L   D E F I N I T I O N S
+ *****************************************************************************/
+
+/*
+ * File format, all numbers little endian:
+ *     header   "HLBTRACE", u32 version, u32 block_size, u32 nr_blocks,
+ *              u32 max_msg_size, u32 min_data_per_part, u32 0
+ *     records  u8 op | M_REC_FAILED, varint ns since the previous record,
+ *              varint size when not sync
+ * A varint has 7 bits per byte, lowest first, with the top bit set when
+ * more bytes follow.
+ */
+#define M_MAGIC                 "HLBTRACE"
+#define M_VERSION               1
+#define M_HEADER_SIZE           32
+#define M_REC_OP_MASK           0x03
+#define M_REC_FAILED            0x80
+#define M_REC_MAX_SIZE          (1 + 10 + 5)
+#define M_BUF_SIZE              65536
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+struct hl_blocks_trace_s {
+    int                         fd_d;
+    int                         write_failed_d; //1 after a write to the file failed, stop recording
+    uint64_t                    start_ns_ud;
+    uint64_t                    last_ns_ud;     //time of the previous record
+    uint32_t                    buf_used_ud;
+    unsigned char               buf_auc[M_BUF_SIZE];
+};
+
+struct hl_blocks_trace_reader_s {
+    FILE*                       file_fp;
+    uint64_t                    last_ns_ud;
+};
+
+//latencies of one op type in replay
+typedef struct m_latencies_s {
+    uint32_t*                   ns_aud;
+    uint64_t                    nr_ud;
+    uint64_t                    alloc_ud;
+} m_latencies_t;
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+//backend of the running replay, to count the flash writes
+static hl_blocks_write_r*   m_d_replay_write_pr     = NULL;
+static uint64_t             m_d_replay_writes_ud    = 0;
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static void m_r_record (
+          hl_blocks_trace_t*          p_trace_pz,
+    const hl_blocks_trace_op_e        p_op_e,
+    const int                         p_result_d,
+    const uint64_t                    p_time_ns_ud,
+    const uint32_t                    p_size_ud);
+
+static int m_r_flush (
+          hl_blocks_trace_t*          p_trace_pz);
+
+static unsigned char* m_r_put_varint (
+          unsigned char*              p_out_puc,
+          uint64_t                    p_value_ud);
+
+static int m_r_get_varint (
+          FILE*                       p_file_fp,
+          uint64_t*                   p_value_pud);
+
+static void m_r_put_u32 (
+          unsigned char*              p_out_puc,
+    const uint32_t                    p_value_ud);
+
+static uint32_t m_r_get_u32 (
+    const unsigned char*              p_in_puc);
+
+static int m_r_replay_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p);
+
+static int m_r_latency_add (
+          m_latencies_t*              p_latencies_pz,
+    const uint64_t                    p_ns_ud);
+
+static void m_r_latency_stats (
+          m_latencies_t*              p_latencies_pz,
+          hl_blocks_trace_op_stats_t* p_stats_pz);
+
+static int m_r_cmp_u32 (
+    const void*                       p_a_p,
+    const void*                       p_b_p);
+
+static void m_r_wait_until (
+    const uint64_t                    p_time_ns_ud);
+
+static uint64_t m_r_now_ns (void);
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+extern int hl_blocks_trace_r_open (
+    const char*                       p_path_pc,
+    const hl_blocks_trace_config_t*   p_config_pz,
+          hl_blocks_trace_t**         p_trace_ppz)
+{
+    if (  (p_path_pc == NULL)
+       || (p_config_pz == NULL)
+       || (p_trace_ppz == NULL))
+        return ERROR (-1, "invalid params for hl_blocks_trace_r_open(%p,%p,%p)",
+            p_path_pc,
+            p_config_pz,
+            p_trace_ppz);
+
+    hl_blocks_trace_t* l_trace_pz = (hl_blocks_trace_t*)malloc (sizeof (hl_blocks_trace_t));
+    if (l_trace_pz == NULL)
+        return ERROR (-1, "failed to allocate trace");
+    l_trace_pz->fd_d = open (p_path_pc, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (l_trace_pz->fd_d < 0) {
+        int l_errno_d = errno;
+        free (l_trace_pz);
+        return ERROR (-1, "failed to create trace file %s: %s", p_path_pc, strerror (l_errno_d));
+    }
+    l_trace_pz->write_failed_d  = 0;
+    l_trace_pz->start_ns_ud     = m_r_now_ns ();
+    l_trace_pz->last_ns_ud      = 0;
+
+    unsigned char* l_hdr_puc = l_trace_pz->buf_auc;
+    memset (l_hdr_puc, 0, M_HEADER_SIZE);
+    memcpy (l_hdr_puc, M_MAGIC, 8);
+    m_r_put_u32 (l_hdr_puc + 8,  M_VERSION);
+    m_r_put_u32 (l_hdr_puc + 12, p_config_pz->block_size_ud);
+    m_r_put_u32 (l_hdr_puc + 16, p_config_pz->nr_blocks_ud);
+    m_r_put_u32 (l_hdr_puc + 20, p_config_pz->max_msg_size_ud);
+    m_r_put_u32 (l_hdr_puc + 24, p_config_pz->min_data_per_part_ud);
+    l_trace_pz->buf_used_ud = M_HEADER_SIZE;
+
+    *p_trace_ppz = l_trace_pz;
+    return SUCCESS ();
+}/*hl_blocks_trace_r_open()*/
+
+
+extern int hl_blocks_trace_r_close (
+          hl_blocks_trace_t**         p_trace_ppz)
+{
+    if (  (p_trace_ppz == NULL)
+       || (*p_trace_ppz == NULL))
+        return SUCCESS ();
+
+    hl_blocks_trace_t* l_trace_pz = *p_trace_ppz;
+    m_r_flush (l_trace_pz);
+    int l_failed_d = l_trace_pz->write_failed_d;
+    if (close (l_trace_pz->fd_d) != 0)
+        l_failed_d = 1;
+    free (l_trace_pz);
+    *p_trace_ppz = NULL;
+    if (l_failed_d)
+        return ERROR (-1, "failed to write all records to the trace file");
+    return SUCCESS ();
+}/*hl_blocks_trace_r_close()*/
+
+
+extern int hl_blocks_trace_r_write (
+          hl_blocks_trace_t*          p_trace_pz,
+          hl_blocks_t*                p_blocks_pz,
+    const void*                       p_data_p,
+    const size_t                      p_size_ud,
+          hl_blocks_msg_seq_t*        p_write_seq_pud)
+{
+    uint64_t l_time_ns_ud = m_r_now_ns ();
+    int l_result_d = hl_blocks_r_write (p_blocks_pz, p_data_p, p_size_ud, p_write_seq_pud);
+    m_r_record (p_trace_pz, HL_BLOCKS_TRACE_K_OP_WRITE, l_result_d, l_time_ns_ud, (uint32_t)p_size_ud);
+    return l_result_d;
+}/*hl_blocks_trace_r_write()*/
+
+
+extern int hl_blocks_trace_r_read (
+          hl_blocks_trace_t*          p_trace_pz,
+          hl_blocks_t*                p_blocks_pz,
+          void*                       p_buff_data_p,
+    const size_t                      p_buff_size_ud,
+          size_t*                     p_read_size_pud,
+          hl_blocks_msg_seq_t*        p_read_seq_pud)
+{
+    uint64_t l_time_ns_ud = m_r_now_ns ();
+    int l_result_d = hl_blocks_r_read (p_blocks_pz, p_buff_data_p, p_buff_size_ud, p_read_size_pud, p_read_seq_pud);
+    m_r_record (p_trace_pz, HL_BLOCKS_TRACE_K_OP_READ, l_result_d, l_time_ns_ud,
+        ((l_result_d == 0) && (p_read_size_pud != NULL)) ? (uint32_t)*p_read_size_pud : 0);
+    return l_result_d;
+}/*hl_blocks_trace_r_read()*/
+
+
+extern int hl_blocks_trace_r_sync (
+          hl_blocks_trace_t*          p_trace_pz,
+          hl_blocks_t*                p_blocks_pz)
+{
+    uint64_t l_time_ns_ud = m_r_now_ns ();
+    int l_result_d = hl_blocks_r_sync (p_blocks_pz);
+    m_r_record (p_trace_pz, HL_BLOCKS_TRACE_K_OP_SYNC, l_result_d, l_time_ns_ud, 0);
+    return l_result_d;
+}/*hl_blocks_trace_r_sync()*/
+
+
+extern int hl_blocks_trace_r_reader_open (
+    const char*                       p_path_pc,
+          hl_blocks_trace_config_t*   p_config_pz,
+          hl_blocks_trace_reader_t**  p_reader_ppz)
+{
+    FILE* l_file_fp = fopen (p_path_pc, "rb");
+    if (l_file_fp == NULL)
+        return ERROR (-1, "failed to open trace file %s: %s", p_path_pc, strerror (errno));
+
+    unsigned char l_hdr_auc[M_HEADER_SIZE];
+    if (  (fread (l_hdr_auc, 1, M_HEADER_SIZE, l_file_fp) != M_HEADER_SIZE)
+       || (memcmp (l_hdr_auc, M_MAGIC, 8) != 0)) {
+        fclose (l_file_fp);
+        return ERROR (-1, "%s is not a trace file", p_path_pc);
+    }
+    if (m_r_get_u32 (l_hdr_auc + 8) != M_VERSION) {
+        fclose (l_file_fp);
+        return ERROR (-1, "trace file %s version %u not supported", p_path_pc, m_r_get_u32 (l_hdr_auc + 8));
+    }
+    p_config_pz->block_size_ud          = m_r_get_u32 (l_hdr_auc + 12);
+    p_config_pz->nr_blocks_ud           = m_r_get_u32 (l_hdr_auc + 16);
+    p_config_pz->max_msg_size_ud        = m_r_get_u32 (l_hdr_auc + 20);
+    p_config_pz->min_data_per_part_ud   = m_r_get_u32 (l_hdr_auc + 24);
+
+    hl_blocks_trace_reader_t* l_reader_pz = (hl_blocks_trace_reader_t*)malloc (sizeof (hl_blocks_trace_reader_t));
+    if (l_reader_pz == NULL) {
+        fclose (l_file_fp);
+        return ERROR (-1, "failed to allocate reader");
+    }
+    l_reader_pz->file_fp    = l_file_fp;
+    l_reader_pz->last_ns_ud = 0;
+    *p_reader_ppz = l_reader_pz;
+    return SUCCESS ();
+}/*hl_blocks_trace_r_reader_open()*/
+
+
+extern int hl_blocks_trace_r_reader_next (
+          hl_blocks_trace_reader_t*   p_reader_pz,
+          hl_blocks_trace_rec_t*      p_rec_pz)
+{
+    int l_op_d = getc (p_reader_pz->file_fp);
+    if (l_op_d == EOF)
+        return ERROR (HL_BLOCKS_K_ERROR_READ_ALL, "End of trace.");
+    if ((l_op_d & M_REC_OP_MASK) >= HL_BLOCKS_TRACE_K_OP_NR_OF)
+        return ERROR (-1, "invalid op 0x%02x in trace", l_op_d);
+
+    uint64_t l_delta_ns_ud = 0;
+    uint64_t l_size_ud = 0;
+    if (m_r_get_varint (p_reader_pz->file_fp, &l_delta_ns_ud) != 0)
+        return ERROR (-1, "trace ends in a record");
+    if (  ((l_op_d & M_REC_OP_MASK) != HL_BLOCKS_TRACE_K_OP_SYNC)
+       && (m_r_get_varint (p_reader_pz->file_fp, &l_size_ud) != 0))
+        return ERROR (-1, "trace ends in a record");
+
+    p_reader_pz->last_ns_ud += l_delta_ns_ud;
+    p_rec_pz->op_e          = (hl_blocks_trace_op_e)(l_op_d & M_REC_OP_MASK);
+    p_rec_pz->failed_d      = (l_op_d & M_REC_FAILED) ? 1 : 0;
+    p_rec_pz->time_ns_ud    = p_reader_pz->last_ns_ud;
+    p_rec_pz->size_ud       = (uint32_t)l_size_ud;
+    return SUCCESS ();
+}/*hl_blocks_trace_r_reader_next()*/
+
+
+extern void hl_blocks_trace_r_reader_close (
+          hl_blocks_trace_reader_t**  p_reader_ppz)
+{
+    if (  (p_reader_ppz == NULL)
+       || (*p_reader_ppz == NULL))
+        return;
+    fclose ((*p_reader_ppz)->file_fp);
+    free (*p_reader_ppz);
+    *p_reader_ppz = NULL;
+}/*hl_blocks_trace_r_reader_close()*/
+
+
+extern int hl_blocks_trace_r_replay (
+    const char*                       p_path_pc,
+    const hl_blocks_trace_config_t*   p_config_pz,
+    const double                      p_speed_d,
+          hl_blocks_write_r*          p_write_pr,
+          hl_blocks_addr_r*           p_addr_pr,
+          hl_blocks_trace_result_t*   p_result_pz)
+{
+    if (  (p_speed_d < 0)
+       || (p_write_pr == NULL)
+       || (p_addr_pr == NULL)
+       || (p_result_pz == NULL))
+        return ERROR (-1, "invalid params for hl_blocks_trace_r_replay(%s)", p_path_pc);
+
+    hl_blocks_trace_config_t    l_config_z;
+    hl_blocks_trace_reader_t*   l_reader_pz = NULL;
+    if (hl_blocks_trace_r_reader_open (p_path_pc, &l_config_z, &l_reader_pz) != 0)
+        return ERROR (-1, "failed to open trace to replay");
+    if (p_config_pz != NULL)
+        l_config_z = *p_config_pz;
+
+    m_d_replay_write_pr  = p_write_pr;
+    m_d_replay_writes_ud = 0;
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (hl_blocks_r_open (
+            l_config_z.block_size_ud,
+            l_config_z.nr_blocks_ud,
+            l_config_z.max_msg_size_ud,
+            l_config_z.min_data_per_part_ud,
+            m_r_replay_write,
+            p_addr_pr,
+            &l_blocks_pz) != 0) {
+        hl_blocks_trace_r_reader_close (&l_reader_pz);
+        return ERROR (-1, "failed to open blocks to replay on");
+    }
+
+    //messages are the recorded sizes with any content
+    unsigned char* l_msg_auc = (unsigned char*)malloc (l_config_z.max_msg_size_ud + 1);
+    m_latencies_t  l_latencies_az[HL_BLOCKS_TRACE_K_OP_NR_OF];
+    memset (l_latencies_az, 0, sizeof (l_latencies_az));
+    memset (p_result_pz, 0, sizeof (hl_blocks_trace_result_t));
+    int            l_result_d = 0;
+    if (l_msg_auc == NULL)
+        l_result_d = ERROR (-1, "failed to allocate %u bytes", l_config_z.max_msg_size_ud + 1);
+    else
+        memset (l_msg_auc, 'x', l_config_z.max_msg_size_ud + 1);
+
+    uint64_t l_start_ns_ud = m_r_now_ns ();
+    while (l_result_d == 0) {
+        hl_blocks_trace_rec_t   l_rec_z;
+        int l_next_d = hl_blocks_trace_r_reader_next (l_reader_pz, &l_rec_z);
+        if (l_next_d == HL_BLOCKS_K_ERROR_READ_ALL)
+            break;
+        if (l_next_d != 0) {
+            l_result_d = ERROR (-1, "failed to read the trace");
+            break;
+        }
+        if (p_speed_d > 0)
+            m_r_wait_until (l_start_ns_ud + (uint64_t)((double)l_rec_z.time_ns_ud / p_speed_d));
+
+        hl_blocks_trace_op_stats_t* l_stats_pz = &p_result_pz->op_az[l_rec_z.op_e];
+        int      l_op_result_d = 0;
+        uint64_t l_op_start_ns_ud = m_r_now_ns ();
+        switch (l_rec_z.op_e) {
+        case HL_BLOCKS_TRACE_K_OP_WRITE:
+            l_op_result_d = hl_blocks_r_write (l_blocks_pz, l_msg_auc,
+                (l_rec_z.size_ud <= l_config_z.max_msg_size_ud) ? l_rec_z.size_ud : l_config_z.max_msg_size_ud + 1,
+                NULL);
+            break;
+        case HL_BLOCKS_TRACE_K_OP_READ: {
+            size_t l_size_ud = 0;
+            l_op_result_d = hl_blocks_r_read (l_blocks_pz, l_msg_auc, l_config_z.max_msg_size_ud + 1, &l_size_ud, NULL);
+            l_rec_z.size_ud = (uint32_t)l_size_ud;
+            break;
+        }
+        default:
+            l_op_result_d = hl_blocks_r_sync (l_blocks_pz);
+            break;
+        }
+        uint64_t l_op_ns_ud = m_r_now_ns () - l_op_start_ns_ud;
+
+        l_stats_pz->nr_ops_ud ++;
+        if (l_op_result_d != 0)
+            l_stats_pz->nr_failed_ud ++;
+        else
+            l_stats_pz->bytes_ud += l_rec_z.size_ud;
+        if (m_r_latency_add (&l_latencies_az[l_rec_z.op_e], l_op_ns_ud) != 0)
+            l_result_d = ERROR (-1, "failed to allocate latencies");
+        p_result_pz->recorded_ns_ud = l_rec_z.time_ns_ud;
+    }/*while more records*/
+    p_result_pz->elapsed_ns_ud = m_r_now_ns () - l_start_ns_ud;
+
+    if (  (hl_blocks_r_close (&l_blocks_pz) != 0)
+       && (l_result_d == 0))
+        l_result_d = ERROR (-1, "failed to close blocks after replay");
+    p_result_pz->flash_writes_ud = m_d_replay_writes_ud;
+    for (uint32_t l_op_ud = 0; l_op_ud < HL_BLOCKS_TRACE_K_OP_NR_OF; l_op_ud++) {
+        m_r_latency_stats (&l_latencies_az[l_op_ud], &p_result_pz->op_az[l_op_ud]);
+        free (l_latencies_az[l_op_ud].ns_aud);
+    }
+    free (l_msg_auc);
+    hl_blocks_trace_r_reader_close (&l_reader_pz);
+    m_d_replay_write_pr = NULL;
+    if (l_result_d != 0)
+        return l_result_d;
+    return SUCCESS ();
+}/*hl_blocks_trace_r_replay()*/
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+static void m_r_record (
+          hl_blocks_trace_t*          p_trace_pz,
+    const hl_blocks_trace_op_e        p_op_e,
+    const int                         p_result_d,
+    const uint64_t                    p_time_ns_ud,
+    const uint32_t                    p_size_ud)
+{
+    if (  (p_trace_pz == NULL)
+       || (p_trace_pz->write_failed_d))
+        return;
+    if (  (p_trace_pz->buf_used_ud + M_REC_MAX_SIZE > M_BUF_SIZE)
+       && (m_r_flush (p_trace_pz) != 0))
+        return;
+
+    uint64_t l_time_ns_ud = p_time_ns_ud - p_trace_pz->start_ns_ud;
+    unsigned char* l_out_puc = p_trace_pz->buf_auc + p_trace_pz->buf_used_ud;
+    *l_out_puc++ = (unsigned char)(p_op_e | ((p_result_d != 0) ? M_REC_FAILED : 0));
+    l_out_puc = m_r_put_varint (l_out_puc, l_time_ns_ud - p_trace_pz->last_ns_ud);
+    if (p_op_e != HL_BLOCKS_TRACE_K_OP_SYNC)
+        l_out_puc = m_r_put_varint (l_out_puc, p_size_ud);
+    p_trace_pz->last_ns_ud  = l_time_ns_ud;
+    p_trace_pz->buf_used_ud = (uint32_t)(l_out_puc - p_trace_pz->buf_auc);
+}/*m_r_record()*/
+
+
+static int m_r_flush (
+          hl_blocks_trace_t*          p_trace_pz)
+{
+    uint32_t l_done_ud = 0;
+    while (l_done_ud < p_trace_pz->buf_used_ud) {
+        ssize_t l_wrote_d = write (p_trace_pz->fd_d, p_trace_pz->buf_auc + l_done_ud, p_trace_pz->buf_used_ud - l_done_ud);
+        if (l_wrote_d < 0) {
+            if (errno == EINTR)
+                continue;
+            WARNING ("Trace write failed, recording stopped: %s", strerror (errno));
+            p_trace_pz->write_failed_d = 1;
+            return -1;
+        }
+        l_done_ud += (uint32_t)l_wrote_d;
+    }
+    p_trace_pz->buf_used_ud = 0;
+    return 0;
+}/*m_r_flush()*/
+
+
+static unsigned char* m_r_put_varint (
+          unsigned char*              p_out_puc,
+          uint64_t                    p_value_ud)
+{
+    while (p_value_ud >= 0x80) {
+        *p_out_puc++ = (unsigned char)(p_value_ud | 0x80);
+        p_value_ud >>= 7;
+    }
+    *p_out_puc++ = (unsigned char)p_value_ud;
+    return p_out_puc;
+}/*m_r_put_varint()*/
+
+
+static int m_r_get_varint (
+          FILE*                       p_file_fp,
+          uint64_t*                   p_value_pud)
+{
+    uint64_t l_value_ud = 0;
+    for (unsigned int l_shift_ud = 0; l_shift_ud < 64; l_shift_ud += 7) {
+        int l_byte_d = getc (p_file_fp);
+        if (l_byte_d == EOF)
+            return -1;
+        l_value_ud |= (uint64_t)(l_byte_d & 0x7F) << l_shift_ud;
+        if ((l_byte_d & 0x80) == 0) {
+            *p_value_pud = l_value_ud;
+            return 0;
+        }
+    }
+    return -1;
+}/*m_r_get_varint()*/
+
+
+static void m_r_put_u32 (
+          unsigned char*              p_out_puc,
+    const uint32_t                    p_value_ud)
+{
+    p_out_puc[0] = (unsigned char)(p_value_ud);
+    p_out_puc[1] = (unsigned char)(p_value_ud >> 8);
+    p_out_puc[2] = (unsigned char)(p_value_ud >> 16);
+    p_out_puc[3] = (unsigned char)(p_value_ud >> 24);
+}/*m_r_put_u32()*/
+
+
+static uint32_t m_r_get_u32 (
+    const unsigned char*              p_in_puc)
+{
+    return (uint32_t)p_in_puc[0]
+        | ((uint32_t)p_in_puc[1] << 8)
+        | ((uint32_t)p_in_puc[2] << 16)
+        | ((uint32_t)p_in_puc[3] << 24);
+}/*m_r_get_u32()*/
+
+
+static int m_r_replay_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p)
+{
+    m_d_replay_writes_ud ++;
+    return m_d_replay_write_pr (p_idx_ud, p_block_p);
+}/*m_r_replay_write()*/
+
+
+static int m_r_latency_add (
+          m_latencies_t*              p_latencies_pz,
+    const uint64_t                    p_ns_ud)
+{
+    if (p_latencies_pz->nr_ud == p_latencies_pz->alloc_ud) {
+        uint64_t l_alloc_ud = (p_latencies_pz->alloc_ud == 0) ? 4096 : p_latencies_pz->alloc_ud * 2;
+        uint32_t* l_ns_aud = (uint32_t*)realloc (p_latencies_pz->ns_aud, l_alloc_ud * sizeof (uint32_t));
+        if (l_ns_aud == NULL)
+            return -1;
+        p_latencies_pz->ns_aud   = l_ns_aud;
+        p_latencies_pz->alloc_ud = l_alloc_ud;
+    }
+    p_latencies_pz->ns_aud[p_latencies_pz->nr_ud++] = (p_ns_ud > UINT32_MAX) ? UINT32_MAX : (uint32_t)p_ns_ud;
+    return 0;
+}/*m_r_latency_add()*/
+
+
+//nearest rank percentiles
+static void m_r_latency_stats (
+          m_latencies_t*              p_latencies_pz,
+          hl_blocks_trace_op_stats_t* p_stats_pz)
+{
+    uint64_t l_nr_ud = p_latencies_pz->nr_ud;
+    if (l_nr_ud == 0)
+        return;
+    qsort (p_latencies_pz->ns_aud, l_nr_ud, sizeof (uint32_t), m_r_cmp_u32);
+    p_stats_pz->p50_ns_ud  = p_latencies_pz->ns_aud[(l_nr_ud * 500 + 999) / 1000 - 1];
+    p_stats_pz->p90_ns_ud  = p_latencies_pz->ns_aud[(l_nr_ud * 900 + 999) / 1000 - 1];
+    p_stats_pz->p99_ns_ud  = p_latencies_pz->ns_aud[(l_nr_ud * 990 + 999) / 1000 - 1];
+    p_stats_pz->p999_ns_ud = p_latencies_pz->ns_aud[(l_nr_ud * 999 + 999) / 1000 - 1];
+    p_stats_pz->max_ns_ud  = p_latencies_pz->ns_aud[l_nr_ud - 1];
+}/*m_r_latency_stats()*/
+
+
+static int m_r_cmp_u32 (
+    const void*                       p_a_p,
+    const void*                       p_b_p)
+{
+    uint32_t l_a_ud = *(const uint32_t*)p_a_p;
+    uint32_t l_b_ud = *(const uint32_t*)p_b_p;
+    return (l_a_ud < l_b_ud) ? -1 : (l_a_ud > l_b_ud) ? 1 : 0;
+}/*m_r_cmp_u32()*/
+
+
+static void m_r_wait_until (
+    const uint64_t                    p_time_ns_ud)
+{
+    //a sleep that ends at once still costs a system call, and calls
+    //replayed late would only get later
+    if (m_r_now_ns () >= p_time_ns_ud)
+        return;
+    struct timespec l_ts_z;
+    l_ts_z.tv_sec  = (time_t)(p_time_ns_ud / 1000000000ULL);
+    l_ts_z.tv_nsec = (long)(p_time_ns_ud % 1000000000ULL);
+    while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &l_ts_z, NULL) == EINTR)
+        ;
+}/*m_r_wait_until()*/
+
+
+static uint64_t m_r_now_ns (void)
+{
+    struct timespec l_ts_z;
+    clock_gettime (CLOCK_MONOTONIC, &l_ts_z);
+    return (uint64_t)l_ts_z.tv_sec * 1000000000ULL + (uint64_t)l_ts_z.tv_nsec;
+}/*m_r_now_ns()*/
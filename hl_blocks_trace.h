@@ -0,0 +1,184 @@
+#ifndef _HL_BLOCKS_TRACE_H_
+#define _HL_BLOCKS_TRACE_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "hl_blocks.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/*****************************************************************************
+ * P U B L I C   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+typedef enum hl_blocks_trace_op_enum_s {
+    HL_BLOCKS_TRACE_K_OP_WRITE = 0,
+    HL_BLOCKS_TRACE_K_OP_READ,
+    HL_BLOCKS_TRACE_K_OP_SYNC,
+    /*
+     * terminator
+     */
+    HL_BLOCKS_TRACE_K_OP_NR_OF
+} hl_blocks_trace_op_e;
+
+//hl_blocks_r_open() params of the recorded instance, the default for replay
+typedef struct hl_blocks_trace_config_s {
+    uint32_t                    block_size_ud;
+    uint32_t                    nr_blocks_ud;
+    uint32_t                    max_msg_size_ud;
+    uint32_t                    min_data_per_part_ud;
+} hl_blocks_trace_config_t;
+
+//one recorded call
+typedef struct hl_blocks_trace_rec_s {
+    hl_blocks_trace_op_e        op_e;
+    int                         failed_d;       //1 when it did not return SUCCESS, e.g. nothing to read
+    uint64_t                    time_ns_ud;     //when it was called, since the trace started
+    uint32_t                    size_ud;        //message size written or read, 0 for sync
+} hl_blocks_trace_rec_t;
+
+//replay results of one op type
+typedef struct hl_blocks_trace_op_stats_s {
+    uint64_t                    nr_ops_ud;
+    uint64_t                    nr_failed_ud;   //did not return SUCCESS in replay
+    uint64_t                    bytes_ud;
+    uint64_t                    p50_ns_ud;
+    uint64_t                    p90_ns_ud;
+    uint64_t                    p99_ns_ud;
+    uint64_t                    p999_ns_ud;
+    uint64_t                    max_ns_ud;
+} hl_blocks_trace_op_stats_t;
+
+typedef struct hl_blocks_trace_result_s {
+    hl_blocks_trace_op_stats_t  op_az[HL_BLOCKS_TRACE_K_OP_NR_OF];
+    uint64_t                    recorded_ns_ud; //time of the last op in the trace
+    uint64_t                    elapsed_ns_ud;  //time of the replay
+    uint64_t                    flash_writes_ud;//blocks written to flash
+} hl_blocks_trace_result_t;
+
+typedef struct hl_blocks_trace_s hl_blocks_trace_t;
+typedef struct hl_blocks_trace_reader_s hl_blocks_trace_reader_t;
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+/*
+ * PURPOSE:
+ *     Record the hl_blocks calls of an application into a compact binary
+ *     trace file, to replay the field traffic later with other settings.
+ *     Call hl_blocks_trace_r_write/read/sync() instead of hl_blocks_r_write/
+ *     read/sync(): they call the library and record when it was called,
+ *     the op, the message size and if it failed, in 3..12 bytes per call.
+ *     Records are collected in memory and written to the file in chunks.
+ *     Like hl_blocks_t, a trace must only be used by one thread at a time.
+ *
+ *     Usage:
+ *         hl_blocks_r_open (512, 64, 512, 16, ..., &blocks);
+ *         hl_blocks_trace_r_open ("/tmp/app.trace", &(hl_blocks_trace_config_t){512, 64, 512, 16}, &trace);
+ *         hl_blocks_trace_r_write (trace, blocks, data, size, &seq);
+ *         ...
+ *         hl_blocks_trace_r_close (&trace);
+ *
+ * PARAMETERS:
+ *     p_path_pc                Trace file to create, replaced when it exists
+ *     p_config_pz              Params of the recorded instance
+ *     p_trace_ppz              Output: the recorder
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_trace_r_open (
+    const char*                       p_path_pc,
+    const hl_blocks_trace_config_t*   p_config_pz,
+          hl_blocks_trace_t**         p_trace_ppz);
+
+// write the remaining records and close the file
+// returns ERROR when any record could not be written
+extern int hl_blocks_trace_r_close (
+          hl_blocks_trace_t**         p_trace_ppz);
+
+// hl_blocks_r_write() and record it, returns what hl_blocks_r_write() returned
+extern int hl_blocks_trace_r_write (
+          hl_blocks_trace_t*          p_trace_pz,
+          hl_blocks_t*                p_blocks_pz,
+    const void*                       p_data_p,
+    const size_t                      p_size_ud,
+          hl_blocks_msg_seq_t*        p_write_seq_pud);
+
+// hl_blocks_r_read() and record it, returns what hl_blocks_r_read() returned
+extern int hl_blocks_trace_r_read (
+          hl_blocks_trace_t*          p_trace_pz,
+          hl_blocks_t*                p_blocks_pz,
+          void*                       p_buff_data_p,
+    const size_t                      p_buff_size_ud,
+          size_t*                     p_read_size_pud,
+          hl_blocks_msg_seq_t*        p_read_seq_pud);
+
+// hl_blocks_r_sync() and record it, returns what hl_blocks_r_sync() returned
+extern int hl_blocks_trace_r_sync (
+          hl_blocks_trace_t*          p_trace_pz,
+          hl_blocks_t*                p_blocks_pz);
+
+/*
+ * PURPOSE:
+ *     Open a trace file to read its records in order.
+ *
+ * PARAMETERS:
+ *     p_path_pc                Trace file from hl_blocks_trace_r_open()
+ *     p_config_pz              Output: params of the recorded instance
+ *     p_reader_ppz             Output: the reader
+ *
+ * RETURN:
+ *     SUCCESS or ERROR when not a trace file
+ */
+extern int hl_blocks_trace_r_reader_open (
+    const char*                       p_path_pc,
+          hl_blocks_trace_config_t*   p_config_pz,
+          hl_blocks_trace_reader_t**  p_reader_ppz);
+
+// next record, or HL_BLOCKS_K_ERROR_READ_ALL at the end of the trace,
+// or -1 when the trace is corrupted
+extern int hl_blocks_trace_r_reader_next (
+          hl_blocks_trace_reader_t*   p_reader_pz,
+          hl_blocks_trace_rec_t*      p_rec_pz);
+
+extern void hl_blocks_trace_r_reader_close (
+          hl_blocks_trace_reader_t**  p_reader_ppz);
+
+/*
+ * PURPOSE:
+ *     Replay a trace on a new hl_blocks instance, with messages of the
+ *     recorded sizes, and measure the latency of each call and the
+ *     nr of blocks written to flash.
+ *     The backend must be open and empty, e.g. hl_blocks_fault_r_open()
+ *     with the block size and nr of blocks of p_config_pz.
+ *     Only one replay can run at a time, because the hl_blocks backend
+ *     functions has no context.
+ *
+ * PARAMETERS:
+ *     p_path_pc                Trace file from hl_blocks_trace_r_open()
+ *     p_config_pz              Params for the new instance, NULL for the recorded params
+ *     p_speed_d                1.0 for the recorded times, 10.0 for 10x faster,
+ *                              0 to call one after the other without waiting
+ *     p_write_pr               Block write function of the backend
+ *     p_addr_pr                Block address function of the backend
+ *     p_result_pz              Output: latency and flash writes
+ *
+ * RETURN:
+ *     SUCCESS or ERROR when the trace or the instance failed, not when
+ *     a call failed, which is counted in the results
+ */
+extern int hl_blocks_trace_r_replay (
+    const char*                       p_path_pc,
+    const hl_blocks_trace_config_t*   p_config_pz,
+    const double                      p_speed_d,
+          hl_blocks_write_r*          p_write_pr,
+          hl_blocks_addr_r*           p_addr_pr,
+          hl_blocks_trace_result_t*   p_result_pz);
+
+#endif /*_HL_BLOCKS_TRACE_H_*/
@@ -0,0 +1,633 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#ifdef __linux__
+#define _GNU_SOURCE     //O_DIRECT
+#endif
+
+#define LOG_MODULE  "hl_blocks_uring"
+
+#include "error_stack.h"
+#include "hl_blocks_uring.h"
+#include "log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+
+// block buffers are aligned for O_DIRECT
+#define M_DIRECT_ALIGN              4096
+
+// max nr of blocks to start reading after the block being read
+#define M_READ_AHEAD_BLOCKS         4
+
+#define M_MIN_QUEUE_DEPTH           4
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+typedef enum m_slot_state_enum_s {
+    M_SLOT_K_IDLE,
+    M_SLOT_K_READING,
+    M_SLOT_K_WRITING,
+} m_slot_state_e;
+
+//one block buffer, used for writing or reading and then
+//kept as cache of that block until the buffer is needed again
+typedef struct m_slot_s {
+    unsigned char*              data_auc;
+    uint32_t                    idx_ud;         //block in this buffer when valid
+    int                         valid_d;        //1 when idx_ud is (being) read/written
+    m_slot_state_e              state_e;
+} m_slot_t;
+
+#ifdef __linux__
+typedef struct m_ring_s {
+    int                         fd_d;           //-1 when not using io_uring
+    int                         fixed_d;        //1 when slot buffers are registered
+    void*                       sq_ring_p;
+    size_t                      sq_ring_size_ud;
+    void*                       cq_ring_p;
+    size_t                      cq_ring_size_ud;
+    struct io_uring_sqe*        sqe_az;
+    size_t                      sqe_size_ud;
+    unsigned*                   sq_head_pud;
+    unsigned*                   sq_tail_pud;
+    unsigned*                   sq_mask_pud;
+    unsigned*                   sq_array_pud;
+    unsigned*                   cq_head_pud;
+    unsigned*                   cq_tail_pud;
+    unsigned*                   cq_mask_pud;
+    struct io_uring_cqe*        cqe_az;
+} m_ring_t;
+#endif
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+static int                  m_d_fd_d                = -1;
+static uint32_t             m_d_block_size_ud       = 0;
+static uint32_t             m_d_nr_blocks_ud        = 0;
+static m_slot_t*            m_d_slot_az             = NULL;
+static struct iovec*        m_d_iov_az              = NULL;
+static uint32_t             m_d_nr_slots_ud         = 0;
+static uint32_t             m_d_next_victim_ud      = 0;
+static int                  m_d_pinned_slot_d       = -1;   //last returned by addr, still in use by hl_blocks
+static int                  m_d_async_error_d       = 0;    //first failed write, reported on next call
+
+#ifdef __linux__
+static m_ring_t             m_d_ring_z              = {.fd_d = -1};
+#endif
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static int m_r_ring_open (
+    const uint32_t                    p_entries_ud);
+
+static void m_r_ring_close (void);
+
+static int m_r_submit (
+    const uint32_t                    p_slot_ud,
+    const m_slot_state_e              p_state_e);
+
+static int m_r_reap (
+    const int                         p_wait_d);
+
+static int m_r_find_slot (
+    const uint32_t                    p_idx_ud);
+
+static int m_r_wait_slot (
+    const uint32_t                    p_slot_ud);
+
+static int m_r_free_slot (
+    const int                         p_wait_d);
+
+static void m_r_complete (
+    const uint32_t                    p_slot_ud,
+    const int                         p_result_d);
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+extern int hl_blocks_uring_r_open (
+    const char*                       p_path_pc,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const uint32_t                    p_queue_depth_ud)
+{
+    if (  (p_path_pc == NULL)
+       || (p_block_size_ud == 0)
+       || (p_nr_blocks_ud == 0)
+       || (p_queue_depth_ud < M_MIN_QUEUE_DEPTH))
+        return ERROR (-1, "invalid params for hl_blocks_uring_r_open(%s,%u,%u,%u)",
+            (p_path_pc == NULL ? "NULL" : p_path_pc),
+            p_block_size_ud,
+            p_nr_blocks_ud,
+            p_queue_depth_ud);
+    if (m_d_slot_az != NULL)
+        return ERROR (-1, "hl_blocks_uring already open, only one file allowed");
+
+    //bypass the page cache when the blocks are aligned for it
+    int l_fd_d = -1;
+    int l_direct_d = 0;
+#ifdef O_DIRECT
+    if (p_block_size_ud % M_DIRECT_ALIGN == 0) {
+        l_fd_d = open (p_path_pc, O_RDWR | O_CREAT | O_DIRECT, 0644);
+        l_direct_d = (l_fd_d >= 0);
+    }
+#endif
+    if (l_fd_d < 0)
+        l_fd_d = open (p_path_pc, O_RDWR | O_CREAT, 0644);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to open %s: %s", p_path_pc, strerror (errno));
+
+    //preallocate so all blocks can be read and writing never fails for lack of space
+    off_t l_size_ud = (off_t)p_block_size_ud * p_nr_blocks_ud;
+    struct stat l_stat_z;
+    if (fstat (l_fd_d, &l_stat_z) != 0) {
+        close (l_fd_d);
+        return ERROR (-1, "failed to stat %s: %s", p_path_pc, strerror (errno));
+    }
+    if (  (S_ISREG (l_stat_z.st_mode))
+       && (l_stat_z.st_size < l_size_ud)) {
+        int l_result_d = posix_fallocate (l_fd_d, 0, l_size_ud);
+        if (  (l_result_d != 0)
+           && (ftruncate (l_fd_d, l_size_ud) != 0)) {
+            close (l_fd_d);
+            return ERROR (-1, "failed to allocate %lld bytes in %s: %s",
+                (long long)l_size_ud,
+                p_path_pc,
+                strerror (l_result_d));
+        }
+    }/*if file too small*/
+
+    //block buffers
+    m_d_slot_az = (m_slot_t*)calloc (p_queue_depth_ud, sizeof (m_slot_t));
+    m_d_iov_az  = (struct iovec*)calloc (p_queue_depth_ud, sizeof (struct iovec));
+    if ((m_d_slot_az == NULL) || (m_d_iov_az == NULL)) {
+        close (l_fd_d);
+        free (m_d_slot_az);
+        free (m_d_iov_az);
+        m_d_slot_az = NULL;
+        return ERROR (-1, "out of memory for %u block buffers", p_queue_depth_ud);
+    }
+    m_d_nr_slots_ud = p_queue_depth_ud;
+    for (uint32_t l_slot_ud = 0; l_slot_ud < m_d_nr_slots_ud; l_slot_ud++) {
+        void* l_data_p = NULL;
+        if (posix_memalign (&l_data_p, M_DIRECT_ALIGN, p_block_size_ud) != 0) {
+            m_d_fd_d = l_fd_d;
+            hl_blocks_uring_r_close ();
+            return ERROR (-1, "out of memory for block buffer");
+        }
+        m_d_slot_az[l_slot_ud].data_auc = (unsigned char*)l_data_p;
+        m_d_slot_az[l_slot_ud].valid_d  = 0;
+        m_d_slot_az[l_slot_ud].state_e  = M_SLOT_K_IDLE;
+        m_d_iov_az[l_slot_ud].iov_base  = l_data_p;
+        m_d_iov_az[l_slot_ud].iov_len   = p_block_size_ud;
+    }
+
+    m_d_fd_d            = l_fd_d;
+    m_d_block_size_ud   = p_block_size_ud;
+    m_d_nr_blocks_ud    = p_nr_blocks_ud;
+    m_d_next_victim_ud  = 0;
+    m_d_pinned_slot_d   = -1;
+    m_d_async_error_d   = 0;
+
+    //continue with pread/pwrite when io_uring is not allowed
+    int l_uring_d = (m_r_ring_open (m_d_nr_slots_ud) == 0);
+    if (!l_uring_d)
+        success ();
+
+    DEBUG ("Opened %s with %u blocks x %u bytes, queue=%u direct=%d io_uring=%d",
+        p_path_pc,
+        p_nr_blocks_ud,
+        p_block_size_ud,
+        p_queue_depth_ud,
+        l_direct_d,
+        l_uring_d);
+    return SUCCESS ();
+}/*hl_blocks_uring_r_open()*/
+
+
+extern int hl_blocks_uring_r_close (void)
+{
+    if (m_d_slot_az == NULL)
+        return SUCCESS ();
+
+    int l_result_d = 0;
+    if (m_d_nr_blocks_ud > 0)
+        l_result_d = hl_blocks_uring_r_flush ();
+
+    m_r_ring_close ();
+    for (uint32_t l_slot_ud = 0; l_slot_ud < m_d_nr_slots_ud; l_slot_ud++)
+        free (m_d_slot_az[l_slot_ud].data_auc);
+    free (m_d_slot_az);
+    free (m_d_iov_az);
+    close (m_d_fd_d);
+    m_d_slot_az         = NULL;
+    m_d_iov_az          = NULL;
+    m_d_nr_slots_ud     = 0;
+    m_d_nr_blocks_ud    = 0;
+    m_d_fd_d            = -1;
+    if (l_result_d != 0)
+        return ERROR (l_result_d, "failed to flush before close");
+    return SUCCESS ();
+}/*hl_blocks_uring_r_close()*/
+
+
+extern int hl_blocks_uring_r_flush (void)
+{
+    if (m_d_slot_az == NULL)
+        return ERROR (-1, "hl_blocks_uring not open");
+
+    for (uint32_t l_slot_ud = 0; l_slot_ud < m_d_nr_slots_ud; l_slot_ud++) {
+        if (m_d_slot_az[l_slot_ud].state_e != M_SLOT_K_IDLE)
+            if (m_r_wait_slot (l_slot_ud) != 0)
+                return ERROR (-1, "failed waiting for blk[%u]", m_d_slot_az[l_slot_ud].idx_ud);
+    }
+
+    if (m_d_async_error_d != 0) {
+        int l_error_d = m_d_async_error_d;
+        m_d_async_error_d = 0;
+        return ERROR (-1, "block write failed: %s", strerror (-l_error_d));
+    }
+
+    if (fdatasync (m_d_fd_d) != 0)
+        return ERROR (-1, "fdatasync failed: %s", strerror (errno));
+    return SUCCESS ();
+}/*hl_blocks_uring_r_flush()*/
+
+
+extern int hl_blocks_uring_r_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    if (m_d_async_error_d != 0) {
+        int l_error_d = m_d_async_error_d;
+        m_d_async_error_d = 0;
+        return ERROR (-1, "earlier block write failed: %s", strerror (-l_error_d));
+    }
+
+    //reuse the buffer of this block, after its pending write/read is done
+    //not to have two writes of the same block in any order
+    int l_slot_d = m_r_find_slot (p_idx_ud);
+    if (l_slot_d >= 0) {
+        if (m_r_wait_slot ((uint32_t)l_slot_d) != 0)
+            return ERROR (-1, "failed waiting for blk[%u]", p_idx_ud);
+    } else {
+        l_slot_d = m_r_free_slot (1);
+        if (l_slot_d < 0)
+            return ERROR (-1, "no buffer to write blk[%u]", p_idx_ud);
+    }
+
+    m_slot_t* l_slot_pz = &m_d_slot_az[l_slot_d];
+    if (l_slot_pz->data_auc != (const unsigned char*)p_block_p)
+        memcpy (l_slot_pz->data_auc, p_block_p, m_d_block_size_ud);
+    l_slot_pz->idx_ud  = p_idx_ud;
+    l_slot_pz->valid_d = 1;
+    if (m_r_submit ((uint32_t)l_slot_d, M_SLOT_K_WRITING) != 0)
+        return ERROR (-1, "failed to write blk[%u]", p_idx_ud);
+    return SUCCESS ();
+}/*hl_blocks_uring_r_write()*/
+
+
+extern int hl_blocks_uring_r_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    //the buffer of a pending write already has the data
+    int l_slot_d = m_r_find_slot (p_idx_ud);
+    if (l_slot_d >= 0) {
+        if (m_d_slot_az[l_slot_d].state_e == M_SLOT_K_READING)
+            if (m_r_wait_slot ((uint32_t)l_slot_d) != 0)
+                return ERROR (-1, "failed waiting for blk[%u]", p_idx_ud);
+    }
+
+    if (  (l_slot_d < 0)
+       || (!m_d_slot_az[l_slot_d].valid_d)) {
+        //not in any buffer: read and wait
+        l_slot_d = m_r_free_slot (1);
+        if (l_slot_d < 0)
+            return ERROR (-1, "no buffer to read blk[%u]", p_idx_ud);
+        m_d_slot_az[l_slot_d].idx_ud  = p_idx_ud;
+        m_d_slot_az[l_slot_d].valid_d = 1;
+        if (  (m_r_submit ((uint32_t)l_slot_d, M_SLOT_K_READING) != 0)
+           || (m_r_wait_slot ((uint32_t)l_slot_d) != 0)
+           || (!m_d_slot_az[l_slot_d].valid_d))
+            return ERROR (-1, "failed to read blk[%u]", p_idx_ud);
+        m_d_pinned_slot_d = l_slot_d;
+
+        //start reading the next blocks, using only idle buffers
+        for (uint32_t l_next_ud = p_idx_ud + 1;
+             (l_next_ud <= p_idx_ud + M_READ_AHEAD_BLOCKS) && (l_next_ud < m_d_nr_blocks_ud);
+             l_next_ud ++) {
+            if (m_r_find_slot (l_next_ud) >= 0)
+                continue;
+            int l_ahead_d = m_r_free_slot (0);
+            if (l_ahead_d < 0)
+                break;
+            m_d_slot_az[l_ahead_d].idx_ud  = l_next_ud;
+            m_d_slot_az[l_ahead_d].valid_d = 1;
+            if (m_r_submit ((uint32_t)l_ahead_d, M_SLOT_K_READING) != 0)
+                break;
+        }/*for each block to read ahead*/
+    }/*if must read*/
+
+    m_d_pinned_slot_d = l_slot_d;
+    *p_block_pp = m_d_slot_az[l_slot_d].data_auc;
+    return SUCCESS ();
+}/*hl_blocks_uring_r_addr()*/
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+//set up the io_uring submission and completion queues
+//and register the block buffers
+static int m_r_ring_open (
+    const uint32_t                    p_entries_ud)
+{
+#ifdef __linux__
+    m_ring_t* l_ring_pz = &m_d_ring_z;
+    struct io_uring_params l_params_z;
+    memset (&l_params_z, 0, sizeof (l_params_z));
+    memset (l_ring_pz, 0, sizeof (m_ring_t));
+    l_ring_pz->fd_d = -1;
+
+    int l_fd_d = (int)syscall (__NR_io_uring_setup, p_entries_ud, &l_params_z);
+    if (l_fd_d < 0)
+        return ERROR (-1, "io_uring_setup(%u) failed: %s", p_entries_ud, strerror (errno));
+
+    l_ring_pz->sq_ring_size_ud = l_params_z.sq_off.array + l_params_z.sq_entries * sizeof (unsigned);
+    l_ring_pz->cq_ring_size_ud = l_params_z.cq_off.cqes + l_params_z.cq_entries * sizeof (struct io_uring_cqe);
+    if (l_params_z.features & IORING_FEAT_SINGLE_MMAP) {
+        if (l_ring_pz->cq_ring_size_ud > l_ring_pz->sq_ring_size_ud)
+            l_ring_pz->sq_ring_size_ud = l_ring_pz->cq_ring_size_ud;
+        l_ring_pz->cq_ring_size_ud = 0;
+    }
+
+    l_ring_pz->sq_ring_p = mmap (NULL, l_ring_pz->sq_ring_size_ud, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, l_fd_d, IORING_OFF_SQ_RING);
+    if (l_ring_pz->sq_ring_p == MAP_FAILED) {
+        close (l_fd_d);
+        return ERROR (-1, "failed to map io_uring sq: %s", strerror (errno));
+    }
+    l_ring_pz->cq_ring_p = l_ring_pz->sq_ring_p;
+    if (l_ring_pz->cq_ring_size_ud > 0) {
+        l_ring_pz->cq_ring_p = mmap (NULL, l_ring_pz->cq_ring_size_ud, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, l_fd_d, IORING_OFF_CQ_RING);
+        if (l_ring_pz->cq_ring_p == MAP_FAILED) {
+            munmap (l_ring_pz->sq_ring_p, l_ring_pz->sq_ring_size_ud);
+            close (l_fd_d);
+            return ERROR (-1, "failed to map io_uring cq: %s", strerror (errno));
+        }
+    }
+    l_ring_pz->sqe_size_ud = l_params_z.sq_entries * sizeof (struct io_uring_sqe);
+    l_ring_pz->sqe_az = (struct io_uring_sqe*)mmap (NULL, l_ring_pz->sqe_size_ud, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, l_fd_d, IORING_OFF_SQES);
+    if (l_ring_pz->sqe_az == MAP_FAILED) {
+        if (l_ring_pz->cq_ring_size_ud > 0)
+            munmap (l_ring_pz->cq_ring_p, l_ring_pz->cq_ring_size_ud);
+        munmap (l_ring_pz->sq_ring_p, l_ring_pz->sq_ring_size_ud);
+        close (l_fd_d);
+        return ERROR (-1, "failed to map io_uring sqes: %s", strerror (errno));
+    }
+
+    unsigned char* l_sq_puc = (unsigned char*)l_ring_pz->sq_ring_p;
+    unsigned char* l_cq_puc = (unsigned char*)l_ring_pz->cq_ring_p;
+    l_ring_pz->sq_head_pud  = (unsigned*)(l_sq_puc + l_params_z.sq_off.head);
+    l_ring_pz->sq_tail_pud  = (unsigned*)(l_sq_puc + l_params_z.sq_off.tail);
+    l_ring_pz->sq_mask_pud  = (unsigned*)(l_sq_puc + l_params_z.sq_off.ring_mask);
+    l_ring_pz->sq_array_pud = (unsigned*)(l_sq_puc + l_params_z.sq_off.array);
+    l_ring_pz->cq_head_pud  = (unsigned*)(l_cq_puc + l_params_z.cq_off.head);
+    l_ring_pz->cq_tail_pud  = (unsigned*)(l_cq_puc + l_params_z.cq_off.tail);
+    l_ring_pz->cq_mask_pud  = (unsigned*)(l_cq_puc + l_params_z.cq_off.ring_mask);
+    l_ring_pz->cqe_az       = (struct io_uring_cqe*)(l_cq_puc + l_params_z.cq_off.cqes);
+    l_ring_pz->fd_d         = l_fd_d;
+
+    //registered buffers are mapped once instead of on every read/write
+    //without them (e.g. memlock limit) use vectored read/write
+    l_ring_pz->fixed_d = (syscall (__NR_io_uring_register, l_fd_d, IORING_REGISTER_BUFFERS,
+        m_d_iov_az, m_d_nr_slots_ud) == 0);
+    return SUCCESS ();
+#else
+    return ERROR (-1, "io_uring not available");
+#endif
+}/*m_r_ring_open()*/
+
+
+static void m_r_ring_close (void)
+{
+#ifdef __linux__
+    m_ring_t* l_ring_pz = &m_d_ring_z;
+    if (l_ring_pz->fd_d < 0)
+        return;
+    munmap (l_ring_pz->sqe_az, l_ring_pz->sqe_size_ud);
+    if (l_ring_pz->cq_ring_size_ud > 0)
+        munmap (l_ring_pz->cq_ring_p, l_ring_pz->cq_ring_size_ud);
+    munmap (l_ring_pz->sq_ring_p, l_ring_pz->sq_ring_size_ud);
+    close (l_ring_pz->fd_d);    //also unregisters the buffers
+    l_ring_pz->fd_d = -1;
+#endif
+}/*m_r_ring_close()*/
+
+
+//start reading/writing the block of a slot
+//with io_uring it only queues it, else it is done when returning
+static int m_r_submit (
+    const uint32_t                    p_slot_ud,
+    const m_slot_state_e              p_state_e)
+{
+    m_slot_t* l_slot_pz = &m_d_slot_az[p_slot_ud];
+    off_t l_ofs_ud = (off_t)m_d_block_size_ud * l_slot_pz->idx_ud;
+    l_slot_pz->state_e = p_state_e;
+
+#ifdef __linux__
+    m_ring_t* l_ring_pz = &m_d_ring_z;
+    if (l_ring_pz->fd_d >= 0) {
+        //there is an sqe per slot, and each slot has at most one request
+        unsigned l_tail_ud = *l_ring_pz->sq_tail_pud;
+        unsigned l_pos_ud = l_tail_ud & *l_ring_pz->sq_mask_pud;
+        struct io_uring_sqe* l_sqe_pz = &l_ring_pz->sqe_az[l_pos_ud];
+        memset (l_sqe_pz, 0, sizeof (struct io_uring_sqe));
+        l_sqe_pz->fd        = m_d_fd_d;
+        l_sqe_pz->off       = (uint64_t)l_ofs_ud;
+        l_sqe_pz->user_data = p_slot_ud;
+        if (l_ring_pz->fixed_d) {
+            l_sqe_pz->opcode    = (p_state_e == M_SLOT_K_WRITING) ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            l_sqe_pz->addr      = (uint64_t)(uintptr_t)l_slot_pz->data_auc;
+            l_sqe_pz->len       = m_d_block_size_ud;
+            l_sqe_pz->buf_index = (uint16_t)p_slot_ud;
+        } else {
+            l_sqe_pz->opcode    = (p_state_e == M_SLOT_K_WRITING) ? IORING_OP_WRITEV : IORING_OP_READV;
+            l_sqe_pz->addr      = (uint64_t)(uintptr_t)&m_d_iov_az[p_slot_ud];
+            l_sqe_pz->len       = 1;
+        }
+        l_ring_pz->sq_array_pud[l_pos_ud] = l_pos_ud;
+        __atomic_store_n (l_ring_pz->sq_tail_pud, l_tail_ud + 1, __ATOMIC_RELEASE);
+
+        int l_result_d;
+        do {
+            l_result_d = (int)syscall (__NR_io_uring_enter, l_ring_pz->fd_d, 1, 0, 0, NULL, 0);
+        } while ((l_result_d < 0) && (errno == EINTR));
+        if (l_result_d < 0) {
+            l_slot_pz->state_e = M_SLOT_K_IDLE;
+            l_slot_pz->valid_d = 0;
+            return ERROR (-1, "io_uring_enter failed: %s", strerror (errno));
+        }
+        return SUCCESS ();
+    }/*if io_uring*/
+#endif
+
+    ssize_t l_size_d;
+    if (p_state_e == M_SLOT_K_WRITING)
+        l_size_d = pwrite (m_d_fd_d, l_slot_pz->data_auc, m_d_block_size_ud, l_ofs_ud);
+    else
+        l_size_d = pread (m_d_fd_d, l_slot_pz->data_auc, m_d_block_size_ud, l_ofs_ud);
+    m_r_complete (p_slot_ud, (l_size_d < 0) ? -errno : (int)l_size_d);
+    return SUCCESS ();
+}/*m_r_submit()*/
+
+
+//process completed requests, waiting for at least one if p_wait_d
+static int m_r_reap (
+    const int                         p_wait_d)
+{
+#ifdef __linux__
+    m_ring_t* l_ring_pz = &m_d_ring_z;
+    if (l_ring_pz->fd_d < 0)
+        return SUCCESS ();
+
+    unsigned l_head_ud = *l_ring_pz->cq_head_pud;
+    if (  (p_wait_d)
+       && (l_head_ud == __atomic_load_n (l_ring_pz->cq_tail_pud, __ATOMIC_ACQUIRE))) {
+        int l_result_d;
+        do {
+            l_result_d = (int)syscall (__NR_io_uring_enter, l_ring_pz->fd_d, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+        } while ((l_result_d < 0) && (errno == EINTR));
+        if (l_result_d < 0)
+            return ERROR (-1, "io_uring_enter wait failed: %s", strerror (errno));
+    }
+
+    unsigned l_tail_ud = __atomic_load_n (l_ring_pz->cq_tail_pud, __ATOMIC_ACQUIRE);
+    while (l_head_ud != l_tail_ud) {
+        const struct io_uring_cqe* l_cqe_pz = &l_ring_pz->cqe_az[l_head_ud & *l_ring_pz->cq_mask_pud];
+        m_r_complete ((uint32_t)l_cqe_pz->user_data, l_cqe_pz->res);
+        l_head_ud ++;
+    }
+    __atomic_store_n (l_ring_pz->cq_head_pud, l_head_ud, __ATOMIC_RELEASE);
+#endif
+    return SUCCESS ();
+}/*m_r_reap()*/
+
+
+//update a slot when its read/write is done with the nr of bytes or -errno
+static void m_r_complete (
+    const uint32_t                    p_slot_ud,
+    const int                         p_result_d)
+{
+    if (p_slot_ud >= m_d_nr_slots_ud)
+        return;
+
+    m_slot_t* l_slot_pz = &m_d_slot_az[p_slot_ud];
+    if (p_result_d != (int)m_d_block_size_ud) {
+        int l_error_d = (p_result_d < 0) ? p_result_d : -EIO;
+        ERROR_LOG ("%s blk[%u] failed: %d %s",
+            (l_slot_pz->state_e == M_SLOT_K_WRITING) ? "write" : "read",
+            l_slot_pz->idx_ud,
+            p_result_d,
+            strerror (-l_error_d));
+        if (  (l_slot_pz->state_e == M_SLOT_K_WRITING)
+           && (m_d_async_error_d == 0))
+            m_d_async_error_d = l_error_d;
+        l_slot_pz->valid_d = 0;
+    }
+    l_slot_pz->state_e = M_SLOT_K_IDLE;
+}/*m_r_complete()*/
+
+
+//slot holding or busy with a block, -1 if none
+static int m_r_find_slot (
+    const uint32_t                    p_idx_ud)
+{
+    for (uint32_t l_slot_ud = 0; l_slot_ud < m_d_nr_slots_ud; l_slot_ud++) {
+        if (  (m_d_slot_az[l_slot_ud].valid_d)
+           && (m_d_slot_az[l_slot_ud].idx_ud == p_idx_ud))
+            return (int)l_slot_ud;
+    }
+    return -1;
+}/*m_r_find_slot()*/
+
+
+static int m_r_wait_slot (
+    const uint32_t                    p_slot_ud)
+{
+    while (m_d_slot_az[p_slot_ud].state_e != M_SLOT_K_IDLE) {
+        if (m_r_reap (1) != 0)
+            return ERROR (-1, "failed to wait for blk[%u]", m_d_slot_az[p_slot_ud].idx_ud);
+    }
+    return SUCCESS ();
+}/*m_r_wait_slot()*/
+
+
+//get an idle slot to reuse, preferring unused ones, then round robin
+//not the slot hl_blocks is still using from the last addr call
+//when p_wait_d, wait for a pending request if all are busy, else return -1
+static int m_r_free_slot (
+    const int                         p_wait_d)
+{
+    while (1) {
+        (void)m_r_reap (0);
+
+        for (uint32_t l_slot_ud = 0; l_slot_ud < m_d_nr_slots_ud; l_slot_ud++) {
+            if (  (m_d_slot_az[l_slot_ud].state_e == M_SLOT_K_IDLE)
+               && (!m_d_slot_az[l_slot_ud].valid_d))
+                return (int)l_slot_ud;
+        }
+        for (uint32_t l_count_ud = 0; l_count_ud < m_d_nr_slots_ud; l_count_ud++) {
+            uint32_t l_slot_ud = m_d_next_victim_ud;
+            m_d_next_victim_ud = (m_d_next_victim_ud + 1) % m_d_nr_slots_ud;
+            if (  (m_d_slot_az[l_slot_ud].state_e == M_SLOT_K_IDLE)
+               && ((int)l_slot_ud != m_d_pinned_slot_d)) {
+                m_d_slot_az[l_slot_ud].valid_d = 0;
+                return (int)l_slot_ud;
+            }
+        }
+
+        if (!p_wait_d)
+            return -1;
+        if (m_r_reap (1) != 0)
+            return -1;
+    }/*while no slot*/
+}/*m_r_free_slot()*/
@@ -0,0 +1,79 @@
+#ifndef _HL_BLOCKS_URING_H_
+#define _HL_BLOCKS_URING_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+/*
+ * PURPOSE:
+ *     Block backend for hl_blocks on a file or block device using
+ *     asynchronous io_uring reads and writes (Linux only).
+ *
+ *     hl_blocks_uring_r_write() copies the block into one of
+ *     p_queue_depth_ud registered buffers, submits the write and returns,
+ *     so hl_blocks_r_sync() does not wait for the device and several
+ *     blocks are written at the same time. It only waits when all
+ *     buffers are in use.
+ *
+ *     hl_blocks_uring_r_addr() returns a buffer holding the block,
+ *     which is the buffer of a pending write of that block, a block
+ *     read before, or it reads the block and waits. On each read it
+ *     also starts reading the next few blocks for the reader.
+ *
+ *     The file is opened with O_DIRECT when the block size is a multiple
+ *     of 4096 bytes and the file system allows it, else through the page
+ *     cache. When io_uring is not available, it reads and writes with
+ *     pread()/pwrite() in the same buffers.
+ *
+ *     hl_blocks_uring_r_flush() waits for all pending writes and
+ *     flushes them to the device. Write errors are returned by the next
+ *     write or flush.
+ *
+ *     Addresses from hl_blocks_uring_r_addr() may be reused for another
+ *     block on the next call, so do not use with hl_blocks_r_drain_fd().
+ *
+ *     Only one file can be open at a time, because the hl_blocks
+ *     backend functions has no context.
+ *
+ * PARAMETERS:
+ *     p_path_pc                File or device to open, created if not exist
+ *     p_block_size_ud          Size of each block
+ *     p_nr_blocks_ud           Number of blocks
+ *     p_queue_depth_ud         Nr of block buffers, i.e. max nr of writes
+ *                              in progress, at least 4
+ *
+ * RETURN:
+ *     SUCCESS or ERROR
+ */
+extern int hl_blocks_uring_r_open (
+    const char*                       p_path_pc,
+    const uint32_t                    p_block_size_ud,
+    const uint32_t                    p_nr_blocks_ud,
+    const uint32_t                    p_queue_depth_ud);
+
+// flush all pending writes then close the file
+extern int hl_blocks_uring_r_close (void);
+
+// wait until all blocks written so far are on the device
+extern int hl_blocks_uring_r_flush (void);
+
+// hl_blocks_write_r for hl_blocks_r_open()
+extern int hl_blocks_uring_r_write (
+    const uint32_t                    p_idx_ud,
+    const void*                       p_block_p);
+
+// hl_blocks_addr_r for hl_blocks_r_open()
+extern int hl_blocks_uring_r_addr (
+    const uint32_t                    p_idx_ud,
+    const void**                      p_block_pp);
+
+#endif /*_HL_BLOCKS_URING_H_*/
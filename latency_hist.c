@@ -0,0 +1,132 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "latency_hist.h"
+#include <time.h>
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+#define M_SUB_MASK                  ((1U << LATENCY_HIST_SUB_BITS) - 1)
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static uint32_t m_r_bucket (
+    const uint64_t                    p_ns_ud);
+
+static uint64_t m_r_bucket_max_ns (
+    const uint32_t                    p_bucket_ud);
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+extern uint64_t latency_hist_r_now_ns (void)
+{
+    struct timespec             l_ts_z;
+    clock_gettime (CLOCK_MONOTONIC, &l_ts_z);
+    return (uint64_t)l_ts_z.tv_sec * 1000000000ULL + (uint64_t)l_ts_z.tv_nsec;
+}/*latency_hist_r_now_ns()*/
+
+
+extern void latency_hist_r_add (
+          latency_hist_t*             p_hist_pz,
+    const uint64_t                    p_ns_ud)
+{
+    uint64_t* l_bucket_pud = &p_hist_pz->bucket_aud[m_r_bucket (p_ns_ud)];
+    __atomic_store_n (l_bucket_pud, *l_bucket_pud + 1, __ATOMIC_RELAXED);
+    __atomic_store_n (&p_hist_pz->sum_ns_ud, p_hist_pz->sum_ns_ud + p_ns_ud, __ATOMIC_RELAXED);
+    __atomic_store_n (&p_hist_pz->count_ud, p_hist_pz->count_ud + 1, __ATOMIC_RELAXED);
+}/*latency_hist_r_add()*/
+
+
+extern void latency_hist_r_snapshot (
+    const latency_hist_t*             p_hist_pz,
+          latency_hist_t*             p_snapshot_pz)
+{
+    p_snapshot_pz->count_ud  = __atomic_load_n (&p_hist_pz->count_ud, __ATOMIC_RELAXED);
+    p_snapshot_pz->sum_ns_ud = __atomic_load_n (&p_hist_pz->sum_ns_ud, __ATOMIC_RELAXED);
+    for (uint32_t l_bucket_ud = 0; l_bucket_ud < LATENCY_HIST_NR_BUCKETS; l_bucket_ud++)
+        p_snapshot_pz->bucket_aud[l_bucket_ud] = __atomic_load_n (&p_hist_pz->bucket_aud[l_bucket_ud], __ATOMIC_RELAXED);
+}/*latency_hist_r_snapshot()*/
+
+
+extern void latency_hist_r_sub (
+          latency_hist_t*             p_hist_pz,
+    const latency_hist_t*             p_earlier_pz)
+{
+    p_hist_pz->count_ud  -= p_earlier_pz->count_ud;
+    p_hist_pz->sum_ns_ud -= p_earlier_pz->sum_ns_ud;
+    for (uint32_t l_bucket_ud = 0; l_bucket_ud < LATENCY_HIST_NR_BUCKETS; l_bucket_ud++)
+        p_hist_pz->bucket_aud[l_bucket_ud] -= p_earlier_pz->bucket_aud[l_bucket_ud];
+}/*latency_hist_r_sub()*/
+
+
+extern uint64_t latency_hist_r_percentile (
+    const latency_hist_t*             p_hist_pz,
+    const double                      p_percent_d)
+{
+    //the buckets of a snapshot may count a few more than count_ud
+    uint64_t l_count_ud = 0;
+    for (uint32_t l_bucket_ud = 0; l_bucket_ud < LATENCY_HIST_NR_BUCKETS; l_bucket_ud++)
+        l_count_ud += p_hist_pz->bucket_aud[l_bucket_ud];
+    if (l_count_ud == 0)
+        return 0;
+
+    //rank of the value, 1..count
+    uint64_t l_rank_ud = (uint64_t)((double)l_count_ud * p_percent_d / 100.0 + 0.999999);
+    if (l_rank_ud < 1)
+        l_rank_ud = 1;
+    if (l_rank_ud > l_count_ud)
+        l_rank_ud = l_count_ud;
+
+    uint64_t l_seen_ud = 0;
+    for (uint32_t l_bucket_ud = 0; l_bucket_ud < LATENCY_HIST_NR_BUCKETS; l_bucket_ud++) {
+        l_seen_ud += p_hist_pz->bucket_aud[l_bucket_ud];
+        if (l_seen_ud >= l_rank_ud)
+            return m_r_bucket_max_ns (l_bucket_ud);
+    }
+    return m_r_bucket_max_ns (LATENCY_HIST_NR_BUCKETS - 1);
+}/*latency_hist_r_percentile()*/
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+//values below 2^SUB_BITS have a bucket each, then each power of 2
+//from 2^msb has 2^SUB_BITS buckets selected by the bits after the msb
+static uint32_t m_r_bucket (
+    const uint64_t                    p_ns_ud)
+{
+    if (p_ns_ud <= M_SUB_MASK)
+        return (uint32_t)p_ns_ud;
+    uint32_t l_msb_ud = 63 - (uint32_t)__builtin_clzll (p_ns_ud);
+    if (l_msb_ud >= LATENCY_HIST_MAX_BITS)
+        return LATENCY_HIST_NR_BUCKETS - 1;
+    uint32_t l_sub_ud = (uint32_t)(p_ns_ud >> (l_msb_ud - LATENCY_HIST_SUB_BITS)) & M_SUB_MASK;
+    return ((l_msb_ud - LATENCY_HIST_SUB_BITS + 1) << LATENCY_HIST_SUB_BITS) + l_sub_ud;
+}/*m_r_bucket()*/
+
+
+//highest value counted in a bucket
+static uint64_t m_r_bucket_max_ns (
+    const uint32_t                    p_bucket_ud)
+{
+    if (p_bucket_ud <= M_SUB_MASK)
+        return p_bucket_ud;
+    uint32_t l_msb_ud = (p_bucket_ud >> LATENCY_HIST_SUB_BITS) + LATENCY_HIST_SUB_BITS - 1;
+    uint64_t l_width_ud = 1ULL << (l_msb_ud - LATENCY_HIST_SUB_BITS);
+    return (1ULL << l_msb_ud) + (uint64_t)((p_bucket_ud & M_SUB_MASK) + 1) * l_width_ud - 1;
+}/*m_r_bucket_max_ns()*/
@@ -0,0 +1,78 @@
+#ifndef _LATENCY_HIST_H_
+#define _LATENCY_HIST_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+
+/*****************************************************************************
+ * P U B L I C   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+//each power of 2 is split in 2^LATENCY_HIST_SUB_BITS buckets,
+//so a value is known within 12.5%
+#define LATENCY_HIST_SUB_BITS   3
+
+//values of 2^LATENCY_HIST_MAX_BITS ns (18 min) or more are counted in the last bucket
+#define LATENCY_HIST_MAX_BITS   40
+
+#define LATENCY_HIST_NR_BUCKETS ((LATENCY_HIST_MAX_BITS - LATENCY_HIST_SUB_BITS + 1) << LATENCY_HIST_SUB_BITS)
+
+//log bucketed histogram of durations in ns, like HdrHistogram
+typedef struct latency_hist_s {
+    uint64_t                    count_ud;       //nr of values added
+    uint64_t                    sum_ns_ud;      //for the average
+    uint64_t                    bucket_aud[LATENCY_HIST_NR_BUCKETS];
+} latency_hist_t;
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+// CLOCK_MONOTONIC in ns, from the vDSO on Linux without a system call
+extern uint64_t latency_hist_r_now_ns (void);
+
+/*
+ * PURPOSE:
+ *     Add a duration to a histogram, zeroed before the first value.
+ *     Only one thread may add, but other threads can take a snapshot
+ *     at the same time: the counters are updated with relaxed atomic
+ *     stores, without a locked add.
+ */
+extern void latency_hist_r_add (
+          latency_hist_t*             p_hist_pz,
+    const uint64_t                    p_ns_ud);
+
+// copy a histogram that another thread adds to, each counter with a relaxed atomic load
+extern void latency_hist_r_snapshot (
+    const latency_hist_t*             p_hist_pz,
+          latency_hist_t*             p_snapshot_pz);
+
+/*
+ * PURPOSE:
+ *     Subtract an earlier snapshot of the same histogram, to get the
+ *     values added since that snapshot, without changing the counters
+ *     of the thread that adds.
+ */
+extern void latency_hist_r_sub (
+          latency_hist_t*             p_hist_pz,
+    const latency_hist_t*             p_earlier_pz);
+
+/*
+ * PURPOSE:
+ *     Get a percentile, e.g. 99.9, as the highest value of the bucket it
+ *     is in, so it is never lower than the real value. 100 is the max.
+ *
+ * RETURN:
+ *     ns, 0 when the histogram is empty
+ */
+extern uint64_t latency_hist_r_percentile (
+    const latency_hist_t*             p_hist_pz,
+    const double                      p_percent_d);
+
+#endif /*_LATENCY_HIST_H_*/
@@ -1,7 +1,235 @@
 #include "log.h"
-#include <ctype.h>
+#include "log_format.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define M_MAX_MODULES               16      //modules with their own level
+#define M_MODULE_NAME_SIZE          32
+
+#define M_RECORD_MAX_SIZE           512     //deferred record incl header and string copies
+#define M_RING_MIN_SIZE             4096
+#define M_DRAIN_SLEEP_NS            1000000 //when the rings were empty
+#define M_ALIGN8(size)              (((size) + 7) & ~(uint32_t)7)
+
+#define M_BATCH_SIZE                8192    //lines written to the sink with one write()
+#define M_LINE_MAX_SIZE             1024    //longer lines are truncated
+#define M_SINK_PATH_SIZE            256
+#define M_HEX_ROW_SIZE              16      //bytes per hex dump line
+
+// timestamp of a deferred record, the TSC where available because
+// clock_gettime() can cost more than the rest of recording
+#if defined(__x86_64__) || defined(__i386__)
+#define M_NOW_TICKS()               ((uint64_t)__rdtsc ())
+#else
+#define M_NOW_TICKS()               m_r_now_ns ()
+#endif
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+typedef struct m_module_level_s {
+    char                        name_ac[M_MODULE_NAME_SIZE];
+    log_level_e                 level_e;
+} m_module_level_t;
+
+// deferred message in a ring, followed by its arguments in 8 byte slots,
+// long double in 2 slots and a string as its 4 byte length and the chars
+typedef struct m_record_s {
+    uint32_t                    size_ud;        //incl header, multiple of 8
+    uint32_t                    nr_args_ud;
+    const log_site_t*           site_pz;        //NULL to skip to the start of the ring
+    uint64_t                    time_ticks_ud;  //M_NOW_TICKS()
+} m_record_t;
+
+// ring of one thread, written only by that thread and read only by
+// the thread holding m_d_rings_mutex_z, so no locks when logging
+typedef struct m_ring_s {
+    uint64_t                    head_ud __attribute__((aligned(64)));  //bytes written
+    uint64_t                    dropped_ud;     //messages that did not fit
+    uint64_t                    tail_ud __attribute__((aligned(64)));  //bytes read
+    uint64_t                    reported_ud;    //dropped_ud when last reported
+    int                         closed_d;       //1 when the thread exited
+    uint32_t                    size_ud;        //power of 2
+    unsigned char*              data_auc;
+    struct m_ring_s*            next_pz;
+} m_ring_t;
+
+// lines of one thread not yet written to the sink
+typedef struct m_batch_s {
+    size_t                      used_ud;
+    size_t                      line_ud;        //start of the current line
+    char                        buf_ac[M_BATCH_SIZE];
+} m_batch_t;
+
+// position while printing a record
+typedef struct m_record_print_s {
+    const m_record_t*           record_pz;
+    const unsigned char*        next_auc;
+    uint32_t                    arg_idx_ud;
+    int                         ran_out_d;      //1 when more args were printed than kept
+} m_record_print_t;
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+volatile unsigned int       log_d_generation_ud     = 1;
+
+static pthread_mutex_t      m_d_mutex_z             = PTHREAD_MUTEX_INITIALIZER;
+static int                  m_d_env_read_d          = 0;
+static log_level_e          m_d_default_level_e     = LOG_K_LEVEL_INFO;
+static m_module_level_t     m_d_module_az[M_MAX_MODULES];
+static unsigned int         m_d_nr_modules_ud       = 0;
+
+// deferred logging
+static int                  m_d_deferred_d          = 0;
+static int                  m_d_stop_d              = 0;
+static uint32_t             m_d_ring_size_ud        = 0;
+static uint64_t             m_d_start_ns_ud         = 0;
+static uint64_t             m_d_start_ticks_ud      = 0;
+static double               m_d_ns_per_tick_f       = 1.0;  //measured again on each drain
+static pthread_t            m_d_drain_thread_z;
+static pthread_mutex_t      m_d_rings_mutex_z       = PTHREAD_MUTEX_INITIALIZER;
+static m_ring_t*            m_d_rings_pz            = NULL;
+static uint64_t             m_d_freed_dropped_ud    = 0;    //of rings already freed
+static _Thread_local m_ring_t* m_d_ring_pz          = NULL;
+static pthread_key_t        m_d_ring_key_z;
+static pthread_once_t       m_d_ring_key_once_z     = PTHREAD_ONCE_INIT;
+
+// where the lines are written, stderr or a file opened by log_r_set_sink_file()
+static pthread_mutex_t      m_d_sink_mutex_z        = PTHREAD_MUTEX_INITIALIZER;
+static int                  m_d_sink_fd_d           = 2;
+static char                 m_d_sink_path_ac[M_SINK_PATH_SIZE];    //empty when not opened here
+static uint64_t             m_d_sink_size_ud        = 0;
+static uint64_t             m_d_sink_max_size_ud    = 0;    //0 to never rotate
+static uint32_t             m_d_sink_nr_files_ud    = 0;
+static _Thread_local m_batch_t m_d_batch_z;
+
+// 2 hex digits of each byte value, "000102..FF", for hex dumps
+#define M_HEX_UPPER(hi)             hi "0" hi "1" hi "2" hi "3" hi "4" hi "5" hi "6" hi "7" \
+                                    hi "8" hi "9" hi "A" hi "B" hi "C" hi "D" hi "E" hi "F"
+#define M_HEX_LOWER(hi)             hi "0" hi "1" hi "2" hi "3" hi "4" hi "5" hi "6" hi "7" \
+                                    hi "8" hi "9" hi "a" hi "b" hi "c" hi "d" hi "e" hi "f"
+static const char           m_d_hex_upper_ac[] =
+    M_HEX_UPPER ("0") M_HEX_UPPER ("1") M_HEX_UPPER ("2") M_HEX_UPPER ("3")
+    M_HEX_UPPER ("4") M_HEX_UPPER ("5") M_HEX_UPPER ("6") M_HEX_UPPER ("7")
+    M_HEX_UPPER ("8") M_HEX_UPPER ("9") M_HEX_UPPER ("A") M_HEX_UPPER ("B")
+    M_HEX_UPPER ("C") M_HEX_UPPER ("D") M_HEX_UPPER ("E") M_HEX_UPPER ("F");
+static const char           m_d_hex_lower_ac[] =
+    M_HEX_LOWER ("0") M_HEX_LOWER ("1") M_HEX_LOWER ("2") M_HEX_LOWER ("3")
+    M_HEX_LOWER ("4") M_HEX_LOWER ("5") M_HEX_LOWER ("6") M_HEX_LOWER ("7")
+    M_HEX_LOWER ("8") M_HEX_LOWER ("9") M_HEX_LOWER ("a") M_HEX_LOWER ("b")
+    M_HEX_LOWER ("c") M_HEX_LOWER ("d") M_HEX_LOWER ("e") M_HEX_LOWER ("f");
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static void m_r_read_env (void);
+
+static int m_r_set_level (
+    const char*                       p_module_pc,
+    const size_t                      p_module_len_ud,
+    const log_level_e                 p_level_e);
+
+static int m_r_parse_level (
+    const char*                       p_text_pc,
+    const size_t                      p_len_ud,
+          log_level_e*                p_level_pe);
+
+static int m_r_config (
+    const char*                       p_config_pc);
+
+static void m_r_vwrite (
+    const char*                       p_file_pc,
+    const int                         p_line_d,
+    const log_level_e                 p_level_e,
+    const char*                       p_format_pc,
+          va_list*                    p_va_list_pz);
+
+static void m_r_parse_site (
+          log_site_t*                 p_site_pz);
+
+static void m_r_record (
+          log_site_t*                 p_site_pz,
+          va_list*                    p_va_list_pz);
+
+static m_ring_t* m_r_get_ring (void);
+
+static void m_r_make_ring_key (void);
+
+static void m_r_close_ring (
+          void*                       p_ring_p);
+
+static uint64_t m_r_now_ns (void);
+
+static void* m_r_drain_thread (
+          void*                       p_arg_p);
+
+static int m_r_drain (void);
+
+static const m_record_t* m_r_peek (
+          m_ring_t*                   p_ring_pz);
+
+static void m_r_print_record (
+    const m_record_t*                 p_record_pz);
+
+static int m_r_next_record_arg (
+          void*                       p_context_p,
+    const log_format_arg_e            p_type_e,
+          log_format_value_t*         p_value_pz);
+
+static m_batch_t* m_r_batch_line (void);
+
+static void m_r_batch_printf (
+          m_batch_t*                  p_batch_pz,
+    const char*                       p_format_pc,
+          ...) __attribute__((format (printf, 2, 3)));
+
+static void m_r_batch_vprintf (
+          m_batch_t*                  p_batch_pz,
+    const char*                       p_format_pc,
+          va_list*                    p_va_list_pz);
+
+static void m_r_batch_end_line (
+          m_batch_t*                  p_batch_pz);
+
+static void m_r_batch_flush (
+          m_batch_t*                  p_batch_pz);
+
+static void m_r_sink_write (
+    const char*                       p_data_pc,
+    const size_t                      p_size_ud);
+
+static void m_r_sink_rotate (void);
+
+static char* m_r_hex_row (
+          char*                       p_out_pc,
+    const unsigned char*              p_data_puc,
+    const uint32_t                    p_size_ud);
+
+static char* m_r_hex32 (
+          char*                       p_out_pc,
+    const uint32_t                    p_value_ud);
 
 extern void log_r_write (
     const char*                       p_file_pc,
@@ -10,20 +238,26 @@ extern void log_r_write (
     const char*                       p_format_pc,
           ...)
 {
-    fprintf (stderr, "%5.5s %30.30s(%5d): ",
-        log_r_level_text (p_level_e),
-        p_file_pc,
-        p_line_d);
-
     va_list                     l_va_list_z;
     va_start (l_va_list_z, p_format_pc);
-    vfprintf(stderr, p_format_pc, l_va_list_z);
+    m_r_vwrite (p_file_pc, p_line_d, p_level_e, p_format_pc, &l_va_list_z);
     va_end(l_va_list_z);
-
-    fprintf (stderr, "\n");
     return;
 }/*log_r_write()*/
 
+extern void log_r_write_site (
+          log_site_t*                 p_site_pz,
+          ...)
+{
+    va_list                     l_va_list_z;
+    va_start (l_va_list_z, p_site_pz);
+    if (__atomic_load_n (&m_d_deferred_d, __ATOMIC_ACQUIRE))
+        m_r_record (p_site_pz, &l_va_list_z);
+    else
+        m_r_vwrite (p_site_pz->file_pc, p_site_pz->line_d, p_site_pz->level_e, p_site_pz->format_pc, &l_va_list_z);
+    va_end(l_va_list_z);
+}/*log_r_write_site()*/
+
 extern void log_r_hex (
     const char*                       p_file_pc,
     const int                         p_line_d,
@@ -36,49 +270,43 @@ extern void log_r_hex (
        || (p_data_p == NULL))
         return;
 
-    fprintf (stderr, "%5.5s %30.30s(%5d): %s (%u bytes):\n",
+    m_batch_t* l_batch_pz = m_r_batch_line ();
+    m_r_batch_printf (l_batch_pz, "%5.5s %30.30s(%5d): %s (%u bytes):",
         log_r_level_text (p_level_e),
         p_file_pc,
         p_line_d,
         p_title_pc,
         p_size_ud);
+    m_r_batch_end_line (l_batch_pz);
 
-    uint32_t                    l_ofs_ud = 0;
-    uint32_t                    l_rem_ud = p_size_ud;
-    while (l_rem_ud > 0) {
-        fprintf (stderr, "%5.5s %30.30s(%5d): [%08x..%08x]",
-            log_r_level_text (p_level_e),
-            p_file_pc,
-            p_line_d,
-            l_ofs_ud,
-            l_ofs_ud + 15);
-
-        for (uint32_t i = 0; i < 16; i ++) {
-            if (i < l_rem_ud) {
-                const unsigned char l_byte_uc = *((const unsigned char*)p_data_p + l_ofs_ud + i);
-                fprintf (stderr, " %02X", l_byte_uc);
-            } else {
-                fprintf (stderr, " ..");
-            }
-        }
-        fprintf (stderr, " | ");
-        for (uint32_t i = 0; ((i < 16) && (i < l_rem_ud)); i ++) {
-            const unsigned char l_byte_uc = *((const unsigned char*)p_data_p + l_ofs_ud + i);
-            if (isprint (l_byte_uc)) {
-                fprintf (stderr, "%c", (const char)l_byte_uc);
-            } else {
-                fprintf (stderr, ".");
-            }
-        }
-        fprintf (stderr, "\n");
-
-        if (l_rem_ud <= 16) {
-            break;
-        }
+    // the prefix is the same on each row, so format it once
+    char                        l_prefix_ac[64];
+    int l_prefix_len_d = snprintf (l_prefix_ac, sizeof (l_prefix_ac), "%5.5s %30.30s(%5d): ",
+        log_r_level_text (p_level_e),
+        p_file_pc,
+        p_line_d);
+    size_t l_prefix_size_ud = (l_prefix_len_d < (int)sizeof (l_prefix_ac)) ? (size_t)l_prefix_len_d : sizeof (l_prefix_ac) - 1;
 
-        l_ofs_ud += 16;
-        l_rem_ud -= 16;
-    }//while more data
+    const unsigned char*        l_data_puc = (const unsigned char*)p_data_p;
+    for (uint32_t l_ofs_ud = 0; l_ofs_ud < p_size_ud; l_ofs_ud += M_HEX_ROW_SIZE) {
+        l_batch_pz = m_r_batch_line ();
+        char* l_out_pc = l_batch_pz->buf_ac + l_batch_pz->used_ud;
+        memcpy (l_out_pc, l_prefix_ac, l_prefix_size_ud);
+        l_out_pc += l_prefix_size_ud;
+        *l_out_pc++ = '[';
+        l_out_pc = m_r_hex32 (l_out_pc, l_ofs_ud);
+        *l_out_pc++ = '.';
+        *l_out_pc++ = '.';
+        l_out_pc = m_r_hex32 (l_out_pc, l_ofs_ud + M_HEX_ROW_SIZE - 1);
+        *l_out_pc++ = ']';
+        l_out_pc = m_r_hex_row (
+            l_out_pc,
+            l_data_puc + l_ofs_ud,
+            (p_size_ud - l_ofs_ud < M_HEX_ROW_SIZE) ? p_size_ud - l_ofs_ud : M_HEX_ROW_SIZE);
+        l_batch_pz->used_ud = (size_t)(l_out_pc - l_batch_pz->buf_ac);
+        m_r_batch_end_line (l_batch_pz);
+    }//for each row
+    m_r_batch_flush (l_batch_pz);
 }/*log_r_hex()*/
 
 extern const char* log_r_level_text (
@@ -100,3 +328,692 @@ extern const char* log_r_level_text (
             return "UNKNOWN";
     }
 }/*log_r_level_text()*/
+
+extern int log_r_set_level (
+    const char*                       p_module_pc,
+    const log_level_e                 p_level_e)
+{
+    pthread_mutex_lock (&m_d_mutex_z);
+    m_r_read_env ();
+    int l_result_d = m_r_set_level (p_module_pc, (p_module_pc == NULL) ? 0 : strlen (p_module_pc), p_level_e);
+    pthread_mutex_unlock (&m_d_mutex_z);
+    return l_result_d;
+}/*log_r_set_level()*/
+
+extern int log_r_config (
+    const char*                       p_config_pc)
+{
+    pthread_mutex_lock (&m_d_mutex_z);
+    m_r_read_env ();
+    int l_result_d = m_r_config (p_config_pc);
+    pthread_mutex_unlock (&m_d_mutex_z);
+    return l_result_d;
+}/*log_r_config()*/
+
+extern log_level_e log_r_module_level (
+          log_module_t*               p_module_pz)
+{
+    pthread_mutex_lock (&m_d_mutex_z);
+    m_r_read_env ();
+    log_level_e l_level_e = m_d_default_level_e;
+    for (unsigned int l_idx_ud = 0; l_idx_ud < m_d_nr_modules_ud; l_idx_ud++) {
+        if (strcmp (m_d_module_az[l_idx_ud].name_ac, p_module_pz->name_pc) == 0) {
+            l_level_e = m_d_module_az[l_idx_ud].level_e;
+            break;
+        }
+    }
+    p_module_pz->level_e       = l_level_e;
+    p_module_pz->generation_ud = log_d_generation_ud;
+    pthread_mutex_unlock (&m_d_mutex_z);
+    return l_level_e;
+}/*log_r_module_level()*/
+
+extern int log_r_start_deferred (
+    const uint32_t                    p_ring_size_ud)
+{
+    if (  (p_ring_size_ud < M_RING_MIN_SIZE)
+       || ((p_ring_size_ud & (p_ring_size_ud - 1)) != 0))
+        return -1;
+
+    pthread_mutex_lock (&m_d_rings_mutex_z);
+    if (m_d_deferred_d) {
+        pthread_mutex_unlock (&m_d_rings_mutex_z);
+        return -1;
+    }
+    m_d_ring_size_ud = p_ring_size_ud;
+    m_d_start_ns_ud    = m_r_now_ns ();
+    m_d_start_ticks_ud = M_NOW_TICKS ();
+    m_d_stop_d       = 0;
+    if (pthread_create (&m_d_drain_thread_z, NULL, m_r_drain_thread, NULL) != 0) {
+        pthread_mutex_unlock (&m_d_rings_mutex_z);
+        return -1;
+    }
+    __atomic_store_n (&m_d_deferred_d, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock (&m_d_rings_mutex_z);
+    return 0;
+}/*log_r_start_deferred()*/
+
+extern void log_r_flush (void)
+{
+    if (__atomic_load_n (&m_d_deferred_d, __ATOMIC_ACQUIRE))
+        m_r_drain ();
+}/*log_r_flush()*/
+
+extern void log_r_stop_deferred (void)
+{
+    if (!__atomic_load_n (&m_d_deferred_d, __ATOMIC_ACQUIRE))
+        return;
+    __atomic_store_n (&m_d_deferred_d, 0, __ATOMIC_RELEASE);
+    __atomic_store_n (&m_d_stop_d, 1, __ATOMIC_RELEASE);
+    pthread_join (m_d_drain_thread_z, NULL);
+    m_r_drain ();
+}/*log_r_stop_deferred()*/
+
+extern uint64_t log_r_get_dropped (void)
+{
+    pthread_mutex_lock (&m_d_rings_mutex_z);
+    uint64_t l_dropped_ud = m_d_freed_dropped_ud;
+    for (m_ring_t* l_ring_pz = m_d_rings_pz; l_ring_pz != NULL; l_ring_pz = l_ring_pz->next_pz)
+        l_dropped_ud += __atomic_load_n (&l_ring_pz->dropped_ud, __ATOMIC_RELAXED);
+    pthread_mutex_unlock (&m_d_rings_mutex_z);
+    return l_dropped_ud;
+}/*log_r_get_dropped()*/
+
+extern int log_r_set_sink_fd (
+    const int                         p_fd_d)
+{
+    if (p_fd_d < 0)
+        return -1;
+    pthread_mutex_lock (&m_d_sink_mutex_z);
+    if (m_d_sink_path_ac[0] != '\0')
+        close (m_d_sink_fd_d);
+    m_d_sink_path_ac[0]  = '\0';
+    m_d_sink_fd_d        = p_fd_d;
+    m_d_sink_max_size_ud = 0;
+    pthread_mutex_unlock (&m_d_sink_mutex_z);
+    return 0;
+}/*log_r_set_sink_fd()*/
+
+extern int log_r_set_sink_file (
+    const char*                       p_path_pc,
+    const uint64_t                    p_max_size_ud,
+    const uint32_t                    p_nr_files_ud)
+{
+    if (  (p_path_pc == NULL)
+       || (strlen (p_path_pc) >= M_SINK_PATH_SIZE))
+        return -1;
+    int l_fd_d = open (p_path_pc, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (l_fd_d < 0)
+        return -1;
+    struct stat                 l_stat_z;
+    if (fstat (l_fd_d, &l_stat_z) != 0) {
+        close (l_fd_d);
+        return -1;
+    }
+
+    pthread_mutex_lock (&m_d_sink_mutex_z);
+    if (m_d_sink_path_ac[0] != '\0')
+        close (m_d_sink_fd_d);
+    strcpy (m_d_sink_path_ac, p_path_pc);
+    m_d_sink_fd_d        = l_fd_d;
+    m_d_sink_size_ud     = (uint64_t)l_stat_z.st_size;
+    m_d_sink_max_size_ud = p_max_size_ud;
+    m_d_sink_nr_files_ud = p_nr_files_ud;
+    pthread_mutex_unlock (&m_d_sink_mutex_z);
+    return 0;
+}/*log_r_set_sink_file()*/
+
+
+//apply LOG_LEVEL once, before any other level is set
+static void m_r_read_env (void)
+{
+    if (m_d_env_read_d)
+        return;
+    m_d_env_read_d = 1;
+    const char* l_env_pc = getenv ("LOG_LEVEL");
+    if (  (l_env_pc != NULL)
+       && (m_r_config (l_env_pc) != 0))
+        fprintf (stderr, "LOG_LEVEL=\"%s\" is not valid, expected e.g. \"info,hl_blocks=debug\"\n", l_env_pc);
+}/*m_r_read_env()*/
+
+static int m_r_set_level (
+    const char*                       p_module_pc,
+    const size_t                      p_module_len_ud,
+    const log_level_e                 p_level_e)
+{
+    if (p_module_pc == NULL) {
+        m_d_default_level_e = p_level_e;
+        log_d_generation_ud ++;
+        return 0;
+    }
+    if (p_module_len_ud >= M_MODULE_NAME_SIZE)
+        return -1;
+
+    unsigned int l_idx_ud = 0;
+    while (  (l_idx_ud < m_d_nr_modules_ud)
+          && (  (strlen (m_d_module_az[l_idx_ud].name_ac) != p_module_len_ud)
+             || (strncmp (m_d_module_az[l_idx_ud].name_ac, p_module_pc, p_module_len_ud) != 0)))
+        l_idx_ud ++;
+    if (l_idx_ud == m_d_nr_modules_ud) {
+        if (m_d_nr_modules_ud >= M_MAX_MODULES)
+            return -1;
+        memcpy (m_d_module_az[l_idx_ud].name_ac, p_module_pc, p_module_len_ud);
+        m_d_module_az[l_idx_ud].name_ac[p_module_len_ud] = '\0';
+        m_d_nr_modules_ud ++;
+    }
+    m_d_module_az[l_idx_ud].level_e = p_level_e;
+    log_d_generation_ud ++;
+    return 0;
+}/*m_r_set_level()*/
+
+//level name or 0..4
+static int m_r_parse_level (
+    const char*                       p_text_pc,
+    const size_t                      p_len_ud,
+          log_level_e*                p_level_pe)
+{
+    static const char* const l_names_apc[] = {"error", "warning", "info", "debug", "trace"};
+    for (int l_level_d = LOG_K_LEVEL_ERROR; l_level_d <= LOG_K_LEVEL_TRACE; l_level_d++) {
+        if (  (  (p_len_ud == strlen (l_names_apc[l_level_d]))
+              && (strncasecmp (p_text_pc, l_names_apc[l_level_d], p_len_ud) == 0))
+           || (  (p_len_ud == 1)
+              && (p_text_pc[0] == '0' + l_level_d))) {
+            *p_level_pe = (log_level_e)l_level_d;
+            return 0;
+        }
+    }
+    return -1;
+}/*m_r_parse_level()*/
+
+static int m_r_config (
+    const char*                       p_config_pc)
+{
+    int l_result_d = 0;
+    const char* l_part_pc = p_config_pc;
+    while (*l_part_pc != '\0') {
+        size_t l_len_ud = strcspn (l_part_pc, ",");
+        const char* l_equal_pc = memchr (l_part_pc, '=', l_len_ud);
+        log_level_e l_level_e;
+        if (l_equal_pc == NULL) {
+            if (m_r_parse_level (l_part_pc, l_len_ud, &l_level_e) == 0)
+                m_r_set_level (NULL, 0, l_level_e);
+            else
+                l_result_d = -1;
+        } else {
+            size_t l_name_len_ud = (size_t)(l_equal_pc - l_part_pc);
+            if (  (m_r_parse_level (l_equal_pc + 1, l_len_ud - l_name_len_ud - 1, &l_level_e) != 0)
+               || (m_r_set_level (l_part_pc, l_name_len_ud, l_level_e) != 0))
+                l_result_d = -1;
+        }
+        l_part_pc += l_len_ud;
+        if (*l_part_pc == ',')
+            l_part_pc ++;
+    }/*while more parts*/
+    return l_result_d;
+}/*m_r_config()*/
+
+static void m_r_vwrite (
+    const char*                       p_file_pc,
+    const int                         p_line_d,
+    const log_level_e                 p_level_e,
+    const char*                       p_format_pc,
+          va_list*                    p_va_list_pz)
+{
+    m_batch_t* l_batch_pz = m_r_batch_line ();
+    m_r_batch_printf (l_batch_pz, "%5.5s %30.30s(%5d): ",
+        log_r_level_text (p_level_e),
+        p_file_pc,
+        p_line_d);
+    m_r_batch_vprintf (l_batch_pz, p_format_pc, p_va_list_pz);
+    m_r_batch_end_line (l_batch_pz);
+    m_r_batch_flush (l_batch_pz);
+}/*m_r_vwrite()*/
+
+
+//keep the argument types of a site, so recording does not parse the format
+//threads may parse the same site at the same time, writing the same types
+static void m_r_parse_site (
+          log_site_t*                 p_site_pz)
+{
+    int                         l_nr_args_d = 0;
+    log_format_spec_t           l_spec_z;
+    const char*                 l_next_pc = p_site_pz->format_pc;
+    while ((l_next_pc = log_format_r_next_spec (l_next_pc, &l_spec_z)) != NULL) {
+        if (l_spec_z.type_e == LOG_FORMAT_K_ARG_NONE)
+            continue;
+        if (l_nr_args_d + (int)l_spec_z.nr_stars_ud + 1 > LOG_SITE_MAX_ARGS) {
+            p_site_pz->truncated_d = 1;
+            break;
+        }
+        for (unsigned int l_star_ud = 0; l_star_ud < l_spec_z.nr_stars_ud; l_star_ud++)
+            p_site_pz->arg_type_auc[l_nr_args_d++] = LOG_FORMAT_K_ARG_INT;
+        p_site_pz->arg_type_auc[l_nr_args_d++] = (unsigned char)l_spec_z.type_e;
+    }
+    __atomic_store_n (&p_site_pz->nr_args_d, l_nr_args_d, __ATOMIC_RELEASE);
+}/*m_r_parse_site()*/
+
+
+//copy a message into the ring of this thread, or drop it when full
+static void m_r_record (
+          log_site_t*                 p_site_pz,
+          va_list*                    p_va_list_pz)
+{
+    m_ring_t* l_ring_pz = m_r_get_ring ();
+    if (l_ring_pz == NULL)
+        return;
+    if (__atomic_load_n (&p_site_pz->nr_args_d, __ATOMIC_ACQUIRE) < 0)
+        m_r_parse_site (p_site_pz);
+
+    // reserve the largest record, so it is written straight into the ring,
+    // and skip to the start of the ring when it may not fit before the end
+    uint64_t l_head_ud  = l_ring_pz->head_ud;
+    uint64_t l_tail_ud  = __atomic_load_n (&l_ring_pz->tail_ud, __ATOMIC_ACQUIRE);
+    uint32_t l_ofs_ud   = (uint32_t)(l_head_ud & (l_ring_pz->size_ud - 1));
+    uint32_t l_skip_ud  = (l_ring_pz->size_ud - l_ofs_ud < M_RECORD_MAX_SIZE) ? l_ring_pz->size_ud - l_ofs_ud : 0;
+    if (l_head_ud + l_skip_ud + M_RECORD_MAX_SIZE - l_tail_ud > l_ring_pz->size_ud) {
+        __atomic_store_n (&l_ring_pz->dropped_ud, l_ring_pz->dropped_ud + 1, __ATOMIC_RELAXED);
+        return;
+    }
+    if (l_skip_ud > 0) {
+        if (l_skip_ud >= sizeof (m_record_t)) {
+            m_record_t* l_skip_pz = (m_record_t*)(l_ring_pz->data_auc + l_ofs_ud);
+            l_skip_pz->size_ud = l_skip_ud;
+            l_skip_pz->site_pz = NULL;
+        }
+        l_head_ud += l_skip_ud;
+        l_ofs_ud   = 0;
+    }
+
+    unsigned char*              l_buf_auc = l_ring_pz->data_auc + l_ofs_ud;
+    uint32_t                    l_size_ud = sizeof (m_record_t);
+    uint32_t                    l_nr_args_ud = (uint32_t)p_site_pz->nr_args_d;
+    for (uint32_t l_arg_idx_ud = 0; l_arg_idx_ud < l_nr_args_ud; l_arg_idx_ud++) {
+        log_format_arg_e        l_type_e = (log_format_arg_e)p_site_pz->arg_type_auc[l_arg_idx_ud];
+        log_format_value_t      l_value_z;
+        log_format_r_get_arg (p_va_list_pz, l_type_e, &l_value_z);
+        if (l_type_e == LOG_FORMAT_K_ARG_STR) {
+            // copy what fits, the caller's string may be gone when formatted
+            // leaving room for the rest of the args and the alignment
+            uint32_t l_len_ud = (uint32_t)strnlen (l_value_z.str_pc, M_RECORD_MAX_SIZE - l_size_ud - 4 - 7
+                                                     - (l_nr_args_ud - l_arg_idx_ud - 1) * 16);
+            memcpy (l_buf_auc + l_size_ud, &l_len_ud, 4);
+            memcpy (l_buf_auc + l_size_ud + 4, l_value_z.str_pc, l_len_ud);
+            l_size_ud = M_ALIGN8 (l_size_ud + 4 + l_len_ud);
+        } else if (l_type_e == LOG_FORMAT_K_ARG_LDOUBLE) {
+            memcpy (l_buf_auc + l_size_ud, &l_value_z, 16);
+            l_size_ud += 16;
+        } else {
+            memcpy (l_buf_auc + l_size_ud, &l_value_z, 8);
+            l_size_ud += 8;
+        }
+    }/*for each arg*/
+
+    m_record_t*                 l_record_pz = (m_record_t*)l_buf_auc;
+    l_record_pz->size_ud       = l_size_ud;
+    l_record_pz->nr_args_ud    = l_nr_args_ud;
+    l_record_pz->site_pz       = p_site_pz;
+    l_record_pz->time_ticks_ud = M_NOW_TICKS ();
+    __atomic_store_n (&l_ring_pz->head_ud, l_head_ud + l_size_ud, __ATOMIC_RELEASE);
+}/*m_r_record()*/
+
+
+//ring of this thread, made on first use
+static m_ring_t* m_r_get_ring (void)
+{
+    if (m_d_ring_pz != NULL)
+        return m_d_ring_pz;
+
+    m_ring_t* l_ring_pz = (m_ring_t*)aligned_alloc (64, sizeof (m_ring_t));
+    if (l_ring_pz == NULL)
+        return NULL;
+    memset (l_ring_pz, 0, sizeof (m_ring_t));
+    l_ring_pz->size_ud  = m_d_ring_size_ud;
+    l_ring_pz->data_auc = (unsigned char*)aligned_alloc (64, l_ring_pz->size_ud);
+    if (l_ring_pz->data_auc == NULL) {
+        free (l_ring_pz);
+        return NULL;
+    }
+
+    pthread_once (&m_d_ring_key_once_z, m_r_make_ring_key);
+    pthread_setspecific (m_d_ring_key_z, l_ring_pz);
+    pthread_mutex_lock (&m_d_rings_mutex_z);
+    l_ring_pz->next_pz = m_d_rings_pz;
+    m_d_rings_pz       = l_ring_pz;
+    pthread_mutex_unlock (&m_d_rings_mutex_z);
+    m_d_ring_pz = l_ring_pz;
+    return l_ring_pz;
+}/*m_r_get_ring()*/
+
+
+static void m_r_make_ring_key (void)
+{
+    pthread_key_create (&m_d_ring_key_z, m_r_close_ring);
+}/*m_r_make_ring_key()*/
+
+
+//called when a thread exits, the ring is freed once drained
+static void m_r_close_ring (
+          void*                       p_ring_p)
+{
+    __atomic_store_n (&((m_ring_t*)p_ring_p)->closed_d, 1, __ATOMIC_RELEASE);
+    m_d_ring_pz = NULL;
+}/*m_r_close_ring()*/
+
+
+static uint64_t m_r_now_ns (void)
+{
+    struct timespec             l_now_z;
+    clock_gettime (CLOCK_MONOTONIC, &l_now_z);
+    return (uint64_t)l_now_z.tv_sec * 1000000000ULL + (uint64_t)l_now_z.tv_nsec;
+}/*m_r_now_ns()*/
+
+
+static void* m_r_drain_thread (
+          void*                       p_arg_p)
+{
+    (void)p_arg_p;
+    while (!__atomic_load_n (&m_d_stop_d, __ATOMIC_ACQUIRE)) {
+        if (m_r_drain () == 0) {
+            struct timespec     l_sleep_z = {0, M_DRAIN_SLEEP_NS};
+            nanosleep (&l_sleep_z, NULL);
+        }
+    }
+    return NULL;
+}/*m_r_drain_thread()*/
+
+
+//format all records, oldest first over all rings, and free the rings
+//of threads that exited
+//return nr of records formatted
+static int m_r_drain (void)
+{
+    int                         l_nr_d = 0;
+    pthread_mutex_lock (&m_d_rings_mutex_z);
+    uint64_t l_ticks_ud = M_NOW_TICKS () - m_d_start_ticks_ud;
+    if (l_ticks_ud > 0)
+        m_d_ns_per_tick_f = (double)(m_r_now_ns () - m_d_start_ns_ud) / (double)l_ticks_ud;
+    while (1) {
+        m_ring_t*               l_oldest_ring_pz = NULL;
+        const m_record_t*       l_oldest_pz = NULL;
+        for (m_ring_t* l_ring_pz = m_d_rings_pz; l_ring_pz != NULL; l_ring_pz = l_ring_pz->next_pz) {
+            const m_record_t* l_record_pz = m_r_peek (l_ring_pz);
+            if (  (l_record_pz != NULL)
+               && (  (l_oldest_pz == NULL)
+                  || (l_record_pz->time_ticks_ud < l_oldest_pz->time_ticks_ud))) {
+                l_oldest_ring_pz = l_ring_pz;
+                l_oldest_pz      = l_record_pz;
+            }
+        }
+        if (l_oldest_pz == NULL)
+            break;
+        m_r_print_record (l_oldest_pz);
+        __atomic_store_n (&l_oldest_ring_pz->tail_ud, l_oldest_ring_pz->tail_ud + l_oldest_pz->size_ud, __ATOMIC_RELEASE);
+        l_nr_d ++;
+    }/*while more records*/
+
+    m_ring_t**                  l_link_ppz = &m_d_rings_pz;
+    while (*l_link_ppz != NULL) {
+        m_ring_t* l_ring_pz = *l_link_ppz;
+        uint64_t l_dropped_ud = __atomic_load_n (&l_ring_pz->dropped_ud, __ATOMIC_RELAXED);
+        if (l_dropped_ud != l_ring_pz->reported_ud) {
+            m_batch_t* l_batch_pz = m_r_batch_line ();
+            m_r_batch_printf (l_batch_pz, "WARNING %30.30s(%5d): dropped %" PRIu64 " messages, log ring full",
+                __FILE__, __LINE__, l_dropped_ud - l_ring_pz->reported_ud);
+            m_r_batch_end_line (l_batch_pz);
+            l_ring_pz->reported_ud = l_dropped_ud;
+        }
+        if (  (__atomic_load_n (&l_ring_pz->closed_d, __ATOMIC_ACQUIRE))
+           && (m_r_peek (l_ring_pz) == NULL)) {
+            *l_link_ppz = l_ring_pz->next_pz;
+            m_d_freed_dropped_ud += l_dropped_ud;
+            free (l_ring_pz->data_auc);
+            free (l_ring_pz);
+            continue;
+        }
+        l_link_ppz = &l_ring_pz->next_pz;
+    }
+    m_r_batch_flush (&m_d_batch_z);
+    pthread_mutex_unlock (&m_d_rings_mutex_z);
+    return l_nr_d;
+}/*m_r_drain()*/
+
+
+//oldest record in a ring, or NULL when empty
+static const m_record_t* m_r_peek (
+          m_ring_t*                   p_ring_pz)
+{
+    uint64_t l_head_ud = __atomic_load_n (&p_ring_pz->head_ud, __ATOMIC_ACQUIRE);
+    while (p_ring_pz->tail_ud != l_head_ud) {
+        uint32_t l_ofs_ud  = (uint32_t)(p_ring_pz->tail_ud & (p_ring_pz->size_ud - 1));
+        uint32_t l_rest_ud = p_ring_pz->size_ud - l_ofs_ud;
+        const m_record_t* l_record_pz = (const m_record_t*)(p_ring_pz->data_auc + l_ofs_ud);
+        if (  (l_rest_ud >= sizeof (m_record_t))
+           && (l_record_pz->site_pz != NULL))
+            return l_record_pz;
+        // skip to the start of the ring
+        __atomic_store_n (&p_ring_pz->tail_ud, p_ring_pz->tail_ud + l_rest_ud, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}/*m_r_peek()*/
+
+
+static void m_r_print_record (
+    const m_record_t*                 p_record_pz)
+{
+    const log_site_t*           l_site_pz = p_record_pz->site_pz;
+    uint64_t                    l_time_ns_ud = 0;
+    if (p_record_pz->time_ticks_ud > m_d_start_ticks_ud)
+        l_time_ns_ud = (uint64_t)((double)(p_record_pz->time_ticks_ud - m_d_start_ticks_ud) * m_d_ns_per_tick_f);
+    m_batch_t* l_batch_pz = m_r_batch_line ();
+    m_r_batch_printf (l_batch_pz, "%5" PRIu64 ".%06" PRIu64 " %5.5s %30.30s(%5d): ",
+        (uint64_t)(l_time_ns_ud / 1000000000ULL),
+        (uint64_t)((l_time_ns_ud / 1000ULL) % 1000000ULL),
+        log_r_level_text (l_site_pz->level_e),
+        l_site_pz->file_pc,
+        l_site_pz->line_d);
+    m_record_print_t            l_print_z = {p_record_pz, (const unsigned char*)(p_record_pz + 1), 0, 0};
+    size_t l_free_ud = l_batch_pz->line_ud + M_LINE_MAX_SIZE - l_batch_pz->used_ud;
+    l_batch_pz->used_ud += log_format_r_snprint (
+        l_batch_pz->buf_ac + l_batch_pz->used_ud,
+        l_free_ud,
+        l_site_pz->format_pc,
+        m_r_next_record_arg,
+        &l_print_z);
+    if (  (!l_print_z.ran_out_d)
+       && (l_site_pz->truncated_d))
+        m_r_batch_printf (l_batch_pz, " (args truncated)");
+    m_r_batch_end_line (l_batch_pz);
+}/*m_r_print_record()*/
+
+
+//next argument of the record being printed
+static int m_r_next_record_arg (
+          void*                       p_context_p,
+    const log_format_arg_e            p_type_e,
+          log_format_value_t*         p_value_pz)
+{
+    m_record_print_t* l_print_pz = (m_record_print_t*)p_context_p;
+    if (l_print_pz->arg_idx_ud >= l_print_pz->record_pz->nr_args_ud) {
+        l_print_pz->ran_out_d = 1;
+        return -1;
+    }
+    l_print_pz->arg_idx_ud ++;
+
+    if (p_type_e == LOG_FORMAT_K_ARG_STR) {
+        // print from a copy with a terminator, the chars are not terminated in the record
+        static _Thread_local char l_str_ac[M_RECORD_MAX_SIZE];
+        uint32_t l_len_ud;
+        memcpy (&l_len_ud, l_print_pz->next_auc, 4);
+        memcpy (l_str_ac, l_print_pz->next_auc + 4, l_len_ud);
+        l_str_ac[l_len_ud] = '\0';
+        p_value_pz->str_pc = l_str_ac;
+        l_print_pz->next_auc += M_ALIGN8 (4 + l_len_ud);
+    } else {
+        uint32_t l_arg_size_ud = (p_type_e == LOG_FORMAT_K_ARG_LDOUBLE) ? 16 : 8;
+        memcpy (p_value_pz, l_print_pz->next_auc, l_arg_size_ud);
+        l_print_pz->next_auc += l_arg_size_ud;
+    }
+    return 0;
+}/*m_r_next_record_arg()*/
+
+
+//start a line in the batch of this thread, after writing the batch
+//when a line may not fit
+static m_batch_t* m_r_batch_line (void)
+{
+    m_batch_t* l_batch_pz = &m_d_batch_z;
+    if (M_BATCH_SIZE - l_batch_pz->used_ud < M_LINE_MAX_SIZE)
+        m_r_batch_flush (l_batch_pz);
+    l_batch_pz->line_ud = l_batch_pz->used_ud;
+    return l_batch_pz;
+}/*m_r_batch_line()*/
+
+
+static void m_r_batch_printf (
+          m_batch_t*                  p_batch_pz,
+    const char*                       p_format_pc,
+          ...)
+{
+    va_list                     l_va_list_z;
+    va_start (l_va_list_z, p_format_pc);
+    m_r_batch_vprintf (p_batch_pz, p_format_pc, &l_va_list_z);
+    va_end (l_va_list_z);
+}/*m_r_batch_printf()*/
+
+
+//add to the current line, truncated to M_LINE_MAX_SIZE incl the newline
+static void m_r_batch_vprintf (
+          m_batch_t*                  p_batch_pz,
+    const char*                       p_format_pc,
+          va_list*                    p_va_list_pz)
+{
+    size_t l_free_ud = p_batch_pz->line_ud + M_LINE_MAX_SIZE - p_batch_pz->used_ud;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    int l_len_d = vsnprintf (p_batch_pz->buf_ac + p_batch_pz->used_ud, l_free_ud, p_format_pc, *p_va_list_pz);
+#pragma GCC diagnostic pop
+    if (l_len_d > 0)
+        p_batch_pz->used_ud += ((size_t)l_len_d < l_free_ud) ? (size_t)l_len_d : l_free_ud - 1;
+}/*m_r_batch_vprintf()*/
+
+
+static void m_r_batch_end_line (
+          m_batch_t*                  p_batch_pz)
+{
+    p_batch_pz->buf_ac[p_batch_pz->used_ud++] = '\n';
+}/*m_r_batch_end_line()*/
+
+
+static void m_r_batch_flush (
+          m_batch_t*                  p_batch_pz)
+{
+    if (p_batch_pz->used_ud == 0)
+        return;
+    m_r_sink_write (p_batch_pz->buf_ac, p_batch_pz->used_ud);
+    p_batch_pz->used_ud = 0;
+    p_batch_pz->line_ud = 0;
+}/*m_r_batch_flush()*/
+
+
+//write whole lines with one write(), so lines of threads never mix
+static void m_r_sink_write (
+    const char*                       p_data_pc,
+    const size_t                      p_size_ud)
+{
+    pthread_mutex_lock (&m_d_sink_mutex_z);
+    if (  (m_d_sink_max_size_ud > 0)
+       && (m_d_sink_size_ud > 0)
+       && (m_d_sink_size_ud + p_size_ud > m_d_sink_max_size_ud))
+        m_r_sink_rotate ();
+
+    size_t l_done_ud = 0;
+    while (l_done_ud < p_size_ud) {
+        ssize_t l_len_d = write (m_d_sink_fd_d, p_data_pc + l_done_ud, p_size_ud - l_done_ud);
+        if (l_len_d < 0) {
+            if (errno == EINTR)
+                continue;
+            break;  //nowhere to report it
+        }
+        l_done_ud += (size_t)l_len_d;
+    }
+    m_d_sink_size_ud += l_done_ud;
+    pthread_mutex_unlock (&m_d_sink_mutex_z);
+}/*m_r_sink_write()*/
+
+
+//keep the last m_d_sink_nr_files_ud files as <path>.1 (newest) .. <path>.N
+//and start an empty file, called with m_d_sink_mutex_z locked
+static void m_r_sink_rotate (void)
+{
+    char                        l_from_ac[M_SINK_PATH_SIZE + 12];  //room for ".<nr>"
+    char                        l_to_ac[M_SINK_PATH_SIZE + 12];
+    close (m_d_sink_fd_d);
+    for (uint32_t l_nr_ud = m_d_sink_nr_files_ud; l_nr_ud > 0; l_nr_ud--) {
+        if (l_nr_ud > 1)
+            snprintf (l_from_ac, sizeof (l_from_ac), "%s.%u", m_d_sink_path_ac, l_nr_ud - 1);
+        else
+            snprintf (l_from_ac, sizeof (l_from_ac), "%s", m_d_sink_path_ac);
+        snprintf (l_to_ac, sizeof (l_to_ac), "%s.%u", m_d_sink_path_ac, l_nr_ud);
+        rename (l_from_ac, l_to_ac);
+    }
+    m_d_sink_fd_d = open (m_d_sink_path_ac, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (m_d_sink_fd_d < 0) {
+        //keep logging somewhere
+        m_d_sink_fd_d = 2;
+        m_d_sink_path_ac[0] = '\0';
+        m_d_sink_max_size_ud = 0;
+    }
+    m_d_sink_size_ud = 0;
+}/*m_r_sink_rotate()*/
+
+
+//" XX" for each byte, " .." for missing bytes, then " | " and the
+//printable chars, or '.' for the others
+//return the end of the row
+static char* m_r_hex_row (
+          char*                       p_out_pc,
+    const unsigned char*              p_data_puc,
+    const uint32_t                    p_size_ud)
+{
+    char*                       l_out_pc = p_out_pc;
+    for (uint32_t i = 0; i < M_HEX_ROW_SIZE; i ++) {
+        l_out_pc[0] = ' ';
+        if (i < p_size_ud)
+            memcpy (l_out_pc + 1, &m_d_hex_upper_ac[2 * p_data_puc[i]], 2);
+        else
+            memcpy (l_out_pc + 1, "..", 2);
+        l_out_pc += 3;
+    }
+    memcpy (l_out_pc, " | ", 3);
+    l_out_pc += 3;
+#if defined(__SSE2__)
+    if (p_size_ud == M_HEX_ROW_SIZE) {
+        // printable is 0x20..0x7e, bytes >= 0x80 are negative when signed
+        __m128i l_data_z  = _mm_loadu_si128 ((const __m128i*)p_data_puc);
+        __m128i l_print_z = _mm_and_si128 (
+            _mm_cmpgt_epi8 (l_data_z, _mm_set1_epi8 (0x1f)),
+            _mm_cmplt_epi8 (l_data_z, _mm_set1_epi8 (0x7f)));
+        __m128i l_text_z  = _mm_or_si128 (
+            _mm_and_si128 (l_print_z, l_data_z),
+            _mm_andnot_si128 (l_print_z, _mm_set1_epi8 ('.')));
+        _mm_storeu_si128 ((__m128i*)l_out_pc, l_text_z);
+        return l_out_pc + M_HEX_ROW_SIZE;
+    }
+#endif
+    for (uint32_t i = 0; i < p_size_ud; i ++)
+        *l_out_pc++ = ((p_data_puc[i] >= 0x20) && (p_data_puc[i] < 0x7f)) ? (char)p_data_puc[i] : '.';
+    return l_out_pc;
+}/*m_r_hex_row()*/
+
+
+//8 lower case hex digits, like "%08x"
+static char* m_r_hex32 (
+          char*                       p_out_pc,
+    const uint32_t                    p_value_ud)
+{
+    memcpy (p_out_pc,     &m_d_hex_lower_ac[2 * (p_value_ud >> 24)], 2);
+    memcpy (p_out_pc + 2, &m_d_hex_lower_ac[2 * ((p_value_ud >> 16) & 0xff)], 2);
+    memcpy (p_out_pc + 4, &m_d_hex_lower_ac[2 * ((p_value_ud >> 8) & 0xff)], 2);
+    memcpy (p_out_pc + 6, &m_d_hex_lower_ac[2 * (p_value_ud & 0xff)], 2);
+    return p_out_pc + 8;
+}/*m_r_hex32()*/
@@ -3,13 +3,34 @@
 
 #include <inttypes.h>
 
-#define ERROR_LOG(format, args...)   log_r_write (__FILE__, __LINE__, LOG_K_LEVEL_ERROR, format, ##args)
-#define WARNING(format, args...) log_r_write (__FILE__, __LINE__, LOG_K_LEVEL_WARNING, format, ##args)
-#define INFO(format, args...)    log_r_write (__FILE__, __LINE__, LOG_K_LEVEL_INFO, format, ##args)
-#define DEBUG(format, args...)   log_r_write (__FILE__, __LINE__, LOG_K_LEVEL_DEBUG, format, ##args)
-#define TRACE(format, args...)   log_r_write (__FILE__, __LINE__, LOG_K_LEVEL_TRACE, format, ##args)
+/*
+ * Log levels are filtered in two steps:
+ *
+ * - At compile time: levels above LOG_MIN_LEVEL compile to nothing, e.g.
+ *   -DLOG_MIN_LEVEL=2 for a production build with only ERROR, WARNING, INFO.
+ *   0=ERROR, 1=WARNING, 2=INFO, 3=DEBUG, 4=TRACE (default).
+ *
+ * - At run time: per module, checked before the arguments are evaluated.
+ *   A module is a .c file that defines LOG_MODULE before including log.h,
+ *   else it is "main". The levels are read from the environment on first
+ *   use, e.g. LOG_LEVEL=debug or LOG_LEVEL=warning,hl_blocks=trace,
+ *   or set with log_r_set_level(). The default is INFO.
+ *
+ * Messages are formatted on the calling thread, or after
+ * log_r_start_deferred() only recorded as binary in a ring of the calling
+ * thread, and formatted later by a background thread.
+ *
+ * Formatted lines are collected in a buffer of the formatting thread and
+ * written to the sink, stderr by default, with one write() per message or
+ * per batch of deferred messages, so lines of threads never mix.
+ */
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL           4
+#endif
 
-#define DEBUG_HEX(title, data, size)    log_r_hex(__FILE__, __LINE__, LOG_K_LEVEL_DEBUG, title, data, size)
+#ifndef LOG_MODULE
+#define LOG_MODULE              "main"
+#endif
 
 typedef enum log_level_enum_s {
     LOG_K_LEVEL_ERROR,
@@ -19,6 +40,81 @@ typedef enum log_level_enum_s {
     LOG_K_LEVEL_TRACE,
 } log_level_e;
 
+// run time level of a module, resolved again after each level change
+typedef struct log_module_s {
+    const char*                 name_pc;
+    log_level_e                 level_e;
+    unsigned int                generation_ud;  //log_d_generation_ud when resolved, 0=never
+} log_module_t;
+
+#define LOG_SITE_MAX_ARGS       8       //args kept per deferred message, incl * width/precision
+
+// one log macro in the code, its address identifies the format in a
+// deferred record, and it keeps the argument types after the first use
+typedef struct log_site_s {
+    const char*                 file_pc;
+    int                         line_d;
+    log_level_e                 level_e;
+    const char*                 format_pc;
+    int                         nr_args_d;      //-1 until the format was parsed
+    int                         truncated_d;    //1 when the format has more args than kept
+    unsigned char               arg_type_auc[LOG_SITE_MAX_ARGS];   //log_format_arg_e
+} log_site_t;
+
+// incremented on each level change
+extern volatile unsigned int log_d_generation_ud;
+
+// module of each file that includes this header
+static log_module_t m_d_log_module_z __attribute__((unused)) = {LOG_MODULE, LOG_K_LEVEL_ERROR, 0};
+
+#define LOG_ENABLED(level)                                                      \
+    (  ((level) <= LOG_MIN_LEVEL)                                               \
+    && ((m_d_log_module_z.generation_ud == log_d_generation_ud)                 \
+       ? ((level) <= m_d_log_module_z.level_e)                                  \
+       : ((level) <= log_r_module_level (&m_d_log_module_z))))
+
+#define LOG_WRITE(level, format, args...)                                       \
+    do {                                                                        \
+        if (LOG_ENABLED (level)) {                                              \
+            static log_site_t l_log_site_z = {__FILE__, __LINE__, level, format, -1, 0, {0}}; \
+            log_r_write_site (&l_log_site_z, ##args);                           \
+        }                                                                       \
+    } while (0)
+
+#define LOG_NOTHING()           do {} while (0)
+
+#define ERROR_LOG(format, args...)   LOG_WRITE (LOG_K_LEVEL_ERROR, format, ##args)
+
+#if LOG_MIN_LEVEL >= 1
+#define WARNING(format, args...) LOG_WRITE (LOG_K_LEVEL_WARNING, format, ##args)
+#else
+#define WARNING(format, args...) LOG_NOTHING ()
+#endif
+
+#if LOG_MIN_LEVEL >= 2
+#define INFO(format, args...)    LOG_WRITE (LOG_K_LEVEL_INFO, format, ##args)
+#else
+#define INFO(format, args...)    LOG_NOTHING ()
+#endif
+
+#if LOG_MIN_LEVEL >= 3
+#define DEBUG(format, args...)   LOG_WRITE (LOG_K_LEVEL_DEBUG, format, ##args)
+#define DEBUG_HEX(title, data, size)                                            \
+    do {                                                                        \
+        if (LOG_ENABLED (LOG_K_LEVEL_DEBUG))                                    \
+            log_r_hex (__FILE__, __LINE__, LOG_K_LEVEL_DEBUG, title, data, size); \
+    } while (0)
+#else
+#define DEBUG(format, args...)   LOG_NOTHING ()
+#define DEBUG_HEX(title, data, size)    LOG_NOTHING ()
+#endif
+
+#if LOG_MIN_LEVEL >= 4
+#define TRACE(format, args...)   LOG_WRITE (LOG_K_LEVEL_TRACE, format, ##args)
+#else
+#define TRACE(format, args...)   LOG_NOTHING ()
+#endif
+
 extern void log_r_write (
     const char*                       p_file_pc,
     const int                         p_line_d,
@@ -26,6 +122,12 @@ extern void log_r_write (
     const char*                       p_format_pc,
           ...);
 
+// write a message of a log macro, directly or deferred
+extern void log_r_write_site (
+          log_site_t*                 p_site_pz,
+          ...);
+
+// hex dumps are always written directly, also when deferred
 extern void log_r_hex (
     const char*                       p_file_pc,
     const int                         p_line_d,
@@ -37,4 +139,72 @@ extern void log_r_hex (
 extern const char* log_r_level_text (
     const log_level_e                 p_level_e);
 
+// set the run time level of a module, or of all modules without
+// their own level when p_module_pc is NULL
+// return 0 on success, -1 when too many modules have their own level
+extern int log_r_set_level (
+    const char*                       p_module_pc,
+    const log_level_e                 p_level_e);
+
+// set levels from text like "debug" or "warning,hl_blocks=trace,hl_blocks_mmap=info",
+// which is also read from the LOG_LEVEL environment variable on first use
+// return 0 on success, -1 when any part is not valid
+extern int log_r_config (
+    const char*                       p_config_pc);
+
+// resolve the run time level of a module, used by LOG_ENABLED()
+extern log_level_e log_r_module_level (
+          log_module_t*               p_module_pz);
+
+/*
+ * PURPOSE:
+ *     Record messages in a binary ring of each thread that logs, instead of
+ *     formatting them on that thread, and start a thread to format them.
+ *     Recording copies the site, a timestamp and the raw arguments, incl a
+ *     copy of strings. When the ring of a thread is full, its messages are
+ *     dropped and counted until the background thread caught up.
+ *
+ * PARAMETERS:
+ *     p_ring_size_ud           Bytes per thread, power of 2 >= 4096, used for
+ *                              rings made after this call
+ *
+ * RETURN:
+ *     0, or -1 when already started or the size is not valid
+ */
+extern int log_r_start_deferred (
+    const uint32_t                    p_ring_size_ud);
+
+// format all recorded messages now, e.g. before a crash report
+extern void log_r_flush (void);
+
+// flush, stop the background thread and write directly again
+extern void log_r_stop_deferred (void);
+
+// nr of messages dropped because a ring was full
+extern uint64_t log_r_get_dropped (void);
+
+// write the lines to an fd, e.g. 2 for stderr (default), not closed by log
+// return 0, or -1 when not valid
+extern int log_r_set_sink_fd (
+    const int                         p_fd_d);
+
+/*
+ * PURPOSE:
+ *     Append the lines to a file, and rotate it when a write would make it
+ *     larger than p_max_size_ud: the file is renamed to <path>.1, the older
+ *     <path>.1 to <path>.2 and so on, keeping p_nr_files_ud old files.
+ *
+ * PARAMETERS:
+ *     p_path_pc                File to append to, created when missing
+ *     p_max_size_ud            Rotate when larger, 0 to never rotate
+ *     p_nr_files_ud            Nr of old files to keep, 0 to only truncate
+ *
+ * RETURN:
+ *     0, or -1 when the file cannot be opened
+ */
+extern int log_r_set_sink_file (
+    const char*                       p_path_pc,
+    const uint64_t                    p_max_size_ud,
+    const uint32_t                    p_nr_files_ud);
+
 #endif /*_LOG_H_*/
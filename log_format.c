@@ -0,0 +1,298 @@
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "log_format.h"
+#include <string.h>
+
+#define M_SPEC_MAX_SIZE               32    //longest conversion spec printed, e.g. "%-*.*llu"
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+// where to print, a file or else a buffer
+typedef struct m_out_s {
+    FILE*                       file_fp;
+    char*                       buf_pc;
+    size_t                      size_ud;    //of buf_pc, incl the terminator
+    size_t                      used_ud;
+} m_out_t;
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static int m_r_print (
+          m_out_t*                    p_out_pz,
+    const char*                       p_format_pc,
+          log_format_next_arg_r*      p_next_arg_pr,
+          void*                       p_context_p);
+
+static void m_r_out_write (
+          m_out_t*                    p_out_pz,
+    const char*                       p_data_pc,
+    const size_t                      p_size_ud);
+
+static void m_r_out_printf (
+          m_out_t*                    p_out_pz,
+    const char*                       p_format_pc,
+          ...);
+
+static void m_r_print_arg (
+          m_out_t*                    p_out_pz,
+    const char*                       p_spec_pc,
+    const log_format_arg_e            p_type_e,
+    const log_format_value_t*         p_value_pz,
+    const int*                        p_stars_ad,
+    const unsigned int                p_nr_stars_ud);
+
+
+/*****************************************************************************
+ *   P U B L I C   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************/
+
+extern const char* log_format_r_next_spec (
+    const char*                       p_format_pc,
+          log_format_spec_t*          p_spec_pz)
+{
+    const char* l_pc = strchr (p_format_pc, '%');
+    if (l_pc == NULL)
+        return NULL;
+    p_spec_pz->start_pc     = l_pc;
+    p_spec_pz->nr_stars_ud  = 0;
+    p_spec_pz->type_e       = LOG_FORMAT_K_ARG_NONE;
+    l_pc ++;
+
+    // flags, width and precision
+    while ((*l_pc != '\0') && (strchr ("-+ #0123456789.*'", *l_pc) != NULL)) {
+        if (*l_pc == '*')
+            p_spec_pz->nr_stars_ud ++;
+        l_pc ++;
+    }
+
+    // length modifier
+    log_format_arg_e l_int_type_e = LOG_FORMAT_K_ARG_INT;
+    int l_ldouble_d = 0;
+    switch (*l_pc) {
+    case 'h': l_pc += (l_pc[1] == 'h') ? 2 : 1; break;
+    case 'l':
+        if (l_pc[1] == 'l') { l_int_type_e = LOG_FORMAT_K_ARG_LLONG; l_pc += 2; }
+        else                { l_int_type_e = LOG_FORMAT_K_ARG_LONG;  l_pc += 1; }
+        break;
+    case 'z': l_int_type_e = LOG_FORMAT_K_ARG_SIZE;    l_pc ++; break;
+    case 'j': l_int_type_e = LOG_FORMAT_K_ARG_INTMAX;  l_pc ++; break;
+    case 't': l_int_type_e = LOG_FORMAT_K_ARG_PTRDIFF; l_pc ++; break;
+    case 'L': l_ldouble_d = 1;                         l_pc ++; break;
+    default: break;
+    }
+
+    // conversion
+    switch (*l_pc) {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+        p_spec_pz->type_e = l_int_type_e;
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        p_spec_pz->type_e = l_ldouble_d ? LOG_FORMAT_K_ARG_LDOUBLE : LOG_FORMAT_K_ARG_DOUBLE;
+        break;
+    case 'p':
+        p_spec_pz->type_e = LOG_FORMAT_K_ARG_PTR;
+        break;
+    case 's':
+        p_spec_pz->type_e = LOG_FORMAT_K_ARG_STR;
+        break;
+    case '\0':
+        l_pc --;    // do not step over the end
+        break;
+    default:        // "%%" or not supported, e.g. %n, printed as is
+        p_spec_pz->nr_stars_ud = 0;
+        break;
+    }
+    l_pc ++;
+    p_spec_pz->size_ud = (size_t)(l_pc - p_spec_pz->start_pc);
+    return l_pc;
+}/*log_format_r_next_spec()*/
+
+
+extern void log_format_r_get_arg (
+          va_list*                    p_va_list_pz,
+    const log_format_arg_e            p_type_e,
+          log_format_value_t*         p_value_pz)
+{
+    switch (p_type_e) {
+    case LOG_FORMAT_K_ARG_INT:      p_value_pz->d      = va_arg (*p_va_list_pz, int);          break;
+    case LOG_FORMAT_K_ARG_LONG:     p_value_pz->ld     = va_arg (*p_va_list_pz, long);         break;
+    case LOG_FORMAT_K_ARG_LLONG:    p_value_pz->lld    = va_arg (*p_va_list_pz, long long);    break;
+    case LOG_FORMAT_K_ARG_SIZE:     p_value_pz->zu     = va_arg (*p_va_list_pz, size_t);       break;
+    case LOG_FORMAT_K_ARG_INTMAX:   p_value_pz->jd     = va_arg (*p_va_list_pz, intmax_t);     break;
+    case LOG_FORMAT_K_ARG_PTRDIFF:  p_value_pz->td     = va_arg (*p_va_list_pz, ptrdiff_t);    break;
+    case LOG_FORMAT_K_ARG_DOUBLE:   p_value_pz->f      = va_arg (*p_va_list_pz, double);       break;
+    case LOG_FORMAT_K_ARG_LDOUBLE:  p_value_pz->lf     = va_arg (*p_va_list_pz, long double);  break;
+    case LOG_FORMAT_K_ARG_PTR:      p_value_pz->p      = va_arg (*p_va_list_pz, const void*);  break;
+    case LOG_FORMAT_K_ARG_STR:
+        p_value_pz->str_pc = va_arg (*p_va_list_pz, const char*);
+        if (p_value_pz->str_pc == NULL)
+            p_value_pz->str_pc = "(null)";
+        break;
+    default:
+        break;
+    }
+}/*log_format_r_get_arg()*/
+
+
+extern int log_format_r_print (
+          FILE*                       p_file_fp,
+    const char*                       p_format_pc,
+          log_format_next_arg_r*      p_next_arg_pr,
+          void*                       p_context_p)
+{
+    m_out_t                     l_out_z = {p_file_fp, NULL, 0, 0};
+    return m_r_print (&l_out_z, p_format_pc, p_next_arg_pr, p_context_p);
+}/*log_format_r_print()*/
+
+
+extern size_t log_format_r_snprint (
+          char*                       p_buf_pc,
+    const size_t                      p_size_ud,
+    const char*                       p_format_pc,
+          log_format_next_arg_r*      p_next_arg_pr,
+          void*                       p_context_p)
+{
+    if (p_size_ud == 0)
+        return 0;
+    m_out_t                     l_out_z = {NULL, p_buf_pc, p_size_ud, 0};
+    p_buf_pc[0] = '\0';
+    m_r_print (&l_out_z, p_format_pc, p_next_arg_pr, p_context_p);
+    return l_out_z.used_ud;
+}/*log_format_r_snprint()*/
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************/
+
+static int m_r_print (
+          m_out_t*                    p_out_pz,
+    const char*                       p_format_pc,
+          log_format_next_arg_r*      p_next_arg_pr,
+          void*                       p_context_p)
+{
+    const char*                 l_text_pc = p_format_pc;
+    log_format_spec_t           l_spec_z;
+    const char*                 l_next_pc;
+    while ((l_next_pc = log_format_r_next_spec (l_text_pc, &l_spec_z)) != NULL) {
+        m_r_out_write (p_out_pz, l_text_pc, (size_t)(l_spec_z.start_pc - l_text_pc));
+        l_text_pc = l_next_pc;
+
+        char                        l_spec_ac[M_SPEC_MAX_SIZE];
+        if (strncmp (l_spec_z.start_pc, "%%", l_spec_z.size_ud) == 0) {
+            m_r_out_write (p_out_pz, "%", 1);
+            continue;
+        }
+        if (  (l_spec_z.type_e == LOG_FORMAT_K_ARG_NONE)
+           || (l_spec_z.size_ud >= sizeof (l_spec_ac))) {
+            m_r_out_write (p_out_pz, l_spec_z.start_pc, l_spec_z.size_ud);
+            continue;
+        }
+        memcpy (l_spec_ac, l_spec_z.start_pc, l_spec_z.size_ud);
+        l_spec_ac[l_spec_z.size_ud] = '\0';
+
+        int                         l_stars_ad[2] = {0, 0};
+        log_format_value_t          l_value_z;
+        for (unsigned int l_star_ud = 0; l_star_ud < l_spec_z.nr_stars_ud; l_star_ud++) {
+            if (p_next_arg_pr (p_context_p, LOG_FORMAT_K_ARG_INT, &l_value_z) != 0) {
+                m_r_out_write (p_out_pz, "...", 3);
+                return -1;
+            }
+            if (l_star_ud < 2)
+                l_stars_ad[l_star_ud] = l_value_z.d;
+        }
+        if (p_next_arg_pr (p_context_p, l_spec_z.type_e, &l_value_z) != 0) {
+            m_r_out_write (p_out_pz, "...", 3);
+            return -1;
+        }
+        m_r_print_arg (
+            p_out_pz,
+            l_spec_ac,
+            l_spec_z.type_e,
+            &l_value_z,
+            l_stars_ad,
+            l_spec_z.nr_stars_ud);
+    }/*while more conversions*/
+    m_r_out_write (p_out_pz, l_text_pc, strlen (l_text_pc));
+    return 0;
+}/*m_r_print()*/
+
+
+// write to the file, or what fits in the buffer
+static void m_r_out_write (
+          m_out_t*                    p_out_pz,
+    const char*                       p_data_pc,
+    const size_t                      p_size_ud)
+{
+    if (p_out_pz->file_fp != NULL) {
+        fwrite (p_data_pc, 1, p_size_ud, p_out_pz->file_fp);
+        return;
+    }
+    size_t l_size_ud = p_size_ud;
+    if (l_size_ud > p_out_pz->size_ud - 1 - p_out_pz->used_ud)
+        l_size_ud = p_out_pz->size_ud - 1 - p_out_pz->used_ud;
+    memcpy (p_out_pz->buf_pc + p_out_pz->used_ud, p_data_pc, l_size_ud);
+    p_out_pz->used_ud += l_size_ud;
+    p_out_pz->buf_pc[p_out_pz->used_ud] = '\0';
+}/*m_r_out_write()*/
+
+
+static void m_r_out_printf (
+          m_out_t*                    p_out_pz,
+    const char*                       p_format_pc,
+          ...)
+{
+    va_list                     l_va_list_z;
+    va_start (l_va_list_z, p_format_pc);
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wformat-nonliteral"
+    if (p_out_pz->file_fp != NULL) {
+        vfprintf (p_out_pz->file_fp, p_format_pc, l_va_list_z);
+    } else {
+        size_t l_free_ud = p_out_pz->size_ud - p_out_pz->used_ud;
+        int l_len_d = vsnprintf (p_out_pz->buf_pc + p_out_pz->used_ud, l_free_ud, p_format_pc, l_va_list_z);
+        if (l_len_d > 0)
+            p_out_pz->used_ud += ((size_t)l_len_d < l_free_ud) ? (size_t)l_len_d : l_free_ud - 1;
+    }
+#pragma GCC diagnostic pop
+    va_end (l_va_list_z);
+}/*m_r_out_printf()*/
+
+// printf the argument with its conversion spec and * width/precision
+#define M_PRINT_ARG(value)                                                      \
+    switch (p_nr_stars_ud) {                                                    \
+    case 0:  m_r_out_printf (p_out_pz, p_spec_pc, value); break;                \
+    case 1:  m_r_out_printf (p_out_pz, p_spec_pc, p_stars_ad[0], value); break; \
+    default: m_r_out_printf (p_out_pz, p_spec_pc, p_stars_ad[0], p_stars_ad[1], value); break; \
+    }
+
+static void m_r_print_arg (
+          m_out_t*                    p_out_pz,
+    const char*                       p_spec_pc,
+    const log_format_arg_e            p_type_e,
+    const log_format_value_t*         p_value_pz,
+    const int*                        p_stars_ad,
+    const unsigned int                p_nr_stars_ud)
+{
+    switch (p_type_e) {
+    case LOG_FORMAT_K_ARG_INT:      M_PRINT_ARG (p_value_pz->d);      break;
+    case LOG_FORMAT_K_ARG_LONG:     M_PRINT_ARG (p_value_pz->ld);     break;
+    case LOG_FORMAT_K_ARG_LLONG:    M_PRINT_ARG (p_value_pz->lld);    break;
+    case LOG_FORMAT_K_ARG_SIZE:     M_PRINT_ARG (p_value_pz->zu);     break;
+    case LOG_FORMAT_K_ARG_INTMAX:   M_PRINT_ARG (p_value_pz->jd);     break;
+    case LOG_FORMAT_K_ARG_PTRDIFF:  M_PRINT_ARG (p_value_pz->td);     break;
+    case LOG_FORMAT_K_ARG_DOUBLE:   M_PRINT_ARG (p_value_pz->f);      break;
+    case LOG_FORMAT_K_ARG_LDOUBLE:  M_PRINT_ARG (p_value_pz->lf);     break;
+    case LOG_FORMAT_K_ARG_PTR:      M_PRINT_ARG (p_value_pz->p);      break;
+    case LOG_FORMAT_K_ARG_STR:      M_PRINT_ARG (p_value_pz->str_pc); break;
+    default: break;
+    }
+}/*m_r_print_arg()*/
@@ -0,0 +1,130 @@
+#ifndef _LOG_FORMAT_H_
+#define _LOG_FORMAT_H_
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+
+/*****************************************************************************
+ * P U B L I C   D A T A   T Y P E   D E F I N I T I O N S
+ *****************************************************************************/
+
+//type of a printf argument, from the conversion and length modifier
+typedef enum log_format_arg_enum_s {
+    LOG_FORMAT_K_ARG_NONE = 0,  //"%%" or unknown, takes no argument
+    LOG_FORMAT_K_ARG_INT,       //also char and short, promoted to int
+    LOG_FORMAT_K_ARG_LONG,
+    LOG_FORMAT_K_ARG_LLONG,
+    LOG_FORMAT_K_ARG_SIZE,
+    LOG_FORMAT_K_ARG_INTMAX,
+    LOG_FORMAT_K_ARG_PTRDIFF,
+    LOG_FORMAT_K_ARG_DOUBLE,
+    LOG_FORMAT_K_ARG_LDOUBLE,
+    LOG_FORMAT_K_ARG_PTR,
+    LOG_FORMAT_K_ARG_STR,       //copy it when kept, may not exist when printed
+    /*
+     * terminator
+     */
+    LOG_FORMAT_K_ARG_NR_OF
+} log_format_arg_e;
+
+typedef union log_format_value_u {
+    int                         d;
+    long                        ld;
+    long long                   lld;
+    size_t                      zu;
+    intmax_t                    jd;
+    ptrdiff_t                   td;
+    double                      f;
+    long double                 lf;
+    const void*                 p;
+    const char*                 str_pc;
+} log_format_value_t;
+
+//one conversion in a format string
+typedef struct log_format_spec_s {
+    const char*                 start_pc;   //the '%'
+    size_t                      size_ud;    //bytes up to and incl the conversion char
+    unsigned int                nr_stars_ud;//int args for * width/precision before the value
+    log_format_arg_e            type_e;
+} log_format_spec_t;
+
+//give the next kept argument to log_format_r_print()
+//return 0, or -1 when no more arguments were kept
+typedef int (log_format_next_arg_r) (
+          void*                       p_context_p,
+    const log_format_arg_e            p_type_e,
+          log_format_value_t*         p_value_pz);
+
+
+/*****************************************************************************
+ * P U B L I C   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+/*
+ * PURPOSE:
+ *     Find the next conversion in a printf format string, to keep the
+ *     arguments of a message and only format it later.
+ *
+ * PARAMETERS:
+ *     p_format_pc              Format string, or the return of the previous call
+ *     p_spec_pz                Output: the conversion found
+ *
+ * RETURN:
+ *     Format after the conversion, or NULL when there are no more
+ */
+extern const char* log_format_r_next_spec (
+    const char*                       p_format_pc,
+          log_format_spec_t*          p_spec_pz);
+
+/*
+ * PURPOSE:
+ *     Take the next argument of the specified type from a va_list.
+ *     A string is returned as the caller's pointer, copy it to keep it.
+ */
+extern void log_format_r_get_arg (
+          va_list*                    p_va_list_pz,
+    const log_format_arg_e            p_type_e,
+          log_format_value_t*         p_value_pz);
+
+/*
+ * PURPOSE:
+ *     Print a format string with arguments kept earlier.
+ *     Conversions that are not supported, e.g. %n, are printed as is.
+ *
+ * PARAMETERS:
+ *     p_file_fp                Where to print
+ *     p_format_pc              printf format string
+ *     p_next_arg_pr            Called for each argument, incl * width/precision
+ *     p_context_p              Passed to p_next_arg_pr
+ *
+ * RETURN:
+ *     0, or -1 when the arguments ran out and "..." was printed instead of the rest
+ */
+extern int log_format_r_print (
+          FILE*                       p_file_fp,
+    const char*                       p_format_pc,
+          log_format_next_arg_r*      p_next_arg_pr,
+          void*                       p_context_p);
+
+/*
+ * PURPOSE:
+ *     Same as log_format_r_print() into a buffer, truncated to fit.
+ *
+ * RETURN:
+ *     Nr of chars in the buffer, excl the terminator
+ */
+extern size_t log_format_r_snprint (
+          char*                       p_buf_pc,
+    const size_t                      p_size_ud,
+    const char*                       p_format_pc,
+          log_format_next_arg_r*      p_next_arg_pr,
+          void*                       p_context_p);
+
+#endif /*_LOG_FORMAT_H_*/
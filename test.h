@@ -1,4 +1,38 @@
+#ifndef _TEST_H_
+#define _TEST_H_
+
 #include "error_stack.h"
+#include <string.h>
 
 #define TEST(name) \
     static int test_r_##name (void)
+
+#define SAFE_STR(str) ((str) == NULL ? "<null>" : (str))
+
+//compared as long long, so signed and unsigned values of any size
+//can be compared, each evaluated once
+#define _ASSERT_INT_EQ(file, line, expected, actual)                            \
+    do {                                                                        \
+        long long l_assert_expected_ll = (long long)(expected);                 \
+        long long l_assert_actual_ll   = (long long)(actual);                   \
+        if (l_assert_expected_ll != l_assert_actual_ll)                         \
+            return ERROR (-1,                                                   \
+                "assertion failed at %s(%d): expected %lld != %lld actual",     \
+                file, line,                                                     \
+                l_assert_expected_ll, l_assert_actual_ll);                      \
+    } while (0)
+
+#define ASSERT_INT_EQ(expected, actual)                                         \
+    _ASSERT_INT_EQ(__FILE__, __LINE__, expected, actual)
+
+#define _ASSERT_STR_EQ(file, line, expected, actual)                            \
+    if (strcmp (expected, actual) != 0)                                         \
+        return ERROR (-1,                                                       \
+            "assertion failed at %s(%d): expected \"%s\" != \"%s\" actual",     \
+            file, line,                                                         \
+            SAFE_STR(expected), SAFE_STR(actual));                              \
+
+#define ASSERT_STR_EQ(expected, actual)                                         \
+    _ASSERT_STR_EQ(__FILE__, __LINE__, expected, actual)
+
+#endif /*_TEST_H_*/
@@ -0,0 +1,124 @@
+#include "error_stack.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+
+#define M_ERROR_NR_THREADS      4
+
+//what each thread found on its own stack
+typedef struct m_error_thread_s {
+    int                         nr_d;
+    int                         failed_d;
+    error_stack_t*              snapshot_pz;
+} m_error_thread_t;
+
+static void* m_r_error_thread (
+          void*                       p_thread_p);
+
+//arguments are kept when the error is added and formatted when printed,
+//incl strings that no longer exist by then
+TEST(error_stack_format_when_printed) {
+    success ();
+    char                        l_name_ac[16];
+    snprintf (l_name_ac, sizeof (l_name_ac), "blk.bin");
+    error ("a.c", 10, -1, "open %s failed: %d%% of %zu, %5.2f %-4s|%*u|%llx",
+        l_name_ac, 42, (size_t)1000, 3.14159, "ab", 6, 77u, 0x1234567890ULL);
+    memset (l_name_ac, 'x', sizeof (l_name_ac) - 1);
+    error ("b.c", 20, 5, "no args");
+    error ("c.c", 30, 7, "%d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+
+    char                        l_text_ac[512];
+    FILE* l_file_fp = fmemopen (l_text_ac, sizeof (l_text_ac), "w");
+    if (l_file_fp == NULL)
+        return ERROR (-1, "failed to open memory file");
+    error_stack_r_print (l_file_fp);
+    fclose (l_file_fp);
+    success ();
+
+    ASSERT_STR_EQ (
+        "  ERR[2]: c.c(30): 1 2 3 4 5 6 7 8 ...\n"
+        "  ERR[1]: b.c(20): no args\n"
+        "  ERR[0]: a.c(10): open blk.bin failed: 42% of 1000,  3.14 ab  |    77|1234567890\n",
+        l_text_ac);
+    return SUCCESS ();
+}//TEST()
+
+//threads have their own stack, and a failed thread passes its stack
+//to the thread that joins it
+TEST(error_stack_per_thread_and_propagate) {
+    success ();
+    error ("main.c", 1, -1, "main before threads");
+
+    pthread_t                   l_thread_az[M_ERROR_NR_THREADS];
+    m_error_thread_t            l_info_az[M_ERROR_NR_THREADS];
+    for (int i = 0; i < M_ERROR_NR_THREADS; i ++) {
+        l_info_az[i].nr_d        = i;
+        l_info_az[i].failed_d    = 0;
+        l_info_az[i].snapshot_pz = NULL;
+        if (pthread_create (&l_thread_az[i], NULL, m_r_error_thread, &l_info_az[i]) != 0)
+            return ERROR (-1, "failed to start thread %d", i);
+    }
+    for (int i = 0; i < M_ERROR_NR_THREADS; i ++)
+        pthread_join (l_thread_az[i], NULL);
+
+    //main stack was not changed by the threads
+    char                        l_text_ac[512];
+    FILE* l_file_fp = fmemopen (l_text_ac, sizeof (l_text_ac), "w");
+    error_stack_r_print (l_file_fp);
+    fclose (l_file_fp);
+    ASSERT_STR_EQ ("  ERR[0]: main.c(1): main before threads\n", l_text_ac);
+
+    //add the stack of thread 2 under the error of main
+    success ();
+    for (int i = 0; i < M_ERROR_NR_THREADS; i ++) {
+        if (l_info_az[i].failed_d)
+            return ERROR (-1, "thread %d found errors of other threads", i);
+    }
+    ASSERT_INT_EQ (12, error_stack_r_propagate (l_info_az[2].snapshot_pz));
+    error ("main.c", 2, -1, "thread %d failed", 2);
+    l_file_fp = fmemopen (l_text_ac, sizeof (l_text_ac), "w");
+    error_stack_r_print (l_file_fp);
+    fclose (l_file_fp);
+    success ();
+    for (int i = 0; i < M_ERROR_NR_THREADS; i ++)
+        error_stack_r_free (l_info_az[i].snapshot_pz);
+
+    ASSERT_STR_EQ (
+        "  ERR[2]: main.c(2): thread 2 failed\n"
+        "  ERR[1]: thread.c(2): thread 2 step 2\n"
+        "  ERR[0]: thread.c(1): thread 2 step 1\n",
+        l_text_ac);
+    return SUCCESS ();
+}//TEST()
+
+
+//add errors with the thread nr, check none of another thread got in between
+static void* m_r_error_thread (
+          void*                       p_thread_p)
+{
+    m_error_thread_t* l_info_pz = (m_error_thread_t*)p_thread_p;
+    for (int l_loop_d = 0; l_loop_d < 1000; l_loop_d ++) {
+        success ();
+        error ("thread.c", 1, 10 + l_info_pz->nr_d, "thread %d step 1", l_info_pz->nr_d);
+        error ("thread.c", 2, 10 + l_info_pz->nr_d, "thread %d step 2", l_info_pz->nr_d);
+
+        error_stack_t* l_snapshot_pz = error_stack_r_snapshot ();
+        char                        l_text_ac[256];
+        char                        l_exp_ac[256];
+        FILE* l_file_fp = fmemopen (l_text_ac, sizeof (l_text_ac), "w");
+        error_stack_r_print_snapshot (l_file_fp, l_snapshot_pz);
+        fclose (l_file_fp);
+        snprintf (l_exp_ac, sizeof (l_exp_ac),
+            "  ERR[1]: thread.c(2): thread %d step 2\n"
+            "  ERR[0]: thread.c(1): thread %d step 1\n",
+            l_info_pz->nr_d, l_info_pz->nr_d);
+        if (strcmp (l_exp_ac, l_text_ac) != 0)
+            l_info_pz->failed_d = 1;
+
+        error_stack_r_free (l_info_pz->snapshot_pz);
+        l_info_pz->snapshot_pz = l_snapshot_pz;
+    }/*for each loop*/
+    return NULL;
+}/*m_r_error_thread()*/
@@ -0,0 +1,244 @@
+#include "hl_blocks.h"
+#include "hl_blocks_fault.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "log.h"
+
+#define M_FAULT_BLOCK_SIZE      128
+#define M_FAULT_NR_BLOCKS       18
+#define M_FAULT_NR_MSGS         60
+
+//what the writer and reader knew when the power was cut
+typedef struct m_fault_run_s {
+    hl_blocks_msg_seq_t         written_seq_ud; //last message written
+    hl_blocks_msg_seq_t         synced_seq_ud;  //last message written before a successful hl_blocks_r_sync()
+    hl_blocks_msg_seq_t         read_seq_ud;    //last message read
+} m_fault_run_t;
+
+static int m_r_fault_run (
+    const hl_blocks_options_t*        p_options_pz,
+    const uint32_t                    p_cut_write_nr_ud,
+    const uint32_t                    p_torn_bytes_ud,
+          m_fault_run_t*              p_run_pz);
+
+static int m_r_fault_recover (
+    const hl_blocks_options_t*        p_options_pz,
+    const m_fault_run_t*              p_run_pz);
+
+static int m_r_fault_read_msg (
+          hl_blocks_t*                p_blocks_pz,
+          hl_blocks_msg_seq_t*        p_seq_pud);
+
+static uint32_t m_r_fault_make_msg (
+    const hl_blocks_msg_seq_t         p_seq_ud,
+          char*                       p_msg_pc);
+
+//cut the power on every write, with nothing, part or all of the block
+//written, and check that open recovers all synced messages not yet read
+//without checkpoint, with checkpoint on sync and every 3 blocks
+TEST(fault_power_cut_on_each_write) {
+    for (uint32_t l_checkpoint_ud = 0; l_checkpoint_ud <= 2; l_checkpoint_ud++) {
+        hl_blocks_options_t         l_options_z;
+        hl_blocks_r_options_init (&l_options_z);
+        l_options_z.checkpoint_ud       = (l_checkpoint_ud > 0);
+        l_options_z.checkpoint_every_ud = (l_checkpoint_ud == 2) ? 3 : 0;
+
+        //nr of writes without power cut
+        m_fault_run_t               l_run_z;
+        if (m_r_fault_run (&l_options_z, 0, 0, &l_run_z) != 0)
+            return ERROR (-1, "failed to run without power cut");
+        ASSERT_INT_EQ (M_FAULT_NR_MSGS, l_run_z.written_seq_ud);
+        uint32_t l_nr_writes_ud = hl_blocks_fault_r_get_write_count ();
+        hl_blocks_fault_r_close ();
+
+        const uint32_t l_torn_aud[] = {0, 3, sizeof (uint32_t) * 4 + 5, M_FAULT_BLOCK_SIZE / 2, M_FAULT_BLOCK_SIZE};
+        for (uint32_t l_write_nr_ud = 1; l_write_nr_ud <= l_nr_writes_ud; l_write_nr_ud++) {
+            for (uint32_t l_torn_idx_ud = 0; l_torn_idx_ud < sizeof (l_torn_aud) / sizeof (l_torn_aud[0]); l_torn_idx_ud++) {
+                if (m_r_fault_run (&l_options_z, l_write_nr_ud, l_torn_aud[l_torn_idx_ud], &l_run_z) != 0)
+                    return ERROR (-1, "failed to run until power cut");
+                if (!hl_blocks_fault_r_is_cut ())
+                    return ERROR (-1, "power not cut on write %u", l_write_nr_ud);
+
+                hl_blocks_fault_r_power_on ();
+                if (m_r_fault_recover (&l_options_z, &l_run_z) != 0)
+                    return ERROR (-1, "failed to recover from power cut on write %u/%u after %u bytes (checkpoint=%u)",
+                        l_write_nr_ud,
+                        l_nr_writes_ud,
+                        l_torn_aud[l_torn_idx_ud],
+                        l_checkpoint_ud);
+                hl_blocks_fault_r_close ();
+            }/*for each torn size*/
+        }/*for each write*/
+    }/*for scan and checkpoint*/
+    return SUCCESS ();
+}//TEST()
+
+//writes after the power cut fail and power on reads what reached flash
+TEST(fault_torn_write_reaches_flash_partly) {
+    if (hl_blocks_fault_r_open (16, 4) != 0)
+        return ERROR (-1, "failed to open");
+
+    char                        l_block_ac[16];
+    memset (l_block_ac, 'a', sizeof (l_block_ac));
+    if (hl_blocks_fault_r_write (1, l_block_ac) != 0)
+        return ERROR (-1, "failed to write");
+
+    hl_blocks_fault_r_cut_at (2, 5);
+    memset (l_block_ac, 'b', sizeof (l_block_ac));
+    if (hl_blocks_fault_r_write (2, l_block_ac) != 0)
+        return ERROR (-1, "failed to write before power cut");
+    if (hl_blocks_fault_r_write (1, l_block_ac) == 0)
+        return ERROR (-1, "expected write to fail on power cut");
+    if (hl_blocks_fault_r_write (3, l_block_ac) == 0)
+        return ERROR (-1, "expected write to fail after power cut");
+    ASSERT_INT_EQ (1, hl_blocks_fault_r_is_cut ());
+    ASSERT_INT_EQ (4, hl_blocks_fault_r_get_write_count ());
+
+    hl_blocks_fault_r_power_on ();
+    ASSERT_INT_EQ (0, hl_blocks_fault_r_is_cut ());
+    const void*                 l_block_p;
+    hl_blocks_fault_r_addr (1, &l_block_p);
+    ASSERT_INT_EQ (0, memcmp ("bbbbbaaaaaaaaaaa", l_block_p, 16));
+    hl_blocks_fault_r_addr (2, &l_block_p);
+    ASSERT_INT_EQ (0, memcmp ("bbbbbbbbbbbbbbbb", l_block_p, 16));
+    hl_blocks_fault_r_addr (3, &l_block_p);
+    ASSERT_INT_EQ (0, ((const char*)l_block_p)[0]);
+    return hl_blocks_fault_r_close ();
+}//TEST()
+
+
+//write, sync and read messages until done or the power is cut,
+//leaving the fault backend open
+static int m_r_fault_run (
+    const hl_blocks_options_t*        p_options_pz,
+    const uint32_t                    p_cut_write_nr_ud,
+    const uint32_t                    p_torn_bytes_ud,
+          m_fault_run_t*              p_run_pz)
+{
+    memset (p_run_pz, 0, sizeof (m_fault_run_t));
+    if (hl_blocks_fault_r_open (M_FAULT_BLOCK_SIZE, M_FAULT_NR_BLOCKS) != 0)
+        return ERROR (-1, "failed to open fault backend");
+
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (hl_blocks_r_open_options (M_FAULT_BLOCK_SIZE, M_FAULT_NR_BLOCKS, 200, 16,
+            hl_blocks_fault_r_write, hl_blocks_fault_r_addr, p_options_pz, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks");
+    hl_blocks_fault_r_cut_at (p_cut_write_nr_ud, p_torn_bytes_ud);
+
+    for (hl_blocks_msg_seq_t l_seq_ud = 1; l_seq_ud <= M_FAULT_NR_MSGS; l_seq_ud++) {
+        char                        l_msg_ac[200];
+        uint32_t l_size_ud = m_r_fault_make_msg (l_seq_ud, l_msg_ac);
+        if (hl_blocks_r_write (l_blocks_pz, l_msg_ac, l_size_ud, NULL) != 0)
+            break;
+        p_run_pz->written_seq_ud = l_seq_ud;
+
+        if (l_seq_ud % 4 == 0) {
+            if (hl_blocks_r_sync (l_blocks_pz) != 0)
+                break;
+            p_run_pz->synced_seq_ud = l_seq_ud;
+        }
+
+        //the reader stays a few messages behind
+        while (p_run_pz->read_seq_ud + 6 < l_seq_ud) {
+            hl_blocks_msg_seq_t         l_read_seq_ud = 0;
+            if (m_r_fault_read_msg (l_blocks_pz, &l_read_seq_ud) != 0)
+                return ERROR (-1, "failed to read msg %u", p_run_pz->read_seq_ud + 1);
+            ASSERT_INT_EQ (p_run_pz->read_seq_ud + 1, l_read_seq_ud);
+            p_run_pz->read_seq_ud = l_read_seq_ud;
+        }
+    }/*for each message*/
+
+    //after a power cut this only releases the memory
+    int l_result_d = hl_blocks_r_close (&l_blocks_pz);
+    if (  (l_result_d != 0)
+       && (!hl_blocks_fault_r_is_cut ()))
+        return ERROR (-1, "failed to close");
+    return SUCCESS ();
+}/*m_r_fault_run()*/
+
+
+//open after the power cut and read the rest,
+//which must include all synced messages not yet read
+static int m_r_fault_recover (
+    const hl_blocks_options_t*        p_options_pz,
+    const m_fault_run_t*              p_run_pz)
+{
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (hl_blocks_r_open_options (M_FAULT_BLOCK_SIZE, M_FAULT_NR_BLOCKS, 200, 16,
+            hl_blocks_fault_r_write, hl_blocks_fault_r_addr, p_options_pz, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks");
+
+    //messages are in order, may repeat some already read, and skip none
+    //that were synced: their content is checked by m_r_fault_read_msg()
+    hl_blocks_msg_seq_t l_next_seq_ud = 0;
+    while (1) {
+        hl_blocks_msg_seq_t         l_read_seq_ud = 0;
+        int l_result_d = m_r_fault_read_msg (l_blocks_pz, &l_read_seq_ud);
+        if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+            break;
+        if (l_result_d != 0)
+            return ERROR (-1, "failed to read after msg %u", l_next_seq_ud);
+        if (  (l_next_seq_ud == 0)
+           && (l_read_seq_ud > p_run_pz->read_seq_ud + 1)
+           && (p_run_pz->read_seq_ud < p_run_pz->synced_seq_ud))
+            return ERROR (-1, "first msg %u after power cut, lost synced %u..%u",
+                l_read_seq_ud,
+                p_run_pz->read_seq_ud + 1,
+                p_run_pz->synced_seq_ud);
+        if (  (l_next_seq_ud > 0)
+           && (l_read_seq_ud != l_next_seq_ud))
+            return ERROR (-1, "read msg %u after power cut, expected %u", l_read_seq_ud, l_next_seq_ud);
+        if (l_read_seq_ud > p_run_pz->written_seq_ud)
+            return ERROR (-1, "read msg %u never written", l_read_seq_ud);
+        l_next_seq_ud = l_read_seq_ud + 1;
+    }/*while more to read*/
+    if (  (p_run_pz->synced_seq_ud > p_run_pz->read_seq_ud)
+       && (l_next_seq_ud <= p_run_pz->synced_seq_ud))
+        return ERROR (-1, "lost synced messages %u..%u",
+            (l_next_seq_ud == 0) ? p_run_pz->read_seq_ud + 1 : l_next_seq_ud,
+            p_run_pz->synced_seq_ud);
+
+    //new messages never reuse the seq of a synced message
+    char                        l_msg_ac[200];
+    hl_blocks_msg_seq_t         l_seq_ud = 0;
+    snprintf (l_msg_ac, sizeof (l_msg_ac), "after power cut");
+    if (hl_blocks_r_write (l_blocks_pz, l_msg_ac, strlen (l_msg_ac) + 1, &l_seq_ud) != 0)
+        return ERROR (-1, "failed to write after power cut");
+    if (l_seq_ud <= p_run_pz->synced_seq_ud)
+        return ERROR (-1, "new msg seq %u <= synced %u", l_seq_ud, p_run_pz->synced_seq_ud);
+    return hl_blocks_r_close (&l_blocks_pz);
+}/*m_r_fault_recover()*/
+
+
+//read a message and check its content matches its seq
+static int m_r_fault_read_msg (
+          hl_blocks_t*                p_blocks_pz,
+          hl_blocks_msg_seq_t*        p_seq_pud)
+{
+    char                        l_buf_ac[200];
+    size_t                      l_size_ud = 0;
+    int l_result_d = hl_blocks_r_read (p_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_size_ud, p_seq_pud);
+    if (l_result_d != 0)
+        return l_result_d;
+
+    char                        l_msg_ac[200];
+    uint32_t l_msg_size_ud = m_r_fault_make_msg (*p_seq_pud, l_msg_ac);
+    if (  (l_size_ud != l_msg_size_ud)
+       || (memcmp (l_buf_ac, l_msg_ac, l_msg_size_ud) != 0))
+        return ERROR (-1, "msg %u has wrong content", *p_seq_pud);
+    return SUCCESS ();
+}/*m_r_fault_read_msg()*/
+
+
+//message for a seq, some spanning blocks, return its size
+static uint32_t m_r_fault_make_msg (
+    const hl_blocks_msg_seq_t         p_seq_ud,
+          char*                       p_msg_pc)
+{
+    uint32_t l_size_ud = 20 + (p_seq_ud * 37) % 140;
+    int l_len_d = snprintf (p_msg_pc, l_size_ud, "fault msg %u", p_seq_ud);
+    memset (p_msg_pc + l_len_d, 'a' + (p_seq_ud % 26), l_size_ud - l_len_d);
+    return l_size_ud;
+}/*m_r_fault_make_msg()*/
@@ -0,0 +1,157 @@
+#include "hl_blocks.h"
+#include "hl_blocks_flashsim.h"
+#include <stdio.h>
+#include <string.h>
+
+#include "test.h"
+#include "log.h"
+
+#define M_SIM_BLOCK_SIZE        512
+#define M_SIM_NR_BLOCKS         32      //4 NOR sectors of 8 blocks
+
+static int m_r_sim_write_read (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_first_ud,
+    const uint32_t                    p_nr_msgs_ud);
+
+//program only clears bits, erase when a bit must be set again,
+//and NAND pages only max_programs times between erases
+TEST(flashsim_program_and_erase) {
+    hl_blocks_flashsim_config_t     l_config_z;
+    hl_blocks_flashsim_stats_t      l_stats_z;
+    unsigned char                   l_block_auc[M_SIM_BLOCK_SIZE];
+    const void*                     l_flash_p = NULL;
+
+    hl_blocks_flashsim_r_config_init (HL_BLOCKS_FLASHSIM_K_TYPE_NOR, &l_config_z);
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_open (M_SIM_BLOCK_SIZE, M_SIM_NR_BLOCKS, &l_config_z));
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_addr (1, &l_flash_p));
+    ASSERT_INT_EQ (0xFF, ((const unsigned char*)l_flash_p)[0]);
+
+    //erased to 0xF0 then 0x00: only programs, 2 pages each time
+    memset (l_block_auc, 0xF0, sizeof (l_block_auc));
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_write (1, l_block_auc));
+    memset (l_block_auc, 0x00, sizeof (l_block_auc));
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_write (1, l_block_auc));
+    hl_blocks_flashsim_r_get_stats (&l_stats_z);
+    ASSERT_INT_EQ (2, (uint32_t)l_stats_z.writes_ud);
+    ASSERT_INT_EQ (4, (uint32_t)l_stats_z.pages_programmed_ud);
+    ASSERT_INT_EQ (0, (uint32_t)l_stats_z.erases_ud);
+
+    //same again: nothing changed, nothing programmed
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_write (1, l_block_auc));
+    hl_blocks_flashsim_r_get_stats (&l_stats_z);
+    ASSERT_INT_EQ (4, (uint32_t)l_stats_z.pages_programmed_ud);
+
+    //a block in the same sector, then set bits in block 1: erase the
+    //sector and program both blocks again
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_write (0, l_block_auc));
+    memset (l_block_auc, 0x0F, sizeof (l_block_auc));
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_write (1, l_block_auc));
+    hl_blocks_flashsim_r_get_stats (&l_stats_z);
+    ASSERT_INT_EQ (1, (uint32_t)l_stats_z.erases_ud);
+    ASSERT_INT_EQ (4 + 2 + 4, (uint32_t)l_stats_z.pages_programmed_ud);
+    ASSERT_INT_EQ (2, (uint32_t)l_stats_z.pages_reprogrammed_ud);
+    ASSERT_INT_EQ (0x0F, ((const unsigned char*)l_flash_p)[0]);
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_addr (0, &l_flash_p));
+    ASSERT_INT_EQ (0x00, ((const unsigned char*)l_flash_p)[M_SIM_BLOCK_SIZE - 1]);
+
+    uint32_t        l_nr_units_ud = 0;
+    const uint32_t* l_erases_aud = hl_blocks_flashsim_r_get_erase_counts (&l_nr_units_ud);
+    ASSERT_INT_EQ (M_SIM_NR_BLOCKS * M_SIM_BLOCK_SIZE / 4096, l_nr_units_ud);
+    ASSERT_INT_EQ (1, l_erases_aud[0]);
+    ASSERT_INT_EQ (0, l_erases_aud[1]);
+    ASSERT_INT_EQ ((4 + 2 + 4) * l_config_z.page_program_ns_ud + l_config_z.erase_ns_ud, (uint32_t)l_stats_z.time_ns_ud);
+    hl_blocks_flashsim_r_close ();
+
+    //NAND with 1 program per page: 4 blocks per page, the 2nd block
+    //in a page is a 2nd program and needs an erase
+    hl_blocks_flashsim_r_config_init (HL_BLOCKS_FLASHSIM_K_TYPE_NAND, &l_config_z);
+    l_config_z.max_programs_ud = 1;
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_open (M_SIM_BLOCK_SIZE, M_SIM_NR_BLOCKS, &l_config_z));
+    memset (l_block_auc, 0x55, sizeof (l_block_auc));
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_write (0, l_block_auc));
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_write (1, l_block_auc));
+    hl_blocks_flashsim_r_get_stats (&l_stats_z);
+    ASSERT_INT_EQ (1, (uint32_t)l_stats_z.erases_ud);
+    ASSERT_INT_EQ (2, (uint32_t)l_stats_z.pages_programmed_ud);
+    ASSERT_INT_EQ (1, (uint32_t)l_stats_z.pages_reprogrammed_ud);
+    hl_blocks_flashsim_r_close ();
+    return SUCCESS ();
+}//TEST()
+
+//hl_blocks on erased NOR flash: open empty, write more than fits
+//once while reading, and open again with the messages not yet read
+TEST(flashsim_nor_ring) {
+    hl_blocks_flashsim_config_t     l_config_z;
+    hl_blocks_flashsim_stats_t      l_stats_z;
+    hl_blocks_t*                    l_blocks_pz = NULL;
+
+    hl_blocks_flashsim_r_config_init (HL_BLOCKS_FLASHSIM_K_TYPE_NOR, &l_config_z);
+    ASSERT_INT_EQ (0, hl_blocks_flashsim_r_open (M_SIM_BLOCK_SIZE, M_SIM_NR_BLOCKS, &l_config_z));
+    ASSERT_INT_EQ (0, hl_blocks_r_open (M_SIM_BLOCK_SIZE, M_SIM_NR_BLOCKS, 200, 16,
+        hl_blocks_flashsim_r_write, hl_blocks_flashsim_r_addr, &l_blocks_pz));
+
+    //fill half the ring: only programs, incl releasing the read blocks
+    ASSERT_INT_EQ (0, m_r_sim_write_read (l_blocks_pz, 1, 40));
+    hl_blocks_flashsim_r_get_stats (&l_stats_z);
+    ASSERT_INT_EQ (0, (uint32_t)l_stats_z.erases_ud);
+    if (l_stats_z.pages_programmed_ud == 0)
+        return ERROR (-1, "nothing programmed");
+
+    //wrap around a few times: each sector erased when its first block is written again
+    ASSERT_INT_EQ (0, m_r_sim_write_read (l_blocks_pz, 41, 400));
+    hl_blocks_flashsim_r_get_stats (&l_stats_z);
+    if (l_stats_z.erases_ud < 4)
+        return ERROR (-1, "only %llu erases after wrapping", (unsigned long long)l_stats_z.erases_ud);
+
+    //unread messages survive a close and open
+    char        l_msg_ac[32];
+    for (uint32_t i = 0; i < 3; i++) {
+        int l_len_d = snprintf (l_msg_ac, sizeof (l_msg_ac), "left %u", i);
+        ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_ac, (size_t)l_len_d, NULL));
+    }
+    ASSERT_INT_EQ (0, hl_blocks_r_close (&l_blocks_pz));
+    ASSERT_INT_EQ (0, hl_blocks_r_open (M_SIM_BLOCK_SIZE, M_SIM_NR_BLOCKS, 200, 16,
+        hl_blocks_flashsim_r_write, hl_blocks_flashsim_r_addr, &l_blocks_pz));
+    for (uint32_t i = 0; i < 3; i++) {
+        char        l_buf_ac[32];
+        size_t      l_size_ud = 0;
+        ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac) - 1, &l_size_ud, NULL));
+        l_buf_ac[l_size_ud] = '\0';
+        snprintf (l_msg_ac, sizeof (l_msg_ac), "left %u", i);
+        ASSERT_STR_EQ (l_msg_ac, l_buf_ac);
+    }
+    ASSERT_INT_EQ (0, hl_blocks_r_close (&l_blocks_pz));
+    hl_blocks_flashsim_r_close ();
+    return SUCCESS ();
+}//TEST()
+
+
+//write messages of 50..150 bytes and read each back, with the reader 20 behind
+static int m_r_sim_write_read (
+          hl_blocks_t*                p_blocks_pz,
+    const uint32_t                    p_first_ud,
+    const uint32_t                    p_nr_msgs_ud)
+{
+    char        l_msg_ac[200];
+    char        l_buf_ac[200];
+    for (uint32_t l_nr_ud = p_first_ud; l_nr_ud < p_first_ud + p_nr_msgs_ud + 20; l_nr_ud++) {
+        if (l_nr_ud < p_first_ud + p_nr_msgs_ud) {
+            memset (l_msg_ac, 'a' + l_nr_ud % 26, sizeof (l_msg_ac));
+            if (hl_blocks_r_write (p_blocks_pz, l_msg_ac, 50 + l_nr_ud % 101, NULL) != 0)
+                return ERROR (-1, "failed to write message %u", l_nr_ud);
+        }
+        if (l_nr_ud < p_first_ud + 20)
+            continue;
+
+        uint32_t    l_read_nr_ud = l_nr_ud - 20;
+        size_t      l_size_ud = 0;
+        if (hl_blocks_r_read (p_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_size_ud, NULL) != 0)
+            return ERROR (-1, "failed to read message %u", l_read_nr_ud);
+        memset (l_msg_ac, 'a' + l_read_nr_ud % 26, sizeof (l_msg_ac));
+        if (  (l_size_ud != 50 + l_read_nr_ud % 101)
+           || (memcmp (l_buf_ac, l_msg_ac, l_size_ud) != 0))
+            return ERROR (-1, "message %u read with size %zu", l_read_nr_ud, l_size_ud);
+    }
+    return SUCCESS ();
+}/*m_r_sim_write_read()*/
@@ -0,0 +1,166 @@
+#include "hl_blocks.h"
+#include "hl_blocks_mmap.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "log.h"
+
+static int m_r_mmap_open (
+    const char*                       p_path_pc,
+          hl_blocks_t**               p_blocks_ppz);
+
+static int m_r_mmap_close (
+          hl_blocks_t**               p_blocks_ppz);
+
+#define M_MMAP_BLOCK_SIZE       512
+#define M_MMAP_NR_BLOCKS        16
+
+//messages written to the file are read after closing and mapping it again
+TEST(mmap_write_close_reopen_and_read) {
+    char                        l_path_ac[] = "/tmp/test_hl_blocks_mmap_XXXXXX";
+    int                         l_fd_d = mkstemp (l_path_ac);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to create temp file");
+    close (l_fd_d);
+
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (m_r_mmap_open (l_path_ac, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open %s", l_path_ac);
+
+    //fill several blocks, read a few and leave the rest for after cold start
+    const int l_nr_msgs_d = 60;
+    for (int i = 0; i < l_nr_msgs_d; i ++)
+    {
+        char                        l_msg_ac[64];
+        snprintf (l_msg_ac, sizeof (l_msg_ac), "mmap message %03d with some padding", i);
+        hl_blocks_msg_seq_t l_write_seq_ud = 0;
+        if (hl_blocks_r_write (
+                l_blocks_pz,
+                l_msg_ac, strlen (l_msg_ac) + 1,
+                &l_write_seq_ud)
+                != 0)
+            return ERROR (-1, "failed to write msg[%d]", i);
+        ASSERT_INT_EQ (i + 1, l_write_seq_ud);
+    }/*for each message to write*/
+
+    //whole blocks read before close are not read again
+    int l_next_rd_id_d = 0;
+    while (l_next_rd_id_d < 20)
+    {
+        char                        l_buf_ac[64];
+        size_t                      l_read_size_ud = 0;
+        if (hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_read_size_ud, NULL) != 0)
+            return ERROR (-1, "failed to read msg[%d]", l_next_rd_id_d);
+        l_next_rd_id_d ++;
+    }
+
+    if (m_r_mmap_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "failed to close");
+
+    if (m_r_mmap_open (l_path_ac, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open %s for cold start", l_path_ac);
+
+    while (1)
+    {
+        char                        l_buf_ac[64];
+        size_t                      l_read_size_ud = 0;
+        hl_blocks_msg_seq_t         l_read_seq_ud = 0;
+        int l_result_d = hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_read_size_ud, &l_read_seq_ud);
+        if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+            break;
+        if (l_result_d != 0)
+            return ERROR (-1, "failed to read after cold start");
+
+        //the partly read block is read again from its start
+        if (l_read_seq_ud < (hl_blocks_msg_seq_t)(l_next_rd_id_d + 1))
+            continue;
+
+        char                        l_exp_msg_ac[64];
+        snprintf (l_exp_msg_ac, sizeof (l_exp_msg_ac), "mmap message %03d with some padding", l_next_rd_id_d);
+        ASSERT_INT_EQ (l_next_rd_id_d + 1, l_read_seq_ud);
+        ASSERT_STR_EQ (l_exp_msg_ac, l_buf_ac);
+        l_next_rd_id_d ++;
+    }/*while reading*/
+    ASSERT_INT_EQ (l_nr_msgs_d, l_next_rd_id_d);
+
+    if (m_r_mmap_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "failed to close");
+    unlink (l_path_ac);
+    return SUCCESS ();
+}//TEST()
+
+//block addresses point into the mapping, which holds the written blocks
+TEST(mmap_addr_is_file_data) {
+    char                        l_path_ac[] = "/tmp/test_hl_blocks_mmap_XXXXXX";
+    int                         l_fd_d = mkstemp (l_path_ac);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to create temp file");
+    close (l_fd_d);
+
+    if (hl_blocks_mmap_r_open (l_path_ac, M_MMAP_BLOCK_SIZE, M_MMAP_NR_BLOCKS, 0) != 0)
+        return ERROR (-1, "failed to map %s", l_path_ac);
+
+    char                        l_block_ac[M_MMAP_BLOCK_SIZE];
+    memset (l_block_ac, 'x', sizeof (l_block_ac));
+    if (hl_blocks_mmap_r_write (3, l_block_ac) != 0)
+        return ERROR (-1, "failed to write block");
+    if (hl_blocks_mmap_r_flush () != 0)
+        return ERROR (-1, "failed to flush");
+
+    const void*                 l_block_p = NULL;
+    if (hl_blocks_mmap_r_addr (3, &l_block_p) != 0)
+        return ERROR (-1, "failed to get block address");
+    ASSERT_INT_EQ (0, memcmp (l_block_ac, l_block_p, sizeof (l_block_ac)));
+    if (hl_blocks_mmap_r_addr (M_MMAP_NR_BLOCKS, &l_block_p) == 0)
+        return ERROR (-1, "expected invalid block index to fail");
+    if (hl_blocks_mmap_r_close () != 0)
+        return ERROR (-1, "failed to close");
+
+    //the file has the block at its offset
+    FILE* l_file_fp = fopen (l_path_ac, "rb");
+    if (l_file_fp == NULL)
+        return ERROR (-1, "failed to open %s", l_path_ac);
+    char                        l_file_block_ac[M_MMAP_BLOCK_SIZE];
+    fseek (l_file_fp, 3 * M_MMAP_BLOCK_SIZE, SEEK_SET);
+    size_t l_size_ud = fread (l_file_block_ac, 1, sizeof (l_file_block_ac), l_file_fp);
+    fclose (l_file_fp);
+    unlink (l_path_ac);
+    ASSERT_INT_EQ (M_MMAP_BLOCK_SIZE, l_size_ud);
+    ASSERT_INT_EQ (0, memcmp (l_block_ac, l_file_block_ac, sizeof (l_block_ac)));
+    return SUCCESS ();
+}//TEST()
+
+
+static int m_r_mmap_open (
+    const char*                       p_path_pc,
+          hl_blocks_t**               p_blocks_ppz)
+{
+    if (hl_blocks_mmap_r_open (p_path_pc, M_MMAP_BLOCK_SIZE, M_MMAP_NR_BLOCKS, 4) != 0)
+        return ERROR (-1, "failed to map %s", p_path_pc);
+
+    if (hl_blocks_r_open (
+                M_MMAP_BLOCK_SIZE,
+                M_MMAP_NR_BLOCKS,
+                256,
+                32,
+                hl_blocks_mmap_r_write,
+                hl_blocks_mmap_r_addr,
+                p_blocks_ppz)
+                != 0)
+        return ERROR (-1, "failed to open blocks");
+    if (hl_blocks_r_set_writev (*p_blocks_ppz, hl_blocks_mmap_r_writev) != 0)
+        return ERROR (-1, "failed to set writev");
+    return SUCCESS ();
+}/*m_r_mmap_open()*/
+
+static int m_r_mmap_close (
+          hl_blocks_t**               p_blocks_ppz)
+{
+    if (hl_blocks_r_close (p_blocks_ppz) != 0)
+        return ERROR (-1, "failed to close blocks");
+    if (hl_blocks_mmap_r_close () != 0)
+        return ERROR (-1, "failed to unmap");
+    return SUCCESS ();
+}/*m_r_mmap_close()*/
@@ -0,0 +1,133 @@
+#include "hl_blocks.h"
+#include "hl_blocks_mmap.h"
+#include "hl_blocks_scan.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "log.h"
+
+#define M_SCAN_BLOCK_SIZE       256
+#define M_SCAN_NR_BLOCKS        32
+
+//export context: next expected message
+typedef struct m_scan_ctx_s {
+    int                         next_id_d;
+} m_scan_ctx_t;
+
+static int m_r_scan_expect_msg (
+          void*                       p_ctx_p,
+    const hl_blocks_msg_seq_t         p_seq_ud,
+    const uint32_t                    p_prio_ud,
+    const void*                       p_data_p,
+    const uint32_t                    p_size_ud);
+
+static void m_r_scan_msg_text (
+    const int                         p_id_d,
+          char*                       p_text_pc,
+    const size_t                      p_size_ud);
+
+//scan an image written by hl_blocks in several threads,
+//export all messages and detect a corrupted block
+TEST(scan_image_and_export) {
+    char                        l_path_ac[] = "/tmp/test_hl_blocks_scan_XXXXXX";
+    int                         l_fd_d = mkstemp (l_path_ac);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to create temp file");
+    close (l_fd_d);
+
+    //write messages of different sizes, some spanning blocks
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (  (hl_blocks_mmap_r_open (l_path_ac, M_SCAN_BLOCK_SIZE, M_SCAN_NR_BLOCKS, 0) != 0)
+       || (hl_blocks_r_open (M_SCAN_BLOCK_SIZE, M_SCAN_NR_BLOCKS, 1024, 16,
+                hl_blocks_mmap_r_write, hl_blocks_mmap_r_addr, &l_blocks_pz) != 0))
+        return ERROR (-1, "failed to open %s", l_path_ac);
+    const int l_nr_msgs_d = 40;
+    for (int i = 0; i < l_nr_msgs_d; i ++) {
+        char                        l_msg_ac[512];
+        m_r_scan_msg_text (i, l_msg_ac, sizeof (l_msg_ac));
+        if (hl_blocks_r_write (l_blocks_pz, l_msg_ac, strlen (l_msg_ac) + 1, NULL) != 0)
+            return ERROR (-1, "failed to write msg[%d]", i);
+    }
+    if (  (hl_blocks_r_close (&l_blocks_pz) != 0)
+       || (hl_blocks_mmap_r_close () != 0))
+        return ERROR (-1, "failed to close");
+
+    l_fd_d = open (l_path_ac, O_RDWR);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to open %s", l_path_ac);
+    unsigned char* l_image_puc = (unsigned char*)mmap (NULL, M_SCAN_BLOCK_SIZE * M_SCAN_NR_BLOCKS,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE, l_fd_d, 0);
+    close (l_fd_d);
+    unlink (l_path_ac);
+    if (l_image_puc == MAP_FAILED)
+        return ERROR (-1, "failed to map image");
+
+    hl_blocks_scan_block_t      l_info_az[M_SCAN_NR_BLOCKS];
+    hl_blocks_scan_t            l_scan_z;
+    if (hl_blocks_scan_r_image (l_image_puc, M_SCAN_BLOCK_SIZE, M_SCAN_NR_BLOCKS, 3, l_info_az, &l_scan_z) != 0)
+        return ERROR (-1, "failed to scan");
+    ASSERT_INT_EQ (M_SCAN_NR_BLOCKS, l_scan_z.nr_blocks_ud);
+    ASSERT_INT_EQ (M_SCAN_NR_BLOCKS, l_scan_z.nr_used_ud + l_scan_z.nr_empty_ud);
+    ASSERT_INT_EQ (0, l_scan_z.nr_corrupt_ud);
+    ASSERT_INT_EQ (0, l_scan_z.tail_idx_ud);
+    ASSERT_INT_EQ (1, l_scan_z.tail_seq_ud);
+    ASSERT_INT_EQ (l_scan_z.nr_used_ud - 1, l_scan_z.head_idx_ud);
+    ASSERT_INT_EQ (1, l_scan_z.first_msg_seq_ud);
+    ASSERT_INT_EQ (l_nr_msgs_d, l_scan_z.last_msg_seq_ud);
+    ASSERT_INT_EQ (l_nr_msgs_d, l_scan_z.nr_msgs_ud);
+
+    m_scan_ctx_t                l_ctx_z = {.next_id_d = 0};
+    uint64_t                    l_nr_exported_ud = 0;
+    if (hl_blocks_scan_r_export (l_image_puc, M_SCAN_BLOCK_SIZE, M_SCAN_NR_BLOCKS, l_info_az,
+            m_r_scan_expect_msg, &l_ctx_z, &l_nr_exported_ud) != 0)
+        return ERROR (-1, "failed to export");
+    ASSERT_INT_EQ (l_nr_msgs_d, l_nr_exported_ud);
+    ASSERT_INT_EQ (l_nr_msgs_d, l_ctx_z.next_id_d);
+
+    //used size beyond the block end
+    l_image_puc[2 * M_SCAN_BLOCK_SIZE + 4] = 0xFF;
+    l_image_puc[2 * M_SCAN_BLOCK_SIZE + 5] = 0xFF;
+    if (hl_blocks_scan_r_image (l_image_puc, M_SCAN_BLOCK_SIZE, M_SCAN_NR_BLOCKS, 0, l_info_az, &l_scan_z) != 0)
+        return ERROR (-1, "failed to scan");
+    ASSERT_INT_EQ (1, l_scan_z.nr_corrupt_ud);
+    ASSERT_INT_EQ (HL_BLOCKS_SCAN_K_BAD_USED_SIZE, l_info_az[2].errors_ud);
+    ASSERT_INT_EQ (1, l_info_az[2].seq_ud != 0);
+
+    munmap (l_image_puc, M_SCAN_BLOCK_SIZE * M_SCAN_NR_BLOCKS);
+    return SUCCESS ();
+}//TEST()
+
+
+static void m_r_scan_msg_text (
+    const int                         p_id_d,
+          char*                       p_text_pc,
+    const size_t                      p_size_ud)
+{
+    //every 7th message is longer than a block
+    int l_len_d = snprintf (p_text_pc, p_size_ud, "scan message %d", p_id_d);
+    int l_pad_d = (p_id_d % 7 == 6) ? 300 : (p_id_d % 5) * 10;
+    memset (p_text_pc + l_len_d, 'a' + (p_id_d % 26), l_pad_d);
+    p_text_pc[l_len_d + l_pad_d] = '\0';
+}/*m_r_scan_msg_text()*/
+
+static int m_r_scan_expect_msg (
+          void*                       p_ctx_p,
+    const hl_blocks_msg_seq_t         p_seq_ud,
+    const uint32_t                    p_prio_ud,
+    const void*                       p_data_p,
+    const uint32_t                    p_size_ud)
+{
+    m_scan_ctx_t* l_ctx_pz = (m_scan_ctx_t*)p_ctx_p;
+    char                        l_exp_ac[512];
+    m_r_scan_msg_text (l_ctx_pz->next_id_d, l_exp_ac, sizeof (l_exp_ac));
+    ASSERT_INT_EQ (l_ctx_pz->next_id_d + 1, p_seq_ud);
+    ASSERT_INT_EQ (0, p_prio_ud);
+    ASSERT_INT_EQ (strlen (l_exp_ac) + 1, p_size_ud);
+    ASSERT_STR_EQ (l_exp_ac, (const char*)p_data_p);
+    l_ctx_pz->next_id_d ++;
+    return 0;
+}/*m_r_scan_expect_msg()*/
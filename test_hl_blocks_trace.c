@@ -0,0 +1,105 @@
+#include "hl_blocks.h"
+#include "hl_blocks_fault.h"
+#include "hl_blocks_trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "log.h"
+
+#define M_TRACE_BLOCK_SIZE      128
+#define M_TRACE_NR_BLOCKS       32
+#define M_TRACE_NR_MSGS         40
+
+//record writes, syncs and reads incl a read with nothing to read,
+//check the records read back, then replay it on a new instance
+TEST(trace_record_and_replay) {
+    char                        l_path_ac[] = "/tmp/test_trace_XXXXXX";
+    int                         l_fd_d = mkstemp (l_path_ac);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to create %s", l_path_ac);
+    close (l_fd_d);
+
+    hl_blocks_trace_config_t    l_config_z = {M_TRACE_BLOCK_SIZE, M_TRACE_NR_BLOCKS, 100, 16};
+    hl_blocks_t*                l_blocks_pz = NULL;
+    hl_blocks_trace_t*          l_trace_pz = NULL;
+    ASSERT_INT_EQ (0, hl_blocks_fault_r_open (M_TRACE_BLOCK_SIZE, M_TRACE_NR_BLOCKS));
+    ASSERT_INT_EQ (0, hl_blocks_r_open (M_TRACE_BLOCK_SIZE, M_TRACE_NR_BLOCKS, 100, 16,
+        hl_blocks_fault_r_write, hl_blocks_fault_r_addr, &l_blocks_pz));
+    ASSERT_INT_EQ (0, hl_blocks_trace_r_open (l_path_ac, &l_config_z, &l_trace_pz));
+
+    char                        l_msg_ac[101];
+    memset (l_msg_ac, 'm', sizeof (l_msg_ac));
+    for (uint32_t i = 0; i < M_TRACE_NR_MSGS; i++) {
+        ASSERT_INT_EQ (0, hl_blocks_trace_r_write (l_trace_pz, l_blocks_pz, l_msg_ac, 1 + i * 2, NULL));
+        if (i % 10 == 9)
+            ASSERT_INT_EQ (0, hl_blocks_trace_r_sync (l_trace_pz, l_blocks_pz));
+    }
+    for (uint32_t i = 0; i <= M_TRACE_NR_MSGS; i++) {
+        size_t l_size_ud = 0;
+        int l_result_d = hl_blocks_trace_r_read (l_trace_pz, l_blocks_pz, l_msg_ac, sizeof (l_msg_ac), &l_size_ud, NULL);
+        ASSERT_INT_EQ ((i < M_TRACE_NR_MSGS) ? 0 : HL_BLOCKS_K_ERROR_READ_ALL, l_result_d);
+    }
+    ASSERT_INT_EQ (0, hl_blocks_trace_r_close (&l_trace_pz));
+    ASSERT_INT_EQ (0, hl_blocks_r_close (&l_blocks_pz));
+    uint32_t l_flash_writes_ud = hl_blocks_fault_r_get_write_count ();
+    hl_blocks_fault_r_close ();
+
+    /*
+     * read the records back
+     */
+    hl_blocks_trace_config_t    l_read_config_z;
+    hl_blocks_trace_reader_t*   l_reader_pz = NULL;
+    ASSERT_INT_EQ (0, hl_blocks_trace_r_reader_open (l_path_ac, &l_read_config_z, &l_reader_pz));
+    ASSERT_INT_EQ (M_TRACE_BLOCK_SIZE, l_read_config_z.block_size_ud);
+    ASSERT_INT_EQ (M_TRACE_NR_BLOCKS, l_read_config_z.nr_blocks_ud);
+    ASSERT_INT_EQ (100, l_read_config_z.max_msg_size_ud);
+    ASSERT_INT_EQ (16, l_read_config_z.min_data_per_part_ud);
+
+    hl_blocks_trace_rec_t       l_rec_z;
+    uint64_t                    l_last_ns_ud = 0;
+    for (uint32_t i = 0; i < M_TRACE_NR_MSGS; i++) {
+        ASSERT_INT_EQ (0, hl_blocks_trace_r_reader_next (l_reader_pz, &l_rec_z));
+        ASSERT_INT_EQ (HL_BLOCKS_TRACE_K_OP_WRITE, l_rec_z.op_e);
+        ASSERT_INT_EQ (1 + i * 2, l_rec_z.size_ud);
+        ASSERT_INT_EQ (0, l_rec_z.failed_d);
+        if (l_rec_z.time_ns_ud < l_last_ns_ud)
+            return ERROR (-1, "time %llu before previous %llu", (unsigned long long)l_rec_z.time_ns_ud, (unsigned long long)l_last_ns_ud);
+        l_last_ns_ud = l_rec_z.time_ns_ud;
+        if (i % 10 == 9) {
+            ASSERT_INT_EQ (0, hl_blocks_trace_r_reader_next (l_reader_pz, &l_rec_z));
+            ASSERT_INT_EQ (HL_BLOCKS_TRACE_K_OP_SYNC, l_rec_z.op_e);
+        }
+    }
+    for (uint32_t i = 0; i <= M_TRACE_NR_MSGS; i++) {
+        ASSERT_INT_EQ (0, hl_blocks_trace_r_reader_next (l_reader_pz, &l_rec_z));
+        ASSERT_INT_EQ (HL_BLOCKS_TRACE_K_OP_READ, l_rec_z.op_e);
+        ASSERT_INT_EQ ((i < M_TRACE_NR_MSGS) ? 1 + i * 2 : 0, l_rec_z.size_ud);
+        ASSERT_INT_EQ ((i < M_TRACE_NR_MSGS) ? 0 : 1, l_rec_z.failed_d);
+    }
+    ASSERT_INT_EQ (HL_BLOCKS_K_ERROR_READ_ALL, hl_blocks_trace_r_reader_next (l_reader_pz, &l_rec_z));
+    hl_blocks_trace_r_reader_close (&l_reader_pz);
+
+    /*
+     * replay as fast as possible with the recorded params: same calls and flash writes
+     */
+    hl_blocks_trace_result_t    l_result_z;
+    ASSERT_INT_EQ (0, hl_blocks_fault_r_open (M_TRACE_BLOCK_SIZE, M_TRACE_NR_BLOCKS));
+    ASSERT_INT_EQ (0, hl_blocks_trace_r_replay (l_path_ac, NULL, 0,
+        hl_blocks_fault_r_write, hl_blocks_fault_r_addr, &l_result_z));
+    hl_blocks_fault_r_close ();
+    unlink (l_path_ac);
+
+    ASSERT_INT_EQ (M_TRACE_NR_MSGS, (uint32_t)l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_WRITE].nr_ops_ud);
+    ASSERT_INT_EQ (0, (uint32_t)l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_WRITE].nr_failed_ud);
+    ASSERT_INT_EQ (M_TRACE_NR_MSGS * M_TRACE_NR_MSGS, (uint32_t)l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_WRITE].bytes_ud);
+    ASSERT_INT_EQ (M_TRACE_NR_MSGS / 10, (uint32_t)l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_SYNC].nr_ops_ud);
+    ASSERT_INT_EQ (M_TRACE_NR_MSGS + 1, (uint32_t)l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_READ].nr_ops_ud);
+    ASSERT_INT_EQ (1, (uint32_t)l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_READ].nr_failed_ud);
+    ASSERT_INT_EQ (M_TRACE_NR_MSGS * M_TRACE_NR_MSGS, (uint32_t)l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_READ].bytes_ud);
+    ASSERT_INT_EQ (l_flash_writes_ud, (uint32_t)l_result_z.flash_writes_ud);
+    if (l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_WRITE].max_ns_ud < l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_WRITE].p50_ns_ud)
+        return ERROR (-1, "max latency below p50");
+    return SUCCESS ();
+}//TEST()
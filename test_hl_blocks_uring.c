@@ -0,0 +1,176 @@
+#include "hl_blocks.h"
+#include "hl_blocks_uring.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "test.h"
+#include "log.h"
+
+static int m_r_uring_open (
+    const char*                       p_path_pc,
+          hl_blocks_t**               p_blocks_ppz);
+
+static int m_r_uring_close (
+          hl_blocks_t**               p_blocks_ppz);
+
+#define M_URING_BLOCK_SIZE      4096
+#define M_URING_NR_BLOCKS       16
+#define M_URING_QUEUE_DEPTH     4
+
+//messages written with async writes are read back through the buffers
+//and after closing and opening the file again
+TEST(uring_write_close_reopen_and_read) {
+    char                        l_path_ac[] = "/tmp/test_hl_blocks_uring_XXXXXX";
+    int                         l_fd_d = mkstemp (l_path_ac);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to create temp file");
+    close (l_fd_d);
+
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (m_r_uring_open (l_path_ac, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open %s", l_path_ac);
+
+    //more blocks than buffers, so buffers are reused while writing
+    const int l_nr_msgs_d = 250;
+    char                        l_msg_ac[200];
+    for (int i = 0; i < l_nr_msgs_d; i ++)
+    {
+        memset (l_msg_ac, 'a' + (i % 26), sizeof (l_msg_ac));
+        snprintf (l_msg_ac, sizeof (l_msg_ac), "uring message %03d", i);
+        hl_blocks_msg_seq_t l_write_seq_ud = 0;
+        if (hl_blocks_r_write (
+                l_blocks_pz,
+                l_msg_ac, sizeof (l_msg_ac),
+                &l_write_seq_ud)
+                != 0)
+            return ERROR (-1, "failed to write msg[%d]", i);
+        ASSERT_INT_EQ (i + 1, l_write_seq_ud);
+    }/*for each message to write*/
+
+    int l_next_rd_id_d = 0;
+    while (l_next_rd_id_d < 100)
+    {
+        char                        l_buf_ac[sizeof (l_msg_ac)];
+        size_t                      l_read_size_ud = 0;
+        if (hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_read_size_ud, NULL) != 0)
+            return ERROR (-1, "failed to read msg[%d]", l_next_rd_id_d);
+        snprintf (l_msg_ac, sizeof (l_msg_ac), "uring message %03d", l_next_rd_id_d);
+        ASSERT_STR_EQ (l_msg_ac, l_buf_ac);
+        l_next_rd_id_d ++;
+    }
+
+    if (m_r_uring_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "failed to close");
+
+    if (m_r_uring_open (l_path_ac, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open %s for cold start", l_path_ac);
+
+    while (1)
+    {
+        char                        l_buf_ac[sizeof (l_msg_ac)];
+        size_t                      l_read_size_ud = 0;
+        hl_blocks_msg_seq_t         l_read_seq_ud = 0;
+        int l_result_d = hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_read_size_ud, &l_read_seq_ud);
+        if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+            break;
+        if (l_result_d != 0)
+            return ERROR (-1, "failed to read after cold start");
+
+        //the partly read block is read again from its start
+        if (l_read_seq_ud < (hl_blocks_msg_seq_t)(l_next_rd_id_d + 1))
+            continue;
+
+        snprintf (l_msg_ac, sizeof (l_msg_ac), "uring message %03d", l_next_rd_id_d);
+        ASSERT_INT_EQ (l_next_rd_id_d + 1, l_read_seq_ud);
+        ASSERT_INT_EQ (sizeof (l_msg_ac), l_read_size_ud);
+        ASSERT_STR_EQ (l_msg_ac, l_buf_ac);
+        l_next_rd_id_d ++;
+    }/*while reading*/
+
+    ASSERT_INT_EQ (l_nr_msgs_d, l_next_rd_id_d);
+
+    if (m_r_uring_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "failed to close");
+    unlink (l_path_ac);
+    return SUCCESS ();
+}//TEST()
+
+//blocks not aligned for O_DIRECT go through the page cache
+//and are in the file after flush
+TEST(uring_unaligned_blocks_in_file) {
+    char                        l_path_ac[] = "/tmp/test_hl_blocks_uring_XXXXXX";
+    int                         l_fd_d = mkstemp (l_path_ac);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to create temp file");
+    close (l_fd_d);
+
+    if (hl_blocks_uring_r_open (l_path_ac, 512, 8, M_URING_QUEUE_DEPTH) != 0)
+        return ERROR (-1, "failed to open %s", l_path_ac);
+
+    char                        l_block_ac[512];
+    for (int i = 0; i < 8; i ++) {
+        memset (l_block_ac, '0' + i, sizeof (l_block_ac));
+        if (hl_blocks_uring_r_write (i, l_block_ac) != 0)
+            return ERROR (-1, "failed to write block %d", i);
+    }
+    //rewriting a block while its first write may be pending
+    memset (l_block_ac, 'x', sizeof (l_block_ac));
+    if (hl_blocks_uring_r_write (7, l_block_ac) != 0)
+        return ERROR (-1, "failed to write block 7 again");
+    if (hl_blocks_uring_r_flush () != 0)
+        return ERROR (-1, "failed to flush");
+
+    const void*                 l_block_p = NULL;
+    if (hl_blocks_uring_r_addr (7, &l_block_p) != 0)
+        return ERROR (-1, "failed to get block");
+    ASSERT_INT_EQ (0, memcmp (l_block_ac, l_block_p, sizeof (l_block_ac)));
+    if (hl_blocks_uring_r_addr (8, &l_block_p) == 0)
+        return ERROR (-1, "expected invalid block index to fail");
+    if (hl_blocks_uring_r_close () != 0)
+        return ERROR (-1, "failed to close");
+
+    FILE* l_file_fp = fopen (l_path_ac, "rb");
+    if (l_file_fp == NULL)
+        return ERROR (-1, "failed to open %s", l_path_ac);
+    char                        l_file_ac[8 * 512];
+    size_t l_size_ud = fread (l_file_ac, 1, sizeof (l_file_ac), l_file_fp);
+    fclose (l_file_fp);
+    unlink (l_path_ac);
+    ASSERT_INT_EQ (sizeof (l_file_ac), l_size_ud);
+    ASSERT_INT_EQ ('0', l_file_ac[0]);
+    ASSERT_INT_EQ ('6', l_file_ac[6 * 512 + 511]);
+    ASSERT_INT_EQ ('x', l_file_ac[7 * 512]);
+    return SUCCESS ();
+}//TEST()
+
+
+static int m_r_uring_open (
+    const char*                       p_path_pc,
+          hl_blocks_t**               p_blocks_ppz)
+{
+    if (hl_blocks_uring_r_open (p_path_pc, M_URING_BLOCK_SIZE, M_URING_NR_BLOCKS, M_URING_QUEUE_DEPTH) != 0)
+        return ERROR (-1, "failed to open %s", p_path_pc);
+
+    if (hl_blocks_r_open (
+                M_URING_BLOCK_SIZE,
+                M_URING_NR_BLOCKS,
+                1024,
+                32,
+                hl_blocks_uring_r_write,
+                hl_blocks_uring_r_addr,
+                p_blocks_ppz)
+                != 0)
+        return ERROR (-1, "failed to open blocks");
+    return SUCCESS ();
+}/*m_r_uring_open()*/
+
+static int m_r_uring_close (
+          hl_blocks_t**               p_blocks_ppz)
+{
+    if (hl_blocks_r_close (p_blocks_ppz) != 0)
+        return ERROR (-1, "failed to close blocks");
+    if (hl_blocks_uring_r_close () != 0)
+        return ERROR (-1, "failed to close file");
+    return SUCCESS ();
+}/*m_r_uring_close()*/
@@ -1,6 +1,9 @@
 #include "hl_blocks.h"
+#include "hl_blocks_format.h"
+#include <arpa/inet.h>
 #include <stdio.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "test.h"
 #include "log.h"
@@ -11,12 +14,14 @@ static uint32_t            m_d_max_msg_size_ud      = 0;
 static uint32_t            m_d_block_size_ud        = 0;
 static uint32_t            m_d_nr_blocks_ud         = 0;
 static unsigned char*      m_d_mock_flash_mem_auc   = NULL;
+static uint32_t            m_d_addr_count_ud        = 0;
 
 static int m_r_start (
     const uint32_t                    p_block_size_ud,
     const uint32_t                    p_nr_blocks_ud,
     const uint32_t                    p_max_msg_size_ud,
     const uint32_t                    p_min_part_size_ud,
+    const hl_blocks_options_t*        p_options_pz,
           hl_blocks_t**               p_block_ppz);
 
 static int m_r_cleanup (
@@ -30,42 +35,34 @@ static int m_r_block_addr (
     const uint32_t                    p_idx_ud,
     const void**                      p_block_pp);
 
+static int m_r_block_writev (
+    const uint32_t                    p_idx_ud,
+    const struct iovec*               p_iov_az,
+    const int                         p_nr_iov_d);
+
 static void m_r_make_test_msg (
           void*                       p_buff_data_p,
     const size_t                      p_buff_size_ud,
     const uint32_t                    p_msg_id_ud,          //a number printed into the start of the message
     const uint32_t                    p_test_msg_len_ud);   //how long the message must be
 
+static uint32_t m_r_checkpoint_generation (void);
+
 
 #define START(block_size,nr_blocks,max_msg_size,min_part_size)                  \
     const uint32_t              l_nr_blocks_ud      = nr_blocks;                \
     const uint32_t              l_block_size_ud     = block_size;               \
     const uint32_t              l_min_part_size_ud  = min_part_size;            \
     hl_blocks_t*                l_blocks_pz         = NULL;                     \
-    if (m_r_start (block_size, nr_blocks, max_msg_size, min_part_size, &l_blocks_pz) != 0) \
+    (void)l_nr_blocks_ud; (void)l_block_size_ud; (void)l_min_part_size_ud;     \
+    if (m_r_start (block_size, nr_blocks, max_msg_size, min_part_size, NULL, &l_blocks_pz) != 0) \
         return ERROR (-1, "test setup failed")
 
-#define SAFE_STR(str) ((str) == NULL ? "<null>" : (str))
-
-#define _ASSERT_INT_EQ(file, line, expected, actual)                            \
-    if ((expected) != (actual))                                                 \
-        return ERROR (-1,                                                       \
-            "assertion failed at %s(%d): expected %u != %u actual",             \
-            file, line,                                                         \
-            expected, actual);
-
-#define ASSERT_INT_EQ(expected, actual)                                         \
-    _ASSERT_INT_EQ(__FILE__, __LINE__, expected, actual)
-
-#define _ASSERT_STR_EQ(file, line, expected, actual)                            \
-    if (strcmp (expected, actual) != 0)                                         \
-        return ERROR (-1,                                                       \
-            "assertion failed at %s(%d): expected \"%s\" != \"%s\" actual",     \
-            file, line,                                                         \
-            SAFE_STR(expected), SAFE_STR(actual));                              \
-
-#define ASSERT_STR_EQ(expected, actual)                                         \
-    _ASSERT_STR_EQ(__FILE__, __LINE__, expected, actual)
+//same as START() with options for hl_blocks_r_open_options()
+#define START_OPTIONS(block_size,nr_blocks,max_msg_size,min_part_size,options)  \
+    hl_blocks_t*                l_blocks_pz         = NULL;                     \
+    if (m_r_start (block_size, nr_blocks, max_msg_size, min_part_size, options, &l_blocks_pz) != 0) \
+        return ERROR (-1, "test setup failed")
 
 #define _ASSERT_NOTHING_MORE_TO_READ(file, line, blocks)                        \
     {                                                                           \
@@ -80,6 +77,7 @@ static void m_r_make_test_msg (
         if (l_result_d != HL_BLOCKS_K_ERROR_READ_ALL)                           \
             return ERROR (-1,                                                   \
             "assertion failed at %s(%d): expected READ_ALL=%d != %d actual",    \
+            file, line,                                                         \
             HL_BLOCKS_K_ERROR_READ_ALL,                                         \
             l_result_d);                                                        \
     }
@@ -751,7 +749,7 @@ TEST(write_and_read_over_buffer_rotation) {
             //the first message(s) after cold start, may already be read when the block
             //was not completely read before shut down
             //if so, skip them...
-            if (l_read_seq_ud < l_next_rd_id_d + 1) {
+            if (l_read_seq_ud < (hl_blocks_msg_seq_t)(l_next_rd_id_d + 1)) {
                 DEBUG ("Skip seq[%u] already read before shutdown.", l_read_seq_ud);
                 continue;
             }
@@ -921,7 +919,7 @@ TEST(write_too_much_but_continue_safely) {
             //the first message(s) after cold start, may already be read when the block
             //was not completely read before shut down
             //if so, skip them...
-            if (l_read_seq_ud < l_next_rd_id_d + 1) {
+            if (l_read_seq_ud < (hl_blocks_msg_seq_t)(l_next_rd_id_d + 1)) {
                 DEBUG ("Skip seq[%u] already read before shutdown.", l_read_seq_ud);
                 continue;
             }
@@ -980,11 +978,1222 @@ TEST(write_too_much_but_continue_safely) {
 }//TEST()
 
 
+//in overwrite mode, writing never fails when full, the oldest messages
+//are dropped and the reader continues with the oldest remaining message
+TEST(overwrite_oldest_when_full) {
+    START(
+        128,    //block size
+        4,      //nr of blocks
+        128,    //max message size
+        16);    //min data per message part
+
+    if (hl_blocks_r_set_full_mode (l_blocks_pz, HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST) != 0)
+        return ERROR (-1, "failed to set overwrite mode");
+
+    const uint32_t l_test_msg_len_ud = 50;
+
+    //write far more than fits in the buffer without reading
+    const int l_nr_msgs_d = 40;
+    for (int i = 0; i < l_nr_msgs_d; i ++)
+    {
+        char                        l_msg_ac[100];
+        m_r_make_test_msg (l_msg_ac, sizeof (l_msg_ac), i, l_test_msg_len_ud);
+        size_t l_len_ud = strlen(l_msg_ac);
+        hl_blocks_msg_seq_t l_write_seq_ud = 0;
+        if (hl_blocks_r_write (
+                l_blocks_pz,
+                l_msg_ac, l_len_ud + 1,
+                &l_write_seq_ud)
+                != 0)
+            return ERROR(-1,
+                "failed to write msg[%d]", i);
+        ASSERT_INT_EQ (i + 1, l_write_seq_ud);
+    }/*for each messages to write*/
+
+    uint32_t                    l_dropped_ud = 0;
+    hl_blocks_msg_seq_t         l_last_dropped_ud = 0;
+    if (hl_blocks_r_get_dropped (l_blocks_pz, &l_dropped_ud, NULL, NULL, &l_last_dropped_ud) != 0)
+        return ERROR (-1, "failed to get dropped");
+    if (l_dropped_ud == 0)
+        return ERROR (-1, "expected messages to be dropped");
+
+    //must read all messages after the last dropped, in sequence
+    int l_next_rd_id_d = l_last_dropped_ud;
+    while (l_next_rd_id_d < l_nr_msgs_d)
+    {
+        char                        l_buf_ac[100];
+        size_t                      l_read_size_ud = 0;
+        hl_blocks_msg_seq_t         l_read_seq_ud = 0;
+        if (hl_blocks_r_read (
+                l_blocks_pz,
+                l_buf_ac, sizeof (l_buf_ac),
+                &l_read_size_ud,
+                &l_read_seq_ud)
+                != 0)
+            return ERROR (-1,
+                "failed to read msg[%d]", l_next_rd_id_d);
+
+        char                        l_exp_msg_ac[100];
+        m_r_make_test_msg (l_exp_msg_ac, sizeof (l_exp_msg_ac), l_next_rd_id_d, l_test_msg_len_ud);
+        ASSERT_INT_EQ (l_next_rd_id_d + 1, l_read_seq_ud);
+        ASSERT_STR_EQ (l_exp_msg_ac, l_buf_ac);
+        l_next_rd_id_d ++;
+    }/*while reading*/
+
+    ASSERT_INT_EQ (l_nr_msgs_d, l_dropped_ud + (l_nr_msgs_d - l_last_dropped_ud));
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//messages spanning blocks must be dropped completely when the block
+//with the first part is dropped, also while the reader is in that block
+TEST(overwrite_oldest_with_spanning_messages) {
+    START(
+        64,     //block size
+        5,      //nr of blocks
+        128,    //max message size
+        8);     //min data per message part
+
+    if (hl_blocks_r_set_full_mode (l_blocks_pz, HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST) != 0)
+        return ERROR (-1, "failed to set overwrite mode");
+
+    int l_next_wr_id_d = 0;
+    int l_next_rd_id_d = 0;
+    for (int i = 0; i < 200; i ++)
+    {
+        //write a few messages of various sizes, up to 2 blocks long
+        for (int j = 0; j < 3; j ++)
+        {
+            char                        l_msg_ac[100];
+            m_r_make_test_msg (l_msg_ac, sizeof (l_msg_ac), l_next_wr_id_d, 10 + (l_next_wr_id_d * 7) % 80);
+            size_t l_len_ud = strlen(l_msg_ac);
+            if (hl_blocks_r_write (
+                    l_blocks_pz,
+                    l_msg_ac, l_len_ud + 1,
+                    NULL)
+                    != 0)
+                return ERROR(-1,
+                    "failed to write msg[%d]", l_next_wr_id_d);
+            l_next_wr_id_d ++;
+        }/*for each msg to write*/
+
+        //read one, which may be after some dropped messages
+        char                        l_buf_ac[100];
+        size_t                      l_read_size_ud = 0;
+        hl_blocks_msg_seq_t         l_read_seq_ud = 0;
+        if (hl_blocks_r_read (
+                l_blocks_pz,
+                l_buf_ac, sizeof (l_buf_ac),
+                &l_read_size_ud,
+                &l_read_seq_ud)
+                != 0)
+            return ERROR (-1,
+                "failed to read msg[%d]", l_next_rd_id_d);
+
+        if (l_read_seq_ud < (hl_blocks_msg_seq_t)(l_next_rd_id_d + 1))
+            return ERROR (-1, "read seq %u went backwards, expected >= %d", l_read_seq_ud, l_next_rd_id_d + 1);
+        l_next_rd_id_d = l_read_seq_ud - 1;
+
+        char                        l_exp_msg_ac[100];
+        m_r_make_test_msg (l_exp_msg_ac, sizeof (l_exp_msg_ac), l_next_rd_id_d, 10 + (l_next_rd_id_d * 7) % 80);
+        ASSERT_STR_EQ (l_exp_msg_ac, l_buf_ac);
+        l_next_rd_id_d ++;
+    }/*for each round*/
+
+    uint32_t                    l_dropped_ud = 0;
+    if (hl_blocks_r_get_dropped (l_blocks_pz, &l_dropped_ud, NULL, NULL, NULL) != 0)
+        return ERROR (-1, "failed to get dropped");
+    if (l_dropped_ud == 0)
+        return ERROR (-1, "expected messages to be dropped");
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+
+//write one test message with the given prio and id
+#define WRITE_PRIO_MSG(prio, id, len)                                           \
+    {                                                                           \
+        char                        l_msg_ac[100];                              \
+        m_r_make_test_msg (l_msg_ac, sizeof (l_msg_ac), id, len);               \
+        if (hl_blocks_r_write_prio (                                            \
+                l_blocks_pz, prio,                                              \
+                l_msg_ac, strlen (l_msg_ac) + 1,                                \
+                NULL)                                                           \
+                != 0)                                                           \
+            return ERROR (-1, "failed to write prio %u msg[%d]", prio, id);     \
+    }
+
+//read the next message and verify it is the test message with the given id
+#define READ_EXPECTED_MSG(id, len)                                              \
+    {                                                                           \
+        char                        l_buf_ac[100];                              \
+        size_t                      l_read_size_ud = 0;                         \
+        if (hl_blocks_r_read (                                                  \
+                l_blocks_pz,                                                    \
+                l_buf_ac, sizeof (l_buf_ac),                                    \
+                &l_read_size_ud,                                                \
+                NULL)                                                           \
+                != 0)                                                           \
+            return ERROR (-1, "failed to read msg[%d]", id);                    \
+        char                        l_exp_msg_ac[100];                          \
+        m_r_make_test_msg (l_exp_msg_ac, sizeof (l_exp_msg_ac), id, len);       \
+        ASSERT_STR_EQ (l_exp_msg_ac, l_buf_ac);                                 \
+    }
+
+//higher prio messages are read before all lower prio messages
+//regardless of being in flash or heap
+TEST(prio_read_highest_first) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.nr_prios_ud = 3;
+    START_OPTIONS(
+        128,    //block size
+        12,     //nr of blocks
+        128,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    //backlog of prio 0 in several flash blocks, then some of prio 2 and 1
+    for (int i = 0; i < 8; i ++)
+        WRITE_PRIO_MSG (0, i, 50);
+    for (int i = 100; i < 104; i ++)
+        WRITE_PRIO_MSG (2, i, 50);
+    for (int i = 200; i < 202; i ++)
+        WRITE_PRIO_MSG (1, i, 20);
+
+    for (int i = 100; i < 104; i ++)
+        READ_EXPECTED_MSG (i, 50);
+
+    //more prio 0 while prio 1 is waiting, then prio 2 again
+    WRITE_PRIO_MSG (0, 8, 50);
+    WRITE_PRIO_MSG (2, 104, 30);
+    READ_EXPECTED_MSG (104, 30);
+    for (int i = 200; i < 202; i ++)
+        READ_EXPECTED_MSG (i, 20);
+    for (int i = 0; i < 9; i ++)
+        READ_EXPECTED_MSG (i, 50);
+
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//after cold start, each prio continues where it was read before
+//and space is reused after blocks of all prios were read
+TEST(prio_cold_start_and_rotation) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.nr_prios_ud = 2;
+    START_OPTIONS(
+        128,    //block size
+        8,      //nr of blocks
+        128,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    int l_next_wr_ad[2] = {0, 1000};
+    int l_next_rd_ad[2] = {0, 1000};
+    for (int l_round_d = 0; l_round_d < 20; l_round_d ++)
+    {
+        //write a mix of both prios, spanning blocks
+        for (int j = 0; j < 3; j ++)
+        {
+            int l_prio_d = (l_round_d + j) % 2;
+            WRITE_PRIO_MSG (l_prio_d, l_next_wr_ad[l_prio_d], 60);
+            l_next_wr_ad[l_prio_d] ++;
+        }
+
+        if (l_round_d == 10)
+        {
+            //cold start half way
+            if (hl_blocks_r_close (&l_blocks_pz) != 0)
+                return ERROR (-1, "Failed to close before cold start");
+            if (hl_blocks_r_open_options (
+                        128,
+                        8,
+                        128,
+                        16,
+                        m_r_block_write,
+                        m_r_block_addr,
+                        &l_options_z,
+                        &l_blocks_pz)
+                        != 0)
+                return ERROR(-1, "failed to open blocks for cold start");
+        }
+
+        //read all high prio, then some of low prio
+        while (l_next_rd_ad[1] < l_next_wr_ad[1])
+        {
+            READ_EXPECTED_MSG (l_next_rd_ad[1], 60);
+            l_next_rd_ad[1] ++;
+        }
+        for (int j = 0; j < 2; j ++)
+        {
+            if (l_next_rd_ad[0] == l_next_wr_ad[0])
+                break;
+            READ_EXPECTED_MSG (l_next_rd_ad[0], 60);
+            l_next_rd_ad[0] ++;
+        }
+    }/*for each round*/
+
+    while (l_next_rd_ad[0] < l_next_wr_ad[0])
+    {
+        READ_EXPECTED_MSG (l_next_rd_ad[0], 60);
+        l_next_rd_ad[0] ++;
+    }
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+
+//drain all prios to a pipe in writes smaller than a message
+//and get each message once after its size, in read order
+TEST(drain_fd_with_framing_in_small_writes) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.nr_prios_ud = 2;
+    START_OPTIONS(
+        128,    //block size
+        12,     //nr of blocks
+        128,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    for (int i = 0; i < 10; i ++)
+        WRITE_PRIO_MSG (0, i, 50);
+    for (int i = 100; i < 103; i ++)
+        WRITE_PRIO_MSG (1, i, 30);
+
+    int                         l_pipe_ad[2];
+    if (pipe (l_pipe_ad) != 0)
+        return ERROR (-1, "failed to create pipe");
+
+    size_t                      l_total_ud = 0;
+    uint32_t                    l_total_msgs_ud = 0;
+    while (1)
+    {
+        size_t                      l_drained_ud = 0;
+        uint32_t                    l_nr_msgs_ud = 0;
+        int l_result_d = hl_blocks_r_drain_fd (l_blocks_pz, l_pipe_ad[1], 37, HL_BLOCKS_K_FRAMING_LEN32, &l_drained_ud, &l_nr_msgs_ud);
+        if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+            break;
+        if (l_result_d != 0)
+            return ERROR (-1, "failed to drain");
+        ASSERT_INT_EQ (1, (l_drained_ud > 0) && (l_drained_ud <= 37));
+        l_total_ud += l_drained_ud;
+        l_total_msgs_ud += l_nr_msgs_ud;
+    }
+    ASSERT_INT_EQ (13, l_total_msgs_ud);
+    ASSERT_INT_EQ (3 * (4 + 31) + 10 * (4 + 51), l_total_ud);
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+
+    unsigned char               l_out_auc[1024];
+    ssize_t l_size_d = read (l_pipe_ad[0], l_out_auc, sizeof (l_out_auc));
+    close (l_pipe_ad[0]);
+    close (l_pipe_ad[1]);
+    ASSERT_INT_EQ (l_total_ud, l_size_d);
+
+    size_t l_ofs_ud = 0;
+    for (int n = 0; n < 13; n ++)
+    {
+        int l_id_d = (n < 3) ? (100 + n) : (n - 3);
+        uint32_t l_len_ud = (n < 3) ? 30 : 50;
+        char                        l_exp_msg_ac[100];
+        m_r_make_test_msg (l_exp_msg_ac, sizeof (l_exp_msg_ac), l_id_d, l_len_ud);
+        uint32_t                    l_frame_ud;
+        memcpy (&l_frame_ud, l_out_auc + l_ofs_ud, sizeof (l_frame_ud));
+        ASSERT_INT_EQ (l_len_ud + 1, ntohl (l_frame_ud));
+        ASSERT_STR_EQ (l_exp_msg_ac, (const char*)l_out_auc + l_ofs_ud + 4);
+        l_ofs_ud += 4 + l_len_ud + 1;
+    }
+
+    //blocks were released, so all space can be written again
+    for (int i = 10; i < 24; i ++)
+        WRITE_PRIO_MSG (0, i, 50);
+    for (int i = 10; i < 24; i ++)
+        READ_EXPECTED_MSG (i, 50);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+
+//read the next message and return its id from the text "test(<id>)"
+#define READ_MSG_ID(id)                                                         \
+    {                                                                           \
+        char                        l_buf_ac[100];                              \
+        size_t                      l_read_size_ud = 0;                         \
+        if (hl_blocks_r_read (                                                  \
+                l_blocks_pz,                                                    \
+                l_buf_ac, sizeof (l_buf_ac),                                    \
+                &l_read_size_ud,                                                \
+                NULL)                                                           \
+                != 0)                                                           \
+            return ERROR (-1, "failed to read msg");                            \
+        if (sscanf (l_buf_ac, "test(%d)", &id) != 1)                            \
+            return ERROR (-1, "unexpected msg \"%s\"", l_buf_ac);               \
+    }
+
+//open from the checkpoint reads only a few blocks
+//and continues at the message after the last read, inside a block
+TEST(checkpoint_resume_at_read_offset) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.checkpoint_ud = 1;
+    START_OPTIONS(
+        128,    //block size
+        32,     //nr of blocks incl 2 for the checkpoint
+        128,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    for (int i = 0; i < 20; i ++)
+        WRITE_PRIO_MSG (0, i, 30);
+    for (int i = 0; i < 5; i ++)
+        READ_EXPECTED_MSG (i, 30);
+    if (hl_blocks_r_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "Failed to close before cold start");
+
+    m_d_addr_count_ud = 0;
+    if (hl_blocks_r_open_options (128, 32, 128, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks for cold start");
+    if (m_d_addr_count_ud >= 10)
+        return ERROR (-1, "open read %u blocks, expected only the checkpoint and a few", m_d_addr_count_ud);
+
+    for (int i = 5; i < 20; i ++)
+        READ_EXPECTED_MSG (i, 30);
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//after a power cut between writing a block and its checkpoint,
+//and after reading blocks since the checkpoint, open rolls forward
+//and reads all synced messages not yet read, without gaps
+TEST(checkpoint_roll_forward_after_power_cut) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.checkpoint_ud = 1;
+    l_options_z.nr_prios_ud   = 2;
+    START_OPTIONS(
+        128,    //block size
+        12,     //nr of blocks incl 2 for the checkpoint
+        128,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    //go around the ring a few times first
+    int l_next_wr_d = 0;
+    int l_next_rd_d = 0;
+    for (int l_round_d = 0; l_round_d < 6; l_round_d ++) {
+        for (int i = 0; i < 8; i ++)
+            WRITE_PRIO_MSG (0, l_next_wr_d + i, 40);
+        l_next_wr_d += 8;
+        for (int i = 0; i < 8; i ++)
+            READ_EXPECTED_MSG (l_next_rd_d + i, 40);
+        l_next_rd_d += 8;
+    }
+    WRITE_PRIO_MSG (1, 1000, 20);
+    for (int i = 0; i < 6; i ++)
+        WRITE_PRIO_MSG (0, l_next_wr_d + i, 40);
+    l_next_wr_d += 6;
+    if (hl_blocks_r_sync (l_blocks_pz) != 0)
+        return ERROR (-1, "failed to sync");
+
+    //checkpoint as it was before the last blocks
+    unsigned char               l_ckpt_auc[2 * 128];
+    memcpy (l_ckpt_auc, m_d_mock_flash_mem_auc, sizeof (l_ckpt_auc));
+    for (int i = 0; i < 4; i ++)
+        WRITE_PRIO_MSG (0, l_next_wr_d + i, 40);
+    l_next_wr_d += 4;
+    if (hl_blocks_r_sync (l_blocks_pz) != 0)
+        return ERROR (-1, "failed to sync");
+    memcpy (m_d_mock_flash_mem_auc, l_ckpt_auc, sizeof (l_ckpt_auc));
+
+    //read a few after the checkpoint
+    READ_EXPECTED_MSG (1000, 20);
+    for (int i = 0; i < 4; i ++)
+        READ_EXPECTED_MSG (l_next_rd_d + i, 40);
+
+    //power cut: open again without closing
+    hl_blocks_t*                l_old_blocks_pz = l_blocks_pz;
+    if (hl_blocks_r_open_options (128, 12, 128, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks after power cut");
+
+    //messages read after the checkpoint may be read again
+    int l_id_d = -1;
+    READ_MSG_ID (l_id_d);
+    if (l_id_d == 1000)
+        READ_MSG_ID (l_id_d);
+    if ((l_id_d < l_next_rd_d) || (l_id_d > l_next_rd_d + 4))
+        return ERROR (-1, "first msg after power cut is %d, expected %d..%d", l_id_d, l_next_rd_d, l_next_rd_d + 4);
+    for (int i = l_id_d + 1; i < l_next_wr_d; i ++)
+        READ_EXPECTED_MSG (i, 40);
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+
+    //new messages continue after the last ones
+    hl_blocks_msg_seq_t         l_seq_ud = 0;
+    char                        l_msg_ac[100];
+    m_r_make_test_msg (l_msg_ac, sizeof (l_msg_ac), 2000, 40);
+    if (hl_blocks_r_write (l_blocks_pz, l_msg_ac, strlen (l_msg_ac) + 1, &l_seq_ud) != 0)
+        return ERROR (-1, "failed to write after power cut");
+    ASSERT_INT_EQ (l_next_wr_d + 1 + 1, l_seq_ud);
+    READ_EXPECTED_MSG (2000, 40);
+
+    hl_blocks_r_close (&l_old_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//the checkpoint is written on sync and close, and with
+//checkpoint_every_ud also after that many blocks
+TEST(checkpoint_on_sync_or_every_blocks) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.checkpoint_ud = 1;
+    START_OPTIONS(
+        128,    //block size
+        32,     //nr of blocks incl 2 for the checkpoint
+        128,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    //full blocks do not write the checkpoint
+    uint32_t l_generation_ud = m_r_checkpoint_generation ();
+    for (int i = 0; i < 20; i ++)
+        WRITE_PRIO_MSG (0, i, 30);
+    hl_blocks_stats_t           l_stats_z;
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    if (l_stats_z.blocks_written_ud < 4)
+        return ERROR (-1, "wrote %llu blocks, expected more", (unsigned long long)l_stats_z.blocks_written_ud);
+    ASSERT_INT_EQ (l_generation_ud, m_r_checkpoint_generation ());
+    ASSERT_INT_EQ (0, hl_blocks_r_sync (l_blocks_pz));
+    ASSERT_INT_EQ (l_generation_ud + 1, m_r_checkpoint_generation ());
+    if (hl_blocks_r_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "Failed to close");
+    ASSERT_INT_EQ (l_generation_ud + 2, m_r_checkpoint_generation ());
+
+    //every 2 blocks
+    l_options_z.checkpoint_every_ud = 2;
+    if (hl_blocks_r_open_options (128, 32, 128, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks");
+    l_generation_ud = m_r_checkpoint_generation ();
+    for (int i = 20; i < 40; i ++)
+        WRITE_PRIO_MSG (0, i, 30);
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    ASSERT_INT_EQ (l_generation_ud + l_stats_z.blocks_written_ud / 2, m_r_checkpoint_generation ());
+
+    //power cut: open again without closing, rolls forward over the blocks
+    //after the last checkpoint, only the messages in heap are lost
+    hl_blocks_t*                l_old_blocks_pz = l_blocks_pz;
+    if (hl_blocks_r_open_options (128, 32, 128, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks after power cut");
+    int l_next_rd_d = 0;
+    for (;;) {
+        char                        l_buf_ac[100];
+        size_t                      l_read_size_ud = 0;
+        int l_result_d = hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_read_size_ud, NULL);
+        if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+            break;
+        int l_id_d = -1;
+        if (  (l_result_d != 0)
+           || (sscanf (l_buf_ac, "test(%d)", &l_id_d) != 1))
+            return ERROR (-1, "failed to read msg %d after power cut", l_next_rd_d);
+        ASSERT_INT_EQ (l_next_rd_d, l_id_d);
+        l_next_rd_d ++;
+    }
+    if (l_next_rd_d < 36)
+        return ERROR (-1, "read %d msgs after power cut, expected all but the last few", l_next_rd_d);
+
+    hl_blocks_r_close (&l_old_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//stats of a message padded to the next block, an explicit sync,
+//a rejected write, a split message and reads from flash and heap
+TEST(stats_count_writes_syncs_and_reads) {
+    START(
+        128,    //block size, 112 data bytes
+        4,      //nr of blocks
+        200,    //max message size
+        16);    //min data per message part
+
+    hl_blocks_stats_t           l_stats_z;
+    char                        l_msg_ac[200];
+    char                        l_buf_ac[200];
+    size_t                      l_size_ud = 0;
+    memset (l_msg_ac, 'x', sizeof (l_msg_ac));
+
+    //80+16 bytes leave 16 in blk[0], too little for the next part
+    ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_ac, 80, NULL));
+    ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_ac, 40, NULL));
+    ASSERT_INT_EQ (0, hl_blocks_r_sync (l_blocks_pz));
+
+    //needs 2 more blocks, only blk[3] is left for the heap
+    ASSERT_INT_EQ (HL_BLOCKS_K_ERROR_NO_SPACE_LEFT_IN_BUFFER, hl_blocks_r_write (l_blocks_pz, l_msg_ac, 150, NULL));
+    ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_size_ud, NULL));
+    ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_ac, 150, NULL));
+    ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_size_ud, NULL));
+    ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_size_ud, NULL));
+    ASSERT_INT_EQ (150, l_size_ud);
+    ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_ac, 10, NULL));
+    ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_size_ud, NULL));
+
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    ASSERT_INT_EQ (4, (uint32_t)l_stats_z.msgs_written_ud);
+    ASSERT_INT_EQ (80 + 40 + 150 + 10, (uint32_t)l_stats_z.bytes_written_ud);
+    ASSERT_INT_EQ (1, (uint32_t)l_stats_z.msgs_split_ud);
+    ASSERT_INT_EQ (5, (uint32_t)l_stats_z.parts_written_ud);
+    ASSERT_INT_EQ (4, (uint32_t)l_stats_z.msgs_read_ud);
+    ASSERT_INT_EQ (80 + 40 + 150 + 10, (uint32_t)l_stats_z.bytes_read_ud);
+    ASSERT_INT_EQ (3, (uint32_t)l_stats_z.reads_flash_ud);
+    ASSERT_INT_EQ (1, (uint32_t)l_stats_z.reads_heap_ud);
+    ASSERT_INT_EQ (2, (uint32_t)l_stats_z.syncs_full_ud);
+    ASSERT_INT_EQ (1, (uint32_t)l_stats_z.syncs_explicit_ud);
+    ASSERT_INT_EQ (3, (uint32_t)l_stats_z.blocks_written_ud);
+    ASSERT_INT_EQ (3, hl_blocks_r___get_write_count (l_blocks_pz));
+    ASSERT_INT_EQ (96 + 56 + 112, (uint32_t)l_stats_z.block_used_ud);
+    ASSERT_INT_EQ (16, (uint32_t)l_stats_z.pad_bytes_ud);
+    ASSERT_INT_EQ (1, (uint32_t)l_stats_z.rejects_full_ud);
+    ASSERT_INT_EQ (0, (uint32_t)l_stats_z.corruptions_ud);
+    ASSERT_INT_EQ (0, (uint32_t)l_stats_z.drop_msgs_ud);
+    ASSERT_INT_EQ ((96 + 56 + 112) * 1000 / (3 * 112), (uint32_t)(l_stats_z.fill_ratio_d * 1000));
+
+    //latency is not kept without the option
+    latency_hist_t              l_hist_z;
+    if (hl_blocks_r_get_latency (l_blocks_pz, HL_BLOCKS_K_LATENCY_WRITE, 0, &l_hist_z) == 0)
+        return ERROR (-1, "got latency when not kept");
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//percentiles are the highest value of their bucket, within 12.5%
+//and each call of hl_blocks is counted in its histogram until reset
+TEST(latency_histograms_and_reset) {
+    latency_hist_t              l_hist_z;
+    memset (&l_hist_z, 0, sizeof (l_hist_z));
+    ASSERT_INT_EQ (0, (uint32_t)latency_hist_r_percentile (&l_hist_z, 50));
+    for (int i = 0; i < 100; i ++)
+        latency_hist_r_add (&l_hist_z, 1000);
+    latency_hist_r_add (&l_hist_z, 1000000);
+    ASSERT_INT_EQ (1023, (uint32_t)latency_hist_r_percentile (&l_hist_z, 50));
+    ASSERT_INT_EQ (1023, (uint32_t)latency_hist_r_percentile (&l_hist_z, 99));
+    ASSERT_INT_EQ (1048575, (uint32_t)latency_hist_r_percentile (&l_hist_z, 99.9));
+    ASSERT_INT_EQ (1048575, (uint32_t)latency_hist_r_percentile (&l_hist_z, 100));
+    ASSERT_INT_EQ (101, (uint32_t)l_hist_z.count_ud);
+
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.latency_ud = 1;
+    START_OPTIONS(
+        128,    //block size
+        8,      //nr of blocks
+        128,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    for (int i = 0; i < 10; i ++)
+        WRITE_PRIO_MSG (0, i, 40);
+    ASSERT_INT_EQ (0, hl_blocks_r_sync (l_blocks_pz));
+    for (int i = 0; i < 10; i ++)
+        READ_EXPECTED_MSG (i, 40);
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+
+    ASSERT_INT_EQ (0, hl_blocks_r_get_latency (l_blocks_pz, HL_BLOCKS_K_LATENCY_OPEN, 0, &l_hist_z));
+    ASSERT_INT_EQ (1, (uint32_t)l_hist_z.count_ud);
+    ASSERT_INT_EQ (0, hl_blocks_r_get_latency (l_blocks_pz, HL_BLOCKS_K_LATENCY_SYNC, 0, &l_hist_z));
+    ASSERT_INT_EQ (1, (uint32_t)l_hist_z.count_ud);
+    ASSERT_INT_EQ (0, hl_blocks_r_get_latency (l_blocks_pz, HL_BLOCKS_K_LATENCY_READ, 0, &l_hist_z));
+    ASSERT_INT_EQ (10, (uint32_t)l_hist_z.count_ud);
+    ASSERT_INT_EQ (0, hl_blocks_r_get_latency (l_blocks_pz, HL_BLOCKS_K_LATENCY_WRITE_PR, 0, &l_hist_z));
+    ASSERT_INT_EQ (hl_blocks_r___get_write_count (l_blocks_pz), (uint32_t)l_hist_z.count_ud);
+
+    //reset: only the writes after it are counted
+    ASSERT_INT_EQ (0, hl_blocks_r_get_latency (l_blocks_pz, HL_BLOCKS_K_LATENCY_WRITE, 1, &l_hist_z));
+    ASSERT_INT_EQ (10, (uint32_t)l_hist_z.count_ud);
+    if (latency_hist_r_percentile (&l_hist_z, 100) < latency_hist_r_percentile (&l_hist_z, 50))
+        return ERROR (-1, "max below median");
+    WRITE_PRIO_MSG (0, 10, 40);
+    ASSERT_INT_EQ (0, hl_blocks_r_get_latency (l_blocks_pz, HL_BLOCKS_K_LATENCY_WRITE, 0, &l_hist_z));
+    ASSERT_INT_EQ (1, (uint32_t)l_hist_z.count_ud);
+    READ_EXPECTED_MSG (10, 40);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//messages up to whole_max are moved whole to the next block
+//instead of split, bigger ones are still split
+TEST(whole_messages_not_split) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.whole_max_ud = 64;
+    START_OPTIONS(
+        128,    //block size, 112 data bytes
+        8,      //nr of blocks
+        200,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    char                        l_msg_ac[200];
+    char                        l_buf_ac[200];
+    size_t                      l_size_ud = 0;
+    const size_t                l_size_aud[3] = {60, 30, 100};
+
+    //16+60 leaves 36 bytes in blk[0], where 16+20 of the next would fit
+    //then 16+30 in blk[1] leaves 66 for the first 50 of 100
+    for (int i = 0; i < 3; i ++) {
+        memset (l_msg_ac, 'a' + i, sizeof (l_msg_ac));
+        ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_ac, l_size_aud[i], NULL));
+    }
+
+    hl_blocks_stats_t           l_stats_z;
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    ASSERT_INT_EQ (1, (uint32_t)l_stats_z.msgs_moved_whole_ud);
+    ASSERT_INT_EQ (36, (uint32_t)l_stats_z.whole_pad_bytes_ud);
+    ASSERT_INT_EQ (36, (uint32_t)l_stats_z.pad_bytes_ud);
+    ASSERT_INT_EQ (1, (uint32_t)l_stats_z.msgs_split_ud);
+    ASSERT_INT_EQ (4, (uint32_t)l_stats_z.parts_written_ud);
+
+    for (int i = 0; i < 3; i ++) {
+        ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_size_ud, NULL));
+        ASSERT_INT_EQ (l_size_aud[i], l_size_ud);
+        memset (l_msg_ac, 'a' + i, sizeof (l_msg_ac));
+        ASSERT_INT_EQ (0, memcmp (l_msg_ac, l_buf_ac, l_size_ud));
+    }
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+
+    //must fit in a block with the headers
+    hl_blocks_t*                l_other_pz = NULL;
+    l_options_z.whole_max_ud = 128 - 32 + 1;
+    if (hl_blocks_r_open_options (128, 8, 200, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_other_pz) == 0)
+        return ERROR (-1, "opened with whole_max bigger than a block");
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//whole blocks of a large message written with writev from the data
+//are the same as written through the heap block
+TEST(direct_writev_of_large_messages) {
+    START(
+        128,    //block size, 112 data bytes
+        16,     //nr of blocks
+        1000,   //max message size
+        16);    //min data per message part
+
+    static unsigned char        l_image_auc[16 * 128];
+    unsigned char               l_msg_auc[500];
+    unsigned char               l_buf_auc[500];
+    size_t                      l_size_ud = 0;
+    const size_t                l_size_aud[4] = {20, 500, 30, 400};
+    hl_blocks_stats_t           l_stats_z;
+
+    for (int l_direct_d = 0; l_direct_d < 2; l_direct_d ++)
+    {
+        if (l_direct_d) {
+            //again on empty flash
+            ASSERT_INT_EQ (0, hl_blocks_r_close (&l_blocks_pz));
+            memset (m_d_mock_flash_mem_auc, 0, sizeof (l_image_auc));
+            ASSERT_INT_EQ (0, hl_blocks_r_open (128, 16, 1000, 16, m_r_block_write, m_r_block_addr, &l_blocks_pz));
+            ASSERT_INT_EQ (0, hl_blocks_r_set_writev (l_blocks_pz, m_r_block_writev));
+        }
+        for (int i = 0; i < 4; i ++) {
+            for (size_t j = 0; j < l_size_aud[i]; j ++)
+                l_msg_auc[j] = (unsigned char)(i * 7 + j);
+            ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_auc, l_size_aud[i], NULL));
+        }
+        ASSERT_INT_EQ (0, hl_blocks_r_sync (l_blocks_pz));
+        if (!l_direct_d)
+            memcpy (l_image_auc, m_d_mock_flash_mem_auc, sizeof (l_image_auc));
+    }/*for without and with writev*/
+
+    //500 after 20: 60 in the heap block, 4 direct blocks of 96, 56 in the heap block
+    //400 after 30: 10 in the heap block, 3 direct blocks, 102 in the heap block
+    ASSERT_INT_EQ (0, memcmp (l_image_auc, m_d_mock_flash_mem_auc, sizeof (l_image_auc)));
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    ASSERT_INT_EQ (7, (uint32_t)l_stats_z.blocks_direct_ud);
+
+    for (int i = 0; i < 4; i ++) {
+        ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_auc, sizeof (l_buf_auc), &l_size_ud, NULL));
+        ASSERT_INT_EQ (l_size_aud[i], l_size_ud);
+        for (size_t j = 0; j < l_size_aud[i]; j ++)
+            l_msg_auc[j] = (unsigned char)(i * 7 + j);
+        ASSERT_INT_EQ (0, memcmp (l_msg_auc, l_buf_auc, l_size_ud));
+    }
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//message data is aligned in flash and read back from flash and heap,
+//also after opening again packed
+TEST(aligned_message_data) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.align_ud = 8;
+    START_OPTIONS(
+        128,    //block size, 112 data bytes
+        8,      //nr of blocks
+        300,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    unsigned char               l_msg_auc[300];
+    unsigned char               l_buf_auc[300];
+    size_t                      l_size_ud = 0;
+    const size_t                l_size_aud[6] = {5, 13, 200, 3, 21, 7};
+
+    for (int i = 0; i < 5; i ++) {
+        memset (l_msg_auc, 'a' + i, sizeof (l_msg_auc));
+        ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_auc, l_size_aud[i], NULL));
+    }
+    hl_blocks_stats_t           l_stats_z;
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    ASSERT_INT_EQ (3 + 3 + 5 + 3, (uint32_t)l_stats_z.align_pad_bytes_ud);
+
+    //every part in the blocks written starts at an aligned address
+    uint32_t l_nr_parts_ud = 0;
+    for (uint32_t l_idx_ud = 0; l_idx_ud < 8; l_idx_ud ++) {
+        const blk_head_t* l_blk_head_pz = (const blk_head_t*)(m_d_mock_flash_mem_auc + l_idx_ud * 128);
+        if (l_blk_head_pz->seq_ud == 0)
+            continue;
+        ASSERT_INT_EQ (8, l_blk_head_pz->align_ud);
+        uint32_t l_ofs_ud = 0;
+        while (l_ofs_ud < l_blk_head_pz->used_size_ud) {
+            const msg_head_t* l_msg_head_pz = (const msg_head_t*)((const unsigned char*)(l_blk_head_pz + 1) + l_ofs_ud);
+            ASSERT_INT_EQ (0, (uint32_t)((uintptr_t)(l_msg_head_pz + 1) % 8));
+            l_ofs_ud += HL_BLOCKS_PART_STEP (l_blk_head_pz->align_ud, l_msg_head_pz->part_size_ud);
+            l_nr_parts_ud ++;
+        }
+        ASSERT_INT_EQ (l_blk_head_pz->used_size_ud, l_ofs_ud);
+    }
+    if (l_nr_parts_ud < 3)
+        return ERROR (-1, "only %u parts in flash", l_nr_parts_ud);
+
+    //read 3 before and the rest after opening again without alignment
+    for (int i = 0; i < 6; i ++) {
+        if (i == 3) {
+            ASSERT_INT_EQ (0, hl_blocks_r_close (&l_blocks_pz));
+            l_options_z.align_ud = 0;
+            ASSERT_INT_EQ (0, hl_blocks_r_open_options (128, 8, 300, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_blocks_pz));
+            memset (l_msg_auc, 'a' + 5, sizeof (l_msg_auc));
+            ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_auc, l_size_aud[5], NULL));
+        }
+        ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_auc, sizeof (l_buf_auc), &l_size_ud, NULL));
+        ASSERT_INT_EQ (l_size_aud[i], l_size_ud);
+        memset (l_msg_auc, 'a' + i, sizeof (l_msg_auc));
+        ASSERT_INT_EQ (0, memcmp (l_msg_auc, l_buf_auc, l_size_ud));
+    }
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+
+    //the block size must be a multiple of the alignment
+    hl_blocks_t*                l_other_pz = NULL;
+    l_options_z.align_ud = 16;
+    if (hl_blocks_r_open_options (120, 8, 300, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_other_pz) == 0)
+        return ERROR (-1, "opened with block size 120 and align 16");
+    l_options_z.align_ud = 6;
+    if (hl_blocks_r_open_options (128, 8, 300, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_other_pz) == 0)
+        return ERROR (-1, "opened with align 6");
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//with a linear mapping open and read get the block addresses without addr_pr()
+TEST(linear_mapped_flash_without_addr_pr) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.checkpoint_ud = 1;
+    START_OPTIONS(
+        128,    //block size
+        32,     //nr of blocks incl 2 for the checkpoint
+        128,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    for (int i = 0; i < 20; i ++)
+        WRITE_PRIO_MSG (0, i, 30);
+    for (int i = 0; i < 5; i ++)
+        READ_EXPECTED_MSG (i, 30);
+    ASSERT_INT_EQ (0, hl_blocks_r_close (&l_blocks_pz));
+
+    //the stride must not be less than a block
+    l_options_z.linear_base_p    = m_d_mock_flash_mem_auc;
+    l_options_z.linear_stride_ud = 64;
+    if (hl_blocks_r_open_options (128, 32, 128, 16, m_r_block_write, NULL, &l_options_z, &l_blocks_pz) == 0)
+        return ERROR (-1, "opened with a stride less than the block size");
+
+    m_d_addr_count_ud = 0;
+    l_options_z.linear_stride_ud = 0;
+    ASSERT_INT_EQ (0, hl_blocks_r_open_options (128, 32, 128, 16, m_r_block_write, NULL, &l_options_z, &l_blocks_pz));
+
+    //wrap around the ring a few times
+    for (int i = 20; i < 120; i ++) {
+        WRITE_PRIO_MSG (0, i, 30);
+        READ_EXPECTED_MSG (i - 15, 30);
+    }
+    for (int i = 105; i < 120; i ++)
+        READ_EXPECTED_MSG (i, 30);
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    ASSERT_INT_EQ (0, m_d_addr_count_ud);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//readers with their own cursor each get the messages with their tags,
+//passing over blocks by their tag map, and nothing is consumed
+TEST(tagged_messages_filtered_read) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.tag_map_ud = 1;
+    START_OPTIONS(
+        128,    //block size, 104 data bytes after the tag map
+        16,     //nr of blocks
+        100,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    unsigned char               l_msg_auc[100];
+    unsigned char               l_buf_auc[100];
+    size_t                      l_size_ud = 0;
+    hl_blocks_msg_seq_t         l_seq_ud = 0;
+    uint32_t                    l_tag_ud = 0;
+
+    //10 with tag 1 fill the first blocks, then tag 5 and 1 alternate and the last has tag 7
+    for (int i = 0; i < 16; i ++) {
+        uint32_t l_write_tag_ud = (i < 10) ? 1 : (i == 15) ? 7 : (i % 2) ? 1 : 5;
+        memset (l_msg_auc, 'a' + i, sizeof (l_msg_auc));
+        ASSERT_INT_EQ (0, hl_blocks_r_write_tag (l_blocks_pz, 0, l_write_tag_ud, l_msg_auc, 30 + i, NULL));
+    }
+    if (hl_blocks_r_write_tag (l_blocks_pz, 0, HL_BLOCKS_MAX_TAGS, l_msg_auc, 10, NULL) == 0)
+        return ERROR (-1, "wrote tag %u", HL_BLOCKS_MAX_TAGS);
+
+    //the blocks with a tag map are valid when opened again
+    if (hl_blocks_r_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "failed to close");
+    ASSERT_INT_EQ (0, hl_blocks_r_open_options (128, 16, 100, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_blocks_pz));
+
+    //one reader of tag 5 then one of tag 1, each gets all of theirs
+    hl_blocks_cursor_t          l_cursor_5_z;
+    hl_blocks_cursor_t          l_cursor_1_z;
+    hl_blocks_r_cursor_init (&l_cursor_5_z);
+    hl_blocks_r_cursor_init (&l_cursor_1_z);
+    for (int i = 10; i < 15; i += 2) {
+        ASSERT_INT_EQ (0, hl_blocks_r_read_tags (l_blocks_pz, &l_cursor_5_z, HL_BLOCKS_TAG_BIT (5) | HL_BLOCKS_TAG_BIT (9),
+            l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud, &l_tag_ud));
+        ASSERT_INT_EQ (i + 1, l_seq_ud);
+        ASSERT_INT_EQ (30 + i, l_size_ud);
+        ASSERT_INT_EQ (5, l_tag_ud);
+        memset (l_msg_auc, 'a' + i, sizeof (l_msg_auc));
+        ASSERT_INT_EQ (0, memcmp (l_msg_auc, l_buf_auc, l_size_ud));
+    }
+    if (hl_blocks_r_read_tags (l_blocks_pz, &l_cursor_5_z, HL_BLOCKS_TAG_BIT (5), l_buf_auc, sizeof (l_buf_auc), &l_size_ud, NULL, &l_tag_ud) != HL_BLOCKS_K_ERROR_READ_ALL)
+        return ERROR (-1, "read a message with tag %u", l_tag_ud);
+
+    hl_blocks_stats_t           l_stats_z;
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    if (l_stats_z.blocks_skipped_ud == 0)
+        return ERROR (-1, "no blocks passed over by their tag map");
+    if (l_stats_z.msgs_skipped_ud < 2)
+        return ERROR (-1, "passed over %u messages", (uint32_t)l_stats_z.msgs_skipped_ud);
+
+    for (int i = 0; i < 14; i ++) {
+        if ((i >= 10) && ((i % 2) == 0))
+            continue;
+        ASSERT_INT_EQ (0, hl_blocks_r_read_tags (l_blocks_pz, &l_cursor_1_z, HL_BLOCKS_TAG_BIT (1),
+            l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud, &l_tag_ud));
+        ASSERT_INT_EQ (i + 1, l_seq_ud);
+        ASSERT_INT_EQ (1, l_tag_ud);
+        memset (l_msg_auc, 'a' + i, sizeof (l_msg_auc));
+        ASSERT_INT_EQ (0, memcmp (l_msg_auc, l_buf_auc, l_size_ud));
+    }
+    if (hl_blocks_r_read_tags (l_blocks_pz, &l_cursor_1_z, HL_BLOCKS_TAG_BIT (1), l_buf_auc, sizeof (l_buf_auc), &l_size_ud, NULL, NULL) != HL_BLOCKS_K_ERROR_READ_ALL)
+        return ERROR (-1, "read tag 1 after the last");
+
+    //all are still there to consume, the cursors continue after it
+    for (int i = 0; i < 12; i ++) {
+        ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud));
+        ASSERT_INT_EQ (i + 1, l_seq_ud);
+    }
+    memset (l_msg_auc, 'z', sizeof (l_msg_auc));
+    ASSERT_INT_EQ (0, hl_blocks_r_write_tag (l_blocks_pz, 0, 5, l_msg_auc, 20, NULL));
+    ASSERT_INT_EQ (0, hl_blocks_r_read_tags (l_blocks_pz, &l_cursor_5_z, HL_BLOCKS_TAG_BIT (5), l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud, NULL));
+    ASSERT_INT_EQ (17, l_seq_ud);
+    if (hl_blocks_r_read_tags (l_blocks_pz, &l_cursor_1_z, HL_BLOCKS_TAG_BIT (1), l_buf_auc, sizeof (l_buf_auc), &l_size_ud, NULL, NULL) != HL_BLOCKS_K_ERROR_READ_ALL)
+        return ERROR (-1, "read tag 1 again");
+    for (int i = 12; i < 17; i ++) {
+        ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud));
+        ASSERT_INT_EQ (i + 1, l_seq_ud);
+    }
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//overwrite past a full ring with messages spanning blocks, also when the
+//block dropped holds the first parts of all messages in the heap block
+TEST(overwrite_oldest_keeps_reads_consistent) {
+    const uint32_t              l_cfg_aud[][2] = {{2, 50}, {3, 300}, {4, 300}};
+    for (uint32_t l_cfg_ud = 0; l_cfg_ud < sizeof (l_cfg_aud) / sizeof (l_cfg_aud[0]); l_cfg_ud ++) {
+        const uint32_t              l_max_ud = l_cfg_aud[l_cfg_ud][1];
+        hl_blocks_t*                l_blocks_pz = NULL;
+        if (m_r_start (128, l_cfg_aud[l_cfg_ud][0], l_max_ud, 16, NULL, &l_blocks_pz) != 0)
+            return ERROR (-1, "test setup failed");
+        ASSERT_INT_EQ (0, hl_blocks_r_set_full_mode (l_blocks_pz, HL_BLOCKS_K_FULL_MODE_OVERWRITE_OLDEST));
+
+        unsigned char               l_msg_auc[300];
+        unsigned char               l_buf_auc[300];
+        size_t                      l_size_ud = 0;
+        hl_blocks_msg_seq_t         l_seq_ud = 0;
+        hl_blocks_msg_seq_t         l_last_seq_ud = 0;
+        for (uint32_t i = 1; i <= 400; i ++) {
+            //the size and data follow from the seq
+            uint32_t l_len_ud = 1 + (i * 37) % l_max_ud;
+            for (uint32_t k = 0; k < l_len_ud; k ++)
+                l_msg_auc[k] = (unsigned char)(i + k);
+            ASSERT_INT_EQ (0, hl_blocks_r_write (l_blocks_pz, l_msg_auc, l_len_ud, &l_seq_ud));
+            ASSERT_INT_EQ (i, l_seq_ud);
+
+            //read one now and then, all at the end
+            while (  ((i % 7) == 0)
+                  || (i == 400)) {
+                int l_result_d = hl_blocks_r_read (l_blocks_pz, l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud);
+                if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+                    break;
+                if (l_result_d != 0)
+                    return ERROR (-1, "%u blocks: failed to read after msg[%u] seq %u", l_cfg_aud[l_cfg_ud][0], l_last_seq_ud, i);
+                if (l_seq_ud <= l_last_seq_ud)
+                    return ERROR (-1, "read seq %u after %u", l_seq_ud, l_last_seq_ud);
+                ASSERT_INT_EQ (1 + (l_seq_ud * 37) % l_max_ud, l_size_ud);
+                for (uint32_t k = 0; k < l_size_ud; k ++)
+                    ASSERT_INT_EQ ((unsigned char)(l_seq_ud + k), l_buf_auc[k]);
+                l_last_seq_ud = l_seq_ud;
+                if (i != 400)
+                    break;
+            }
+        }
+        ASSERT_INT_EQ (400, l_last_seq_ud);
+        ASSERT_INT_EQ (0, m_r_cleanup (&l_blocks_pz));
+    }/*for each config*/
+    return SUCCESS ();
+}//TEST()
+
+//a full ring keeps a block to sync the heap block of each prio with data,
+//so all messages written are still there after close and open
+TEST(prio_full_keeps_space_to_sync_all_lanes) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.nr_prios_ud = 2;
+    START_OPTIONS(
+        128,    //block size
+        4,      //nr of blocks
+        100,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    unsigned char               l_msg_auc[100];
+    unsigned char               l_buf_auc[100];
+    size_t                      l_size_ud = 0;
+    uint32_t                    l_nr_written_aud[2] = {0, 0};
+
+    //fill the ring from prio 0, then write to prio 1 until full
+    for (uint32_t l_prio_ud = 0; l_prio_ud < 2; l_prio_ud ++) {
+        while (1) {
+            uint32_t i = l_nr_written_aud[l_prio_ud];
+            memset (l_msg_auc, (int)(l_prio_ud * 100 + i), sizeof (l_msg_auc));
+            int l_result_d = hl_blocks_r_write_prio (l_blocks_pz, l_prio_ud, l_msg_auc, 40 + i % 20, NULL);
+            if (l_result_d == HL_BLOCKS_K_ERROR_NO_SPACE_LEFT_IN_BUFFER)
+                break;
+            ASSERT_INT_EQ (0, l_result_d);
+            l_nr_written_aud[l_prio_ud] ++;
+        }
+    }
+    if (l_nr_written_aud[0] == 0)
+        return ERROR (-1, "nothing written in prio 0");
+
+    if (hl_blocks_r_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "failed to sync all prios on close");
+    ASSERT_INT_EQ (0, hl_blocks_r_open_options (128, 4, 100, 16, m_r_block_write, m_r_block_addr, &l_options_z, &l_blocks_pz));
+
+    //all written are read, highest prio first
+    for (uint32_t l_nr_ud = 0; l_nr_ud < 2; l_nr_ud ++) {
+        uint32_t l_prio_ud = 1 - l_nr_ud;
+        for (uint32_t i = 0; i < l_nr_written_aud[l_prio_ud]; i ++) {
+            ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_auc, sizeof (l_buf_auc), &l_size_ud, NULL));
+            ASSERT_INT_EQ (40 + i % 20, l_size_ud);
+            memset (l_msg_auc, (int)(l_prio_ud * 100 + i), sizeof (l_msg_auc));
+            ASSERT_INT_EQ (0, memcmp (l_msg_auc, l_buf_auc, l_size_ud));
+        }
+    }
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//blocks written before the crc have no crc flag and crc_ud 0,
+//they are still read after the upgrade, also with new blocks after them
+TEST(legacy_blocks_without_crc_are_read) {
+    START(
+        128,    //block size
+        16,     //nr of blocks
+        128,    //max message size
+        16);    //min data per message part
+
+    for (int i = 0; i < 10; i ++)
+        WRITE_PRIO_MSG (0, i, 30);
+    if (hl_blocks_r_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "Failed to close");
+
+    //as written before the crc
+    for (uint32_t l_idx_ud = 0; l_idx_ud < l_nr_blocks_ud; l_idx_ud++) {
+        blk_head_t* l_blk_head_pz = (blk_head_t*)(m_d_mock_flash_mem_auc + l_idx_ud * l_block_size_ud);
+        l_blk_head_pz->flags_ud &= (uint8_t)~HL_BLOCKS_BLK_FLAG_CRC;
+        l_blk_head_pz->crc_ud = 0;
+    }
+
+    if (hl_blocks_r_open (128, 16, 128, 16, m_r_block_write, m_r_block_addr, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks with legacy blocks");
+    for (int i = 10; i < 15; i ++)
+        WRITE_PRIO_MSG (0, i, 30);
+    if (hl_blocks_r_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "Failed to close");
+
+    if (hl_blocks_r_open (128, 16, 128, 16, m_r_block_write, m_r_block_addr, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks with legacy and new blocks");
+    for (int i = 0; i < 15; i ++)
+        READ_EXPECTED_MSG (i, 30);
+    ASSERT_NOTHING_MORE_TO_READ (l_blocks_pz);
+    hl_blocks_stats_t           l_stats_z;
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    ASSERT_INT_EQ (0, l_stats_z.corruptions_ud);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//open only checks the crc of the newest block, older blocks are
+//checked when read, and skipped when their data is corrupted
+TEST(open_checks_crc_of_newest_block_only) {
+    START(
+        128,    //block size
+        16,     //nr of blocks
+        128,    //max message size
+        16);    //min data per message part
+
+    for (int i = 0; i < 15; i ++)
+        WRITE_PRIO_MSG (0, i, 30);
+    if (hl_blocks_r_close (&l_blocks_pz) != 0)
+        return ERROR (-1, "Failed to close");
+
+    //corrupt the data of the oldest but one and of the newest block
+    uint32_t l_newest_idx_ud = 0;
+    blk_seq_t l_newest_seq_ud = 0;
+    for (uint32_t l_idx_ud = 0; l_idx_ud < l_nr_blocks_ud; l_idx_ud++) {
+        const blk_head_t* l_blk_head_pz = (const blk_head_t*)(m_d_mock_flash_mem_auc + l_idx_ud * l_block_size_ud);
+        if (l_blk_head_pz->seq_ud > l_newest_seq_ud) {
+            l_newest_idx_ud = l_idx_ud;
+            l_newest_seq_ud = l_blk_head_pz->seq_ud;
+        }
+    }
+    ASSERT_INT_EQ (1, l_newest_idx_ud > 2);
+    m_d_mock_flash_mem_auc[1 * l_block_size_ud + sizeof (blk_head_t) + sizeof (msg_head_t)] ^= 0x01;
+    m_d_mock_flash_mem_auc[l_newest_idx_ud * l_block_size_ud + sizeof (blk_head_t) + sizeof (msg_head_t)] ^= 0x01;
+
+    if (hl_blocks_r_open (128, 16, 128, 16, m_r_block_write, m_r_block_addr, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks");
+    hl_blocks_stats_t           l_stats_z;
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    ASSERT_INT_EQ (1, l_stats_z.corruptions_ud);
+
+    //messages in order without those in the corrupted blocks
+    int l_last_id_d = -1;
+    int l_nr_read_d = 0;
+    for (;;) {
+        char                        l_buf_ac[100];
+        size_t                      l_read_size_ud = 0;
+        int l_result_d = hl_blocks_r_read (l_blocks_pz, l_buf_ac, sizeof (l_buf_ac), &l_read_size_ud, NULL);
+        if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+            break;
+        int l_id_d = -1;
+        if (  (l_result_d != 0)
+           || (sscanf (l_buf_ac, "test(%d)", &l_id_d) != 1)
+           || (l_id_d <= l_last_id_d))
+            return ERROR (-1, "unexpected msg after msg %d", l_last_id_d);
+        l_last_id_d = l_id_d;
+        l_nr_read_d ++;
+    }
+    ASSERT_INT_EQ (0, (l_nr_read_d < 8) || (l_nr_read_d > 13));
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+//with only readers of tags, releasing behind their cursors frees the
+//space for the writer, but not the messages a cursor did not pass yet
+TEST(tag_readers_release_behind_cursors) {
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    l_options_z.tag_map_ud = 1;
+    START_OPTIONS(
+        128,    //block size, 104 data bytes after the tag map
+        8,      //nr of blocks
+        100,    //max message size
+        16,     //min data per message part
+        &l_options_z);
+
+    unsigned char               l_msg_auc[100];
+    unsigned char               l_buf_auc[100];
+    size_t                      l_size_ud = 0;
+    hl_blocks_msg_seq_t         l_seq_ud = 0;
+    hl_blocks_msg_seq_t         l_write_seq_ud = 0;
+    hl_blocks_cursor_t          l_cursor_1_z;
+    hl_blocks_cursor_t          l_cursor_2_z;
+    hl_blocks_cursor_t* const   l_cursor_apz[] = {&l_cursor_1_z, &l_cursor_2_z};
+    hl_blocks_r_cursor_init (&l_cursor_1_z);
+    hl_blocks_r_cursor_init (&l_cursor_2_z);
+
+    //many times the space in the blocks, each reader gets all of its tag
+    for (int i = 0; i < 200; i ++) {
+        memset (l_msg_auc, 'a' + i % 26, sizeof (l_msg_auc));
+        ASSERT_INT_EQ (0, hl_blocks_r_write_tag (l_blocks_pz, 0, 1 + i % 2, l_msg_auc, 40, &l_write_seq_ud));
+        if (i % 5 != 4)
+            continue;
+        for (hl_blocks_cursor_t* l_cursor_pz = &l_cursor_1_z; l_cursor_pz != NULL; l_cursor_pz = (l_cursor_pz == &l_cursor_1_z) ? &l_cursor_2_z : NULL) {
+            uint32_t l_tag_ud = (l_cursor_pz == &l_cursor_1_z) ? 1 : 2;
+            hl_blocks_msg_seq_t l_last_seq_ud = l_cursor_pz->lane_az[0].last_seq_ud;
+            while (hl_blocks_r_read_tags (l_blocks_pz, l_cursor_pz, HL_BLOCKS_TAG_BIT (l_tag_ud),
+                    l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud, NULL) == 0) {
+                //seq 1 has tag 1, 2 tag 2, ...
+                ASSERT_INT_EQ (l_tag_ud % 2, l_seq_ud % 2);
+                if (l_last_seq_ud != 0)
+                    ASSERT_INT_EQ (l_last_seq_ud + 2, l_seq_ud);
+                l_last_seq_ud = l_seq_ud;
+            }
+            if (l_last_seq_ud + 2 <= l_write_seq_ud)
+                return ERROR (-1, "tag %u read up to seq %u of %u", l_tag_ud, l_last_seq_ud, l_write_seq_ud);
+        }
+        ASSERT_INT_EQ (0, hl_blocks_r_release (l_blocks_pz, l_cursor_apz, 2, NULL));
+    }
+    hl_blocks_stats_t           l_stats_z;
+    ASSERT_INT_EQ (0, hl_blocks_r_get_stats (l_blocks_pz, &l_stats_z));
+    ASSERT_INT_EQ (0, l_stats_z.rejects_full_ud);
+    if (l_stats_z.blocks_released_ud < 20)
+        return ERROR (-1, "released %u blocks", (uint32_t)l_stats_z.blocks_released_ud);
+
+    //messages of tag 2 are kept while its reader did not pass them
+    for (int i = 0; i < 5; i ++)
+        ASSERT_INT_EQ (0, hl_blocks_r_write_tag (l_blocks_pz, 0, 2, l_msg_auc, 40, NULL));
+    ASSERT_INT_EQ (0, hl_blocks_r_write_tag (l_blocks_pz, 0, 1, l_msg_auc, 40, &l_write_seq_ud));
+    ASSERT_INT_EQ (0, hl_blocks_r_read_tags (l_blocks_pz, &l_cursor_1_z, HL_BLOCKS_TAG_BIT (1),
+        l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud, NULL));
+    ASSERT_INT_EQ (l_write_seq_ud, l_seq_ud);
+    uint32_t                    l_nr_released_ud = 0;
+    ASSERT_INT_EQ (0, hl_blocks_r_release (l_blocks_pz, l_cursor_apz, 2, &l_nr_released_ud));
+    ASSERT_INT_EQ (0, l_nr_released_ud);
+    for (int i = 0; i < 5; i ++) {
+        ASSERT_INT_EQ (0, hl_blocks_r_read_tags (l_blocks_pz, &l_cursor_2_z, HL_BLOCKS_TAG_BIT (2),
+            l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud, NULL));
+        ASSERT_INT_EQ (l_write_seq_ud - 5 + i, l_seq_ud);
+    }
+    ASSERT_INT_EQ (0, hl_blocks_r_release (l_blocks_pz, l_cursor_apz, 2, &l_nr_released_ud));
+    if (l_nr_released_ud == 0)
+        return ERROR (-1, "nothing released after both cursors passed");
+
+    //only the messages in the blocks not released are left to read
+    ASSERT_INT_EQ (0, hl_blocks_r_read (l_blocks_pz, l_buf_auc, sizeof (l_buf_auc), &l_size_ud, &l_seq_ud));
+    if (l_seq_ud + 1 < l_write_seq_ud)
+        return ERROR (-1, "read seq %u released before seq %u", l_seq_ud, l_write_seq_ud);
+    return m_r_cleanup (&l_blocks_pz);
+}//TEST()
+
+
 static int m_r_start (
     const uint32_t                    p_block_size_ud,
     const uint32_t                    p_nr_blocks_ud,
     const uint32_t                    p_max_msg_size_ud,
     const uint32_t                    p_min_data_per_part_ud,
+    const hl_blocks_options_t*        p_options_pz,
           hl_blocks_t**               p_block_ppz)
 {
     /*
@@ -994,14 +2203,20 @@ static int m_r_start (
     m_d_nr_blocks_ud        = p_nr_blocks_ud;
     m_d_max_msg_size_ud     = p_max_msg_size_ud;
     m_d_mock_flash_mem_auc  = (unsigned char*)malloc (m_d_block_size_ud * m_d_nr_blocks_ud);
+    memset (m_d_mock_flash_mem_auc, 0, m_d_block_size_ud * m_d_nr_blocks_ud);
+    hl_blocks_options_t         l_options_z;
+    hl_blocks_r_options_init (&l_options_z);
+    if (p_options_pz != NULL)
+        l_options_z = *p_options_pz;
     hl_blocks_t*                l_blocks_pz = NULL;
-    if (hl_blocks_r_open (
+    if (hl_blocks_r_open_options (
                 m_d_block_size_ud,
                 m_d_nr_blocks_ud,
                 m_d_max_msg_size_ud,
                 p_min_data_per_part_ud,
                 m_r_block_write,
                 m_r_block_addr,
+                &l_options_z,
                 &l_blocks_pz)
                 != 0)
         return ERROR(-1,
@@ -1042,9 +2257,30 @@ static int m_r_block_addr (
         return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
 
     *p_block_pp = m_d_mock_flash_mem_auc + (m_d_block_size_ud * p_idx_ud);
+    m_d_addr_count_ud ++;
     return SUCCESS();
 }/*m_r_block_addr()*/
 
+//write the pieces and clear the rest of the block,
+//so the block is the same as written by m_r_block_write()
+static int m_r_block_writev (
+    const uint32_t                    p_idx_ud,
+    const struct iovec*               p_iov_az,
+    const int                         p_nr_iov_d)
+{
+    if (p_idx_ud >= m_d_nr_blocks_ud)
+        return ERROR (-1, "invalid block idx %u not 0..%u", p_idx_ud, m_d_nr_blocks_ud - 1);
+
+    unsigned char* l_blk_puc = m_d_mock_flash_mem_auc + (m_d_block_size_ud * p_idx_ud);
+    size_t l_ofs_ud = 0;
+    for (int i = 0; i < p_nr_iov_d; i++) {
+        memcpy (l_blk_puc + l_ofs_ud, p_iov_az[i].iov_base, p_iov_az[i].iov_len);
+        l_ofs_ud += p_iov_az[i].iov_len;
+    }
+    memset (l_blk_puc + l_ofs_ud, 0, m_d_block_size_ud - l_ofs_ud);
+    return SUCCESS();
+}/*m_r_block_writev()*/
+
 static void m_r_make_test_msg (
           void*                       p_buff_data_p,
     const size_t                      p_buff_size_ud,
@@ -1071,3 +2307,18 @@ static void m_r_make_test_msg (
     *(((char*)p_buff_data_p) + l_len_ud) = '\0';
     return;
 }//m_r_make_test_msg()
+
+
+//highest generation of the checkpoints in the mock flash, 0 when none
+static uint32_t m_r_checkpoint_generation (void)
+{
+    uint32_t l_generation_ud = 0;
+    for (uint32_t l_idx_ud = 0; l_idx_ud < HL_BLOCKS_CHECKPOINT_BLOCKS; l_idx_ud++) {
+        checkpoint_t                l_ckpt_z;
+        memcpy (&l_ckpt_z, m_d_mock_flash_mem_auc + l_idx_ud * m_d_block_size_ud, sizeof (l_ckpt_z));
+        if (  (l_ckpt_z.magic_ud == HL_BLOCKS_CHECKPOINT_MAGIC)
+           && (l_ckpt_z.generation_ud > l_generation_ud))
+            l_generation_ud = l_ckpt_z.generation_ud;
+    }
+    return l_generation_ud;
+}/*m_r_checkpoint_generation()*/
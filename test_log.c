@@ -0,0 +1,193 @@
+#include "error_stack.h"
+#include "log.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "test.h"
+
+//modules get their own level from config text, and a cached level is
+//resolved again after each change
+TEST(log_module_levels) {
+    log_module_t                l_a_z = {"test_log_a", LOG_K_LEVEL_ERROR, 0};
+    log_module_t                l_b_z = {"test_log_b", LOG_K_LEVEL_ERROR, 0};
+
+    ASSERT_INT_EQ (0, log_r_config ("test_log_a=trace,test_log_b=Warning"));
+    ASSERT_INT_EQ (LOG_K_LEVEL_TRACE, log_r_module_level (&l_a_z));
+    ASSERT_INT_EQ (LOG_K_LEVEL_WARNING, log_r_module_level (&l_b_z));
+    ASSERT_INT_EQ (log_d_generation_ud, l_b_z.generation_ud);
+
+    //invalid parts fail, valid parts are still applied
+    ASSERT_INT_EQ (-1, log_r_config ("test_log_a=loud,test_log_b=3,=info"));
+    ASSERT_INT_EQ (-1, log_r_config ("test_log_name_that_is_too_long_for_a_module=info"));
+    ASSERT_INT_EQ (1, l_b_z.generation_ud != log_d_generation_ud);
+    ASSERT_INT_EQ (LOG_K_LEVEL_TRACE, log_r_module_level (&l_a_z));
+    ASSERT_INT_EQ (LOG_K_LEVEL_DEBUG, log_r_module_level (&l_b_z));
+
+    ASSERT_INT_EQ (0, log_r_set_level ("test_log_a", LOG_K_LEVEL_ERROR));
+    ASSERT_INT_EQ (LOG_K_LEVEL_ERROR, log_r_module_level (&l_a_z));
+    return SUCCESS ();
+}//TEST()
+
+#define M_LOG_NR_THREADS        3
+#define M_LOG_NR_MESSAGES       200
+
+//file contents as a string, empty when missing
+static void m_r_log_read_file (
+    const char*                       p_path_pc,
+          char*                       p_text_pc,
+    const size_t                      p_size_ud)
+{
+    size_t l_len_ud = 0;
+    FILE* l_file_fp = fopen (p_path_pc, "r");
+    if (l_file_fp != NULL) {
+        l_len_ud = fread (p_text_pc, 1, p_size_ud - 1, l_file_fp);
+        fclose (l_file_fp);
+    }
+    p_text_pc[l_len_ud] = '\0';
+}
+
+static void* m_r_log_thread (
+          void*                       p_nr_p)
+{
+    int l_nr_d = *(int*)p_nr_p;
+    for (int i = 0; i < M_LOG_NR_MESSAGES; i ++)
+        ERROR_LOG ("thread %d message %d of %s", l_nr_d, i, "test");
+    return NULL;
+}
+
+//deferred messages are formatted later with copies of their arguments,
+//and messages that do not fit in the ring of a thread are dropped
+TEST(log_deferred) {
+    static char                 l_text_ac[65536];
+    char                        l_path_ac[] = "/tmp/test_log_XXXXXX";
+    int                         l_fd_d = mkstemp (l_path_ac);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to create %s", l_path_ac);
+    ASSERT_INT_EQ (0, log_r_set_sink_fd (l_fd_d));
+    ASSERT_INT_EQ (-1, log_r_start_deferred (5000));
+    ASSERT_INT_EQ (0, log_r_start_deferred (4096));
+    ASSERT_INT_EQ (-1, log_r_start_deferred (4096));
+
+    char                        l_name_ac[16] = "blk.bin";
+    ERROR_LOG ("open %s: %d%% of %zu, %5.2f %-4s|%*u|%llx",
+        l_name_ac, 42, (size_t)1000, 3.14159, "ab", 6, 77u, 0x1234567890ULL);
+    strcpy (l_name_ac, "gone");
+    ERROR_LOG ("%d %d %d %d %d %d %d %d %d %d", 1, 2, 3, 4, 5, 6, 7, 8, 9, 10);
+    log_r_flush ();
+    m_r_log_read_file (l_path_ac, l_text_ac, sizeof (l_text_ac));
+    if (strstr (l_text_ac, "): open blk.bin: 42% of 1000,  3.14 ab  |    77|1234567890\n") == NULL)
+        return ERROR (-1, "deferred message not formatted: %s", l_text_ac);
+    if (strstr (l_text_ac, "): 1 2 3 4 5 6 7 8 ...\n") == NULL)
+        return ERROR (-1, "deferred message not truncated: %s", l_text_ac);
+
+    //each thread writes more than fits in its ring before the drain
+    //thread catches up, or all fit, but none are lost without counting
+    pthread_t                   l_thread_az[M_LOG_NR_THREADS];
+    int                         l_nr_ad[M_LOG_NR_THREADS];
+    for (int i = 0; i < M_LOG_NR_THREADS; i ++) {
+        l_nr_ad[i] = i;
+        pthread_create (&l_thread_az[i], NULL, m_r_log_thread, &l_nr_ad[i]);
+    }
+    for (int i = 0; i < M_LOG_NR_THREADS; i ++)
+        pthread_join (l_thread_az[i], NULL);
+    log_r_stop_deferred ();
+    log_r_set_sink_fd (2);
+    close (l_fd_d);
+    m_r_log_read_file (l_path_ac, l_text_ac, sizeof (l_text_ac));
+    unlink (l_path_ac);
+
+    int l_nr_lines_d = 0;
+    for (const char* l_pc = strstr (l_text_ac, " message "); l_pc != NULL; l_pc = strstr (l_pc + 1, " message "))
+        l_nr_lines_d ++;
+    ASSERT_INT_EQ (M_LOG_NR_THREADS * M_LOG_NR_MESSAGES, l_nr_lines_d + (int)log_r_get_dropped ());
+    if (strstr (l_text_ac, "thread 2 message 0 of test\n") == NULL)
+        return ERROR (-1, "first message of thread 2 not formatted: %s", l_text_ac);
+    return SUCCESS ();
+}//TEST()
+
+//a file sink is renamed to <path>.1 .. <path>.N before it gets too large,
+//with only whole lines in each file
+TEST(log_sink_file_rotation) {
+    char                        l_path_ac[] = "/tmp/test_log_rotate_XXXXXX";
+    int                         l_fd_d = mkstemp (l_path_ac);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to create %s", l_path_ac);
+    close (l_fd_d);
+
+    ASSERT_INT_EQ (-1, log_r_set_sink_file ("/no/such/dir/log", 0, 0));
+    ASSERT_INT_EQ (0, log_r_set_sink_file (l_path_ac, 1000, 2));
+    for (int i = 0; i < 100; i ++)
+        ERROR_LOG ("rotate line %d", i);
+    log_r_set_sink_fd (2);
+
+    char                        l_file_ac[64];
+    char                        l_text_ac[2048];
+    for (int l_nr_d = 0; l_nr_d <= 3; l_nr_d ++) {
+        if (l_nr_d == 0)
+            snprintf (l_file_ac, sizeof (l_file_ac), "%s", l_path_ac);
+        else
+            snprintf (l_file_ac, sizeof (l_file_ac), "%s.%d", l_path_ac, l_nr_d);
+        struct stat             l_stat_z;
+        int l_exists_d = (stat (l_file_ac, &l_stat_z) == 0);
+        ASSERT_INT_EQ (l_nr_d < 3, l_exists_d);
+        if (!l_exists_d)
+            continue;
+        if (l_stat_z.st_size > 1000)
+            return ERROR (-1, "%s has %lld bytes > 1000", l_file_ac, (long long)l_stat_z.st_size);
+        m_r_log_read_file (l_file_ac, l_text_ac, sizeof (l_text_ac));
+        if (  (strncmp (l_text_ac, "ERROR", 5) != 0)
+           || (l_text_ac[strlen (l_text_ac) - 1] != '\n'))
+            return ERROR (-1, "%s does not have whole lines: %s", l_file_ac, l_text_ac);
+        if (  (l_nr_d == 0)
+           && (strstr (l_text_ac, "rotate line 99\n") == NULL))
+            return ERROR (-1, "last line not in %s: %s", l_file_ac, l_text_ac);
+        unlink (l_file_ac);
+    }
+    return SUCCESS ();
+}//TEST()
+
+//hex dump rows are the same as formatted with printf, for all byte values
+//and a last row that is not full
+TEST(log_hex_rows) {
+    static char                 l_text_ac[8192];
+    static char                 l_expect_ac[8192];
+    unsigned char               l_data_auc[256 + 5];
+    for (unsigned int i = 0; i < sizeof (l_data_auc); i ++)
+        l_data_auc[i] = (unsigned char)(i * 7 + 3);
+
+    char                        l_path_ac[] = "/tmp/test_log_hex_XXXXXX";
+    int                         l_fd_d = mkstemp (l_path_ac);
+    if (l_fd_d < 0)
+        return ERROR (-1, "failed to create %s", l_path_ac);
+    ASSERT_INT_EQ (0, log_r_set_sink_fd (l_fd_d));
+    log_r_hex ("a.c", 12, LOG_K_LEVEL_DEBUG, "block", l_data_auc, sizeof (l_data_auc));
+    log_r_set_sink_fd (2);
+    close (l_fd_d);
+    m_r_log_read_file (l_path_ac, l_text_ac, sizeof (l_text_ac));
+    unlink (l_path_ac);
+
+    size_t l_len_ud = (size_t)snprintf (l_expect_ac, sizeof (l_expect_ac), "%5.5s %30.30s(%5d): block (%zu bytes):\n",
+        "DEBUG", "a.c", 12, sizeof (l_data_auc));
+    for (unsigned int l_ofs_ud = 0; l_ofs_ud < sizeof (l_data_auc); l_ofs_ud += 16) {
+        l_len_ud += (size_t)snprintf (l_expect_ac + l_len_ud, sizeof (l_expect_ac) - l_len_ud, "%5.5s %30.30s(%5d): [%08x..%08x]",
+            "DEBUG", "a.c", 12, l_ofs_ud, l_ofs_ud + 15);
+        for (unsigned int i = l_ofs_ud; i < l_ofs_ud + 16; i ++) {
+            if (i < sizeof (l_data_auc))
+                l_len_ud += (size_t)snprintf (l_expect_ac + l_len_ud, sizeof (l_expect_ac) - l_len_ud, " %02X", l_data_auc[i]);
+            else
+                l_len_ud += (size_t)snprintf (l_expect_ac + l_len_ud, sizeof (l_expect_ac) - l_len_ud, " ..");
+        }
+        l_len_ud += (size_t)snprintf (l_expect_ac + l_len_ud, sizeof (l_expect_ac) - l_len_ud, " | ");
+        for (unsigned int i = l_ofs_ud; (i < l_ofs_ud + 16) && (i < sizeof (l_data_auc)); i ++)
+            l_expect_ac[l_len_ud++] = isprint (l_data_auc[i]) ? (char)l_data_auc[i] : '.';
+        l_expect_ac[l_len_ud++] = '\n';
+        l_expect_ac[l_len_ud] = '\0';
+    }
+    if (strcmp (l_expect_ac, l_text_ac) != 0)
+        return ERROR (-1, "hex dump differs from printf");
+    return SUCCESS ();
+}//TEST()
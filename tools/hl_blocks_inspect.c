@@ -0,0 +1,256 @@
+/*****************************************************************************
+ * hl_blocks_inspect: examine an image (flash dump or file) written with
+ * hl_blocks, without opening it with hl_blocks_r_open().
+ *
+ * Usage:
+ *     hl_blocks_inspect -b <block size> [-n <nr blocks>] [-t <threads>] [-v]
+ *                       [-o <export file>] <image>
+ *
+ *     -b   block size used when the image was written
+ *     -n   nr of blocks, default is all blocks in the image
+ *     -t   nr of threads to scan with, default nr of CPUs
+ *     -v   list each used block
+ *     -o   write all complete messages to this file ("-" for stdout),
+ *          oldest first, each as a line "<seq> <prio> <size>" followed
+ *          by <size> bytes and a newline
+ *
+ * Exit code is 0 when the image is valid, 1 on error and 2 when corrupt
+ * blocks were found.
+ *
+ * Build with bin/build_tools.sh
+ *****************************************************************************/
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "error_stack.h"
+#include "hl_blocks_scan.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define M_EXPORT_BUFFER_SIZE        (4 * 1024 * 1024)
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static void m_r_usage (
+    const char*                       p_prog_pc);
+
+static void m_r_print_block (
+    const uint32_t                    p_idx_ud,
+    const hl_blocks_scan_block_t*     p_info_pz);
+
+static int m_r_export_msg (
+          void*                       p_ctx_p,
+    const hl_blocks_msg_seq_t         p_seq_ud,
+    const uint32_t                    p_prio_ud,
+    const void*                       p_data_p,
+    const uint32_t                    p_size_ud);
+
+
+/*****************************************************************************
+ *   M A I N
+ *****************************************************************************/
+
+int main (int argc, char* argv[])
+{
+    error_stack_r_init ();
+
+    uint32_t l_block_size_ud = 0;
+    uint32_t l_nr_blocks_ud = 0;
+    long l_nr_threads_d = sysconf (_SC_NPROCESSORS_ONLN);
+    int l_verbose_d = 0;
+    const char* l_export_pc = NULL;
+    int l_opt_d;
+    while ((l_opt_d = getopt (argc, argv, "b:n:t:vo:h")) != -1) {
+        switch (l_opt_d) {
+        case 'b': l_block_size_ud = (uint32_t)strtoul (optarg, NULL, 0); break;
+        case 'n': l_nr_blocks_ud = (uint32_t)strtoul (optarg, NULL, 0); break;
+        case 't': l_nr_threads_d = strtol (optarg, NULL, 0); break;
+        case 'v': l_verbose_d = 1; break;
+        case 'o': l_export_pc = optarg; break;
+        default:
+            m_r_usage (argv[0]);
+            return 1;
+        }
+    }
+    if ((optind != argc - 1) || (l_block_size_ud == 0)) {
+        m_r_usage (argv[0]);
+        return 1;
+    }
+    const char* l_path_pc = argv[optind];
+    if (l_nr_threads_d < 1)
+        l_nr_threads_d = 1;
+
+    int l_fd_d = open (l_path_pc, O_RDONLY);
+    if (l_fd_d < 0) {
+        fprintf (stderr, "failed to open %s: %s\n", l_path_pc, strerror (errno));
+        return 1;
+    }
+    struct stat l_stat_z;
+    if (fstat (l_fd_d, &l_stat_z) != 0) {
+        fprintf (stderr, "failed to stat %s: %s\n", l_path_pc, strerror (errno));
+        return 1;
+    }
+    uint64_t l_image_blocks_ud = (uint64_t)l_stat_z.st_size / l_block_size_ud;
+    if (l_nr_blocks_ud == 0)
+        l_nr_blocks_ud = (uint32_t)l_image_blocks_ud;
+    if ((l_nr_blocks_ud == 0) || (l_nr_blocks_ud > l_image_blocks_ud)) {
+        fprintf (stderr, "%s has %llu blocks of %u bytes, cannot inspect %u blocks\n",
+            l_path_pc,
+            (unsigned long long)l_image_blocks_ud,
+            l_block_size_ud,
+            l_nr_blocks_ud);
+        return 1;
+    }
+
+    size_t l_map_size_ud = (size_t)l_nr_blocks_ud * l_block_size_ud;
+    void* l_image_p = mmap (NULL, l_map_size_ud, PROT_READ, MAP_SHARED, l_fd_d, 0);
+    if (l_image_p == MAP_FAILED) {
+        fprintf (stderr, "failed to map %s: %s\n", l_path_pc, strerror (errno));
+        return 1;
+    }
+    close (l_fd_d);
+    //each thread reads its range front to back
+    madvise (l_image_p, l_map_size_ud, MADV_SEQUENTIAL);
+
+    hl_blocks_scan_block_t* l_blocks_az = (hl_blocks_scan_block_t*)malloc ((size_t)l_nr_blocks_ud * sizeof (hl_blocks_scan_block_t));
+    if (l_blocks_az == NULL) {
+        fprintf (stderr, "out of memory for %u blocks\n", l_nr_blocks_ud);
+        return 1;
+    }
+    hl_blocks_scan_t            l_scan_z;
+    if (hl_blocks_scan_r_image (l_image_p, l_block_size_ud, l_nr_blocks_ud, (uint32_t)l_nr_threads_d, l_blocks_az, &l_scan_z) != 0) {
+        error_stack_r_print (stderr);
+        return 1;
+    }
+
+    if (l_verbose_d) {
+        for (uint32_t l_idx_ud = 0; l_idx_ud < l_nr_blocks_ud; l_idx_ud++) {
+            if (l_blocks_az[l_idx_ud].seq_ud != 0)
+                m_r_print_block (l_idx_ud, &l_blocks_az[l_idx_ud]);
+        }
+    }
+
+    printf ("image:      %s\n", l_path_pc);
+    printf ("blocks:     %u x %u bytes, %u used, %u empty, %u corrupt\n",
+        l_scan_z.nr_blocks_ud,
+        l_block_size_ud,
+        l_scan_z.nr_used_ud,
+        l_scan_z.nr_empty_ud,
+        l_scan_z.nr_corrupt_ud);
+    printf ("fill:       %llu / %llu bytes (%.1f%% of image, %.1f%% of used blocks)\n",
+        (unsigned long long)l_scan_z.used_bytes_ud,
+        (unsigned long long)l_scan_z.data_bytes_ud,
+        (l_scan_z.data_bytes_ud == 0) ? 0.0 : 100.0 * l_scan_z.used_bytes_ud / l_scan_z.data_bytes_ud,
+        (l_scan_z.nr_used_ud == l_scan_z.nr_corrupt_ud) ? 0.0
+            : 100.0 * l_scan_z.used_bytes_ud
+              / ((double)(l_scan_z.nr_used_ud - l_scan_z.nr_corrupt_ud) * (l_scan_z.data_bytes_ud / l_scan_z.nr_blocks_ud)));
+    if (l_scan_z.nr_used_ud > 0) {
+        printf ("tail:       blk[%u] seq=%u\n", l_scan_z.tail_idx_ud, l_scan_z.tail_seq_ud);
+        printf ("head:       blk[%u] seq=%u\n", l_scan_z.head_idx_ud, l_scan_z.head_seq_ud);
+        printf ("messages:   %llu starting in valid blocks, seq %u..%u\n",
+            (unsigned long long)l_scan_z.nr_msgs_ud,
+            l_scan_z.first_msg_seq_ud,
+            l_scan_z.last_msg_seq_ud);
+        for (uint32_t l_prio_ud = 0; l_prio_ud < HL_BLOCKS_MAX_PRIOS; l_prio_ud++) {
+            if (l_scan_z.prio_blocks_aud[l_prio_ud] > 0)
+                printf ("prio[%u]:    %u blocks\n", l_prio_ud, l_scan_z.prio_blocks_aud[l_prio_ud]);
+        }
+    }
+    if (l_scan_z.nr_corrupt_ud > 0) {
+        for (uint32_t l_idx_ud = 0; l_idx_ud < l_nr_blocks_ud; l_idx_ud++) {
+            if ((l_blocks_az[l_idx_ud].seq_ud != 0) && (l_blocks_az[l_idx_ud].errors_ud != 0))
+                m_r_print_block (l_idx_ud, &l_blocks_az[l_idx_ud]);
+        }
+    }
+
+    int l_result_d = (l_scan_z.nr_corrupt_ud > 0) ? 2 : 0;
+    if (l_export_pc != NULL) {
+        FILE* l_out_fp = (strcmp (l_export_pc, "-") == 0) ? stdout : fopen (l_export_pc, "wb");
+        if (l_out_fp == NULL) {
+            fprintf (stderr, "failed to create %s: %s\n", l_export_pc, strerror (errno));
+            return 1;
+        }
+        setvbuf (l_out_fp, NULL, _IOFBF, M_EXPORT_BUFFER_SIZE);
+        uint64_t l_nr_msgs_ud = 0;
+        if (  (hl_blocks_scan_r_export (l_image_p, l_block_size_ud, l_nr_blocks_ud, l_blocks_az, m_r_export_msg, l_out_fp, &l_nr_msgs_ud) != 0)
+           || (fflush (l_out_fp) != 0)) {
+            error_stack_r_print (stderr);
+            fprintf (stderr, "failed to export to %s\n", l_export_pc);
+            l_result_d = 1;
+        }
+        if (l_out_fp != stdout)
+            fclose (l_out_fp);
+        fprintf (stderr, "exported %llu messages\n", (unsigned long long)l_nr_msgs_ud);
+    }
+
+    free (l_blocks_az);
+    munmap (l_image_p, l_map_size_ud);
+    return l_result_d;
+}/*main()*/
+
+
+/*****************************************************************************
+ *****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************
+ *****************************************************************************/
+
+static void m_r_usage (
+    const char*                       p_prog_pc)
+{
+    fprintf (stderr,
+        "usage: %s -b <block size> [-n <nr blocks>] [-t <threads>] [-v] [-o <export file>] <image>\n",
+        p_prog_pc);
+}/*m_r_usage()*/
+
+
+static void m_r_print_block (
+    const uint32_t                    p_idx_ud,
+    const hl_blocks_scan_block_t*     p_info_pz)
+{
+    printf ("blk[%u]: seq=%u prio=%u used=%u parts=%u msgs=%u msg_seq=%u..%u%s%s",
+        p_idx_ud,
+        p_info_pz->seq_ud,
+        p_info_pz->prio_ud,
+        p_info_pz->used_size_ud,
+        p_info_pz->nr_parts_ud,
+        p_info_pz->nr_msgs_ud,
+        p_info_pz->first_msg_seq_ud,
+        p_info_pz->last_msg_seq_ud,
+        p_info_pz->continued_ud ? " continued" : "",
+        p_info_pz->incomplete_ud ? " incomplete" : "");
+    if (p_info_pz->errors_ud & HL_BLOCKS_SCAN_K_BAD_USED_SIZE) printf (" BAD_USED_SIZE");
+    if (p_info_pz->errors_ud & HL_BLOCKS_SCAN_K_BAD_PRIO)      printf (" BAD_PRIO");
+    if (p_info_pz->errors_ud & HL_BLOCKS_SCAN_K_BAD_MSG_HEAD)  printf (" BAD_MSG_HEAD");
+    if (p_info_pz->errors_ud & HL_BLOCKS_SCAN_K_BAD_MSG_SEQ)   printf (" BAD_MSG_SEQ");
+    if (p_info_pz->errors_ud & HL_BLOCKS_SCAN_K_BAD_MSG_SIZE)  printf (" BAD_MSG_SIZE");
+    if (p_info_pz->errors_ud & HL_BLOCKS_SCAN_K_BAD_CRC)       printf (" BAD_CRC");
+    if (p_info_pz->errors_ud & HL_BLOCKS_SCAN_K_BAD_ALIGN)     printf (" BAD_ALIGN");
+    printf ("\n");
+}/*m_r_print_block()*/
+
+
+static int m_r_export_msg (
+          void*                       p_ctx_p,
+    const hl_blocks_msg_seq_t         p_seq_ud,
+    const uint32_t                    p_prio_ud,
+    const void*                       p_data_p,
+    const uint32_t                    p_size_ud)
+{
+    FILE* l_out_fp = (FILE*)p_ctx_p;
+    if (  (fprintf (l_out_fp, "%u %u %u\n", p_seq_ud, p_prio_ud, p_size_ud) < 0)
+       || (fwrite (p_data_p, 1, p_size_ud, l_out_fp) != p_size_ud)
+       || (fputc ('\n', l_out_fp) == EOF))
+        return ERROR (-1, "failed to write msg seq=%u", p_seq_ud);
+    return 0;
+}/*m_r_export_msg()*/
@@ -0,0 +1,353 @@
+/*****************************************************************************
+ * hl_blocks_powercut_bench: measure how long hl_blocks_r_open() takes after
+ * a power cut and how many messages are lost, using the hl_blocks_fault
+ * backend to cut the power on random writes with torn blocks.
+ *
+ * Usage:
+ *     hl_blocks_powercut_bench [-b <block size>] [-c <cuts>] [-y <msgs per sync>]
+ *                              [-s <seed>] [<nr blocks> ...]
+ *
+ *     -b   block size, default 512
+ *     -c   nr of power cuts per image size and mode, default 20
+ *     -y   call hl_blocks_r_sync() after this nr of messages, default 8
+ *     -s   seed for the random cuts, default 1
+ *     nr blocks: image sizes to test, default 64 1024 8192
+ *
+ * Each run writes messages while a reader stays behind, until the power is
+ * cut on a random write, then opens the image again and reads the rest.
+ * For each image size it prints for the scan and checkpoint modes:
+ *     open_avg/max_us  time of hl_blocks_r_open_options() after the cut
+ *     lost_synced      messages lost that were written before a sync,
+ *                      must always be 0
+ *     lost_unsynced    messages lost that were written after the last sync
+ *     duplicates       messages read before the cut that were read again
+ *     corrupt          messages read with the wrong content
+ *     open_failed      runs where open failed
+ *
+ * Build with bin/build_tools.sh
+ *****************************************************************************/
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "error_stack.h"
+#include "hl_blocks.h"
+#include "hl_blocks_fault.h"
+#include "hl_blocks_format.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define M_MAX_SIZES                 16
+
+//what the writer and reader knew when the power was cut
+typedef struct m_run_s {
+    hl_blocks_msg_seq_t         written_seq_ud; //last message written
+    hl_blocks_msg_seq_t         synced_seq_ud;  //last message written before a successful sync
+    hl_blocks_msg_seq_t         read_seq_ud;    //last message read
+} m_run_t;
+
+//results of all cuts for one image size and mode
+typedef struct m_result_s {
+    uint64_t                    open_tot_ns_ud;
+    uint64_t                    open_max_ns_ud;
+    uint32_t                    nr_opens_ud;
+    uint32_t                    lost_synced_ud;
+    uint32_t                    lost_unsynced_ud;
+    uint32_t                    duplicates_ud;
+    uint32_t                    corrupt_ud;
+    uint32_t                    open_failed_ud;
+} m_result_t;
+
+
+/*****************************************************************************
+ *   L O C A L   D A T A    D E F I N I T I O N S
+ *****************************************************************************/
+
+static uint32_t             m_d_block_size_ud       = 512;
+static uint32_t             m_d_sync_msgs_ud        = 8;
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static void m_r_usage (
+    const char*                       p_prog_pc);
+
+static int m_r_run (
+    const uint32_t                    p_nr_blocks_ud,
+    const hl_blocks_options_t*        p_options_pz,
+    const uint32_t                    p_cut_write_nr_ud,
+    const uint32_t                    p_torn_bytes_ud,
+          m_run_t*                    p_run_pz);
+
+static void m_r_recover (
+    const uint32_t                    p_nr_blocks_ud,
+    const hl_blocks_options_t*        p_options_pz,
+    const m_run_t*                    p_run_pz,
+          m_result_t*                 p_result_pz);
+
+static void m_r_count_lost (
+    const m_run_t*                    p_run_pz,
+    const hl_blocks_msg_seq_t         p_first_seq_ud,
+    const hl_blocks_msg_seq_t         p_last_seq_ud,
+          m_result_t*                 p_result_pz);
+
+static uint32_t m_r_make_msg (
+    const hl_blocks_msg_seq_t         p_seq_ud,
+          char*                       p_msg_pc);
+
+static uint64_t m_r_now_ns (void);
+
+
+/*****************************************************************************
+ *   M A I N
+ *****************************************************************************/
+
+int main (int argc, char* argv[])
+{
+    error_stack_r_init ();
+
+    uint32_t l_nr_cuts_ud = 20;
+    unsigned int l_seed_ud = 1;
+    int l_opt_d;
+    while ((l_opt_d = getopt (argc, argv, "b:c:y:s:h")) != -1) {
+        switch (l_opt_d) {
+        case 'b': m_d_block_size_ud = (uint32_t)strtoul (optarg, NULL, 0); break;
+        case 'c': l_nr_cuts_ud = (uint32_t)strtoul (optarg, NULL, 0); break;
+        case 'y': m_d_sync_msgs_ud = (uint32_t)strtoul (optarg, NULL, 0); break;
+        case 's': l_seed_ud = (unsigned int)strtoul (optarg, NULL, 0); break;
+        default:
+            m_r_usage (argv[0]);
+            return 1;
+        }
+    }
+    if ((m_d_block_size_ud < 128) || (m_d_sync_msgs_ud == 0)) {
+        m_r_usage (argv[0]);
+        return 1;
+    }
+
+    uint32_t l_sizes_aud[M_MAX_SIZES] = {64, 1024, 8192};
+    uint32_t l_nr_sizes_ud = 3;
+    if (optind < argc) {
+        l_nr_sizes_ud = 0;
+        for (int l_arg_d = optind; (l_arg_d < argc) && (l_nr_sizes_ud < M_MAX_SIZES); l_arg_d++)
+            l_sizes_aud[l_nr_sizes_ud++] = (uint32_t)strtoul (argv[l_arg_d], NULL, 0);
+    }
+
+    printf ("%8s %-10s %5s %12s %12s %12s %13s %10s %7s %11s\n",
+        "blocks", "mode", "cuts", "open_avg_us", "open_max_us",
+        "lost_synced", "lost_unsynced", "duplicates", "corrupt", "open_failed");
+    int l_exit_d = 0;
+    for (uint32_t l_size_idx_ud = 0; l_size_idx_ud < l_nr_sizes_ud; l_size_idx_ud++) {
+        uint32_t l_nr_blocks_ud = l_sizes_aud[l_size_idx_ud];
+        if (l_nr_blocks_ud < HL_BLOCKS_CHECKPOINT_BLOCKS + 4) {
+            fprintf (stderr, "skip %u blocks, need at least %u\n", l_nr_blocks_ud, HL_BLOCKS_CHECKPOINT_BLOCKS + 4);
+            continue;
+        }
+
+        for (uint32_t l_checkpoint_ud = 0; l_checkpoint_ud <= 1; l_checkpoint_ud++) {
+            hl_blocks_options_t         l_options_z;
+            hl_blocks_r_options_init (&l_options_z);
+            l_options_z.checkpoint_ud = l_checkpoint_ud;
+
+            //nr of writes without a power cut, to cut on any of them
+            m_run_t                     l_run_z;
+            if (m_r_run (l_nr_blocks_ud, &l_options_z, 0, 0, &l_run_z) != 0) {
+                error_stack_r_print (stderr);
+                return 1;
+            }
+            uint32_t l_nr_writes_ud = hl_blocks_fault_r_get_write_count ();
+            hl_blocks_fault_r_close ();
+
+            m_result_t                  l_result_z;
+            memset (&l_result_z, 0, sizeof (l_result_z));
+            for (uint32_t l_cut_ud = 0; l_cut_ud < l_nr_cuts_ud; l_cut_ud++) {
+                uint32_t l_write_nr_ud = 1 + (uint32_t)rand_r (&l_seed_ud) % l_nr_writes_ud;
+                uint32_t l_torn_bytes_ud = (uint32_t)rand_r (&l_seed_ud) % (m_d_block_size_ud + 1);
+                if (m_r_run (l_nr_blocks_ud, &l_options_z, l_write_nr_ud, l_torn_bytes_ud, &l_run_z) != 0) {
+                    error_stack_r_print (stderr);
+                    return 1;
+                }
+                hl_blocks_fault_r_power_on ();
+                m_r_recover (l_nr_blocks_ud, &l_options_z, &l_run_z, &l_result_z);
+                hl_blocks_fault_r_close ();
+            }/*for each cut*/
+
+            printf ("%8u %-10s %5u %12.1f %12.1f %12u %13u %10u %7u %11u\n",
+                l_nr_blocks_ud,
+                l_checkpoint_ud ? "checkpoint" : "scan",
+                l_nr_cuts_ud,
+                (l_result_z.nr_opens_ud > 0) ? (double)l_result_z.open_tot_ns_ud / l_result_z.nr_opens_ud / 1000.0 : 0.0,
+                (double)l_result_z.open_max_ns_ud / 1000.0,
+                l_result_z.lost_synced_ud,
+                l_result_z.lost_unsynced_ud,
+                l_result_z.duplicates_ud,
+                l_result_z.corrupt_ud,
+                l_result_z.open_failed_ud);
+            fflush (stdout);
+            if (  (l_result_z.lost_synced_ud > 0)
+               || (l_result_z.corrupt_ud > 0)
+               || (l_result_z.open_failed_ud > 0))
+                l_exit_d = 2;
+        }/*for scan and checkpoint*/
+    }/*for each image size*/
+    return l_exit_d;
+}/*main()*/
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************/
+
+static void m_r_usage (
+    const char*                       p_prog_pc)
+{
+    fprintf (stderr,
+        "usage: %s [-b <block size>] [-c <cuts>] [-y <msgs per sync>] [-s <seed>] [<nr blocks> ...]\n",
+        p_prog_pc);
+}/*m_r_usage()*/
+
+
+//write 4 messages per block with a reader half the image behind,
+//until done or the power is cut, leaving the fault backend open
+static int m_r_run (
+    const uint32_t                    p_nr_blocks_ud,
+    const hl_blocks_options_t*        p_options_pz,
+    const uint32_t                    p_cut_write_nr_ud,
+    const uint32_t                    p_torn_bytes_ud,
+          m_run_t*                    p_run_pz)
+{
+    memset (p_run_pz, 0, sizeof (m_run_t));
+    if (hl_blocks_fault_r_open (m_d_block_size_ud, p_nr_blocks_ud) != 0)
+        return ERROR (-1, "failed to open fault backend");
+
+    hl_blocks_t*                l_blocks_pz = NULL;
+    if (hl_blocks_r_open_options (m_d_block_size_ud, p_nr_blocks_ud, m_d_block_size_ud, 16,
+            hl_blocks_fault_r_write, hl_blocks_fault_r_addr, p_options_pz, &l_blocks_pz) != 0)
+        return ERROR (-1, "failed to open blocks");
+    hl_blocks_fault_r_cut_at (p_cut_write_nr_ud, p_torn_bytes_ud);
+
+    char* l_msg_pc = (char*)malloc (m_d_block_size_ud);
+    hl_blocks_msg_seq_t l_nr_msgs_ud = (hl_blocks_msg_seq_t)p_nr_blocks_ud * 4;
+    for (hl_blocks_msg_seq_t l_seq_ud = 1; l_seq_ud <= l_nr_msgs_ud; l_seq_ud++) {
+        uint32_t l_size_ud = m_r_make_msg (l_seq_ud, l_msg_pc);
+        if (hl_blocks_r_write (l_blocks_pz, l_msg_pc, l_size_ud, NULL) != 0)
+            break;
+        p_run_pz->written_seq_ud = l_seq_ud;
+
+        if (l_seq_ud % m_d_sync_msgs_ud == 0) {
+            if (hl_blocks_r_sync (l_blocks_pz) != 0)
+                break;
+            p_run_pz->synced_seq_ud = l_seq_ud;
+        }
+
+        while (p_run_pz->read_seq_ud + p_nr_blocks_ud / 2 < l_seq_ud) {
+            size_t                      l_size_ud = 0;
+            hl_blocks_msg_seq_t         l_read_seq_ud = 0;
+            if (hl_blocks_r_read (l_blocks_pz, l_msg_pc, m_d_block_size_ud, &l_size_ud, &l_read_seq_ud) != 0)
+                break;
+            p_run_pz->read_seq_ud = l_read_seq_ud;
+        }
+    }/*for each message*/
+    free (l_msg_pc);
+
+    //after a power cut this only releases the memory
+    if (  (hl_blocks_r_close (&l_blocks_pz) != 0)
+       && (!hl_blocks_fault_r_is_cut ()))
+        return ERROR (-1, "failed to close");
+    return SUCCESS ();
+}/*m_r_run()*/
+
+
+//open after the power cut, read all and count what was lost
+static void m_r_recover (
+    const uint32_t                    p_nr_blocks_ud,
+    const hl_blocks_options_t*        p_options_pz,
+    const m_run_t*                    p_run_pz,
+          m_result_t*                 p_result_pz)
+{
+    hl_blocks_t*                l_blocks_pz = NULL;
+    uint64_t l_start_ns_ud = m_r_now_ns ();
+    int l_result_d = hl_blocks_r_open_options (m_d_block_size_ud, p_nr_blocks_ud, m_d_block_size_ud, 16,
+        hl_blocks_fault_r_write, hl_blocks_fault_r_addr, p_options_pz, &l_blocks_pz);
+    uint64_t l_open_ns_ud = m_r_now_ns () - l_start_ns_ud;
+    if (l_result_d != 0) {
+        p_result_pz->open_failed_ud ++;
+        m_r_count_lost (p_run_pz, p_run_pz->read_seq_ud + 1, p_run_pz->written_seq_ud, p_result_pz);
+        return;
+    }
+    p_result_pz->open_tot_ns_ud += l_open_ns_ud;
+    if (l_open_ns_ud > p_result_pz->open_max_ns_ud)
+        p_result_pz->open_max_ns_ud = l_open_ns_ud;
+    p_result_pz->nr_opens_ud ++;
+
+    char* l_buf_pc = (char*)malloc (m_d_block_size_ud);
+    char* l_msg_pc = (char*)malloc (m_d_block_size_ud);
+    hl_blocks_msg_seq_t l_next_seq_ud = p_run_pz->read_seq_ud + 1;
+    while (1) {
+        size_t                      l_size_ud = 0;
+        hl_blocks_msg_seq_t         l_seq_ud = 0;
+        l_result_d = hl_blocks_r_read (l_blocks_pz, l_buf_pc, m_d_block_size_ud, &l_size_ud, &l_seq_ud);
+        if (l_result_d == HL_BLOCKS_K_ERROR_READ_ALL)
+            break;
+        if (l_result_d != 0) {
+            p_result_pz->corrupt_ud ++;
+            continue;
+        }
+        if (  (l_size_ud != m_r_make_msg (l_seq_ud, l_msg_pc))
+           || (memcmp (l_buf_pc, l_msg_pc, l_size_ud) != 0)) {
+            p_result_pz->corrupt_ud ++;
+            continue;
+        }
+        if (l_seq_ud < l_next_seq_ud) {
+            p_result_pz->duplicates_ud ++;
+            continue;
+        }
+        m_r_count_lost (p_run_pz, l_next_seq_ud, l_seq_ud - 1, p_result_pz);
+        l_next_seq_ud = l_seq_ud + 1;
+    }/*while more to read*/
+    m_r_count_lost (p_run_pz, l_next_seq_ud, p_run_pz->written_seq_ud, p_result_pz);
+    free (l_buf_pc);
+    free (l_msg_pc);
+    hl_blocks_r_close (&l_blocks_pz);
+}/*m_r_recover()*/
+
+
+//count messages first..last that were not read after the power cut
+static void m_r_count_lost (
+    const m_run_t*                    p_run_pz,
+    const hl_blocks_msg_seq_t         p_first_seq_ud,
+    const hl_blocks_msg_seq_t         p_last_seq_ud,
+          m_result_t*                 p_result_pz)
+{
+    for (hl_blocks_msg_seq_t l_seq_ud = p_first_seq_ud; l_seq_ud <= p_last_seq_ud; l_seq_ud++) {
+        if (l_seq_ud <= p_run_pz->synced_seq_ud)
+            p_result_pz->lost_synced_ud ++;
+        else
+            p_result_pz->lost_unsynced_ud ++;
+    }
+}/*m_r_count_lost()*/
+
+
+//message for a seq, 16 bytes up to a block, return its size
+static uint32_t m_r_make_msg (
+    const hl_blocks_msg_seq_t         p_seq_ud,
+          char*                       p_msg_pc)
+{
+    uint32_t l_size_ud = 16 + (p_seq_ud * 37) % (m_d_block_size_ud - 16);
+    int l_len_d = snprintf (p_msg_pc, l_size_ud, "msg %u", p_seq_ud);
+    memset (p_msg_pc + l_len_d, 'a' + (p_seq_ud % 26), l_size_ud - l_len_d);
+    return l_size_ud;
+}/*m_r_make_msg()*/
+
+
+static uint64_t m_r_now_ns (void)
+{
+    struct timespec             l_ts_z;
+    clock_gettime (CLOCK_MONOTONIC, &l_ts_z);
+    return (uint64_t)l_ts_z.tv_sec * 1000000000ULL + (uint64_t)l_ts_z.tv_nsec;
+}/*m_r_now_ns()*/
@@ -0,0 +1,181 @@
+/*****************************************************************************
+ * hl_blocks_trace_replay: replay a trace recorded with hl_blocks_trace on a
+ * new hl_blocks instance in memory, to compare settings on field traffic.
+ *
+ * Usage:
+ *     hl_blocks_trace_replay [-b <block size>] [-n <nr blocks>] [-m <max msg size>]
+ *                            [-p <min data per part>] [-s <speed>] [-f nor|nand]
+ *                            <trace file>
+ *
+ *     -b -n -m -p  params for hl_blocks_r_open(), default as recorded
+ *     -s           1 for the recorded times (default), 10 for 10x faster,
+ *                  0 to replay without waiting
+ *     -f           replay on simulated NOR or NAND flash with
+ *                  hl_blocks_flashsim, default plain memory
+ *
+ * It prints per op type the nr of calls, failed calls, MB/s over the
+ * replay time and latency percentiles, and the nr of blocks written to
+ * flash with the write amplification: flash bytes / message bytes written.
+ * With -f it also prints the pages programmed and erases, the write
+ * amplification of the pages programmed and the simulated flash time.
+ *
+ * Build with bin/build_tools.sh
+ *****************************************************************************/
+
+/*****************************************************************************
+ * I N C L U D E D   H E A D E R   F I L E S
+ *****************************************************************************/
+
+#include "error_stack.h"
+#include "hl_blocks.h"
+#include "hl_blocks_fault.h"
+#include "hl_blocks_flashsim.h"
+#include "hl_blocks_trace.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E C L A R A T I O N S
+ *****************************************************************************/
+
+static void m_r_usage (
+    const char*                       p_prog_pc);
+
+
+/*****************************************************************************
+ *   M A I N
+ *****************************************************************************/
+
+int main (int argc, char* argv[])
+{
+    error_stack_r_init ();
+
+    uint32_t l_block_size_ud = 0;
+    uint32_t l_nr_blocks_ud = 0;
+    uint32_t l_max_msg_size_ud = 0;
+    uint32_t l_min_part_ud = 0;
+    int      l_min_part_set_d = 0;
+    double   l_speed_d = 1.0;
+    const char* l_flash_pc = NULL;
+    int l_opt_d;
+    while ((l_opt_d = getopt (argc, argv, "b:n:m:p:s:f:h")) != -1) {
+        switch (l_opt_d) {
+        case 'b': l_block_size_ud = (uint32_t)strtoul (optarg, NULL, 0); break;
+        case 'n': l_nr_blocks_ud = (uint32_t)strtoul (optarg, NULL, 0); break;
+        case 'm': l_max_msg_size_ud = (uint32_t)strtoul (optarg, NULL, 0); break;
+        case 'p': l_min_part_ud = (uint32_t)strtoul (optarg, NULL, 0); l_min_part_set_d = 1; break;
+        case 's': l_speed_d = strtod (optarg, NULL); break;
+        case 'f': l_flash_pc = optarg; break;
+        default:
+            m_r_usage (argv[0]);
+            return 1;
+        }
+    }
+    if (  (optind + 1 != argc)
+       || (l_speed_d < 0)
+       || (  (l_flash_pc != NULL)
+          && (strcmp (l_flash_pc, "nor") != 0)
+          && (strcmp (l_flash_pc, "nand") != 0))) {
+        m_r_usage (argv[0]);
+        return 1;
+    }
+    const char* l_path_pc = argv[optind];
+
+    //recorded params, replaced by the options
+    hl_blocks_trace_config_t    l_config_z;
+    hl_blocks_trace_reader_t*   l_reader_pz = NULL;
+    if (hl_blocks_trace_r_reader_open (l_path_pc, &l_config_z, &l_reader_pz) != 0) {
+        error_stack_r_print (stderr);
+        return 1;
+    }
+    hl_blocks_trace_r_reader_close (&l_reader_pz);
+    if (l_block_size_ud > 0)    l_config_z.block_size_ud = l_block_size_ud;
+    if (l_nr_blocks_ud > 0)     l_config_z.nr_blocks_ud = l_nr_blocks_ud;
+    if (l_max_msg_size_ud > 0)  l_config_z.max_msg_size_ud = l_max_msg_size_ud;
+    if (l_min_part_set_d)       l_config_z.min_data_per_part_ud = l_min_part_ud;
+
+    hl_blocks_trace_result_t    l_result_z;
+    hl_blocks_flashsim_stats_t  l_sim_stats_z;
+    if (l_flash_pc != NULL) {
+        hl_blocks_flashsim_config_t l_sim_config_z;
+        hl_blocks_flashsim_r_config_init ((strcmp (l_flash_pc, "nand") == 0) ? HL_BLOCKS_FLASHSIM_K_TYPE_NAND : HL_BLOCKS_FLASHSIM_K_TYPE_NOR,
+            &l_sim_config_z);
+        if (  (hl_blocks_flashsim_r_open (l_config_z.block_size_ud, l_config_z.nr_blocks_ud, &l_sim_config_z) != 0)
+           || (hl_blocks_trace_r_replay (l_path_pc, &l_config_z, l_speed_d,
+                    hl_blocks_flashsim_r_write, hl_blocks_flashsim_r_addr, &l_result_z) != 0)) {
+            error_stack_r_print (stderr);
+            hl_blocks_flashsim_r_close ();
+            return 1;
+        }
+        hl_blocks_flashsim_r_get_stats (&l_sim_stats_z);
+        hl_blocks_flashsim_r_close ();
+    } else {
+        if (  (hl_blocks_fault_r_open (l_config_z.block_size_ud, l_config_z.nr_blocks_ud) != 0)
+           || (hl_blocks_trace_r_replay (l_path_pc, &l_config_z, l_speed_d,
+                    hl_blocks_fault_r_write, hl_blocks_fault_r_addr, &l_result_z) != 0)) {
+            error_stack_r_print (stderr);
+            hl_blocks_fault_r_close ();
+            return 1;
+        }
+        hl_blocks_fault_r_close ();
+    }
+
+    printf ("%u blocks x %u bytes, max msg %u, min data per part %u, speed %g\n",
+        l_config_z.nr_blocks_ud,
+        l_config_z.block_size_ud,
+        l_config_z.max_msg_size_ud,
+        l_config_z.min_data_per_part_ud,
+        l_speed_d);
+    printf ("recorded %.3f s, replayed in %.3f s\n",
+        (double)l_result_z.recorded_ns_ud / 1e9,
+        (double)l_result_z.elapsed_ns_ud / 1e9);
+    printf ("%-6s %12s %10s %10s %10s %10s %10s %10s %10s\n",
+        "op", "calls", "failed", "MB/s", "p50_us", "p90_us", "p99_us", "p999_us", "max_us");
+    const char* l_op_apc[HL_BLOCKS_TRACE_K_OP_NR_OF] = {"write", "read", "sync"};
+    for (uint32_t l_op_ud = 0; l_op_ud < HL_BLOCKS_TRACE_K_OP_NR_OF; l_op_ud++) {
+        const hl_blocks_trace_op_stats_t* l_stats_pz = &l_result_z.op_az[l_op_ud];
+        printf ("%-6s %12llu %10llu %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+            l_op_apc[l_op_ud],
+            (unsigned long long)l_stats_pz->nr_ops_ud,
+            (unsigned long long)l_stats_pz->nr_failed_ud,
+            (l_result_z.elapsed_ns_ud > 0) ? (double)l_stats_pz->bytes_ud * 1000.0 / (double)l_result_z.elapsed_ns_ud : 0.0,
+            (double)l_stats_pz->p50_ns_ud / 1000.0,
+            (double)l_stats_pz->p90_ns_ud / 1000.0,
+            (double)l_stats_pz->p99_ns_ud / 1000.0,
+            (double)l_stats_pz->p999_ns_ud / 1000.0,
+            (double)l_stats_pz->max_ns_ud / 1000.0);
+    }
+    uint64_t l_written_ud = l_result_z.op_az[HL_BLOCKS_TRACE_K_OP_WRITE].bytes_ud;
+    printf ("flash writes %llu blocks, write amplification %.2f\n",
+        (unsigned long long)l_result_z.flash_writes_ud,
+        (l_written_ud > 0) ? (double)l_result_z.flash_writes_ud * l_config_z.block_size_ud / (double)l_written_ud : 0.0);
+    if (l_flash_pc != NULL) {
+        hl_blocks_flashsim_config_t l_sim_config_z;
+        hl_blocks_flashsim_r_config_init ((strcmp (l_flash_pc, "nand") == 0) ? HL_BLOCKS_FLASHSIM_K_TYPE_NAND : HL_BLOCKS_FLASHSIM_K_TYPE_NOR,
+            &l_sim_config_z);
+        printf ("%s: %llu pages programmed (%llu again after erase), %llu erases (max %u per unit), write amplification %.2f, flash time %.3f s\n",
+            l_flash_pc,
+            (unsigned long long)l_sim_stats_z.pages_programmed_ud,
+            (unsigned long long)l_sim_stats_z.pages_reprogrammed_ud,
+            (unsigned long long)l_sim_stats_z.erases_ud,
+            l_sim_stats_z.max_erases_ud,
+            (l_written_ud > 0) ? (double)l_sim_stats_z.pages_programmed_ud * l_sim_config_z.page_size_ud / (double)l_written_ud : 0.0,
+            (double)l_sim_stats_z.time_ns_ud / 1e9);
+    }
+    return 0;
+}/*main()*/
+
+
+/*****************************************************************************
+ *   L O C A L   F U N C T I O N   D E F I N I T I O N S
+ *****************************************************************************/
+
+static void m_r_usage (
+    const char*                       p_prog_pc)
+{
+    fprintf (stderr,
+        "usage: %s [-b <block size>] [-n <nr blocks>] [-m <max msg size>] [-p <min data per part>] [-s <speed>] [-f nor|nand] <trace file>\n",
+        p_prog_pc);
+}/*m_r_usage()*/